@@ -0,0 +1,274 @@
+/** Benchmarks for the audio mixing.
+ *
+ *  Compares the float mixing path (copySample) with the
+ *  Q15 integer mixing path (mixSample) and the block
+ *  kernels (mixBlock) for a number of sound layers mixed
+ *  into one ringbuffer block.
+ *
+ *  Also measures the cost of decoding IMA-ADPCM samples while
+ *  mixing compared to PCM samples.
+ */
+
+#include "audio.h"
+#include "audio_adpcm.h"
+#include "audio_mix.h"
+#include "audio_ringbuffer.h"
+#include "bench_cycles.h"
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace rcAudio;
+
+namespace {
+
+/** Audio proc giving the benchmark access to the mixing functions. */
+class BenchAudio : public Audio {
+    public:
+        BenchAudio() {
+            volume = {0.8f, 0.6f};
+        }
+
+        virtual void step(const rcProc::StepInfo& /* info */) override {
+        }
+
+        void mixFloat(const std::vector<uint8_t>& data,
+                      rcProc::AudioSample* out, float dynamicVolume) {
+            for (size_t i = 0; i < data.size(); i++) {
+                copySample(data[i], out + i, dynamicVolume);
+            }
+        }
+
+        using Audio::getGains;
+        using Audio::mixSample;
+
+        void mixQ15(const std::vector<uint8_t>& data,
+                    rcProc::AudioSample* out, float dynamicVolume) {
+            const auto gains = getGains(dynamicVolume);
+            for (size_t i = 0; i < data.size(); i++) {
+                mixSample(data[i], out + i, gains);
+            }
+        }
+};
+
+static std::vector<uint8_t> createData() {
+    std::vector<uint8_t> data(AudioRingbuffer::BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return data;
+}
+
+/** One second of a sweep, as PCM and as IMA-ADPCM. */
+struct SweepSamples {
+    std::vector<uint8_t> pcm;
+    std::vector<uint8_t> adpcm;
+
+    SweepSamples() {
+        AdpcmEncoder encoder;
+        int32_t value = 0;
+        for (uint32_t i = 0; i < SAMPLE_RATE; i++) {
+            value = (value + static_cast<int32_t>(i % 400) * 8) & 0xFFFF;
+            const auto sample = static_cast<int16_t>((value < 0x8000) ? value : 0xFFFF - value) - 16384;
+            pcm.push_back(static_cast<uint8_t>((sample >> 8) + 128));
+            encoder.add(sample, adpcm);
+        }
+        encoder.finish(adpcm);
+    }
+
+    SampleData get(bool useAdpcm) const {
+        return useAdpcm ?
+            SampleData::adpcm(adpcm, ADPCM_BLOCK_SIZE, SAMPLE_RATE) :
+            SampleData(pcm);
+    }
+};
+
+} // namespace
+
+/** Mixes state.range(0) layers with the float path into one block. */
+static void BM_MixFloat(benchmark::State& state) {
+    BenchAudio audio;
+    const auto data = createData();
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> block;
+    const auto layers = state.range(0);
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        block.fill({0, 0});
+        for (int64_t layer = 0; layer < layers; layer++) {
+            audio.mixFloat(data, block.data(), 0.5f);
+        }
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+}
+BENCHMARK(BM_MixFloat)->DenseRange(1, 5)->Arg(8);
+
+/** Mixes state.range(0) layers with the Q15 path into one block. */
+static void BM_MixQ15(benchmark::State& state) {
+    BenchAudio audio;
+    const auto data = createData();
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> block;
+    const auto layers = state.range(0);
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        block.fill({0, 0});
+        for (int64_t layer = 0; layer < layers; layer++) {
+            audio.mixQ15(data, block.data(), 0.5f);
+        }
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+}
+BENCHMARK(BM_MixQ15)->DenseRange(1, 5)->Arg(8);
+
+/** Mixes state.range(0) layers with the block kernel into one block.
+ *
+ *  Fails if the output is not bit-exact with the per-sample loop.
+ */
+static void BM_MixBlock(benchmark::State& state) {
+    BenchAudio audio;
+    const auto data = createData();
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> block;
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> reference;
+    const auto layers = state.range(0);
+    const Gains gains = audio.getGains(0.5f);
+
+    reference.fill({0, 0});
+    block.fill({0, 0});
+    audio.mixQ15(data, reference.data(), 0.5f);
+    mixBlock(data.data(), block.data(), data.size(), gains);
+    for (size_t i = 0; i < block.size(); i++) {
+        if (block[i].channel1 != reference[i].channel1 ||
+            block[i].channel2 != reference[i].channel2) {
+            state.SkipWithError("mixBlock is not bit-exact");
+            return;
+        }
+    }
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        block.fill({0, 0});
+        for (int64_t layer = 0; layer < layers; layer++) {
+            mixBlock(data.data(), block.data(), data.size(), gains);
+        }
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+}
+BENCHMARK(BM_MixBlock)->DenseRange(1, 5)->Arg(8);
+
+/** Resamples and mixes one block with the old per-sample float position. */
+static void BM_ResampleFloat(benchmark::State& state) {
+    BenchAudio audio;
+    const auto data = createData();
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> block;
+    const auto gains = audio.getGains(0.5f);
+    const float posStep = 0.7f / data.size();
+    float pos = 0.0f;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        block.fill({0, 0});
+        for (auto& sample : block) {
+            BenchAudio::mixSample(data[std::min(
+                static_cast<uint16_t>(data.size() * pos),
+                static_cast<uint16_t>(data.size() - 1))], &sample, gains);
+            pos += posStep;
+            while (pos >= 1.0f) {
+                pos -= 1.0f;
+            }
+        }
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+}
+BENCHMARK(BM_ResampleFloat);
+
+/** Resamples and mixes one block with the fixed-point kernels. */
+static void BM_ResampleBlock(benchmark::State& state) {
+    BenchAudio audio;
+    const auto data = createData();
+    const SampleData sample(data);
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> block;
+    std::array<uint8_t, AudioRingbuffer::BLOCK_SIZE> buffer;
+    const auto gains = audio.getGains(0.5f);
+    const Phase posStep = toPhaseStep(0.7 / data.size());
+    Phase pos = 0;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        block.fill({0, 0});
+        pos = resampleBlock(sample, pos, posStep, buffer.data(), buffer.size());
+        mixBlock(buffer.data(), block.data(), buffer.size(), gains);
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+}
+BENCHMARK(BM_ResampleBlock);
+
+/** Reads and mixes one block of a sample playing forward.
+ *
+ *  state.range(0) selects PCM (0) or IMA-ADPCM (1).
+ */
+static void BM_ReadBlock(benchmark::State& state) {
+    BenchAudio audio;
+    const SweepSamples sweep;
+    const SampleData sample = sweep.get(state.range(0) != 0);
+    SampleReader reader;
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> block;
+    std::array<uint8_t, AudioRingbuffer::BLOCK_SIZE> buffer;
+    const auto gains = audio.getGains(0.5f);
+    uint32_t pos = 0;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        block.fill({0, 0});
+        if (pos + buffer.size() > sample.size()) {
+            pos = 0;
+        }
+        const uint8_t* data = reader.read(sample, pos, buffer.data(), buffer.size());
+        mixBlock(data, block.data(), buffer.size(), gains);
+        pos += buffer.size();
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_ReadBlock)->Arg(0)->Arg(1);
+
+/** Resamples and mixes one block of a sample (like the engine sound).
+ *
+ *  state.range(0) selects PCM (0) or IMA-ADPCM (1).
+ */
+static void BM_ResampleRead(benchmark::State& state) {
+    BenchAudio audio;
+    const SweepSamples sweep;
+    const SampleData sample = sweep.get(state.range(0) != 0);
+    SampleReader reader;
+    std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> block;
+    std::array<uint8_t, AudioRingbuffer::BLOCK_SIZE> buffer;
+    const auto gains = audio.getGains(0.5f);
+    const Phase posStep = toPhaseStep(1.3 / sample.size());
+    Phase pos = 0;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        block.fill({0, 0});
+        pos = resampleBlock(sample, reader, pos, posStep, buffer.data(), buffer.size());
+        mixBlock(buffer.data(), block.data(), buffer.size(), gains);
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+}
+BENCHMARK(BM_ResampleRead)->Arg(0)->Arg(1);
@@ -0,0 +1,142 @@
+/** Benchmarks for the parallel rendering of the audio procs.
+ *
+ *  Renders one ringbuffer block per iteration with a growing
+ *  number of sound layers, once on one lane and once split on
+ *  two lanes (see ProcScheduler).
+ */
+
+#include "audio.h"
+#include "audio_engine.h"
+#include "audio_mix.h"
+#include "audio_noise.h"
+#include "audio_ringbuffer.h"
+#include "audio_steam.h"
+#include "bench_cycles.h"
+#include "proc_scheduler.h"
+#include "signals.h"
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace rcAudio;
+using namespace rcSignals;
+
+namespace {
+
+typedef std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> Block;
+
+/** Creates a sample data vector with the given length. */
+static std::vector<uint8_t> createData(size_t len) {
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return data;
+}
+
+static void stepVirtual(rcProc::Proc* proc, const rcProc::StepInfo& info) {
+    proc->step(info);
+}
+
+/** The sound layers, e.g. engine, steam, noise. */
+class Layers {
+    private:
+        std::vector<std::vector<uint8_t>> datas;
+        std::vector<std::unique_ptr<Audio>> procs;
+
+    public:
+        explicit Layers(size_t num) {
+            for (size_t i = 0; i < 5; i++) {
+                datas.push_back(createData(2000 - i * 300));
+            }
+            std::array<SampleData, 5> samples;
+            for (size_t i = 0; i < samples.size(); i++) {
+                samples[i] = SampleData(datas[i]);
+            }
+
+            for (size_t i = 0; i < num; i++) {
+                switch (i % 3) {
+                case 0:
+                    procs.emplace_back(new AudioEngine(samples, {0, 250, 500, 750, 1000}));
+                    break;
+                case 1:
+                    procs.emplace_back(new AudioSteam());
+                    break;
+                default:
+                    procs.emplace_back(new AudioNoise(SignalType::ST_THROTTLE,
+                        AudioNoise::NoiseType::PINK));
+                }
+            }
+        }
+
+        std::vector<ProcStep> getSteps() const {
+            std::vector<ProcStep> steps;
+            for (const auto& proc : procs) {
+                steps.push_back(ProcStep{.fn = &stepVirtual, .proc = proc.get()});
+            }
+            return steps;
+        }
+};
+
+} // namespace
+
+/** Renders one block with state.range(0) layers, with (state.range(1) == 1) or without worker. */
+static void BM_AudioLayers(benchmark::State& state) {
+    Layers layers(state.range(0));
+    ProcScheduler scheduler;
+    scheduler.plan(layers.getSteps());
+    if (state.range(1) != 0) {
+        scheduler.startWorker();
+    }
+
+    Signals signals;
+    signals.reset();
+    signals[SignalType::ST_RPM] = 800;
+    Block block;
+    rcProc::StepInfo info{
+        .deltaMs = AudioRingbuffer::BLOCK_SIZE * 1000u / SAMPLE_RATE,
+        .signals = &signals,
+        .intervals = {
+            rcProc::SamplesInterval{.first = block.data(), .last = block.data() + block.size()},
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+    };
+
+    RcSignal throttle = 0;
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        signals[SignalType::ST_THROTTLE] = throttle;
+        throttle = (throttle + 7) % RCSIGNAL_MAX;
+
+        block.fill({0, 0});
+        scheduler.step(info);
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+    state.SetLabel(state.range(1) ? "two lanes" : "one lane");
+    state.SetItemsProcessed(state.iterations() * block.size());
+}
+BENCHMARK(BM_AudioLayers)->ArgsProduct({{1, 2, 4, 8, 16}, {0, 1}})->UseRealTime();
+
+/** Adds two blocks, see rcAudio::addBlock(). */
+static void BM_AddBlock(benchmark::State& state) {
+    Block in;
+    Block out;
+    for (size_t i = 0; i < in.size(); i++) {
+        in[i] = {static_cast<int16_t>(i * 31), static_cast<int16_t>(i * -17)};
+        out[i] = {static_cast<int16_t>(i * 13), static_cast<int16_t>(i * 7)};
+    }
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        addBlock(in.data(), out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+    state.SetItemsProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_AddBlock);
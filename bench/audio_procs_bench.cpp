@@ -0,0 +1,116 @@
+/** Benchmarks for the audio procs.
+ *
+ *  Renders one ringbuffer block per iteration through the
+ *  step() function of the procs, the same way the render
+ *  task does it.
+ */
+
+#include "audio.h"
+#include "audio_engine.h"
+#include "audio_noise.h"
+#include "audio_ringbuffer.h"
+#include "audio_steam.h"
+#include "bench_cycles.h"
+#include "signals.h"
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace rcAudio;
+using namespace rcSignals;
+
+namespace {
+
+typedef std::array<rcProc::AudioSample, AudioRingbuffer::BLOCK_SIZE> Block;
+
+/** Creates a sample data vector with the given length. */
+static std::vector<uint8_t> createData(size_t len) {
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return data;
+}
+
+/** Returns the step info rendering into one block. */
+static rcProc::StepInfo createInfo(Signals* signals, Block* block) {
+    return rcProc::StepInfo{
+        .deltaMs = AudioRingbuffer::BLOCK_SIZE * 1000u / SAMPLE_RATE,
+        .signals = signals,
+        .intervals = {
+            rcProc::SamplesInterval{.first = block->data(), .last = block->data() + block->size()},
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+    };
+}
+
+/** Steps the proc once per iteration, changing the throttle over time. */
+static void stepAudio(benchmark::State& state, Audio* audio, Signals* signals) {
+    Block block;
+    auto info = createInfo(signals, &block);
+
+    // fade in (e.g. AudioEngine)
+    info.deltaMs = 1000u;
+    audio->step(info);
+    info.deltaMs = AudioRingbuffer::BLOCK_SIZE * 1000u / SAMPLE_RATE;
+
+    RcSignal throttle = 0;
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        (*signals)[SignalType::ST_THROTTLE] = throttle;
+        throttle = (throttle + 7) % RCSIGNAL_MAX;
+
+        block.fill({0, 0});
+        audio->step(info);
+        benchmark::DoNotOptimize(block.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_block");
+    state.SetItemsProcessed(state.iterations() * block.size());
+}
+
+} // namespace
+
+/** Renders one block with an AudioEngine with state.range(0) valid samples. */
+static void BM_AudioEngine(benchmark::State& state) {
+    const auto numSamples = state.range(0);
+
+    std::vector<std::vector<uint8_t>> datas;
+    std::array<SampleData, 5> samples;
+    for (int64_t i = 0; i < numSamples; i++) {
+        datas.push_back(createData(2000 - i * 300));
+    }
+    for (int64_t i = 0; i < numSamples; i++) {
+        samples[i] = SampleData(datas[i]);
+    }
+
+    AudioEngine audio(samples, {0, 250, 500, 750, 1000});
+    Signals signals;
+    signals.reset();
+    signals[SignalType::ST_RPM] = 800;
+    stepAudio(state, &audio, &signals);
+}
+BENCHMARK(BM_AudioEngine)->DenseRange(1, 5);
+
+/** Renders one block with an AudioSteam cylinder. */
+static void BM_AudioSteam(benchmark::State& state) {
+    AudioSteam audio;
+    Signals signals;
+    signals.reset();
+    signals[SignalType::ST_RPM] = 200;
+    stepAudio(state, &audio, &signals);
+}
+BENCHMARK(BM_AudioSteam);
+
+/** Renders one block with an AudioNoise of type state.range(0). */
+static void BM_AudioNoise(benchmark::State& state) {
+    AudioNoise audio(SignalType::ST_THROTTLE,
+        static_cast<AudioNoise::NoiseType>(state.range(0)));
+    Signals signals;
+    signals.reset();
+    stepAudio(state, &audio, &signals);
+}
+BENCHMARK(BM_AudioNoise)->DenseRange(
+    static_cast<int>(AudioNoise::NoiseType::WHITE),
+    static_cast<int>(AudioNoise::NoiseType::RECT));
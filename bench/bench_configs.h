@@ -0,0 +1,61 @@
+/** Helper for loading the shipped configurations in the benchmarks.
+ *
+ *  The shipped configurations (configs/\*.json) are converted into the
+ *  binary format at build time and read from BENCH_CONFIG_DIR.
+ */
+
+#ifndef _BENCH_CONFIGS_H_
+#define _BENCH_CONFIGS_H_
+
+#include "proc_storage.h"
+#include "simple_byte_stream.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+/** The names of the shipped configurations. */
+static const std::array<std::string, 4> CONFIG_NAMES = {
+    "full_beetle", "full_boat", "full_train", "full_truck"};
+
+/** Reads the configuration and returns it re-serialized.
+ *
+ *  Procs not available on the host (e.g. outputs) are dropped during
+ *  the first deserialize, so that the benchmark loop only contains
+ *  procs that are really created.
+ *
+ *  @returns An empty vector if the configuration could not be read.
+ */
+static std::vector<uint8_t> readConfig(const std::string& name) {
+    std::ifstream file(std::string(BENCH_CONFIG_DIR) + "/" + name + ".rc", std::ios::binary);
+    const std::vector<uint8_t> data(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ProcStorage storage;
+    SimpleInStream in(data);
+    if (data.empty() || !storage.deserialize(in)) {
+        return {};
+    }
+
+    SimpleOutStream out;
+    storage.serialize(out);
+    std::vector<uint8_t> result(out.buffer().begin(), out.buffer().begin() + out.tellg());
+    free(out.buffer().data());
+    return result;
+}
+
+/** Returns the configuration, reading it only once. */
+static const std::vector<uint8_t>& loadConfig(const std::string& name) {
+    static std::map<std::string, std::vector<uint8_t>> configs;
+    if (configs.find(name) == configs.end()) {
+        configs[name] = readConfig(name);
+    }
+    return configs[name];
+}
+
+#endif // _BENCH_CONFIGS_H_
@@ -0,0 +1,61 @@
+/** Helper for reporting CPU cycles in the benchmarks.
+ *
+ *  The target counts cycles and not nanoseconds, so
+ *  the benchmarks report cycles as well where the host
+ *  supports it.
+ */
+
+#ifndef _BENCH_CYCLES_H_
+#define _BENCH_CYCLES_H_
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** Returns the CPU time stamp counter or 0 if not available. */
+inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/** Measures the cycles of all iterations and reports them per item.
+ *
+ *  Usage:
+ *  @code
+ *  CycleCounter cycles(state);
+ *  for (auto _ : state) { ... }
+ *  cycles.report("cycles_per_block", blocks);
+ *  @endcode
+ */
+class CycleCounter {
+    private:
+        benchmark::State& state;
+        uint64_t startCycles;
+
+    public:
+        explicit CycleCounter(benchmark::State& stateVal) :
+            state(stateVal),
+            startCycles(readCycles()) {
+        }
+
+        /** Adds a counter with the cycles per item.
+         *
+         *  @param name The name of the counter.
+         *  @param itemsPerIteration Number of items processed per iteration.
+         */
+        void report(const char* name, uint64_t itemsPerIteration = 1) {
+            const uint64_t cycles = readCycles() - startCycles;
+            if (cycles > 0 && state.iterations() > 0) {
+                state.counters[name] = static_cast<double>(cycles) /
+                    static_cast<double>(state.iterations() * itemsPerIteration);
+            }
+        }
+};
+
+#endif // _BENCH_CYCLES_H_
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+
+# this script compares two sets of google benchmark json results,
+# e.g. the bench_results/ directories from two different commits.
+#
+# example usage: compare_bench.py old_results/ new_results/ --threshold 10
+#
+
+import argparse
+import json
+import pathlib
+
+
+def load_results(path):
+    """Returns a dict benchmark name -> cpu time in ns for a json file
+    or for all json files in a directory.
+    """
+
+    path = pathlib.Path(path)
+    files = sorted(path.glob("*.json")) if path.is_dir() else [path]
+
+    results = {}
+    for file in files:
+        with open(file) as json_file:
+            data = json.load(json_file)
+        for bench in data.get("benchmarks", []):
+            if bench.get("run_type", "iteration") != "iteration" or "error_occurred" in bench:
+                continue
+            unit = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[bench.get("time_unit", "ns")]
+            results[bench["name"]] = bench["cpu_time"] * unit
+    return results
+
+
+# --- main code
+
+parser = argparse.ArgumentParser(
+    prog="compare_bench",
+    description="Compares two google benchmark json results of the rc function controller benchmarks.",
+    epilog="Have fun",
+)
+parser.add_argument("old", help="Json file or directory with the baseline results")
+parser.add_argument("new", help="Json file or directory with the new results")
+parser.add_argument(
+    "--threshold",
+    "-t",
+    type=float,
+    default=10.0,
+    help="Slowdown in percent that counts as regression",
+)
+
+args = parser.parse_args()
+
+old = load_results(args.old)
+new = load_results(args.new)
+
+regressions = 0
+print(f"{'Benchmark':<40} {'old ns':>12} {'new ns':>12} {'change':>8}")
+for name in sorted(old.keys() | new.keys()):
+    if name not in old or name not in new:
+        print(f"{name:<40} {'only in ' + ('new' if name in new else 'old'):>34}")
+        continue
+
+    change = (new[name] - old[name]) / old[name] * 100.0 if old[name] else 0.0
+    marker = ""
+    if change > args.threshold:
+        marker = "  <- regression"
+        regressions += 1
+    print(f"{name:<40} {old[name]:>12.1f} {new[name]:>12.1f} {change:>+7.1f}%{marker}")
+
+if regressions:
+    exit(f"{regressions} regression(s) above {args.threshold}%")
@@ -0,0 +1,106 @@
+/** Benchmarks for the engine simulation.
+ *
+ *  Covers the power curve lookup (Curve and UniformCurve) and one simulation step
+ *  of the gear engine.
+ */
+
+#include "bench_cycles.h"
+#include "curve.h"
+#include "engine_gear.h"
+#include "power_curves.h"
+#include "signals.h"
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstdint>
+
+using namespace rcEngine;
+using namespace rcSignals;
+
+namespace {
+
+/** Number of lookups per iteration. */
+static constexpr size_t NUM_LOOKUPS = 256u;
+
+/** Creates the curve inputs, covering the whole curve and a bit outside. */
+static std::array<float, NUM_LOOKUPS> createInputs() {
+    std::array<float, NUM_LOOKUPS> inputs;
+    for (size_t i = 0u; i < inputs.size(); i++) {
+        inputs[i] = -0.1f + 1.2f * static_cast<float>((i * 37u) % NUM_LOOKUPS) / NUM_LOOKUPS;
+    }
+    return inputs;
+}
+
+/** Maps the inputs with a Curve or a UniformCurve. */
+template<typename CurveType>
+static void mapCurve(benchmark::State& state, const CurveType& curve) {
+    const auto inputs = createInputs();
+
+    std::array<float, NUM_LOOKUPS> outputs;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        for (size_t i = 0u; i < inputs.size(); i++) {
+            outputs[i] = curve.map(inputs[i]);
+        }
+        benchmark::DoNotOptimize(outputs.data());
+        benchmark::ClobberMemory();
+    }
+    cycles.report("cycles_per_map", NUM_LOOKUPS);
+    state.SetItemsProcessed(state.iterations() * NUM_LOOKUPS);
+}
+
+} // namespace
+
+/** Maps the inputs with the shortest power curve. */
+static void BM_CurveMap4(benchmark::State& state) {
+    mapCurve(state, powerCurveElectric);
+}
+BENCHMARK(BM_CurveMap4);
+
+/** Maps the inputs with the longest power curve. */
+static void BM_CurveMap8(benchmark::State& state) {
+    mapCurve(state, powerCurvePetrol);
+}
+BENCHMARK(BM_CurveMap8);
+
+/** Maps the inputs with the lookup table of the shortest power curve. */
+static void BM_UniformCurveMap4(benchmark::State& state) {
+    mapCurve(state, powerLutElectric);
+}
+BENCHMARK(BM_UniformCurveMap4);
+
+/** Maps the inputs with the lookup table of the longest power curve. */
+static void BM_UniformCurveMap8(benchmark::State& state) {
+    mapCurve(state, powerLutPetrol);
+}
+BENCHMARK(BM_UniformCurveMap8);
+
+/** One 20ms step of a running EngineGear with changing throttle. */
+static void BM_EngineGearStep(benchmark::State& state) {
+    EngineGear engine;
+    engine.start();
+
+    Signals signals;
+    rcProc::StepInfo info = {
+        .deltaMs = 20u,
+        .signals = &signals,
+        .intervals = {
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr},
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+    };
+
+    RcSignal speed = 0;
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        signals.reset();
+        signals[SignalType::ST_IGNITION] = RCSIGNAL_TRUE;
+        signals[SignalType::ST_SPEED] = speed;
+        speed = (speed + 3) % RCSIGNAL_MAX;
+
+        engine.step(info);
+        benchmark::DoNotOptimize(signals);
+    }
+    cycles.report("cycles_per_step");
+}
+BENCHMARK(BM_EngineGearStep);
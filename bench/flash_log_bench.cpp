@@ -0,0 +1,156 @@
+/** Benchmarks for replacing one dynamic sample in the flash.
+ *
+ *  A library of 30 samples (one or two sectors each) is stored in the
+ *  host flash, then one sample after another is replaced:
+ *
+ *  - reset: the whole library is removed and uploaded again
+ *    (the only way to replace a sample before the log layout)
+ *  - log: only the new version is appended
+ *
+ *  Reports the erased sectors, the uploaded bytes and the simulated
+ *  upload time per replaced sample and the wear of the most erased sector.
+ */
+
+#include "bench_cycles.h"
+#include "flash_sample.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace FlashSample;
+
+namespace {
+
+constexpr uint32_t NUM_SAMPLES = 30u;
+constexpr uint32_t CHUNK_SIZE = 220u;  // like samples.js
+
+/** Throughput of the windowed upload, see upload_bench. */
+constexpr double LINK_BYTES_PER_S = 35000.0;
+
+/** Typical ESP32 flash timings. */
+constexpr double ERASE_SECTOR_S = 0.045;
+constexpr double WRITE_SECTOR_S = 0.011;
+
+rcSamples::AudioId sampleId(uint32_t i) {
+    return {'s', static_cast<char>('a' + i / 26u), static_cast<char>('a' + i % 26u)};
+}
+
+uint32_t sampleSize(uint32_t i) {
+    return 3000u + (i % 3u) * 2000u;
+}
+
+/** Uploads the sample in chunks. @returns the uploaded bytes. */
+uint32_t upload(SampleStorage& storage, uint32_t i) {
+    const auto id = sampleId(i);
+    const uint32_t size = sampleSize(i);
+    std::vector<uint8_t> data(size);
+    for (uint32_t j = 0u; j < size; j++) {
+        data[j] = static_cast<uint8_t>(j * 5u + i);
+    }
+
+    if (!storage.addId(id, size)) {
+        return 0u;
+    }
+    for (uint32_t offset = 0u; offset < size; offset += CHUNK_SIZE) {
+        storage.setData(id, offset, std::span<const uint8_t>(data).subspan(
+            offset, std::min(CHUNK_SIZE, size - offset)));
+    }
+    return size;
+}
+
+void uploadAll(SampleStorage& storage) {
+    for (uint32_t i = 0u; i < NUM_SAMPLES; i++) {
+        upload(storage, i);
+    }
+    FlashSingleton::getInstance().flush();
+}
+
+std::vector<uint32_t> eraseCounts() {
+    const auto& flash = FlashSingleton::getInstance();
+    std::vector<uint32_t> counts(flash.getMaxSectors());
+    for (uint16_t i = 0u; i < counts.size(); i++) {
+        counts[i] = flash.getEraseCount(i);
+    }
+    return counts;
+}
+
+void report(benchmark::State& state, const SampleStorage& storage, uint64_t bytes,
+    const std::vector<uint32_t>& countsBefore) {
+
+    const auto& flash = FlashSingleton::getInstance();
+    const auto& stats = flash.getStatistics();
+    const double replaced = static_cast<double>(state.iterations());
+
+    const auto counts = eraseCounts();
+    uint32_t maxErases = 0u;
+    for (size_t i = 0u; i < counts.size(); i++) {
+        maxErases = std::max(maxErases, counts[i] - countsBefore[i]);
+    }
+
+    const double uploadS = static_cast<double>(bytes) / LINK_BYTES_PER_S +
+        stats.sectorsErased * ERASE_SECTOR_S + stats.sectorsWritten * WRITE_SECTOR_S;
+
+    state.counters["erased_sectors"] = stats.sectorsErased / replaced;
+    state.counters["uploaded_bytes"] = static_cast<double>(bytes) / replaced;
+    state.counters["sim_upload_ms"] = uploadS * 1000.0 / replaced;
+    state.counters["max_sector_erases"] = maxErases / replaced;
+    state.counters["samples"] = static_cast<double>(storage.getFiles().size());
+}
+
+} // namespace
+
+/** Replaces a sample by removing and uploading the whole library. */
+static void BM_ReplaceByReset(benchmark::State& state) {
+    auto& flash = FlashSingleton::getInstance();
+    SampleStorage storage;
+    storage.reset();
+    uploadAll(storage);
+
+    const auto countsBefore = eraseCounts();
+    flash.resetStatistics();
+    uint64_t bytes = 0u;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        storage.reset();
+        for (uint32_t i = 0u; i < NUM_SAMPLES; i++) {
+            bytes += upload(storage, i);
+        }
+        flash.flush();
+    }
+    cycles.report("cycles_per_replace");
+    report(state, storage, bytes, countsBefore);
+    storage.reset();
+}
+BENCHMARK(BM_ReplaceByReset);
+
+/** Replaces one sample after the other with a new version in the log. */
+static void BM_ReplaceLog(benchmark::State& state) {
+    auto& flash = FlashSingleton::getInstance();
+    SampleStorage storage;
+    storage.reset();
+    uploadAll(storage);
+
+    const auto countsBefore = eraseCounts();
+    flash.resetStatistics();
+    uint64_t bytes = 0u;
+    uint32_t next = 0u;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        // like the audio writer task: compact and upload again if it doesn't fit
+        uint32_t uploaded = upload(storage, next);
+        while (uploaded == 0u && storage.compact()) {
+            uploaded = upload(storage, next);
+        }
+        bytes += uploaded;
+        flash.flush();
+        next = (next + 7u) % NUM_SAMPLES;
+    }
+    cycles.report("cycles_per_replace");
+    report(state, storage, bytes, countsBefore);
+    storage.reset();
+}
+BENCHMARK(BM_ReplaceLog);
@@ -0,0 +1,53 @@
+/** Benchmarks for stepping the procs of a configuration.
+ *
+ *  Compares the virtual step() calls with the step pipelines
+ *  (see ProcStorage::setPipeline()).
+ *  See bench_configs.h for the configurations.
+ */
+
+#include "bench_configs.h"
+#include "bench_cycles.h"
+#include "proc.h"
+#include "proc_storage.h"
+#include "signals.h"
+#include "simple_byte_stream.h"
+
+#include <benchmark/benchmark.h>
+
+/** Steps the configuration state.range(0) with the pipeline on (state.range(1) == 1) or off. */
+static void BM_ProcStorageStep(benchmark::State& state) {
+    const auto& name = CONFIG_NAMES[state.range(0)];
+    const auto& data = loadConfig(name);
+    if (data.empty()) {
+        state.SkipWithError("configuration not found");
+        return;
+    }
+
+    ProcStorage storage;
+    SimpleInStream in(data);
+    storage.deserialize(in);
+    storage.setPipeline(state.range(1) != 0);
+    storage.start();
+
+    rcSignals::Signals signals;
+    signals.reset();
+    rcProc::StepInfo info = {
+        .deltaMs = 20u,
+        .signals = &signals,
+        .intervals = {
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr},
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+    };
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        storage.step(info);
+        benchmark::DoNotOptimize(signals);
+    }
+    cycles.report("cycles_per_step");
+    storage.stop();
+    state.SetLabel(name + (state.range(1) ? " pipeline" : " virtual"));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcStorageStep)->ArgsProduct({
+    benchmark::CreateDenseRange(0, CONFIG_NAMES.size() - 1, 1), {0, 1}});
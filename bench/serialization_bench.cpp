@@ -0,0 +1,168 @@
+/** Benchmarks for the configuration and sample handling.
+ *
+ *  See bench_configs.h for the configurations.
+ */
+
+#include "bench_configs.h"
+#include "bench_cycles.h"
+#include "proc_storage.h"
+#include "sample.h"
+#include "sample_index.h"
+#include "simple_byte_stream.h"
+#include "wav_sample.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+/** A sample list with num samples of 16 bytes each. */
+struct SampleList {
+    std::vector<uint8_t> content;
+    std::vector<rcSamples::SampleFile> files;
+
+    explicit SampleList(size_t num) :
+        content(num * 16u) {
+        for (size_t i = 0; i < num; i++) {
+            files.push_back(rcSamples::SampleFile{
+                .id = {static_cast<char>('A' + i % 26), static_cast<char>('a' + (i / 26) % 26),
+                    static_cast<char>('0' + i / 676)},
+                .content = std::span<const uint8_t>(content.data() + i * 16u, 16u)});
+        }
+    }
+};
+
+} // namespace
+
+/** Serializes the configuration state.range(0). */
+static void BM_ProcStorageSerialize(benchmark::State& state) {
+    const auto& name = CONFIG_NAMES[state.range(0)];
+    const auto& data = loadConfig(name);
+    if (data.empty()) {
+        state.SkipWithError("configuration not found");
+        return;
+    }
+
+    ProcStorage storage;
+    SimpleInStream in(data);
+    storage.deserialize(in);
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        SimpleOutStream out;
+        storage.serialize(out);
+        benchmark::DoNotOptimize(out.buffer().data());
+        free(out.buffer().data());
+    }
+    cycles.report("cycles_per_config");
+    state.SetLabel(name);
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ProcStorageSerialize)->DenseRange(0, CONFIG_NAMES.size() - 1);
+
+/** Deserializes the configuration state.range(0), replacing the old procs. */
+static void BM_ProcStorageDeserialize(benchmark::State& state) {
+    const auto& name = CONFIG_NAMES[state.range(0)];
+    const auto& data = loadConfig(name);
+    if (data.empty()) {
+        state.SkipWithError("configuration not found");
+        return;
+    }
+
+    ProcStorage storage;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        SimpleInStream in(data);
+        benchmark::DoNotOptimize(storage.deserialize(in));
+    }
+    cycles.report("cycles_per_config");
+    state.SetLabel(name);
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ProcStorageDeserialize)->DenseRange(0, CONFIG_NAMES.size() - 1);
+
+/** Parses the wav headers of all static samples. */
+static void BM_GetWavSamples(benchmark::State& state) {
+    const auto& files = rcSamples::getStaticSamples();
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        for (const auto& file : files) {
+            benchmark::DoNotOptimize(getWavSamples(file.content).data());
+        }
+    }
+    cycles.report("cycles_per_sample", files.size());
+    state.SetItemsProcessed(state.iterations() * files.size());
+}
+BENCHMARK(BM_GetWavSamples);
+
+/** Looks up every sample of a list with state.range(0) samples by
+ *  id and by data pointer with a linear search (as SampleStorageSingleton
+ *  did before the SampleIndex).
+ */
+static void BM_SampleLookupLinear(benchmark::State& state) {
+    const SampleList list(state.range(0));
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        for (const auto& file : list.files) {
+            for (size_t i = 0; i < list.files.size(); i++) {
+                if (list.files[i].id == file.id) {
+                    benchmark::DoNotOptimize(i);
+                    break;
+                }
+            }
+            for (size_t i = 0; i < list.files.size(); i++) {
+                if (list.files[i].content.data() == file.content.data()) {
+                    benchmark::DoNotOptimize(i);
+                    break;
+                }
+            }
+        }
+    }
+    cycles.report("cycles_per_sample", list.files.size());
+    state.SetItemsProcessed(state.iterations() * list.files.size());
+}
+BENCHMARK(BM_SampleLookupLinear)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+
+/** Like BM_SampleLookupLinear but with the SampleIndex. */
+static void BM_SampleLookupIndex(benchmark::State& state) {
+    const SampleList list(state.range(0));
+    SampleIndex index;
+    index.reset(list.files.size());
+    for (size_t i = 0; i < list.files.size(); i++) {
+        index.add(list.files[i].id, list.files[i].content.data(), i);
+    }
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        for (const auto& file : list.files) {
+            benchmark::DoNotOptimize(index.find(file.id));
+            benchmark::DoNotOptimize(index.find(file.content.data()));
+        }
+    }
+    cycles.report("cycles_per_sample", list.files.size());
+    state.SetItemsProcessed(state.iterations() * list.files.size());
+}
+BENCHMARK(BM_SampleLookupIndex)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+
+/** Rebuilds the SampleIndex for state.range(0) samples (done when the dynamic samples change). */
+static void BM_SampleIndexRebuild(benchmark::State& state) {
+    const SampleList list(state.range(0));
+    SampleIndex index;
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        index.reset(list.files.size());
+        for (size_t i = 0; i < list.files.size(); i++) {
+            index.add(list.files[i].id, list.files[i].content.data(), i);
+        }
+        benchmark::DoNotOptimize(index.size());
+    }
+    cycles.report("cycles_per_sample", list.files.size());
+    state.SetItemsProcessed(state.iterations() * list.files.size());
+}
+BENCHMARK(BM_SampleIndexRebuild)->Arg(16)->Arg(256)->Arg(1024);
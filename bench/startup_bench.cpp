@@ -0,0 +1,229 @@
+/** Benchmarks for finding the sample data when starting.
+ *
+ *  Before the pipeline starts, every proc of the configuration looks up
+ *  its samples. Compared are:
+ *
+ *  - eager: the WAV headers of all static samples are parsed
+ *    (what the SampleStorageSingleton constructor did before)
+ *  - lazy: only the samples referenced by the default configuration
+ *    are resolved, once by parsing the header, once with the SampleInfo
+ *    generated by audio_tool.py
+ *  - dynamic: the same for uploaded samples read from the flash
+ *
+ *  Reports the host cycles, the resolved samples and the heap
+ *  allocations per start (counted by the operator new below).
+ */
+
+#include "bench_cycles.h"
+#include "flash_sample.h"
+#include "proc_storage.h"
+#include "sample_list.h"
+#include "sample_storage_singleton.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+
+/** Heap statistics of the counting operator new below. */
+struct HeapCounter {
+    size_t bytes = 0u;  ///< currently allocated bytes
+    size_t peakBytes = 0u;
+    size_t numNew = 0u;  ///< calls to operator new
+};
+
+HeapCounter heapCounter;
+
+/** Header in front of every allocation to remember the size. */
+struct alignas(std::max_align_t) BlockHeader {
+    size_t size;
+};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    auto header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+    if (header == nullptr) {
+        throw std::bad_alloc();
+    }
+    header->size = size;
+
+    heapCounter.numNew++;
+    heapCounter.bytes += size;
+    heapCounter.peakBytes = std::max(heapCounter.peakBytes, heapCounter.bytes);
+    return header + 1;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    auto header = static_cast<BlockHeader*>(ptr) - 1;
+    heapCounter.bytes -= header->size;
+    std::free(header);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace {
+
+constexpr uint32_t NUM_DYNAMIC = 20u;
+constexpr uint32_t DYNAMIC_SIZE = 6000u;
+
+/** The static samples as they were before audio_tool.py added the SampleInfo. */
+const std::vector<rcSamples::SampleFile>& filesWithoutInfo() {
+    static std::vector<rcSamples::SampleFile> files;
+    if (files.empty()) {
+        for (const auto& file : rcSamples::getStaticSamples()) {
+            files.push_back(rcSamples::SampleFile{.id = file.id, .content = file.content});
+        }
+    }
+    return files;
+}
+
+/** The static samples used by the default configuration. */
+const std::vector<rcSamples::AudioId>& referencedIds() {
+    static std::vector<rcSamples::AudioId> ids;
+    if (ids.empty()) {
+        ProcStorage storage;  // looks up the samples of the default procs
+        const auto& list = SampleStorageSingleton::getInstance().getStaticList();
+        for (uint16_t i = 0u; i < list.size(); i++) {
+            if (list.isResolved(i)) {
+                ids.push_back(list.getFile(i).id);
+            }
+        }
+    }
+    return ids;
+}
+
+/** Resolves the samples like the procs do. */
+void lookUp(const SampleList& list, const std::vector<rcSamples::AudioId>& ids) {
+    for (const auto& id : ids) {
+        const uint16_t index = list.find(id);
+        if (index != SampleIndex::NOT_FOUND) {
+            benchmark::DoNotOptimize(list.getData(index).size());
+        }
+    }
+}
+
+/** Measures the heap use of one start. */
+class HeapProbe {
+    private:
+        size_t startBytes;
+        size_t startNew;
+
+    public:
+        HeapProbe() :
+            startBytes(heapCounter.bytes),
+            startNew(heapCounter.numNew) {
+            heapCounter.peakBytes = heapCounter.bytes;
+        }
+
+        void report(benchmark::State& state, const SampleList& list) const {
+            state.counters["heap_peak_bytes"] = static_cast<double>(heapCounter.peakBytes - startBytes);
+            state.counters["heap_allocs"] = static_cast<double>(heapCounter.numNew - startNew);
+            state.counters["resolved"] = list.getNumResolved();
+            state.counters["samples"] = static_cast<double>(list.size());
+        }
+};
+
+/** Starts with the given files, resolving all or only the ids.
+ *  The heap is measured during an extra start.
+ */
+void runStart(benchmark::State& state, std::span<const rcSamples::SampleFile> files,
+    const std::vector<rcSamples::AudioId>& ids, bool eager) {
+
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        SampleList list;
+        list.reset(files);
+        if (eager) {
+            list.resolveAll();
+        } else {
+            lookUp(list, ids);
+        }
+        benchmark::DoNotOptimize(list.getNumResolved());
+    }
+    cycles.report("cycles_per_start");
+
+    HeapProbe probe;
+    SampleList list;
+    list.reset(files);
+    if (eager) {
+        list.resolveAll();
+    } else {
+        lookUp(list, ids);
+    }
+    probe.report(state, list);
+}
+
+/** Uploads raw WAV files (stored as they are, so the header has to be parsed). */
+void uploadDynamic(FlashSample::SampleStorage& storage) {
+    storage.reset();
+    for (uint32_t i = 0u; i < NUM_DYNAMIC; i++) {
+        std::vector<uint8_t> wav = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+            'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0, 0x22, 0x56, 0, 0, 0x22, 0x56, 0, 0, 1, 0, 8, 0,
+            'L', 'I', 'S', 'T', 4, 0, 0, 0, 'I', 'N', 'F', 'O',
+            'd', 'a', 't', 'a', 0, 0, 0, 0};
+        const uint32_t dataSize = DYNAMIC_SIZE - wav.size();
+        wav[wav.size() - 4u] = static_cast<uint8_t>(dataSize);
+        wav[wav.size() - 3u] = static_cast<uint8_t>(dataSize >> 8);
+        wav.resize(DYNAMIC_SIZE, 0x80u);
+
+        const rcSamples::AudioId id = {'d', static_cast<char>('a' + i / 10u), static_cast<char>('0' + i % 10u)};
+        storage.addId(id, DYNAMIC_SIZE);
+        storage.setData(id, 0u, wav);
+    }
+    storage.flush();
+}
+
+} // namespace
+
+/** All WAV headers parsed when starting (the old way). */
+static void BM_StartupEager(benchmark::State& state) {
+    runStart(state, filesWithoutInfo(), referencedIds(), true);
+}
+BENCHMARK(BM_StartupEager);
+
+/** Only the referenced samples, the WAV headers are parsed. */
+static void BM_StartupLazyParse(benchmark::State& state) {
+    runStart(state, filesWithoutInfo(), referencedIds(), false);
+}
+BENCHMARK(BM_StartupLazyParse);
+
+/** Only the referenced samples with the precomputed SampleInfo. */
+static void BM_StartupLazyInfo(benchmark::State& state) {
+    runStart(state, rcSamples::getStaticSamples(), referencedIds(), false);
+}
+BENCHMARK(BM_StartupLazyInfo);
+
+/** Reading the dynamic samples from the flash: all (arg 1) or only two of them (arg 0). */
+static void BM_StartupDynamic(benchmark::State& state) {
+    const bool eager = state.range(0) != 0;
+    FlashSample::SampleStorage storage;
+    uploadDynamic(storage);
+    const auto files = storage.getFiles();
+    const std::vector<rcSamples::AudioId> ids = {files.front().id, files.back().id};
+
+    runStart(state, files, ids, eager);
+    storage.reset();
+}
+BENCHMARK(BM_StartupDynamic)->Arg(1)->Arg(0);
@@ -0,0 +1,303 @@
+/** Benchmarks for the sample upload via bluetooth.
+ *
+ *  The bluetooth link, the receive queue and the task receiving the
+ *  audio commands are simulated, the commands are executed by the real
+ *  SampleStorageSingleton (writing to the host flash).
+ *
+ *  - stop and wait: every chunk is a write with response into a queue
+ *    with one entry that the main task empties every 20 ms.
+ *    A full queue is answered with an error and the client retries after 200 ms.
+ *  - windowed: a window of chunks is written without response into a
+ *    deeper queue drained by the audio writer task, then the acknowledge
+ *    is read. Chunks dropped by a full queue are sent again.
+ *
+ *  Reports the simulated throughput and the host cycles per chunk.
+ */
+
+#include "bench_cycles.h"
+#include "crc16.h"
+#include "flash_sample.h"
+#include "sample_storage_singleton.h"
+#include "simple_byte_stream.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t SAMPLE_SIZE = 24u * 1024u;
+constexpr uint32_t CHUNK_SIZE = 220u;  // like samples.js
+constexpr uint32_t NUM_CHUNKS = (SAMPLE_SIZE + CHUNK_SIZE - 1u) / CHUNK_SIZE;
+
+/** Connection interval, as negotiated by most browsers. */
+constexpr uint64_t INTERVAL_US = 15000u;
+
+/** Packets per connection event for writes without response. */
+constexpr uint32_t PACKETS_PER_EVENT = 4u;
+
+constexpr uint64_t MAIN_TASK_US = 20000u;
+constexpr uint64_t RETRY_US = 200000u;  // see uploadAudio() in bluetooth.js
+
+/** Typical ESP32 flash timings. */
+constexpr uint64_t ERASE_SECTOR_US = 45000u;
+constexpr uint64_t WRITE_SECTOR_US = 11000u;
+
+/** The sample data sent by the client. */
+const std::vector<uint8_t>& sampleData() {
+    static std::vector<uint8_t> data;
+    if (data.empty()) {
+        data.resize(SAMPLE_SIZE);
+        for (uint32_t i = 0u; i < SAMPLE_SIZE; i++) {
+            data[i] = static_cast<uint8_t>(i * 13u + (i >> 7));
+        }
+    }
+    return data;
+}
+
+void appendUint16(std::vector<uint8_t>& buf, uint16_t value) {
+    buf.push_back(static_cast<uint8_t>(value >> 8));
+    buf.push_back(static_cast<uint8_t>(value));
+}
+
+void appendUint32(std::vector<uint8_t>& buf, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        buf.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+std::vector<uint8_t> addCommand() {
+    std::vector<uint8_t> buf = {'R', 'A', 1, 0x01u, 'u', 'p', 'l'};
+    appendUint32(buf, SAMPLE_SIZE);
+    return buf;
+}
+
+std::vector<uint8_t> chunkCommand(uint32_t chunk, bool sequenced) {
+    const auto& data = sampleData();
+    const uint32_t offset = chunk * CHUNK_SIZE;
+    const uint32_t size = std::min(CHUNK_SIZE, SAMPLE_SIZE - offset);
+    std::span<const uint8_t> part(data.data() + offset, size);
+
+    std::vector<uint8_t> buf = {'R', 'A', 1,
+        sequenced ? static_cast<uint8_t>(0x03u) : static_cast<uint8_t>(0x02u),
+        'u', 'p', 'l'};
+    if (sequenced) {
+        appendUint16(buf, static_cast<uint16_t>(chunk));
+    }
+    appendUint32(buf, offset);
+    appendUint32(buf, size);
+    if (sequenced) {
+        appendUint16(buf, crc16le(UINT16_MAX, part));
+    }
+    buf.insert(buf.end(), part.begin(), part.end());
+    return buf;
+}
+
+/** The next connection event at or after the time. */
+uint64_t nextEvent(uint64_t timeUs) {
+    return (timeUs + INTERVAL_US - 1u) / INTERVAL_US * INTERVAL_US;
+}
+
+/** The receive queue and the task executing the audio commands. */
+class Receiver {
+    private:
+        struct Entry {
+            uint64_t arrivalUs;
+            std::vector<uint8_t> command;
+        };
+
+        std::deque<Entry> queue;
+        size_t depth;
+
+        /** The main task only looks at the queue every 20 ms. */
+        bool ticked;
+
+        uint64_t busyUntilUs;
+
+        /** When the next queue entry is taken out by the task. */
+        uint64_t startOf(const Entry& entry) const {
+            const uint64_t start = std::max(entry.arrivalUs, busyUntilUs);
+            if (!ticked) {
+                return start;
+            }
+            return (start + MAIN_TASK_US - 1u) / MAIN_TASK_US * MAIN_TASK_US;
+        }
+
+    public:
+        Receiver(size_t depthVal, bool tickedVal) :
+            depth(depthVal),
+            ticked(tickedVal),
+            busyUntilUs(0u) {
+        }
+
+        /** Executes all commands the task started until the time. */
+        void runUntil(uint64_t timeUs) {
+            auto& ss = SampleStorageSingleton::getInstance();
+            auto& flash = FlashSample::FlashSingleton::getInstance();
+            while (!queue.empty() && startOf(queue.front()) <= timeUs) {
+                const uint64_t start = startOf(queue.front());
+                const auto before = flash.getStatistics();
+
+                SimpleInStream in(queue.front().command);
+                ss.executeCommand(in);
+                queue.pop_front();
+
+                const auto& after = flash.getStatistics();
+                busyUntilUs = start +
+                    (after.sectorsErased - before.sectorsErased) * ERASE_SECTOR_US +
+                    (after.sectorsWritten - before.sectorsWritten) * WRITE_SECTOR_US;
+            }
+        }
+
+        /** Called by the bluetooth stack. @returns false if the queue is full. */
+        bool receive(uint64_t timeUs, std::vector<uint8_t> command) {
+            runUntil(timeUs);
+            if (queue.size() >= depth) {
+                return false;
+            }
+            queue.push_back(Entry{.arrivalUs = timeUs, .command = std::move(command)});
+            return true;
+        }
+};
+
+/** The result of a simulated upload. */
+struct Upload {
+    uint64_t timeUs = 0u;
+    uint32_t resends = 0u;  ///< chunks sent more than once
+};
+
+void resetStorage() {
+    const std::vector<uint8_t> reset = {'R', 'A', 1, 0x00u};
+    SimpleInStream in(reset);
+    SampleStorageSingleton::getInstance().executeCommand(in);
+    FlashSample::FlashSingleton::getInstance().flush();
+}
+
+/** Every chunk waits for the write response (the old upload). */
+Upload uploadStopAndWait() {
+    Receiver receiver(1u, true);
+    Upload upload;
+
+    uint64_t now = 0u;
+    for (uint32_t chunk = 0u; chunk <= NUM_CHUNKS; chunk++) {
+        const auto command = (chunk == 0u) ? addCommand() : chunkCommand(chunk - 1u, false);
+        for (;;) {
+            const uint64_t request = nextEvent(now);
+            const bool accepted = receiver.receive(request, command);
+            now = request + INTERVAL_US;  // the response in the next event
+            if (accepted) {
+                break;
+            }
+            now += RETRY_US;
+            upload.resends++;
+        }
+    }
+    receiver.runUntil(UINT64_MAX);
+    upload.timeUs = now;
+    return upload;
+}
+
+/** Sends a window of chunks without response and reads the
+ *  acknowledge (like uploadSample() in samples.js).
+ */
+Upload uploadWindowed(size_t depth) {
+    constexpr uint32_t MAX_STALLS = 5u;
+
+    auto& ss = SampleStorageSingleton::getInstance();
+    Receiver receiver(depth, false);
+    Upload upload;
+
+    // "new sample" with response
+    uint64_t now = nextEvent(0u);
+    receiver.receive(now, addCommand());
+    now += INTERVAL_US;
+
+    uint32_t acked = 0u;
+    uint32_t sent = 0u;
+    uint32_t stalls = 0u;
+    uint32_t maxSent = 0u;
+    while (acked < NUM_CHUNKS) {
+        // the writes of one window
+        uint64_t event = nextEvent(now);
+        uint32_t packets = 0u;
+        while (sent < NUM_CHUNKS && sent - acked < depth) {
+            if (packets == PACKETS_PER_EVENT) {
+                event += INTERVAL_US;
+                packets = 0u;
+            }
+            receiver.receive(event, chunkCommand(sent, true));
+            if (sent < maxSent) {
+                upload.resends++;
+            }
+            sent++;
+            maxSent = std::max(maxSent, sent);
+            packets++;
+        }
+
+        // read request in the next event, the response one later
+        now = event + 2u * INTERVAL_US;
+        receiver.runUntil(now);
+        std::array<uint8_t, 16> buf;
+        SimpleOutStream out(buf);
+        ss.serializeAck(out, static_cast<uint8_t>(depth));
+        SimpleInStream in(std::span<const uint8_t>(buf.data(), out.tellg()));
+        in.read<uint8_t>();
+        in.read<uint8_t>();
+        in.read<uint8_t>();
+        in.read<rcSamples::AudioId>();
+        const uint16_t seq = in.read<uint16_t>();
+
+        const uint32_t progress = static_cast<uint16_t>(seq - acked);
+        if (progress > 0u && progress <= sent - acked) {
+            acked += progress;
+            stalls = 0u;
+        } else if (++stalls >= MAX_STALLS) {
+            sent = acked;
+            stalls = 0u;
+        }
+    }
+    receiver.runUntil(UINT64_MAX);
+    upload.timeUs = now;
+    return upload;
+}
+
+void reportUpload(benchmark::State& state, const Upload& upload) {
+    state.counters["sim_ms"] = static_cast<double>(upload.timeUs) / 1000.0;
+    state.counters["sim_kbytes_per_s"] =
+        static_cast<double>(SAMPLE_SIZE) / 1024.0 /
+        (static_cast<double>(upload.timeUs) / 1000000.0);
+    state.counters["resends"] = upload.resends;
+}
+
+} // namespace
+
+/** The old upload: write with response into a queue with one entry. */
+static void BM_UploadStopAndWait(benchmark::State& state) {
+    Upload upload;
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        resetStorage();
+        upload = uploadStopAndWait();
+    }
+    cycles.report("cycles_per_chunk", NUM_CHUNKS);
+    reportUpload(state, upload);
+    resetStorage();
+}
+BENCHMARK(BM_UploadStopAndWait);
+
+/** The sequenced upload with a queue of state.range(0) entries. */
+static void BM_UploadWindowed(benchmark::State& state) {
+    Upload upload;
+    CycleCounter cycles(state);
+    for (auto _ : state) {
+        resetStorage();
+        upload = uploadWindowed(static_cast<size_t>(state.range(0)));
+    }
+    cycles.report("cycles_per_chunk", NUM_CHUNKS);
+    reportUpload(state, upload);
+    resetStorage();
+}
+BENCHMARK(BM_UploadWindowed)->Arg(1)->Arg(4)->Arg(16)->Arg(32);
@@ -8,6 +8,7 @@
 #define _RC_AUDIO_H_
 
 #include "proc.h"
+#include <algorithm>
 #include <cstdint>
 #include <array>
 #include <span>
@@ -17,7 +18,99 @@ namespace rcAudio {
 
 static constexpr uint32_t SAMPLE_RATE = 22050; // fixed sample rate for audio
 
-typedef std::span<const uint8_t> SampleData;
+/** The data of an audio sample.
+ *
+ *  Either unsigned 8 bit PCM samples (the data chunk of the WAV
+ *  file) or IMA-ADPCM blocks (4 bit per sample).
+ *
+ *  Every ADPCM block starts with the full 16 bit sample and the
+ *  step index, so decoding can restart at every block.
+ *  Use a SampleReader (audio_adpcm.h) to access the samples
+ *  independent of the format.
+ */
+class SampleData {
+    private:
+        std::span<const uint8_t> bytes;
+        uint32_t numSamples;
+
+        /** Bytes per ADPCM block, 0 for PCM. */
+        uint16_t blockSize;
+
+    public:
+        SampleData() :
+            bytes(),
+            numSamples(0u),
+            blockSize(0u) {
+        }
+
+        /** Unsigned 8 bit PCM samples. */
+        SampleData(std::span<const uint8_t> pcm) :
+            bytes(pcm),
+            numSamples(pcm.size()),
+            blockSize(0u) {
+        }
+
+        SampleData(const uint8_t* pcm, size_t size) :
+            SampleData(std::span<const uint8_t>(pcm, size)) {
+        }
+
+        /** IMA-ADPCM blocks (mono, 4 bit) with the given block size. */
+        static SampleData adpcm(std::span<const uint8_t> blocks, uint16_t blockSizeVal,
+                                uint32_t numSamplesVal) {
+            SampleData result(blocks);
+            result.numSamples = numSamplesVal;
+            result.blockSize = blockSizeVal;
+            return result;
+        }
+
+        /** Number of samples (not bytes). */
+        size_t size() const {
+            return numSamples;
+        }
+
+        bool empty() const {
+            return numSamples == 0u;
+        }
+
+        /** The (encoded) data, also used to identify the sample. */
+        const uint8_t* data() const {
+            return bytes.data();
+        }
+
+        std::span<const uint8_t> getBytes() const {
+            return bytes;
+        }
+
+        bool isAdpcm() const {
+            return blockSize != 0u;
+        }
+
+        uint16_t getBlockSize() const {
+            return blockSize;
+        }
+
+        /** Returns a PCM sample. Not valid for ADPCM data. */
+        uint8_t operator[](size_t index) const {
+            return bytes[index];
+        }
+
+        /** Points the sample to a copy of its data, e.g. after it was moved in the flash.
+         *
+         *  @param from The copied bytes (containing the sample).
+         *  @param to The start of the copy.
+         *  @returns false if the sample is not inside from (and not changed).
+         */
+        bool relocate(std::span<const uint8_t> from, const uint8_t* to) {
+            // pointers into different arrays can't be compared directly
+            const auto address = reinterpret_cast<uintptr_t>(bytes.data());
+            const auto begin = reinterpret_cast<uintptr_t>(from.data());
+            if (bytes.empty() || address < begin || address - begin >= from.size()) {
+                return false;
+            }
+            bytes = std::span<const uint8_t>(to + (address - begin), bytes.size());
+            return true;
+        }
+};
 
 /** Volume type for audio volume.
  *
@@ -37,6 +130,26 @@ public:
     }
 };
 
+/** Fixed-point gain in Q15 format.
+ *
+ *  GAIN_Q15_ONE corresponds to a volume of 1.0.
+ *  The type is 32 bit wide so that gains above 1.0
+ *  are possible.
+ */
+typedef int32_t GainQ15;
+
+static constexpr GainQ15 GAIN_Q15_ONE = 1 << 15;
+
+/** Converts a float volume into a Q15 gain (rounded). */
+constexpr GainQ15 toGainQ15(float value) {
+    return static_cast<GainQ15>(value * GAIN_Q15_ONE + (value < 0.0f ? -0.5f : 0.5f));
+}
+
+/** Saturates an accumulated value to the range of an audio sample channel. */
+constexpr int16_t saturate16(int32_t value) {
+    return static_cast<int16_t>(std::clamp<int32_t>(value, INT16_MIN, INT16_MAX));
+}
+
 /** Base class for audios
  *
  *  Abstract base class for audio.
@@ -73,8 +186,42 @@ protected:
         samplePos->channel2 += sampleData * volume[1].value;
     }
 
+    /** Returns the Q15 gains for both channels.
+     *
+     *  The integer mixing functions should call this once per step
+     *  (or once per interval) and not once per sample.
+     *
+     *  @param dynamicVolume Volume multiplicator for the samples (e.g. 1.0f).
+     */
+    std::array<GainQ15, 2> getGains(const float dynamicVolume = 1.0f) const {
+        return {toGainQ15(volume[0].value * dynamicVolume),
+                toGainQ15(volume[1].value * dynamicVolume)};
+    }
+
+    /** Integer version of copySample().
+     *
+     *  The product is done in 32 bit and saturated once when
+     *  adding it to the target sample.
+     *
+     *  @param data The sample data straight out of the unsigned
+     *     8bit WAV file.
+     *  @param gains The Q15 gains from getGains().
+     */
+    static void mixSample(const uint8_t data, rcProc::AudioSample* samplePos,
+                          const std::array<GainQ15, 2>& gains) {
+        const int32_t sampleData = static_cast<int32_t>(data) - 128;
+        samplePos->channel1 = saturate16(samplePos->channel1 + ((sampleData * gains[0]) >> 15));
+        samplePos->channel2 = saturate16(samplePos->channel2 + ((sampleData * gains[1]) >> 15));
+    }
+
 public:
     virtual ~Audio() {}
+
+    /** Points the samples inside from to their copy at to, see SampleData::relocate().
+     *
+     *  The caller needs to make sure that the proc is not stepped at the same time.
+     */
+    virtual void relocateSamples(std::span<const uint8_t> /*from*/, const uint8_t* /*to*/) {}
 };
 
 
@@ -0,0 +1,238 @@
+/* RC engine functions controller for Arduino ESP32.
+ *
+ * IMA-ADPCM encoding and decoding of audio samples.
+ *
+ */
+
+#include "audio_adpcm.h"
+
+#include <algorithm>  // for clamp and min
+
+namespace rcAudio {
+
+namespace {
+
+static constexpr uint8_t MAX_STEP_INDEX = 88u;
+
+static constexpr std::array<int16_t, MAX_STEP_INDEX + 1> STEP_TABLE = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static constexpr std::array<int8_t, 16> INDEX_TABLE = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/** Applies a 4 bit code to the predictor and step index (decoder and encoder). */
+inline void applyCode(uint8_t code, int32_t& predictor, uint8_t& stepIndex) {
+    const int32_t step = STEP_TABLE[stepIndex];
+    int32_t diff = step >> 3;
+    if (code & 1u) {
+        diff += step >> 2;
+    }
+    if (code & 2u) {
+        diff += step >> 1;
+    }
+    if (code & 4u) {
+        diff += step;
+    }
+    predictor = std::clamp<int32_t>((code & 8u) ? predictor - diff : predictor + diff,
+        INT16_MIN, INT16_MAX);
+    stepIndex = static_cast<uint8_t>(std::clamp<int32_t>(
+        stepIndex + INDEX_TABLE[code], 0, MAX_STEP_INDEX));
+}
+
+/** Converts a 16 bit sample to the unsigned 8 bit format used for mixing. */
+inline uint8_t toUnsigned8(int32_t sample) {
+    return static_cast<uint8_t>(std::clamp<int32_t>((sample + 128) >> 8, -128, 127) + 128);
+}
+
+} // namespace
+
+uint32_t adpcmBytes(uint32_t numSamples, uint16_t blockSize) {
+    const uint32_t samplesPerBlock = adpcmSamplesPerBlock(blockSize);
+    const uint32_t rest = numSamples % samplesPerBlock;
+    return (numSamples / samplesPerBlock) * blockSize +
+        ((rest > 0u) ? ADPCM_HEADER_SIZE + rest / 2u : 0u);
+}
+
+uint32_t adpcmSamples(uint32_t numBytes, uint16_t blockSize) {
+    const uint32_t rest = numBytes % blockSize;
+    return (numBytes / blockSize) * adpcmSamplesPerBlock(blockSize) +
+        ((rest >= ADPCM_HEADER_SIZE) ? 1u + (rest - ADPCM_HEADER_SIZE) * 2u : 0u);
+}
+
+// ---------- AdpcmEncoder
+
+AdpcmEncoder::AdpcmEncoder(uint16_t blockSizeVal) :
+    blockSize(blockSizeVal) {
+    reset();
+}
+
+void AdpcmEncoder::reset() {
+    blockPos = 0u;
+    predictor = 0;
+    stepIndex = 0u;
+    lowNibble = 0u;
+}
+
+void AdpcmEncoder::add(int16_t sample, std::vector<uint8_t>& out) {
+
+    // -- the block header restarts the decoder with the exact sample
+    if (blockPos == 0u) {
+        predictor = sample;
+        out.push_back(static_cast<uint16_t>(sample) & 0xFFu);
+        out.push_back(static_cast<uint16_t>(sample) >> 8);
+        out.push_back(stepIndex);
+        out.push_back(0u);
+        blockPos = 1u;
+        return;
+    }
+
+    // -- find the code that gets closest to the sample
+    const int32_t step = STEP_TABLE[stepIndex];
+    int32_t diff = sample - predictor;
+    uint8_t code = 0u;
+    if (diff < 0) {
+        code = 8u;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        code |= 4u;
+        diff -= step;
+    }
+    if (diff >= step >> 1) {
+        code |= 2u;
+        diff -= step >> 1;
+    }
+    if (diff >= step >> 2) {
+        code |= 1u;
+    }
+
+    // the predictor follows the decoder, not the input
+    applyCode(code, predictor, stepIndex);
+
+    if (blockPos & 1u) {
+        lowNibble = code;
+    } else {
+        out.push_back(static_cast<uint8_t>(lowNibble | (code << 4)));
+    }
+
+    blockPos++;
+    if (blockPos >= adpcmSamplesPerBlock(blockSize)) {
+        blockPos = 0u;
+    }
+}
+
+void AdpcmEncoder::finish(std::vector<uint8_t>& out) {
+    if (blockPos > 0u && (blockPos & 1u) == 0u) {
+        out.push_back(lowNibble);
+    }
+    blockPos = 0u;
+}
+
+// ---------- SampleReader
+
+SampleReader::SampleReader() :
+    source(nullptr),
+    blockSize(ADPCM_BLOCK_SIZE),
+    samplesPerBlock(1u),
+    pos(0u),
+    block(nullptr),
+    blockPos(0u),
+    predictor(0),
+    stepIndex(0u),
+    cache{},
+    cacheStart(0u),
+    cacheCount(0u) {
+}
+
+void SampleReader::seek(const SampleData& sample, uint32_t index) {
+    if (source != sample.data()) {
+        source = sample.data();
+        blockSize = sample.getBlockSize();
+        samplesPerBlock = adpcmSamplesPerBlock(blockSize);
+        block = nullptr;
+        cacheCount = 0u;
+    }
+
+    // -- restart at the block, unless we can just decode forward
+    const uint32_t blockIndex = index / samplesPerBlock;
+    if (block == nullptr || index < pos || pos / samplesPerBlock != blockIndex) {
+        pos = blockIndex * samplesPerBlock;
+        block = source + blockIndex * blockSize;
+        blockPos = 0u;
+    }
+
+    while (pos < index) {
+        decodeNext();
+    }
+}
+
+uint8_t SampleReader::decodeNext() {
+    if (blockPos == 0u) {
+        predictor = static_cast<int16_t>(block[0] | (block[1] << 8));
+        stepIndex = std::min<uint8_t>(block[2], MAX_STEP_INDEX);
+
+    } else {
+        const uint8_t byte = block[ADPCM_HEADER_SIZE + ((blockPos - 1u) >> 1)];
+        const uint8_t code = ((blockPos - 1u) & 1u) ? (byte >> 4) : (byte & 0x0Fu);
+        applyCode(code, predictor, stepIndex);
+    }
+
+    pos++;
+    blockPos++;
+    if (blockPos >= samplesPerBlock) {
+        blockPos = 0u;
+        block += blockSize;
+    }
+    return toUnsigned8(predictor);
+}
+
+const uint8_t* SampleReader::read(const SampleData& sample, uint32_t index,
+                                  uint8_t* buffer, size_t num) {
+    if (!sample.isAdpcm()) {
+        return sample.data() + index;
+    }
+
+    seek(sample, index);
+    for (size_t i = 0u; i < num; i++) {
+        buffer[i] = decodeNext();
+    }
+    return buffer;
+}
+
+uint8_t SampleReader::at(const SampleData& sample, uint32_t index) {
+    if (!sample.isAdpcm()) {
+        return sample[index];
+    }
+
+    if (source == sample.data() && index - cacheStart < cacheCount) {
+        return cache[index - cacheStart];
+    }
+
+    // -- refill the cache, when going backwards with the index at the end
+    uint32_t start = index;
+    if (source == sample.data() && cacheCount > 0u && index < cacheStart) {
+        start = (index >= CACHE_SIZE - 1u) ? index - (CACHE_SIZE - 1u) : 0u;
+    }
+    const uint32_t count = std::min<uint32_t>(CACHE_SIZE, sample.size() - start);
+
+    seek(sample, start);
+    for (uint32_t i = 0u; i < count; i++) {
+        cache[i] = decodeNext();
+    }
+    cacheStart = start;
+    cacheCount = count;
+    return cache[index - start];
+}
+
+} // namespace
@@ -0,0 +1,135 @@
+/* RC engine functions controller for Arduino ESP32.
+ *
+ * IMA-ADPCM encoding and decoding of audio samples.
+ *
+ */
+
+#ifndef _AUDIO_ADPCM_H_
+#define _AUDIO_ADPCM_H_
+
+#include "audio.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rcAudio {
+
+/** Default size of an ADPCM block (like in IMA-ADPCM WAV files).
+ *
+ *  Every block is a restart point for the decoder, so smaller
+ *  blocks make seeking faster and the data slightly bigger.
+ */
+static constexpr uint16_t ADPCM_BLOCK_SIZE = 256u;
+
+/** Size of the block header (first sample, step index, reserved). */
+static constexpr uint16_t ADPCM_HEADER_SIZE = 4u;
+
+/** Returns the number of samples in a full ADPCM block. */
+constexpr uint32_t adpcmSamplesPerBlock(uint16_t blockSize) {
+    return (blockSize - ADPCM_HEADER_SIZE) * 2u + 1u;
+}
+
+/** Returns the number of bytes for numSamples ADPCM encoded samples.
+ *
+ *  The last block is not padded.
+ */
+uint32_t adpcmBytes(uint32_t numSamples, uint16_t blockSize = ADPCM_BLOCK_SIZE);
+
+/** Returns the number of samples in numBytes of ADPCM blocks.
+ *
+ *  Might be one sample more than encoded, if the last byte was
+ *  only half used.
+ */
+uint32_t adpcmSamples(uint32_t numBytes, uint16_t blockSize = ADPCM_BLOCK_SIZE);
+
+/** Streaming IMA-ADPCM encoder (mono).
+ *
+ *  The output uses the same block layout as IMA-ADPCM WAV files:
+ *  a four byte header with the first sample (16 bit little
+ *  endian) and the step index followed by 4 bit codes, low nibble
+ *  first.
+ */
+class AdpcmEncoder {
+    private:
+        uint16_t blockSize;
+        uint32_t blockPos;  ///< index of the next sample in the block
+        int32_t predictor;
+        uint8_t stepIndex;
+        uint8_t lowNibble;  ///< pending low nibble (for odd block positions)
+
+    public:
+        explicit AdpcmEncoder(uint16_t blockSizeVal = ADPCM_BLOCK_SIZE);
+
+        void reset();
+
+        /** Encodes one 16 bit sample and appends the bytes to out. */
+        void add(int16_t sample, std::vector<uint8_t>& out);
+
+        /** Writes a pending half byte. */
+        void finish(std::vector<uint8_t>& out);
+};
+
+/** Reads 8 bit samples from SampleData independent of the format.
+ *
+ *  PCM data is accessed directly. ADPCM data is decoded on the fly.
+ *  The reader keeps the decoder state, so reading forward only
+ *  decodes every sample once. Jumping backwards (e.g. a loop or
+ *  the engine revolution wrapping around) restarts at the start of
+ *  the block.
+ *
+ *  Every proc needs its own reader for each sample it plays.
+ */
+class SampleReader {
+    public:
+        /** Samples decoded ahead for random access with at(). */
+        static constexpr uint8_t CACHE_SIZE = 32u;
+
+    private:
+        /** The data the decoder state belongs to. */
+        const uint8_t* source;
+        uint16_t blockSize;
+        uint32_t samplesPerBlock;
+
+        // -- decoder state
+        uint32_t pos;  ///< the index of the next decoded sample
+        const uint8_t* block;
+        uint32_t blockPos;
+        int32_t predictor;
+        uint8_t stepIndex;
+
+        std::array<uint8_t, CACHE_SIZE> cache;
+        uint32_t cacheStart;
+        uint32_t cacheCount;
+
+        /** Moves the decoder to the index (restarting at the block if needed). */
+        void seek(const SampleData& sample, uint32_t index);
+
+        /** Decodes the next sample. */
+        uint8_t decodeNext();
+
+    public:
+        SampleReader();
+
+        /** Returns num samples starting at index.
+         *
+         *  For PCM this is a pointer into the sample data, for ADPCM
+         *  the samples are decoded into the buffer.
+         *  index + num must not be bigger than the sample size.
+         *
+         *  @param buffer A buffer for at least num samples.
+         */
+        const uint8_t* read(const SampleData& sample, uint32_t index, uint8_t* buffer, size_t num);
+
+        /** Returns a single sample, e.g. for resampling.
+         *
+         *  For ADPCM some samples around the index are cached, so
+         *  moving slowly backwards is also cheap.
+         */
+        uint8_t at(const SampleData& sample, uint32_t index);
+};
+
+} // namespace
+
+#endif // _AUDIO_ADPCM_H_
@@ -7,7 +7,7 @@
 #include "audio_dynamic.h"
 #include "signals.h"
 
-#include <cmath>  // for floor and abs
+#include <algorithm>  // for min
 #include <cstdint>
 
 using namespace rcSignals;
@@ -27,7 +27,7 @@ AudioDynamic::AudioDynamic(const SampleData& sampleVal,
                 const rcSignals::SignalType& speedTypeVal,
                 const rcSignals::SignalType& volumeTypeVal,
                 const std::array<Volume, 2> volumeVal) :
-    sample(SampleData()),
+    sample(sampleVal),
     speedType(speedTypeVal),
     volumeType(volumeTypeVal) {
     volume = volumeVal;
@@ -37,6 +37,7 @@ AudioDynamic::AudioDynamic(const SampleData& sampleVal,
 
 void AudioDynamic::start() {
     pos = 0;
+    lastGains = {0, 0};
 }
 
 void AudioDynamic::step(const rcProc::StepInfo& info) {
@@ -62,38 +63,47 @@ void AudioDynamic::step(const rcProc::StepInfo& info) {
         speed = info.signals->get(speedType, RCSIGNAL_NEUTRAL);
     }
 
-    float fVolume = dynamicVolume / 1000.0f;
-    float fSpeed = 1.0f / sample.size() * speed / 1000.0f;
+    const Gains gains = getGains(dynamicVolume / 1000.0f);
+    const Phase posStep = toPhaseStep(
+        1.0 / sample.size() * speed / 1000.0);
 
+    // ramp the gains over all samples of this step
+    size_t numTotal = 0;
     for (const auto interval : info.intervals) {
-        copySamples(fSpeed, interval, fVolume);
+        numTotal += interval.last - interval.first;
     }
+
+    size_t offset = 0;
+    for (const auto interval : info.intervals) {
+        const size_t num = interval.last - interval.first;
+        copySamples(posStep, interval,
+                    interpolateGains(lastGains, gains, offset, numTotal),
+                    interpolateGains(lastGains, gains, offset + num, numTotal));
+        offset += num;
+    }
+    lastGains = gains;
 }
 
-void AudioDynamic::copySamples(float posStep,
+void AudioDynamic::copySamples(Phase posStep,
     const rcProc::SamplesInterval& interval,
-    float volume) {
-
-    auto first = interval.first;
-    auto last = interval.last;
-
-    // -- copy audio samples
-    while (first != last) {
-
-        copySample(
-           sample[std::min(
-               static_cast<uint16_t>(sample.size() * pos),
-               static_cast<uint16_t>(sample.size() - 1))],
-           first,
-           volume);
-
-        pos += posStep;
-        while (pos >= 1.0) {
-            pos -= 1.0;
-        }
-        first++;
+    const Gains& gainsStart,
+    const Gains& gainsEnd) {
+
+    std::array<uint8_t, MIX_CHUNK_SIZE> buffer;
+
+    const size_t numTotal = interval.last - interval.first;
+    size_t done = 0;
+
+    // -- copy audio samples in chunks
+    while (done < numTotal) {
+        const size_t num = std::min(MIX_CHUNK_SIZE, numTotal - done);
+
+        pos = resampleBlock(sample, reader, pos, posStep, buffer.data(), num);
+        mixBlockRamp(buffer.data(), interval.first + done, num,
+                     interpolateGains(gainsStart, gainsEnd, done, numTotal),
+                     interpolateGains(gainsStart, gainsEnd, done + num, numTotal));
+        done += num;
     }
 }
 
 } // namespace
-
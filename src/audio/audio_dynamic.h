@@ -8,6 +8,7 @@
 #define _AUDIO_DYNAMIC_H_
 
 #include "audio.h"
+#include "audio_mix.h"
 #include "signals.h"
 
 #include <array>
@@ -29,6 +30,7 @@ namespace rcAudio {
 class AudioDynamic : public Audio {
     private:
         SampleData sample;
+        SampleReader reader; ///< Reads (and decodes) the sample.
 
         /** The input signal determining the speed.
          *
@@ -43,17 +45,26 @@ class AudioDynamic : public Audio {
          */
         rcSignals::SignalType volumeType;
 
-        float pos; ///< Current playing position (part of a revolution).
+        Phase pos; ///< Current playing position (part of the sample).
+
+        /** The gains at the end of the last step.
+         *
+         *  The gains are ramped from these to the new gains
+         *  during one step to prevent clicking.
+         */
+        Gains lastGains;
 
         /** Copy samples to the target buffer.
          *
          *  @param posStep increase of \ref pos per sample step
          *  @param interval The samples interval that needs to be filled.
-         *  @param volume The volume from the ST_MASTER_VOLUME signal.
+         *  @param gainsStart The gains at the start of the interval.
+         *  @param gainsEnd The gains at the end of the interval.
          */
-        void copySamples(float posStep,
+        void copySamples(Phase posStep,
                          const rcProc::SamplesInterval& interval,
-                         float volume);
+                         const Gains& gainsStart,
+                         const Gains& gainsEnd);
 
     public:
         AudioDynamic();
@@ -65,6 +76,16 @@ class AudioDynamic : public Audio {
         virtual void start() override;
         virtual void step(const rcProc::StepInfo& info) override;
 
+        virtual void getSignalUsage(rcProc::SignalUsage& usage) const override {
+            usage.read(speedType);
+            usage.read(volumeType);
+            usage.audio = true;
+        }
+
+        virtual void relocateSamples(std::span<const uint8_t> from, const uint8_t* to) override {
+            sample.relocate(from, to);
+        }
+
         friend AudioDynamicTest_getSampleIndices_Test;
         friend AudioDynamicTest_getVolumes_Test;
 
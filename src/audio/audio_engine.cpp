@@ -41,7 +41,7 @@ AudioEngine::AudioEngine(const std::array<SampleData, NUM_SAMPLES>& samplesVal,
 
 void AudioEngine::start() {
     lastVolumeFactor = 0.0f;
-    pos = 0.0f;
+    pos = 0;
 
     // calculate RPMs
     //
@@ -58,7 +58,14 @@ void AudioEngine::start() {
         }
     }
 
-    currentVolumes = {0.0f};
+    setCurrentVolumes({0.0f});
+}
+
+void AudioEngine::setCurrentVolumes(const std::array<float, NUM_SAMPLES>& volumes) {
+    currentVolumes = volumes;
+    for (uint8_t i = 0; i < NUM_SAMPLES; i ++) {
+        currentGains[i] = getGains(currentVolumes[i]);
+    }
 }
 
 
@@ -149,12 +156,14 @@ void AudioEngine::step(const rcProc::StepInfo& info) {
     auto rpm = info.signals->get(SignalType::ST_RPM, rcSignals::RCSIGNAL_NEUTRAL);
 
     // smooth blending
-    // 0.01 -> 100 cycles -> 2 s
+    // independent of the step time, since the audio procs might
+    // also be stepped per audio block.
+    // 0.0005 per ms -> 2 s
     if (rpm < 100) {
-        lastVolumeFactor = std::clamp(lastVolumeFactor - 0.01f, 0.0f, 1.0f);
-    // 0.1 -> 10 cycles -> 200 ms
+        lastVolumeFactor = std::clamp(lastVolumeFactor - 0.0005f * info.deltaMs, 0.0f, 1.0f);
+    // 0.005 per ms -> 200 ms
     } else {
-        lastVolumeFactor = std::clamp(lastVolumeFactor + 0.1f, 0.0f, 1.0f);
+        lastVolumeFactor = std::clamp(lastVolumeFactor + 0.005f * info.deltaMs, 0.0f, 1.0f);
     }
 
     auto newVolumes = getVolumes(rpm, throttle);
@@ -171,42 +180,47 @@ void AudioEngine::step(const rcProc::StepInfo& info) {
     signals[SignalType::ST_WINCH] = static_cast<int16_t>(newVolumes[4] * 1000.0);
     */
 
-    float posStep = abs((rpm / 60.0f) / static_cast<float>(rcAudio::SAMPLE_RATE));
+    Phase posStep = toPhaseStep(std::abs((rpm / 60.0) / static_cast<double>(rcAudio::SAMPLE_RATE)));
 
     for (const auto interval : info.intervals) {
         copySamples(posStep, newVolumes, interval);
     }
 }
 
-void AudioEngine::copySamples(float posStep,
+void AudioEngine::copySamples(Phase posStep,
     const std::array<float, AudioEngine::NUM_SAMPLES>& newVolumes,
     const rcProc::SamplesInterval& interval) {
 
+    std::array<uint8_t, MIX_CHUNK_SIZE> buffer;
+    std::array<int32_t, MIX_CHUNK_SIZE> acc1;
+    std::array<int32_t, MIX_CHUNK_SIZE> acc2;
+
     auto first = interval.first;
-    auto last = interval.last;
 
     // -- copy audio samples
-    while (first != last) {
-
+    // in chunks that end at the latest when a new engine revolution starts
+    while (first != interval.last) {
+        const size_t num = samplesUntilWrap(pos, posStep,
+            std::min<size_t>(MIX_CHUNK_SIZE, interval.last - first));
+
+        // accumulate all samples and saturate only once
+        acc1.fill(0);
+        acc2.fill(0);
         for (uint8_t i = 0; i < NUM_SAMPLES; i ++) {
-            if (currentVolumes[i] > 0.0f) {
-                copySample(
-                    samples[i][std::min(
-                        static_cast<uint16_t>(samples[i].size() * pos),
-                        static_cast<uint16_t>(samples[i].size() - 1))],
-                    first,
-                    currentVolumes[i]);
+            if (currentVolumes[i] > 0.0f && !samples[i].empty()) {
+                resampleBlock(samples[i], readers[i], pos, posStep, buffer.data(), num);
+                accumulateBlock(buffer.data(), acc1.data(), acc2.data(), num, currentGains[i]);
             }
         }
+        saturateBlock(acc1.data(), acc2.data(), first, num);
 
-        pos += posStep;
-        while (pos >= 1.0) {
-            pos -= 1.0;
-            currentVolumes = newVolumes;
+        const uint64_t newPos = pos + static_cast<uint64_t>(num) * posStep;
+        if (newPos >= (1ULL << 32)) {
+            setCurrentVolumes(newVolumes);
         }
-        first++;
+        pos = static_cast<Phase>(newPos);
+        first += num;
     }
 }
 
 } // namespace
-
@@ -8,6 +8,7 @@
 #define _AUDIO_ENGINE_H_
 
 #include "audio.h"
+#include "audio_mix.h"
 #include "signals.h"
 
 #include <array>
@@ -38,6 +39,9 @@ class AudioEngine : public Audio {
 
         std::array<SampleData, NUM_SAMPLES> samples;
 
+        /** Readers (decoders) for the samples. */
+        std::array<SampleReader, NUM_SAMPLES> readers;
+
         /** The RPMs for the samples.
          *
          *  This will be computed in the start() function.
@@ -61,10 +65,20 @@ class AudioEngine : public Audio {
          */
         std::array<float, NUM_SAMPLES> currentVolumes;
 
+        /** The Q15 gains (per channel) for \ref currentVolumes.
+         *
+         *  Updated together with the currentVolumes so that the
+         *  inner mixing loop does not need any float operation.
+         */
+        std::array<Gains, NUM_SAMPLES> currentGains;
+
+        /** Sets \ref currentVolumes and \ref currentGains. */
+        void setCurrentVolumes(const std::array<float, NUM_SAMPLES>& volumes);
+
         /** Used for smooth blending volume. */
         float lastVolumeFactor;
 
-        float pos; ///< Current playing position (part of a engine revolution).
+        Phase pos; ///< Current playing position (part of a engine revolution).
 
         /** Returns of the sample with the index is considered valid.
          *
@@ -100,7 +114,7 @@ class AudioEngine : public Audio {
          *    once the engine revolution starts again.
          *  @param[in] interval The samples interval that needs to be filled.
          */
-        void copySamples(float posStep,
+        void copySamples(Phase posStep,
                          const std::array<float, NUM_SAMPLES>& newVolumes,
                          const rcProc::SamplesInterval& interval);
 
@@ -113,6 +127,18 @@ class AudioEngine : public Audio {
         virtual void start() override;
         virtual void step(const rcProc::StepInfo& info) override;
 
+        virtual void getSignalUsage(rcProc::SignalUsage& usage) const override {
+            usage.read(throttleType);
+            usage.read(rcSignals::SignalType::ST_RPM);
+            usage.audio = true;
+        }
+
+        virtual void relocateSamples(std::span<const uint8_t> from, const uint8_t* to) override {
+            for (auto& sample : samples) {
+                sample.relocate(from, to);
+            }
+        }
+
         friend AudioEngineTest_getVolumes_Test;
 
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const AudioEngine&);
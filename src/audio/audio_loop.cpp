@@ -4,6 +4,10 @@
  */
 
 #include "audio_loop.h"
+#include "audio_mix.h"
+
+#include <algorithm>  // for min
+#include <array>
 
 namespace rcAudio {
 
@@ -11,14 +15,24 @@ void AudioLoop::copySamples(bool triggerNew,
     const rcProc::SamplesInterval& interval) {
 
     auto first = interval.first;
-    auto last = interval.last;
+    const auto gains = getGains();
+    std::array<uint8_t, MIX_CHUNK_SIZE> buffer;
 
     // -- copy audio samples
-    while (active && first != last && pos < sample.size()) {
-        copySample(sample[pos], first);
+    while (active && first != interval.last && pos < sample.size()) {
+
+        // copy up to the loop end (at least one sample)
+        size_t end = sample.size();
+        if (triggerNew) {
+            end = std::min<size_t>(end, loopEnd);
+        }
+        size_t num = (end > pos) ? (end - pos) : 1u;
+        num = std::min<size_t>(std::min<size_t>(num, interval.last - first), buffer.size());
+
+        mixBlock(reader.read(sample, pos, buffer.data(), num), first, num, gains);
 
-        pos++;
-        first++;
+        pos += num;
+        first += num;
 
         // loop back
         if (triggerNew &&
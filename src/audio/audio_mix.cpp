@@ -0,0 +1,152 @@
+/* RC engine functions controller for Arduino ESP32.
+ *
+ * Block based mixing kernels for the audio procs.
+ *
+ * The loops are kept simple (no aliasing, no branches in the loop body)
+ * so that GCC can auto-vectorize them on the host.
+ * On the Xtensa target the 32 bit multiply-accumulate maps to
+ * MULL and ADD without any float conversion.
+ */
+
+#include "audio_mix.h"
+
+#include <algorithm>  // for min and max
+#include <cmath>  // for ceil and abs
+
+namespace rcAudio {
+
+void mixBlock(const uint8_t* __restrict in, rcProc::AudioSample* __restrict out,
+              size_t num, const Gains& gains) {
+
+    const int32_t gain1 = gains[0];
+    const int32_t gain2 = gains[1];
+    for (size_t i = 0; i < num; i++) {
+        const int32_t sample = static_cast<int32_t>(in[i]) - 128;
+        out[i].channel1 = saturate16(out[i].channel1 + ((sample * gain1) >> 15));
+        out[i].channel2 = saturate16(out[i].channel2 + ((sample * gain2) >> 15));
+    }
+}
+
+void mixBlockRamp(const uint8_t* __restrict in, rcProc::AudioSample* __restrict out,
+                  size_t num, const Gains& gainsStart, const Gains& gainsEnd) {
+
+    if (num == 0) {
+        return;
+    }
+
+    const int32_t delta1 = (gainsEnd[0] - gainsStart[0]) / static_cast<int32_t>(num);
+    const int32_t delta2 = (gainsEnd[1] - gainsStart[1]) / static_cast<int32_t>(num);
+    for (size_t i = 0; i < num; i++) {
+        const int32_t sample = static_cast<int32_t>(in[i]) - 128;
+        const int32_t gain1 = gainsStart[0] + static_cast<int32_t>(i) * delta1;
+        const int32_t gain2 = gainsStart[1] + static_cast<int32_t>(i) * delta2;
+        out[i].channel1 = saturate16(out[i].channel1 + ((sample * gain1) >> 15));
+        out[i].channel2 = saturate16(out[i].channel2 + ((sample * gain2) >> 15));
+    }
+}
+
+Gains interpolateGains(const Gains& gainsStart, const Gains& gainsEnd,
+                       size_t index, size_t num) {
+    if (num == 0) {
+        return gainsEnd;
+    }
+
+    Gains result;
+    for (size_t i = 0; i < result.size(); i++) {
+        result[i] = gainsStart[i] + static_cast<GainQ15>(
+            static_cast<int64_t>(gainsEnd[i] - gainsStart[i]) *
+            static_cast<int64_t>(index) / static_cast<int64_t>(num));
+    }
+    return result;
+}
+
+void accumulateBlock(const uint8_t* __restrict in,
+                     int32_t* __restrict acc1, int32_t* __restrict acc2,
+                     size_t num, const Gains& gains) {
+
+    const int32_t gain1 = gains[0];
+    const int32_t gain2 = gains[1];
+    for (size_t i = 0; i < num; i++) {
+        const int32_t sample = static_cast<int32_t>(in[i]) - 128;
+        acc1[i] += (sample * gain1) >> 15;
+        acc2[i] += (sample * gain2) >> 15;
+    }
+}
+
+void saturateBlock(const int32_t* __restrict acc1, const int32_t* __restrict acc2,
+                   rcProc::AudioSample* __restrict out, size_t num) {
+
+    for (size_t i = 0; i < num; i++) {
+        out[i].channel1 = saturate16(out[i].channel1 + acc1[i]);
+        out[i].channel2 = saturate16(out[i].channel2 + acc2[i]);
+    }
+}
+
+void addBlock(const rcProc::AudioSample* __restrict in,
+              rcProc::AudioSample* __restrict out, size_t num) {
+
+    for (size_t i = 0; i < num; i++) {
+        out[i].channel1 = saturate16(static_cast<int32_t>(out[i].channel1) + in[i].channel1);
+        out[i].channel2 = saturate16(static_cast<int32_t>(out[i].channel2) + in[i].channel2);
+    }
+}
+
+void convertBlockU8(const rcProc::AudioSample* __restrict in, uint8_t* __restrict out,
+                    size_t num, GainQ15 gain) {
+
+    for (size_t i = 0; i < num; i++) {
+        out[i * 2] = static_cast<uint8_t>(std::clamp<int32_t>(
+            ((in[i].channel1 * gain) >> 15) + 127, 0, 255));
+        out[i * 2 + 1] = static_cast<uint8_t>(std::clamp<int32_t>(
+            ((in[i].channel2 * gain) >> 15) + 127, 0, 255));
+    }
+}
+
+Phase toPhaseStep(double step) {
+    // round the magnitude up, so that a step of exactly one sample
+    // does not fall behind by one sample due to rounding.
+    const int64_t magnitude = static_cast<int64_t>(std::ceil(std::abs(step) * 4294967296.0));
+
+    // go over int64 so that negative steps wrap correctly
+    return static_cast<Phase>(step < 0.0 ? -magnitude : magnitude);
+}
+
+size_t samplesUntilWrap(Phase phase, Phase step, size_t maxNum) {
+    if (step == 0) {
+        return maxNum;
+    }
+
+    // smallest n with phase + n * step >= 2^32
+    const uint64_t remaining = (1ULL << 32) - phase;
+    const uint64_t num = (remaining + step - 1) / step;
+    return static_cast<size_t>(std::max<uint64_t>(1u, std::min<uint64_t>(num, maxNum)));
+}
+
+Phase resampleBlock(const SampleData& in, Phase phase, Phase step,
+                    uint8_t* __restrict out, size_t num) {
+
+    const uint64_t size = in.size();
+    const uint8_t* data = in.data();
+    for (size_t i = 0; i < num; i++) {
+        out[i] = data[(static_cast<uint64_t>(phase) * size) >> 32];
+        phase += step;
+    }
+    return phase;
+}
+
+Phase resampleBlock(const SampleData& in, SampleReader& reader, Phase phase, Phase step,
+                    uint8_t* out, size_t num) {
+
+    if (!in.isAdpcm()) {
+        return resampleBlock(in, phase, step, out, num);
+    }
+
+    const uint64_t size = in.size();
+    for (size_t i = 0; i < num; i++) {
+        out[i] = reader.at(in, static_cast<uint32_t>((static_cast<uint64_t>(phase) * size) >> 32));
+        phase += step;
+    }
+    return phase;
+}
+
+} // namespace
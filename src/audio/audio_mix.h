@@ -0,0 +1,163 @@
+/* RC engine functions controller for Arduino ESP32.
+ *
+ * Block based mixing kernels for the audio procs.
+ *
+ */
+
+#ifndef _AUDIO_MIX_H_
+#define _AUDIO_MIX_H_
+
+#include "audio.h"
+#include "audio_adpcm.h"
+#include "proc.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace rcAudio {
+
+/** Q15 gains for both channels. */
+typedef std::array<GainQ15, 2> Gains;
+
+/** Size of temporary buffers used by the audio procs when mixing in chunks. */
+static constexpr size_t MIX_CHUNK_SIZE = 256;
+
+/** Mixes 8 bit unsigned samples into a stereo block.
+ *
+ *  out[i] = saturate(out[i] + ((in[i] - 128) * gain) >> 15)
+ *
+ *  This is bit-exact with calling Audio::mixSample() for
+ *  every sample.
+ *
+ *  @param in The sample data straight out of the unsigned 8bit WAV file.
+ *  @param out The target block.
+ *  @param num Number of samples to mix.
+ *  @param gains The Q15 gains for both channels.
+ */
+void mixBlock(const uint8_t* in, rcProc::AudioSample* out, size_t num,
+              const Gains& gains);
+
+/** Same as mixBlock() but with a linear gain ramp.
+ *
+ *  The gain for sample i is gainsStart + i * ((gainsEnd - gainsStart) / num)
+ *  (integer division), so the last sample is slightly below gainsEnd.
+ *
+ *  @param in The sample data straight out of the unsigned 8bit WAV file.
+ *  @param out The target block.
+ *  @param num Number of samples to mix.
+ *  @param gainsStart The gains for the first sample.
+ *  @param gainsEnd The gains after the last sample.
+ */
+void mixBlockRamp(const uint8_t* in, rcProc::AudioSample* out, size_t num,
+                  const Gains& gainsStart, const Gains& gainsEnd);
+
+/** Returns the gains at position index of a linear ramp with num samples.
+ *
+ *  Used to split one ramp into several mixBlockRamp() calls.
+ */
+Gains interpolateGains(const Gains& gainsStart, const Gains& gainsEnd,
+                       size_t index, size_t num);
+
+/** Accumulates 8 bit unsigned samples into 32 bit accumulators.
+ *
+ *  Used to mix several samples with only one final saturation.
+ *  See saturateBlock().
+ *
+ *  @param in The sample data straight out of the unsigned 8bit WAV file.
+ *  @param acc1 Accumulator for the first channel.
+ *  @param acc2 Accumulator for the second channel.
+ *  @param num Number of samples.
+ *  @param gains The Q15 gains for both channels.
+ */
+void accumulateBlock(const uint8_t* in, int32_t* acc1, int32_t* acc2, size_t num,
+                     const Gains& gains);
+
+/** Adds the accumulators to the stereo block with saturation.
+ *
+ *  @param acc1 Accumulator for the first channel.
+ *  @param acc2 Accumulator for the second channel.
+ *  @param out The target block.
+ *  @param num Number of samples.
+ */
+void saturateBlock(const int32_t* acc1, const int32_t* acc2,
+                   rcProc::AudioSample* out, size_t num);
+
+/** Adds one stereo block to another with saturation.
+ *
+ *  out[i] = saturate(out[i] + in[i])
+ *
+ *  Used to sum up the partial blocks rendered by several workers.
+ *  The loop has no branches and no aliasing, so the compiler can
+ *  vectorize it (e.g. with saturating 16 bit adds on the host).
+ *
+ *  @param in The block to add.
+ *  @param out The target block.
+ *  @param num Number of samples.
+ */
+void addBlock(const rcProc::AudioSample* in, rcProc::AudioSample* out, size_t num);
+
+/** Converts a stereo block to interleaved unsigned 8 bit samples for the DAC.
+ *
+ *  out[2 * i] = clamp(((in[i].channel1 * gain) >> 15) + 127, 0, 255)
+ *
+ *  @param in The stereo block.
+ *  @param out The target buffer for 2 * num bytes.
+ *  @param num Number of samples.
+ *  @param gain The Q15 master gain.
+ */
+void convertBlockU8(const rcProc::AudioSample* in, uint8_t* out, size_t num,
+                    GainQ15 gain);
+
+/** Fixed-point phase for resampling.
+ *
+ *  The full range of the uint32_t (2^32) corresponds to the
+ *  whole sample, so wrapping around at the end of the
+ *  sample is just the integer overflow.
+ */
+typedef uint32_t Phase;
+
+/** Converts a phase step (whole samples per output sample) to fixed-point.
+ *
+ *  Negative steps play the sample backwards.
+ *  The step is a double since a float is not precise enough for 32 bit.
+ */
+Phase toPhaseStep(double step);
+
+/** Returns the number of output samples until the phase wraps around.
+ *
+ *  Only meaningful for forward (positive) steps.
+ *  Returns at least 1 and at most maxNum.
+ */
+size_t samplesUntilWrap(Phase phase, Phase step, size_t maxNum);
+
+/** Resamples a sample with a fixed-point step into an 8 bit buffer.
+ *
+ *  The resampled data can then be mixed with mixBlock(),
+ *  mixBlockRamp() or accumulateBlock().
+ *
+ *  out[i] = in[(phase + i * step) * size / 2^32]
+ *
+ *  @param in The sample data. Must not be empty.
+ *  @param phase The start phase.
+ *  @param step The phase step per output sample.
+ *  @param out The target buffer for num samples.
+ *  @param num Number of samples.
+ *  @returns The phase after the last sample.
+ */
+Phase resampleBlock(const SampleData& in, Phase phase, Phase step,
+                    uint8_t* out, size_t num);
+
+/** Same as resampleBlock() but also for ADPCM samples.
+ *
+ *  PCM samples use the fast path above, ADPCM samples are
+ *  decoded by the reader.
+ *
+ *  @param reader The reader for this sample (keeps the decoder state).
+ */
+Phase resampleBlock(const SampleData& in, SampleReader& reader, Phase phase, Phase step,
+                    uint8_t* out, size_t num);
+
+} // namespace
+
+#endif // _AUDIO_MIX_H_
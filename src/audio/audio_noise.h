@@ -82,6 +82,11 @@ class AudioNoise : public Audio {
         virtual void start() override;
         virtual void step(const rcProc::StepInfo& info) override;
 
+        virtual void getSignalUsage(rcProc::SignalUsage& usage) const override {
+            usage.read(volumeType);
+            usage.audio = true;
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const AudioNoise&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, AudioNoise&);
 };
@@ -5,6 +5,7 @@
  */
 
 #include "audio_ringbuffer.h"
+#include <algorithm>  // for min
 #include <cstdint>
 #include <array>
 
@@ -12,17 +13,36 @@ static rcAudio::AudioRingbuffer singletonRingbuffer;
 
 namespace rcAudio {
 
-rcProc::SamplesInterval AudioRingbuffer::getEmptyBlocks() {
-    rcProc::SamplesInterval result = {
-        &(buffer[indexEmpty * BLOCK_SIZE]),
-        &(buffer[indexEmpty * BLOCK_SIZE]),
-    };
+uint32_t AudioRingbuffer::numBlocks(const rcProc::SamplesInterval& iv,
+                                    uint32_t counter, uint32_t maxNum) const {
+
+    if (iv.first != &(buffer[blockIndex(counter) * BLOCK_SIZE]) ||
+        iv.last <= iv.first) {
+        return 0;
+    }
+
+    const auto num = (iv.last - iv.first) / BLOCK_SIZE;
+    if (num < 0 || static_cast<uint32_t>(num) > maxNum ||
+        blockIndex(counter) + num > NUM_BLOCKS) {
+        return 0;
+    }
+    return static_cast<uint32_t>(num);
+}
+
+rcProc::SamplesInterval AudioRingbuffer::getEmptyBlocks(uint32_t maxBlocks) {
+    const uint32_t writing = indexWriting.load(std::memory_order_relaxed);
+    const uint32_t empty = indexEmpty.load(std::memory_order_acquire);
+
+    // free blocks, but only up to the end of the buffer
+    const uint32_t index = blockIndex(writing);
+    const uint32_t num = std::min({
+        NUM_BLOCKS - distance(empty, writing),
+        NUM_BLOCKS - index,
+        maxBlocks});
 
-    while ((blockStatus[indexEmpty] == BlockStatus::EMPTY) &&
-        (indexEmpty < NUM_BLOCKS)) {
-        result.last += BLOCK_SIZE;
-        blockStatus[indexEmpty] = BlockStatus::WRITING;
-        indexEmpty++;
+    rcProc::SamplesInterval result = {
+        &(buffer[index * BLOCK_SIZE]),
+        &(buffer[index * BLOCK_SIZE]) + num * BLOCK_SIZE
     };
 
     // zero out the blocks
@@ -31,76 +51,54 @@ rcProc::SamplesInterval AudioRingbuffer::getEmptyBlocks() {
         i->channel2 = 0;
     }
 
-    // wrap-around
-    if (indexEmpty >= NUM_BLOCKS) {
-        indexEmpty = 0;
-    }
-
+    indexWriting.store(advance(writing, num), std::memory_order_relaxed);
     return result;
 }
 
-void rcAudio::AudioRingbuffer::setBlocksFull(rcProc::SamplesInterval iv) {
-    int32_t startIndex = (iv.first - &(buffer[0])) / BLOCK_SIZE;
-    int32_t endIndex = (iv.last - &(buffer[0])) / BLOCK_SIZE;
+void AudioRingbuffer::setBlocksFull(rcProc::SamplesInterval iv) {
+    const uint32_t full = indexFull.load(std::memory_order_relaxed);
+    const uint32_t num = numBlocks(iv, full,
+        distance(full, indexWriting.load(std::memory_order_relaxed)));
 
-    if (startIndex >= 0 && startIndex < NUM_BLOCKS) {
-        for (int32_t i = startIndex; i < endIndex && i < NUM_BLOCKS; i++) {
-            blockStatus[i] = BlockStatus::FULL;
-        }
-    }
+    // release: the consumer sees the samples once it sees the index
+    indexFull.store(advance(full, num), std::memory_order_release);
 }
 
-rcProc::SamplesInterval rcAudio::AudioRingbuffer::getFullBlocks() {
-    rcProc::SamplesInterval result = {
-        &(buffer[indexFull * BLOCK_SIZE]),
-        &(buffer[indexFull * BLOCK_SIZE]),
-    };
+rcProc::SamplesInterval AudioRingbuffer::getFullBlocks() {
+    const uint32_t reading = indexReading.load(std::memory_order_relaxed);
+    const uint32_t full = indexFull.load(std::memory_order_acquire);
 
-    if ((blockStatus[indexFull] == BlockStatus::FULL) &&
-        (indexFull < NUM_BLOCKS)) {
-        result.last += BLOCK_SIZE;
-        blockStatus[indexFull] = BlockStatus::READING;
-        indexFull++;
-    };
+    const uint32_t index = blockIndex(reading);
+    const uint32_t num = std::min(distance(reading, full), 1u);
 
-    // wrap-around
-    if (indexFull >= NUM_BLOCKS) {
-        indexFull = 0;
-    }
+    rcProc::SamplesInterval result = {
+        &(buffer[index * BLOCK_SIZE]),
+        &(buffer[index * BLOCK_SIZE]) + num * BLOCK_SIZE
+    };
 
+    indexReading.store(advance(reading, num), std::memory_order_relaxed);
     return result;
 }
 
-void rcAudio::AudioRingbuffer::setBlocksEmpty(rcProc::SamplesInterval iv) {
-
-    int32_t startIndex = (iv.first - &(buffer[0])) / BLOCK_SIZE;
-    int32_t endIndex = (iv.last - &(buffer[0])) / BLOCK_SIZE;
+void AudioRingbuffer::setBlocksEmpty(rcProc::SamplesInterval iv) {
+    const uint32_t empty = indexEmpty.load(std::memory_order_relaxed);
+    const uint32_t num = numBlocks(iv, empty,
+        distance(empty, indexReading.load(std::memory_order_relaxed)));
 
-    if (startIndex >= 0 && startIndex < NUM_BLOCKS) {
-        for (int32_t i = startIndex; i < endIndex && i < NUM_BLOCKS; i++) {
-            blockStatus[i] = BlockStatus::EMPTY;
-        }
-    }
+    // release: the producer may only overwrite the samples after reading is done
+    indexEmpty.store(advance(empty, num), std::memory_order_release);
 }
 
-uint8_t rcAudio::AudioRingbuffer::getNumEmpty() const {
-    uint8_t num = 0;
-    for (const auto& status : blockStatus) {
-        if (status == BlockStatus::EMPTY) {
-            num++;
-        }
-    }
-    return num;
+uint8_t AudioRingbuffer::getNumEmpty() const {
+    return NUM_BLOCKS - distance(
+        indexEmpty.load(std::memory_order_acquire),
+        indexWriting.load(std::memory_order_relaxed));
 }
 
-uint8_t rcAudio::AudioRingbuffer::getNumFull() const {
-    uint8_t num = 0;
-    for (const auto& status : blockStatus) {
-        if (status == BlockStatus::FULL) {
-            num++;
-        }
-    }
-    return num;
+uint8_t AudioRingbuffer::getNumFull() const {
+    return distance(
+        indexReading.load(std::memory_order_relaxed),
+        indexFull.load(std::memory_order_acquire));
 }
 
 AudioRingbuffer& getRingbuffer() {
@@ -108,4 +106,3 @@ AudioRingbuffer& getRingbuffer() {
 }
 
 } // namespace
-
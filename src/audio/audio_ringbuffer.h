@@ -8,8 +8,10 @@
 #define _AUDIO_RINGBUFFER_H_
 
 #include "proc.h"
-#include <cstdint>
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 
 namespace rcAudio {
 
@@ -24,8 +26,21 @@ namespace rcAudio {
  *  - current index to end
  *  - start to final index.
  *
- *  Note: this should be thread-safe if read and write are done
- *   in different threads.
+ *  The ringbuffer is a single-producer/single-consumer queue:
+ *
+ *  - getEmptyBlocks(), setBlocksFull() and getNumEmpty() must only
+ *    be called from the producer (the task running the audio procs).
+ *  - getFullBlocks(), setBlocksEmpty() and getNumFull() must only
+ *    be called from the consumer (the task feeding the DMA).
+ *
+ *  Producer and consumer can run in different threads (or on
+ *  different cores) without any lock.
+ *  The block ownership is handed over with release/acquire
+ *  atomics on \ref indexFull and \ref indexEmpty.
+ *
+ *  Blocks have to be set full/empty in the same order in which
+ *  they have been handed out. Intervals not matching this contract
+ *  are ignored.
  */
 class AudioRingbuffer {
 
@@ -33,59 +48,115 @@ public:
     static constexpr int32_t BLOCK_SIZE = 256; ///< memory block size (number of rcProc::AudioSamples)
     static constexpr int32_t NUM_BLOCKS = 7; ///< number of memory blocks (we need enough for at least 20ms)
 
+    /** Size used to separate the producer and consumer data.
+     *
+     *  The ESP32 has 32 byte cache lines, x86 hosts 64 bytes.
+     */
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
 private:
-    /** Status of the different memory blocks.
+    /** The block counters run from 0 to COUNTER_WRAP - 1.
+     *
+     *  They count blocks and not indices so that a completely full
+     *  and a completely empty buffer can be distinguished.
+     *  COUNTER_WRAP is a multiple of NUM_BLOCKS so the block index
+     *  stays continuous when the counters wrap around.
      */
-    enum class BlockStatus : uint8_t {
-        EMPTY,  ///< Memory block is currently empty
-        WRITING,  ///< Memory block is reserved for writing
-        FULL,  ///< Memory block has been written
-        READING  ///< Memory block has been given to DMA
-    };
+    static constexpr uint32_t COUNTER_WRAP = NUM_BLOCKS * 0x10000000u;
 
     std::array<rcProc::AudioSample, NUM_BLOCKS * BLOCK_SIZE> buffer;
-    std::array<BlockStatus, NUM_BLOCKS> blockStatus;
 
-    uint8_t indexEmpty;  ///< The index to the first empty block
-    uint8_t indexFull;  ///< The index to the first full block
+    // -- written by the producer
+    /** Number of blocks handed out by getEmptyBlocks(). Producer only. */
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> indexWriting;
+    /** Number of blocks written (released to the consumer). */
+    std::atomic<uint32_t> indexFull;
+
+    // -- written by the consumer
+    /** Number of blocks handed out by getFullBlocks(). Consumer only. */
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> indexReading;
+    /** Number of blocks read (released to the producer). */
+    std::atomic<uint32_t> indexEmpty;
+
+    /** Returns the block index of a counter. */
+    static uint32_t blockIndex(uint32_t counter) {
+        return counter % NUM_BLOCKS;
+    }
+
+    /** Returns the counter increased by num. */
+    static uint32_t advance(uint32_t counter, uint32_t num) {
+        return (counter + num) % COUNTER_WRAP;
+    }
+
+    /** Returns the number of blocks between the two counters. */
+    static uint32_t distance(uint32_t from, uint32_t to) {
+        return (to + COUNTER_WRAP - from) % COUNTER_WRAP;
+    }
+
+    /** Returns the number of blocks in the interval if it starts at
+     *  the block for counter and covers at most maxNum whole blocks.
+     *
+     *  Returns 0 for invalid intervals.
+     */
+    uint32_t numBlocks(const rcProc::SamplesInterval& iv, uint32_t counter, uint32_t maxNum) const;
 
 public:
     /** You might not want to create a ringbuffer yourself
      *  Instead use the getRingbuffer function.
      */
     AudioRingbuffer():
-          indexEmpty(0),
-          indexFull(0) {
-        for (auto& status : blockStatus) {
-            status = BlockStatus::EMPTY;
-        }
+          indexWriting(0),
+          indexFull(0),
+          indexReading(0),
+          indexEmpty(0) {
     }
 
     /** Returns the next sequence of empty blocks, marking them as WRITING.
      *
      *  The returned blocks will be emptied out (set to 0)
+     *
+     *  Producer only.
+     *
+     *  @param maxBlocks The maximum number of blocks to return.
     */
-    rcProc::SamplesInterval getEmptyBlocks();
+    rcProc::SamplesInterval getEmptyBlocks(uint32_t maxBlocks = NUM_BLOCKS);
 
+    /** Marks the blocks as FULL, handing them over to the consumer.
+     *
+     *  Producer only.
+     */
     void setBlocksFull(rcProc::SamplesInterval);
 
     /** Returns the next full block, marking them as READING.
+     *
+     *  Consumer only.
     */
     rcProc::SamplesInterval getFullBlocks();
 
     /** Marks the blocks in the given interval as empty.
      *
      *  Call this function after reading has finished.
+     *
+     *  Consumer only.
      */
     void setBlocksEmpty(rcProc::SamplesInterval);
 
     /** Returns the number of empty blocks.
+     *
+     *  Exact if called by the producer.
      */
     uint8_t getNumEmpty() const;
 
     /** Returns the number of full blocks.
+     *
+     *  Exact if called by the consumer.
      */
     uint8_t getNumFull() const;
+
+    /** Returns the index of the block containing the sample. */
+    uint32_t getBlockIndex(const rcProc::AudioSample* sample) const {
+        return static_cast<uint32_t>((sample - buffer.data()) / BLOCK_SIZE) % NUM_BLOCKS;
+    }
 };
 
 /** Returns the ringbuffer used globally. */
@@ -5,7 +5,10 @@
  */
 
 #include "audio_simple.h"
+#include "audio_mix.h"
 #include "signals.h"
+#include <algorithm>  // for min
+#include <array>
 #include <cstdint>
 
 using namespace rcSignals;
@@ -62,14 +65,16 @@ void AudioSimple::copySamples(bool /*triggerNew unused*/,
     const rcProc::SamplesInterval& interval) {
 
     auto first = interval.first;
-    auto last = interval.last;
+    const auto gains = getGains();
+    std::array<uint8_t, MIX_CHUNK_SIZE> buffer;
 
     // -- copy audio samples
-    while (active && first != last && pos < sample.size()) {
-        copySample(sample[pos], first);
-
-        pos++;
-        first++;
+    while (active && first != interval.last && pos < sample.size()) {
+        const size_t num = std::min<size_t>(
+            std::min<size_t>(interval.last - first, sample.size() - pos), buffer.size());
+        mixBlock(reader.read(sample, pos, buffer.data(), num), first, num, gains);
+        pos += num;
+        first += num;
     }
 }
 
@@ -8,6 +8,7 @@
 #define _AUDIO_SIMPLE_H_
 
 #include "audio.h"
+#include "audio_adpcm.h"
 #include "signals.h"
 #include <cstdint>
 
@@ -20,6 +21,7 @@ namespace rcAudio {
 class AudioSimple : public Audio {
     protected:
         SampleData sample;  ///< The sample that should be played.
+        SampleReader reader; ///< Reads (and decodes) the sample.
 
         /** The signal type that will trigger the sound
          *
@@ -52,6 +54,15 @@ class AudioSimple : public Audio {
         virtual void start() override;
         virtual void step(const rcProc::StepInfo& info) override;
 
+        virtual void getSignalUsage(rcProc::SignalUsage& usage) const override {
+            usage.read(triggerType);
+            usage.audio = true;
+        }
+
+        virtual void relocateSamples(std::span<const uint8_t> from, const uint8_t* to) override {
+            sample.relocate(from, to);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const AudioSimple&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, AudioSimple&);
 };
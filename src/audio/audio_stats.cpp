@@ -0,0 +1,112 @@
+/* RC engine sound & light controller for Arduino ESP32.
+ *
+ * Contains the statistics about the audio output.
+ *
+ */
+
+#include "audio_stats.h"
+#include "clock.h"
+
+static rcAudio::AudioStats singletonStats(rcAudio::getRingbuffer());
+
+namespace rcAudio {
+
+AudioStats::AudioStats(const AudioRingbuffer& ringbufferVal) :
+    ringbuffer(ringbufferVal),
+    underruns(0u),
+    overruns(0u),
+    blocksRendered(0u),
+    blocksPlayed(0u),
+    fillSum(0u) {
+
+    for (auto& bucket : latency) {
+        bucket.store(0u, std::memory_order_relaxed);
+    }
+    renderTimeUs.fill(0u);
+}
+
+uint32_t AudioStats::nowUs() {
+    return static_cast<uint32_t>(rcSignals::getTimeUs());
+}
+
+void AudioStats::blocksFull(const rcProc::SamplesInterval& interval, uint32_t timeUs) {
+    uint32_t num = 0u;
+    for (auto pos = interval.first; pos < interval.last; pos += AudioRingbuffer::BLOCK_SIZE) {
+        renderTimeUs[ringbuffer.getBlockIndex(pos)] = timeUs;
+        num++;
+    }
+    blocksRendered.fetch_add(num, std::memory_order_relaxed);
+}
+
+void AudioStats::blockPlayed(const rcProc::SamplesInterval& interval,
+                             uint8_t numFull, uint32_t timeUs) {
+
+    fillSum.fetch_add(numFull * 100u, std::memory_order_relaxed);
+
+    if (interval.first == interval.last) {
+        underruns.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+
+    // wrap around of the time stamps is fine for the difference
+    const uint32_t latencyUs = timeUs - renderTimeUs[ringbuffer.getBlockIndex(interval.first)];
+    size_t bucket = 0u;
+    while (bucket < LATENCY_BUCKET_LIMITS_US.size() &&
+           latencyUs >= LATENCY_BUCKET_LIMITS_US[bucket]) {
+        bucket++;
+    }
+    latency[bucket].fetch_add(1u, std::memory_order_relaxed);
+    blocksPlayed.fetch_add(1u, std::memory_order_relaxed);
+}
+
+AudioStatsReport AudioStats::getTotals() const {
+    AudioStatsReport report;
+    report.periodMs = 0u;
+    report.underruns = underruns.load(std::memory_order_relaxed);
+    report.overruns = overruns.load(std::memory_order_relaxed);
+    report.blocksRendered = blocksRendered.load(std::memory_order_relaxed);
+    report.blocksPlayed = blocksPlayed.load(std::memory_order_relaxed);
+    report.fillAvg = 0u;  // the sampler does the averaging
+    for (size_t i = 0u; i < latency.size(); i++) {
+        report.latency[i] = latency[i].load(std::memory_order_relaxed);
+    }
+    return report;
+}
+
+AudioStatsSampler::AudioStatsSampler(const AudioStats& statsVal) :
+    stats(statsVal),
+    lastTotals(statsVal.getTotals()),
+    lastFillSum(statsVal.getFillSum()),
+    lastTimeUs(AudioStats::nowUs()) {
+}
+
+AudioStatsReport AudioStatsSampler::sample(uint32_t timeUs) {
+    const AudioStatsReport totals = stats.getTotals();
+    const uint32_t fillSum = stats.getFillSum();
+
+    AudioStatsReport report;
+    report.periodMs = (timeUs - lastTimeUs) / 1000u;
+    report.underruns = totals.underruns - lastTotals.underruns;
+    report.overruns = totals.overruns - lastTotals.overruns;
+    report.blocksRendered = totals.blocksRendered - lastTotals.blocksRendered;
+    report.blocksPlayed = totals.blocksPlayed - lastTotals.blocksPlayed;
+    for (size_t i = 0u; i < report.latency.size(); i++) {
+        report.latency[i] = totals.latency[i] - lastTotals.latency[i];
+    }
+
+    // every DMA buffer (played or silence) is one fill level sample
+    const uint32_t numFill = report.blocksPlayed + report.underruns;
+    report.fillAvg = (numFill == 0u) ? 0u :
+        static_cast<uint16_t>((fillSum - lastFillSum) / numFill);
+
+    lastTotals = totals;
+    lastFillSum = fillSum;
+    lastTimeUs = timeUs;
+    return report;
+}
+
+AudioStats& getAudioStats() {
+    return singletonStats;
+}
+
+} // namespace
@@ -0,0 +1,151 @@
+/* RC engine sound & light controller for Arduino ESP32.
+ *
+ * Contains the statistics about the audio output.
+ *
+ */
+
+#ifndef _AUDIO_STATS_H_
+#define _AUDIO_STATS_H_
+
+#include "proc.h"
+#include "audio_ringbuffer.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rcAudio {
+
+/** Number of buckets in the render to DMA latency histogram. */
+static constexpr size_t NUM_LATENCY_BUCKETS = 8;
+
+/** Upper limits of the latency buckets in micro seconds.
+ *
+ *  The last bucket contains everything above the last limit.
+ */
+static constexpr std::array<uint32_t, NUM_LATENCY_BUCKETS - 1> LATENCY_BUCKET_LIMITS_US = {
+    10000u, 20000u, 30000u, 40000u, 60000u, 80000u, 120000u};
+
+/** The audio statistics for one reporting period.
+ *
+ *  Created by the AudioStatsSampler.
+ */
+struct AudioStatsReport {
+    uint32_t periodMs;        ///< Length of the reporting period
+    uint32_t underruns;       ///< DMA buffers filled with silence (no full block)
+    uint32_t overruns;        ///< DMA buffers re-played because the audio task was late
+    uint32_t blocksRendered;  ///< Ringbuffer blocks filled by the audio procs
+    uint32_t blocksPlayed;    ///< Ringbuffer blocks written to the DMA buffers
+
+    /** Average number of full blocks in the ringbuffer when a DMA buffer
+     *  was filled (in 1/100 blocks).
+     */
+    uint16_t fillAvg;
+
+    /** Number of blocks per render to DMA latency bucket. */
+    std::array<uint32_t, NUM_LATENCY_BUCKETS> latency;
+
+    /** Returns the count scaled to one second. */
+    uint32_t perSecond(uint32_t count) const {
+        if (periodMs == 0u) {
+            return 0u;
+        }
+        return static_cast<uint32_t>(static_cast<uint64_t>(count) * 1000u / periodMs);
+    }
+};
+
+/** This class collects statistics about the audio output.
+ *
+ *  The counters are written lock-free by the render task (producer)
+ *  and the audio task (consumer) of the AudioRingbuffer.
+ *  They only ever increase. Use the AudioStatsSampler to get
+ *  the values for a reporting period.
+ */
+class AudioStats {
+    private:
+        const AudioRingbuffer& ringbuffer;
+
+        std::atomic<uint32_t> underruns;
+        std::atomic<uint32_t> overruns;
+        std::atomic<uint32_t> blocksRendered;
+        std::atomic<uint32_t> blocksPlayed;
+        std::atomic<uint32_t> fillSum;  ///< Sum of the full blocks in 1/100 blocks
+        std::array<std::atomic<uint32_t>, NUM_LATENCY_BUCKETS> latency;
+
+        /** The time when each ringbuffer block was rendered.
+         *
+         *  Written by the producer before the block is handed over
+         *  and read by the consumer after it got the block, so the
+         *  ringbuffer takes care of the synchronization.
+         */
+        std::array<uint32_t, AudioRingbuffer::NUM_BLOCKS> renderTimeUs;
+
+    public:
+        /** You might not want to create the stats yourself.
+         *  Instead use the getAudioStats function.
+         *
+         *  @param ringbufferVal The ringbuffer between the render task and
+         *    the audio task.
+         */
+        AudioStats(const AudioRingbuffer& ringbufferVal);
+
+        /** Returns the time stamp (rcSignals::getTimeUs()) used for the statistics. */
+        static uint32_t nowUs();
+
+        /** Records the blocks in the interval as rendered.
+         *
+         *  Call this function from the producer before setBlocksFull().
+         */
+        void blocksFull(const rcProc::SamplesInterval& interval, uint32_t timeUs);
+
+        /** Records the block in the interval as played.
+         *
+         *  Call this function from the consumer after getFullBlocks().
+         *  An empty interval is counted as underrun.
+         *
+         *  @param interval The block written to the DMA buffer.
+         *  @param numFull The number of full blocks before getFullBlocks().
+         *  @param timeUs The current time.
+         */
+        void blockPlayed(const rcProc::SamplesInterval& interval,
+                         uint8_t numFull, uint32_t timeUs);
+
+        /** Records DMA buffers that could not be filled in time. */
+        void countOverruns(uint32_t num) {
+            overruns.fetch_add(num, std::memory_order_relaxed);
+        }
+
+        /** Returns the totals since start (with periodMs and fillAvg set to 0). */
+        AudioStatsReport getTotals() const;
+
+        /** Returns the sum of all fill level samples in 1/100 blocks. */
+        uint32_t getFillSum() const {
+            return fillSum.load(std::memory_order_relaxed);
+        }
+};
+
+/** Creates the AudioStatsReport for consecutive periods.
+ *
+ *  Every reader (e.g. the status output and the bluetooth
+ *  characteristic) should use it's own sampler.
+ */
+class AudioStatsSampler {
+    private:
+        const AudioStats& stats;
+        AudioStatsReport lastTotals;
+        uint32_t lastFillSum;
+        uint32_t lastTimeUs;
+
+    public:
+        AudioStatsSampler(const AudioStats& statsVal);
+
+        /** Returns the statistics since the last call. */
+        AudioStatsReport sample(uint32_t timeUs);
+};
+
+/** Returns the audio statistics used globally. */
+AudioStats& getAudioStats();
+
+} // namespace
+
+#endif // _AUDIO_STATS_H_
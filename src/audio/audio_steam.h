@@ -80,6 +80,12 @@ class AudioSteam : public Audio {
         virtual void start() override;
         virtual void step(const rcProc::StepInfo& info) override;
 
+        virtual void getSignalUsage(rcProc::SignalUsage& usage) const override {
+            usage.read(rcSignals::SignalType::ST_RPM);
+            usage.read(rcSignals::SignalType::ST_THROTTLE);
+            usage.audio = true;
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const AudioSteam&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, AudioSteam&);
 };
@@ -13,22 +13,12 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 
+#include "shared_buffer.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/** A C style span for usage in the queues. */
-typedef struct {
-    /** Pointer to dynamically allocated buffer.
-     *
-     *  Make sure to free after use.
-     */
-    uint8_t* data;
-
-    /** Filled size of the data. */
-    size_t len;
-} QueueByteBuffer;
-
 /** Initializes and starts the bluetooth component (in a thread)
  *
  *  nv_flash_init should have been called before
@@ -42,23 +32,49 @@ void btNotify(void);
 /** Stops the bluetooth component */
 void btStop(void);
 
-/** Message queue containing a byte buffer with the latest signals. */
-extern QueueHandle_t queueOutSignals;
+/* The output slots hold the latest SharedBuffer published by the main task.
+ * The GATT callbacks acquire it, send it and release it again.
+ *
+ * The input queues contain SharedBuffer pointers with one reference
+ * that the receiver has to release after use.
+ */
+
+/** Slot containing a byte buffer with the latest signals. */
+extern SharedBufferSlot* slotOutSignals;
 
 /** Message queue containing a byte buffer signals received via bluetooth. */
 extern QueueHandle_t queueInSignals;
 
-/** Message queue containing the current (proc) configuration. */
-extern QueueHandle_t queueOutConfig;
+/** Slot containing the current (proc) configuration. */
+extern SharedBufferSlot* slotOutConfig;
 
 /** Message queue containing (proc) configuration received via bluetooth. */
 extern QueueHandle_t queueInConfig;
 
+/** Number of audio commands the audio queue can hold.
+ *
+ *  This is also the window for the sequenced sample upload: the
+ *  client may send this many chunks before waiting for an acknowledge.
+ */
+#define AUDIO_QUEUE_DEPTH 16
+
 /** Message queue containing audio data received via bluetooth. */
 extern QueueHandle_t queueInAudio;
 
-/** Message queue containing audio list to send via bluetooth. */
-extern QueueHandle_t queueOutAudioList;
+/** Slot containing the acknowledge of the sequenced audio upload. */
+extern SharedBufferSlot* slotOutAudioAck;
+
+/** Slot containing audio list to send via bluetooth. */
+extern SharedBufferSlot* slotOutAudioList;
+
+/** Slot containing the latest audio statistics. */
+extern SharedBufferSlot* slotOutAudioStats;
+
+/** Slot containing the latest proc step time report. */
+extern SharedBufferSlot* slotOutProfile;
+
+/** Message queue containing profiler commands received via bluetooth. */
+extern QueueHandle_t queueInProfile;
 
 #ifdef __cplusplus
 }
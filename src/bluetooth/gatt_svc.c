@@ -4,7 +4,7 @@
  */
 
 /* Includes */
-#include "bluetooth.h" // for the queue definitions
+#include "bluetooth.h" // for the queue and slot definitions
 
 #include "gatt_svc.h"
 
@@ -25,11 +25,17 @@ static const char *model_num = "0.1";
 /** Signals (3.3.3.2.) Characteristic User Description */
 static const char* const signals_user_descr = "An array of signed 16 bit values describing the internal controller signals.";
 
+/** Signals (3.3.3.2.) Characteristic User Description */
+static const char* const audio_stats_user_descr = "Audio output statistics: glitch counters and render to DMA latency histogram.";
+
+/** Signals (3.3.3.2.) Characteristic User Description */
+static const char* const profile_user_descr = "Step times of the procs. Write 1 to switch profiling on, 0 for off.";
+
 /** Signals (3.3.3.2.) Characteristic User Description */
 static const char* const config_user_descr = "A binary encode stream containing the controller configuration.";
 
 /** Signals (3.3.3.2.) Characteristic User Description */
-static const char* const audio_user_descr = "A binary command to modify custom audio samples.";
+static const char* const audio_user_descr = "A binary command to modify custom audio samples. Read for the upload acknowledge.";
 
 /** Signals (3.3.3.2.) Characteristic User Description */
 static const char* const audio_list_user_descr = "A binary stream containing a list of custom audio samples.";
@@ -43,6 +49,8 @@ static const char* const audio_list_user_descr = "A binary stream containing a l
 /* Private function declarations */
 
 uint16_t signals_chr_val_handle;
+uint16_t audio_stats_chr_val_handle;
+uint16_t profile_chr_val_handle;
 uint16_t config_chr_val_handle;
 uint16_t audio_chr_val_handle;
 uint16_t audio_list_chr_val_handle;
@@ -52,12 +60,13 @@ struct GenericAccessArgs {
     char* characteristicsName;
     uint16_t* characteristicsValHandle;
     QueueHandle_t* inQueue;
-    QueueHandle_t* outQueue;
+    SharedBufferSlot** outSlot;
 };
 
 /** Generic characteristic access function.
  *
- *  This function reads and writes to queues of QueueByteBuffers.
+ *  This function reads from the out slot and writes SharedBuffers
+ *  to the in queue.
  *
  *  @param[in] arg  A struct of the type GenericAccessArgs
  */
@@ -65,13 +74,17 @@ static int generic_chr_access(uint16_t conn_handle, uint16_t attr_handle,
                                  struct ble_gatt_access_ctxt *ctxt, void *arg);
 
 struct GenericAccessArgs signalsArgs = {"signals", &signals_chr_val_handle,
-    &queueInSignals, &queueOutSignals};
+    &queueInSignals, &slotOutSignals};
+struct GenericAccessArgs audioStatsArgs = {"audioStats", &audio_stats_chr_val_handle,
+    NULL, &slotOutAudioStats};
+struct GenericAccessArgs profileArgs = {"profile", &profile_chr_val_handle,
+    &queueInProfile, &slotOutProfile};
 struct GenericAccessArgs configArgs = {"config", &config_chr_val_handle,
-    &queueInConfig, &queueOutConfig};
+    &queueInConfig, &slotOutConfig};
 struct GenericAccessArgs audioArgs = {"audio", &audio_chr_val_handle,
-    &queueInAudio, NULL};
+    &queueInAudio, &slotOutAudioAck};
 struct GenericAccessArgs audioListArgs = {"audioList", &audio_list_chr_val_handle,
-    NULL, &queueOutAudioList};
+    NULL, &slotOutAudioList};
 
 static int device_info_chr_access(uint16_t conn_handle, uint16_t attr_handle,
                                  struct ble_gatt_access_ctxt *ctxt, void *arg);
@@ -102,6 +115,16 @@ static const ble_uuid128_t signals_chr_uuid =
     BLE_UUID128_INIT(0xa8, 0x56, 0xb5, 0xf9, 0xb3, 0x3f, 0x4f, 0x26,
                      0xb2, 0x50, 0x71, 0x2c, 0x81, 0x42, 0x7d, 0x17);
 
+/// UUID for the audio statistics characteristics.
+static const ble_uuid128_t audio_stats_chr_uuid =
+    BLE_UUID128_INIT(0xa8, 0x56, 0xb5, 0xf9, 0xb3, 0x3f, 0x4f, 0x26,
+                     0xb2, 0x50, 0x71, 0x2c, 0x81, 0x42, 0x7d, 0x1B);
+
+/// UUID for the proc profile characteristics.
+static const ble_uuid128_t profile_chr_uuid =
+    BLE_UUID128_INIT(0xa8, 0x56, 0xb5, 0xf9, 0xb3, 0x3f, 0x4f, 0x26,
+                     0xb2, 0x50, 0x71, 0x2c, 0x81, 0x42, 0x7d, 0x1C);
+
 /// UUID for the rc config service. Random
 static const ble_uuid128_t config_svc_uuid =
     BLE_UUID128_INIT(0x3f, 0x39, 0x2d, 0xb4, 0x40, 0x3a, 0x42, 0x20,
@@ -148,8 +171,44 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
                     },
                 .val_handle = &signals_chr_val_handle,
                 .cpfd = NULL,  // client presentation format description
-            }, { 0, }  // No more characteristics in this service.
             },
+
+            // -- audio statistics characteristics
+            {
+                .uuid = &audio_stats_chr_uuid.u,
+                .access_cb = generic_chr_access,
+                .arg = &audioStatsArgs,
+                .flags = BLE_GATT_CHR_F_READ,
+                .descriptors =
+                    (struct ble_gatt_dsc_def[]) { {
+                        // characteristic user description (see: 3.3.3.2.)
+                        .uuid = BLE_UUID16_DECLARE(GATT_CHAR_USER_DESCR_UUID),
+                        .att_flags = BLE_ATT_F_READ,
+                        .access_cb = generic_desc_chr_access,
+                        .arg = (void*)audio_stats_user_descr,
+                    }, { 0, } },  // No more descriptors in this characteristic
+                .val_handle = &audio_stats_chr_val_handle,
+                .cpfd = NULL,  // client presentation format description
+            },
+
+            // -- proc profile characteristics
+            {
+                .uuid = &profile_chr_uuid.u,
+                .access_cb = generic_chr_access,
+                .arg = &profileArgs,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                .descriptors =
+                    (struct ble_gatt_dsc_def[]) { {
+                        // characteristic user description (see: 3.3.3.2.)
+                        .uuid = BLE_UUID16_DECLARE(GATT_CHAR_USER_DESCR_UUID),
+                        .att_flags = BLE_ATT_F_READ,
+                        .access_cb = generic_desc_chr_access,
+                        .arg = (void*)profile_user_descr,
+                    }, { 0, } },  // No more descriptors in this characteristic
+                .val_handle = &profile_chr_val_handle,
+                .cpfd = NULL,  // client presentation format description
+            },
+            { 0, } },  // No more characteristics in this service.
     },
 
     // Service: rc config
@@ -180,7 +239,7 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
                 .uuid = &audio_chr_uuid.u,
                 .access_cb = generic_chr_access,
                 .arg = &audioArgs,
-                .flags =  BLE_GATT_CHR_F_WRITE,
+                .flags =  BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
                 .descriptors =
                     (struct ble_gatt_dsc_def[]) { {
                         // characteristic user description (see: 3.3.3.2.)
@@ -236,19 +295,24 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
 };
 
 
-/** Peeks on the given queue and appends it to the ctxt for sending. */
-static int sendTopQueue(QueueHandle_t queue, struct ble_gatt_access_ctxt *ctxt) {
-
-    QueueByteBuffer buffer;
-    if (xQueuePeek(queue, (void*)&buffer, (TickType_t)0)) {
-        // too many messages ESP_LOGI(TAG, "sendTopQueue; 1=%c 2=%c len=%d", buffer.data[0], buffer.data[1], buffer.len);
-        int rc = os_mbuf_append(ctxt->om,
-                            buffer.data,
-                            buffer.len);
+/** Appends the latest buffer of the slot to the ctxt for sending.
+ *
+ *  The buffer is not copied beforehand. Our reference keeps it alive
+ *  even if the main task publishes a new one in the mean time.
+ */
+static int sendSlot(SharedBufferSlot* slot, struct ble_gatt_access_ctxt *ctxt) {
 
-        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    SharedBuffer* buffer = sharedBufferSlotAcquire(slot);
+    if (buffer == NULL) {
+        return BLE_ATT_ERR_READ_NOT_PERMITTED;
     }
-    return BLE_ATT_ERR_READ_NOT_PERMITTED;
+
+    int rc = os_mbuf_append(ctxt->om,
+                        sharedBufferData(buffer),
+                        sharedBufferLen(buffer));
+    sharedBufferRelease(buffer);
+
+    return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
 }
 
 
@@ -258,25 +322,25 @@ static int receiveToQueue(QueueHandle_t queue, struct ble_gatt_access_ctxt *ctxt
 
     uint16_t om_len = OS_MBUF_PKTLEN(ctxt->om);
 
-    QueueByteBuffer buffer = {
-        .data = malloc(om_len),
-        .len = om_len
-    };
-    if (buffer.data == NULL) {
+    SharedBuffer* buffer = sharedBufferCreate(om_len);
+    if (buffer == NULL) {
         return BLE_ATT_ERR_UNLIKELY;
     }
 
     uint16_t actualLen = 0;
-    int rc = ble_hs_mbuf_to_flat(ctxt->om, buffer.data, buffer.len, &actualLen);
-    ESP_LOGI(TAG, "receiveToQueue; omLen=%u len=%u rc=%d", om_len, actualLen, rc);
+    int rc = ble_hs_mbuf_to_flat(ctxt->om, sharedBufferData(buffer), om_len, &actualLen);
+    // debug only, sample uploads write many chunks in a row
+    ESP_LOGD(TAG, "receiveToQueue; omLen=%u len=%u rc=%d", om_len, actualLen, rc);
 
     if (rc != 0) {
-        free(buffer.data);
+        sharedBufferRelease(buffer);
         return BLE_ATT_ERR_UNLIKELY;
     }
+    sharedBufferSetLen(buffer, actualLen);
 
+    // the receiver takes over our reference
     if (xQueueSendToBack(queue, (void*)&buffer, (TickType_t)0) != pdPASS) {
-        free(buffer.data);
+        sharedBufferRelease(buffer);
         return BLE_ATT_ERR_UNLIKELY;
     }
 
@@ -389,18 +453,18 @@ static int generic_chr_access(uint16_t conn_handle, uint16_t attr_handle,
         }
         */
 
-        if (aArgs->outQueue != NULL) {
-            return sendTopQueue(*(aArgs->outQueue), ctxt);
+        if (aArgs->outSlot != NULL) {
+            return sendSlot(*(aArgs->outSlot), ctxt);
         } else {
             return BLE_ATT_ERR_READ_NOT_PERMITTED;
         }
 
     } else if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
         if (conn_handle != BLE_HS_CONN_HANDLE_NONE) {
-            ESP_LOGI(TAG, "Descriptor write; %s conn_handle=%d attr_handle=%d",
+            ESP_LOGD(TAG, "Descriptor write; %s conn_handle=%d attr_handle=%d",
                         aArgs->characteristicsName, conn_handle, attr_handle);
         } else {
-            ESP_LOGI(TAG, "Descriptor write by NimBLE stack; %s attr_handle=%d",
+            ESP_LOGD(TAG, "Descriptor write by NimBLE stack; %s attr_handle=%d",
                         aArgs->characteristicsName, attr_handle);
         }
 
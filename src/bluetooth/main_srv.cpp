@@ -15,12 +15,16 @@
 #include "gap.h"
 #include "gatt_svc.h"
 
-QueueHandle_t queueOutSignals = NULL;
+SharedBufferSlot* slotOutSignals = NULL;
 QueueHandle_t queueInSignals = NULL;
-QueueHandle_t queueOutConfig = NULL;
+SharedBufferSlot* slotOutConfig = NULL;
 QueueHandle_t queueInConfig = NULL;
 QueueHandle_t queueInAudio = NULL;
-QueueHandle_t queueOutAudioList = NULL;
+SharedBufferSlot* slotOutAudioAck = NULL;
+SharedBufferSlot* slotOutAudioList = NULL;
+SharedBufferSlot* slotOutAudioStats = NULL;
+SharedBufferSlot* slotOutProfile = NULL;
+QueueHandle_t queueInProfile = NULL;
 
 /* Library function declarations */
 
@@ -75,13 +79,17 @@ static void nimble_host_task(void *param) {
 
 void btStart(void) {
 
-    // setup my queues
-    queueOutSignals   = xQueueCreate(1, sizeof(QueueByteBuffer));
-    queueInSignals    = xQueueCreate(1, sizeof(QueueByteBuffer));
-    queueOutConfig    = xQueueCreate(1, sizeof(QueueByteBuffer));
-    queueInConfig     = xQueueCreate(1, sizeof(QueueByteBuffer));
-    queueInAudio      = xQueueCreate(1, sizeof(QueueByteBuffer));
-    queueOutAudioList = xQueueCreate(1, sizeof(QueueByteBuffer));
+    // setup my queues and slots
+    slotOutSignals    = sharedBufferSlotCreate();
+    queueInSignals    = xQueueCreate(1, sizeof(SharedBuffer*));
+    slotOutConfig     = sharedBufferSlotCreate();
+    queueInConfig     = xQueueCreate(1, sizeof(SharedBuffer*));
+    queueInAudio      = xQueueCreate(AUDIO_QUEUE_DEPTH, sizeof(SharedBuffer*));
+    slotOutAudioAck   = sharedBufferSlotCreate();
+    slotOutAudioList  = sharedBufferSlotCreate();
+    slotOutAudioStats = sharedBufferSlotCreate();
+    slotOutProfile    = sharedBufferSlotCreate();
+    queueInProfile    = xQueueCreate(1, sizeof(SharedBuffer*));
 
     ESP_ERROR_CHECK(
         nimble_port_init());
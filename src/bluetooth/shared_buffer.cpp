@@ -0,0 +1,125 @@
+/** Reference counted byte buffers shared between the main task
+ *  and the bluetooth (NimBLE) callbacks.
+ *
+ *  @file
+ */
+
+#include "shared_buffer.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+/** The header of a SharedBuffer.
+ *
+ *  The data directly follows the header in the same allocation.
+ */
+struct SharedBuffer {
+    std::atomic<uint32_t> refs;
+    size_t capacity;
+    size_t len;
+};
+
+struct SharedBufferSlot {
+    std::mutex mutex;
+    SharedBuffer* buffer = nullptr;
+};
+
+/** Number of currently allocated buffers. */
+static std::atomic<size_t> numAllocated(0u);
+
+extern "C" {
+
+SharedBuffer* sharedBufferCreate(size_t capacity) {
+    void* mem = malloc(sizeof(SharedBuffer) + capacity);
+    if (mem == nullptr) {
+        return nullptr;
+    }
+    numAllocated.fetch_add(1u, std::memory_order_relaxed);
+
+    auto buffer = new(mem) SharedBuffer;
+    buffer->refs.store(1u, std::memory_order_relaxed);
+    buffer->capacity = capacity;
+    buffer->len = capacity;
+    return buffer;
+}
+
+void sharedBufferRetain(SharedBuffer* buffer) {
+    buffer->refs.fetch_add(1u, std::memory_order_relaxed);
+}
+
+void sharedBufferRelease(SharedBuffer* buffer) {
+    if (buffer == nullptr) {
+        return;
+    }
+
+    // acq_rel so that all accesses of the other owners happen
+    // before the free.
+    if (buffer->refs.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+        buffer->~SharedBuffer();
+        free(buffer);
+        numAllocated.fetch_sub(1u, std::memory_order_relaxed);
+    }
+}
+
+uint8_t* sharedBufferData(SharedBuffer* buffer) {
+    return reinterpret_cast<uint8_t*>(buffer + 1);
+}
+
+size_t sharedBufferLen(const SharedBuffer* buffer) {
+    return buffer->len;
+}
+
+void sharedBufferSetLen(SharedBuffer* buffer, size_t len) {
+    buffer->len = (len < buffer->capacity) ? len : buffer->capacity;
+}
+
+size_t sharedBufferCapacity(const SharedBuffer* buffer) {
+    return buffer->capacity;
+}
+
+uint32_t sharedBufferRefs(const SharedBuffer* buffer) {
+    return buffer->refs.load(std::memory_order_acquire);
+}
+
+size_t sharedBufferNumAllocated(void) {
+    return numAllocated.load(std::memory_order_relaxed);
+}
+
+SharedBufferSlot* sharedBufferSlotCreate(void) {
+    return new(std::nothrow) SharedBufferSlot();
+}
+
+void sharedBufferSlotDestroy(SharedBufferSlot* slot) {
+    if (slot != nullptr) {
+        sharedBufferRelease(slot->buffer);
+        delete slot;
+    }
+}
+
+void sharedBufferSlotPublish(SharedBufferSlot* slot, SharedBuffer* buffer) {
+    SharedBuffer* old;
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        old = slot->buffer;
+        slot->buffer = buffer;
+    }
+    // readers that acquired the old buffer still hold their own reference
+    sharedBufferRelease(old);
+}
+
+SharedBuffer* sharedBufferSlotAcquire(SharedBufferSlot* slot) {
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (slot->buffer != nullptr) {
+        sharedBufferRetain(slot->buffer);
+    }
+    return slot->buffer;
+}
+
+bool sharedBufferSlotIsEmpty(SharedBufferSlot* slot) {
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    return slot->buffer == nullptr;
+}
+
+} // extern "C"
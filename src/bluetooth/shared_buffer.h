@@ -0,0 +1,164 @@
+/** Reference counted byte buffers shared between the main task
+ *  and the bluetooth (NimBLE) callbacks.
+ *
+ *  @file
+ *
+ *  A SharedBuffer is freed once the last reference is released.
+ *  This allows the GATT callbacks to send the buffer directly
+ *  (without copying it first) while the main task already
+ *  publishes the next one.
+ *
+ *  A SharedBufferSlot holds the latest published buffer for one
+ *  characteristic.
+ */
+
+#ifndef _RC_SHARED_BUFFER_
+#define _RC_SHARED_BUFFER_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>  // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** A reference counted byte buffer. */
+typedef struct SharedBuffer SharedBuffer;
+
+/** Holds the latest published SharedBuffer. */
+typedef struct SharedBufferSlot SharedBufferSlot;
+
+/** Creates a new buffer with the given capacity.
+ *
+ *  The length is initialized with the capacity.
+ *
+ *  @returns A buffer with one reference or NULL if out of memory.
+ */
+SharedBuffer* sharedBufferCreate(size_t capacity);
+
+/** Adds a reference to the buffer. */
+void sharedBufferRetain(SharedBuffer* buffer);
+
+/** Removes a reference from the buffer and frees it on the last one.
+ *
+ *  NULL is ignored.
+ */
+void sharedBufferRelease(SharedBuffer* buffer);
+
+/** Returns the data of the buffer. */
+uint8_t* sharedBufferData(SharedBuffer* buffer);
+
+/** Returns the filled size of the buffer. */
+size_t sharedBufferLen(const SharedBuffer* buffer);
+
+/** Sets the filled size of the buffer (at most the capacity). */
+void sharedBufferSetLen(SharedBuffer* buffer, size_t len);
+
+/** Returns the allocated size of the buffer. */
+size_t sharedBufferCapacity(const SharedBuffer* buffer);
+
+/** Returns the number of references to the buffer. */
+uint32_t sharedBufferRefs(const SharedBuffer* buffer);
+
+/** Returns the number of buffers currently allocated.
+ *
+ *  For statistics and tests.
+ */
+size_t sharedBufferNumAllocated(void);
+
+/** Creates a new and empty slot.
+ *
+ *  @returns NULL if out of memory.
+ */
+SharedBufferSlot* sharedBufferSlotCreate(void);
+
+/** Releases the published buffer and frees the slot. */
+void sharedBufferSlotDestroy(SharedBufferSlot* slot);
+
+/** Publishes a new buffer in the slot.
+ *
+ *  The slot takes over the reference of the caller and releases
+ *  the previously published buffer.
+ *
+ *  @param[in] buffer The new buffer. NULL empties the slot.
+ */
+void sharedBufferSlotPublish(SharedBufferSlot* slot, SharedBuffer* buffer);
+
+/** Returns the published buffer with an added reference.
+ *
+ *  The caller has to release the buffer after use.
+ *
+ *  @returns NULL if nothing was published.
+ */
+SharedBuffer* sharedBufferSlotAcquire(SharedBufferSlot* slot);
+
+/** Returns true if nothing was published yet. */
+bool sharedBufferSlotIsEmpty(SharedBufferSlot* slot);
+
+#ifdef __cplusplus
+}
+
+#include <array>
+#include <span>
+
+/** Returns the filled part of the buffer as span, e.g. for SimpleInStream. */
+inline std::span<const uint8_t> sharedBufferSpan(SharedBuffer* buffer) {
+    return std::span<const uint8_t>(sharedBufferData(buffer), sharedBufferLen(buffer));
+}
+
+/** Returns the whole capacity of the buffer, e.g. for SimpleOutStream. */
+inline std::span<uint8_t> sharedBufferCapacitySpan(SharedBuffer* buffer) {
+    return std::span<uint8_t>(sharedBufferData(buffer), sharedBufferCapacity(buffer));
+}
+
+/** A small set of SharedBuffers with fixed capacity.
+ *
+ *  Used for messages that are published periodically, so that
+ *  there is no allocation in the main loop.
+ *  A buffer is reused once nobody but the pool references it.
+ */
+template<size_t N>
+class SharedBufferPool {
+    private:
+        std::array<SharedBuffer*, N> buffers;
+
+    public:
+        explicit SharedBufferPool(size_t capacity) {
+            for (auto& buffer : buffers) {
+                buffer = sharedBufferCreate(capacity);
+            }
+        }
+
+        ~SharedBufferPool() {
+            for (auto buffer : buffers) {
+                sharedBufferRelease(buffer);
+            }
+        }
+
+        SharedBufferPool(const SharedBufferPool&) = delete;
+        SharedBufferPool& operator=(const SharedBufferPool&) = delete;
+
+        /** Returns a currently unused buffer with an added reference.
+         *
+         *  Only one task may get buffers from the pool.
+         *
+         *  @returns nullptr if all buffers are still in use.
+         */
+        SharedBuffer* get() {
+            for (auto buffer : buffers) {
+                // Nobody else can add a reference to a buffer that is
+                // only referenced by the pool.
+                if (buffer != nullptr && sharedBufferRefs(buffer) == 1u) {
+                    sharedBufferRetain(buffer);
+                    sharedBufferSetLen(buffer, sharedBufferCapacity(buffer));
+                    return buffer;
+                }
+            }
+            return nullptr;
+        }
+};
+
+#endif // __cplusplus
+
+#endif // _RC_SHARED_BUFFER_
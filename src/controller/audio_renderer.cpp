@@ -0,0 +1,64 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation of the audio renderer.
+ *
+ *  @file
+*/
+
+#include "audio_renderer.h"
+#include "proc_storage.h"
+#include "proc.h"
+#include "audio.h"
+
+#include <mutex>
+
+using namespace rcAudio;
+
+AudioRenderer::AudioRenderer(ProcStorage& storageVal,
+                             AudioRingbuffer& ringbufferVal,
+                             rcSignals::SignalsSnapshot& snapshotVal,
+                             AudioStats& statsVal) :
+    storage(storageVal),
+    ringbuffer(ringbufferVal),
+    snapshot(snapshotVal),
+    stats(statsVal),
+    numSamples(0u) {
+
+    signals.reset();
+}
+
+uint32_t AudioRenderer::render(uint32_t maxBlocks) {
+
+    // don't wait for the main task, it might take a while.
+    // the consumer will play silence in the mean time.
+    std::unique_lock<std::mutex> lock(storage.getAudioMutex(), std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return 0u;
+    }
+
+    auto interval = ringbuffer.getEmptyBlocks(maxBlocks);
+    const uint32_t num = interval.last - interval.first;
+    if (num == 0u) {
+        return 0u;
+    }
+
+    const uint64_t oldMs = numSamples * 1000u / SAMPLE_RATE;
+    numSamples += num;
+    const uint64_t newMs = numSamples * 1000u / SAMPLE_RATE;
+
+    signals = snapshot.read();
+
+    rcProc::StepInfo info = {
+        .deltaMs = static_cast<rcSignals::TimeMs>(newMs - oldMs),
+        .signals = &signals,
+        .intervals = {
+            interval,
+            rcProc::SamplesInterval{.first = interval.last, .last = interval.last}
+        }
+    };
+    storage.stepAudio(info);
+
+    stats.blocksFull(interval, AudioStats::nowUs());
+    ringbuffer.setBlocksFull(interval);
+    return num / AudioRingbuffer::BLOCK_SIZE;
+}
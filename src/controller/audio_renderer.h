@@ -0,0 +1,65 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for the audio renderer.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_AUDIO_RENDERER_H_
+#define _RC_AUDIO_RENDERER_H_
+
+#include "signals.h"
+#include "signals_snapshot.h"
+#include "audio_ringbuffer.h"
+#include "audio_stats.h"
+
+#include <cstdint>
+
+class ProcStorage;
+
+/** Renders the audio procs block by block.
+ *
+ *  This is used by the dedicated audio render task (on the second core)
+ *  in separate audio mode (see ProcStorage::setSeparateAudio()).
+ *
+ *  The renderer is the producer of the AudioRingbuffer. It renders
+ *  blocks on demand, whenever the consumer frees them, reading
+ *  the latest signals published by the main task.
+ *
+ *  While the main task holds the audio mutex of the ProcStorage
+ *  (e.g. during a configuration update) nothing is rendered.
+ */
+class AudioRenderer {
+    private:
+        ProcStorage& storage;
+        rcAudio::AudioRingbuffer& ringbuffer;
+        rcSignals::SignalsSnapshot& snapshot;
+        rcAudio::AudioStats& stats;
+
+        /** Copy of the signals given to the audio procs. */
+        rcSignals::Signals signals;
+
+        /** Number of samples rendered since creation.
+         *
+         *  Used to compute the step time in ms without accumulating
+         *  rounding errors.
+         */
+        uint64_t numSamples;
+
+    public:
+        AudioRenderer(ProcStorage& storageVal,
+                      rcAudio::AudioRingbuffer& ringbufferVal,
+                      rcSignals::SignalsSnapshot& snapshotVal,
+                      rcAudio::AudioStats& statsVal);
+
+        /** Renders the next empty ringbuffer blocks.
+         *
+         *  @param maxBlocks The maximum number of blocks to render.
+         *  @returns The number of blocks rendered. 0 if the ringbuffer
+         *    is full or the ProcStorage is being modified.
+         */
+        uint32_t render(uint32_t maxBlocks = 1u);
+};
+
+#endif // _RC_AUDIO_RENDERER_H_
@@ -0,0 +1,202 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation for storing the configuration in a flash partition
+ *
+ *  @file
+*/
+
+#include "config_store.h"
+#include "crc16.h"
+
+#ifdef HAVE_NV
+#include <esp_log.h>
+
+static const char* TAG = "ConfigStore";
+#else
+#include <fstream>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#ifdef HAVE_NV
+ConfigStore::ConfigStore(const char* label) :
+    part(nullptr),
+    mapHandle(0),
+    mapPtr(nullptr),
+    slotSize(0u),
+    active(NO_SLOT) {
+
+    part = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA,
+            ESP_PARTITION_SUBTYPE_ANY,
+            label);
+
+    if (part) {
+        slotSize = part->size / NUM_SLOTS / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+
+        // map the partition to data memory
+        const void* maddr = nullptr;
+        ESP_ERROR_CHECK(
+            esp_partition_mmap(part, 0, NUM_SLOTS * slotSize, ESP_PARTITION_MMAP_DATA,
+                &maddr,
+                &mapHandle));
+        mapPtr = static_cast<const uint8_t*>(maddr);
+
+    } else {
+        ESP_LOGW(TAG, "Can't find the config partition, please define it correctly in `partitions.csv`");
+    }
+
+    scan();
+}
+
+ConfigStore::~ConfigStore() {
+    if (mapHandle != 0) {
+        esp_partition_munmap(mapHandle);
+        mapHandle = 0;
+    }
+}
+
+#else
+ConfigStore::ConfigStore(const std::string& fileNameVal) :
+    fileName(fileNameVal),
+    eraseCount(0u),
+    mapPtr(nullptr),
+    slotSize(HOST_SIZE / NUM_SLOTS),
+    active(NO_SLOT) {
+
+    uint8_t* memory = new uint8_t[HOST_SIZE];
+    std::fill(memory, memory + HOST_SIZE, 0xFFu);
+    mapPtr = memory;
+
+    if (!fileName.empty()) {
+        std::ifstream file(fileName, std::ios::binary);
+        file.read(reinterpret_cast<char*>(memory), HOST_SIZE);
+    }
+
+    scan();
+}
+
+ConfigStore::~ConfigStore() {
+    delete[] mapPtr;
+}
+#endif
+
+
+ConfigStore::SlotHeader ConfigStore::header(uint8_t slot) const {
+    SlotHeader result{};
+    if (mapPtr != nullptr && slot < NUM_SLOTS) {
+        // the mapped flash is not necessarily aligned for the struct
+        std::memcpy(&result, mapPtr + slot * slotSize, sizeof(result));
+    }
+    return result;
+}
+
+
+uint16_t ConfigStore::calcCrc(std::span<const uint8_t> data, uint32_t sequence) {
+    const uint32_t size = static_cast<uint32_t>(data.size());
+    std::array<uint8_t, 8> fields;
+    std::memcpy(fields.data(), &sequence, sizeof(sequence));
+    std::memcpy(fields.data() + sizeof(sequence), &size, sizeof(size));
+
+    return crc16le(crc16le(UINT16_MAX, data), fields);
+}
+
+
+bool ConfigStore::isValid(uint8_t slot) const {
+    const SlotHeader head = header(slot);
+    if (head.magic != MAGIC || head.size > maxSize()) {
+        return false;
+    }
+
+    std::span<const uint8_t> data(mapPtr + slot * slotSize + sizeof(SlotHeader), head.size);
+    return head.crc == calcCrc(data, head.sequence);
+}
+
+
+void ConfigStore::scan() {
+    active = NO_SLOT;
+    for (uint8_t slot = 0u; slot < NUM_SLOTS; slot++) {
+        if (isValid(slot) &&
+            (active == NO_SLOT || header(slot).sequence > header(active).sequence)) {
+            active = slot;
+        }
+    }
+}
+
+
+std::span<const uint8_t> ConfigStore::load() const {
+    if (active == NO_SLOT) {
+        return {};
+    }
+    return std::span<const uint8_t>(
+        mapPtr + active * slotSize + sizeof(SlotHeader), header(active).size);
+}
+
+
+void ConfigStore::eraseSlot(uint8_t slot) {
+#ifdef HAVE_NV
+    ESP_ERROR_CHECK(
+        esp_partition_erase_range(part, slot * slotSize, slotSize));
+#else
+    uint8_t* flashData = const_cast<uint8_t*>(mapPtr) + slot * slotSize;
+    std::fill(flashData, flashData + slotSize, 0xFFu);
+    eraseCount++;
+#endif
+}
+
+
+void ConfigStore::write(uint32_t offset, std::span<const uint8_t> data) {
+#ifdef HAVE_NV
+    ESP_ERROR_CHECK(
+        esp_partition_write(part, offset, data.data(), data.size()));
+#else
+    // like programming NOR flash, only bits are cleared
+    uint8_t* flashData = const_cast<uint8_t*>(mapPtr) + offset;
+    for (size_t i = 0u; i < data.size(); i++) {
+        flashData[i] &= data[i];
+    }
+#endif
+}
+
+
+bool ConfigStore::save(std::span<const uint8_t> data) {
+    if (mapPtr == nullptr || data.size() > maxSize()) {
+        return false;
+    }
+
+    // -- unchanged configuration
+    const auto current = load();
+    if (active != NO_SLOT && current.size() == data.size() &&
+        std::equal(data.begin(), data.end(), current.begin())) {
+        return true;
+    }
+
+    const uint8_t slot = (active == NO_SLOT) ? 0u : (active + 1u) % NUM_SLOTS;
+    const uint32_t sequence = (active == NO_SLOT) ? 1u : header(active).sequence + 1u;
+
+    eraseSlot(slot);
+    write(slot * slotSize + sizeof(SlotHeader), data);
+
+    // the header is written last, this commits the slot
+    const SlotHeader head{
+        .magic = MAGIC,
+        .crc = calcCrc(data, sequence),
+        .sequence = sequence,
+        .size = static_cast<uint32_t>(data.size())};
+    write(slot * slotSize, std::span<const uint8_t>(
+        reinterpret_cast<const uint8_t*>(&head), sizeof(head)));
+
+#ifndef HAVE_NV
+    if (!fileName.empty()) {
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(mapPtr), HOST_SIZE);
+    }
+#endif
+
+    scan();
+    return active == slot;
+}
@@ -0,0 +1,156 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for storing the configuration in a flash partition
+ *
+ *  @file
+*/
+
+#ifndef _RC_CONFIG_STORE_H_
+#define _RC_CONFIG_STORE_H_
+
+#ifdef HAVE_NV
+#include <esp_partition.h>
+#include <spi_flash_mmap.h>
+#else
+#ifndef SPI_FLASH_SEC_SIZE
+#define SPI_FLASH_SEC_SIZE 4096
+#endif
+#include <string>
+#endif
+
+#include <cstdint>
+#include <span>
+
+/** Stores the serialized configuration in the "config" flash partition.
+ *
+ *  The partition is split into two slots (A and B). A save always goes
+ *  to the slot that is not currently valid:
+ *
+ *  - the slot is erased
+ *  - the data is written after the header
+ *  - the header (with a higher sequence number and the CRC) is written last
+ *
+ *  So after a power loss during a save the old slot is still valid and
+ *  the new one is ignored because its header is missing or its CRC
+ *  doesn't match.
+ *
+ *  The partition is memory mapped, load() returns the configuration
+ *  directly from the flash without copying it.
+ *
+ *  On the host the partition is a memory buffer, optionally
+ *  backed by a file.
+ */
+class ConfigStore {
+    public:
+        /** The header at the start of every slot */
+        struct SlotHeader {
+            uint16_t magic;
+            uint16_t crc;  ///< CRC16 over the data, the sequence and the size
+            uint32_t sequence;  ///< incremented with every save
+            uint32_t size;  ///< size of the data following the header
+        };
+
+        static constexpr uint16_t MAGIC = 0xC0F1u;
+        static constexpr uint8_t NUM_SLOTS = 2u;
+        static constexpr uint8_t NO_SLOT = NUM_SLOTS;
+
+        /** Size of the partition on the host. */
+        static constexpr uint32_t HOST_SIZE = 4u * SPI_FLASH_SEC_SIZE;
+
+    private:
+#ifdef HAVE_NV
+        const esp_partition_t* part;
+        esp_partition_mmap_handle_t mapHandle;
+#else
+        /** Backing file, empty for a memory only store */
+        std::string fileName;
+
+        uint32_t eraseCount;
+#endif
+        const uint8_t* mapPtr;
+
+        /** Size of one slot (including the header), a multiple of the sector size */
+        uint32_t slotSize;
+
+        /** The slot with the newest valid configuration, NO_SLOT if none */
+        uint8_t active;
+
+        /** The header of the given slot, also if it's not valid */
+        SlotHeader header(uint8_t slot) const;
+
+        /** Checks the magic, the size and the CRC of the slot. */
+        bool isValid(uint8_t slot) const;
+
+        /** Finds the valid slot with the highest sequence number. */
+        void scan();
+
+        void eraseSlot(uint8_t slot);
+        void write(uint32_t offset, std::span<const uint8_t> data);
+
+        static uint16_t calcCrc(std::span<const uint8_t> data, uint32_t sequence);
+
+    public:
+#ifdef HAVE_NV
+        /** Maps the partition with the given label. */
+        explicit ConfigStore(const char* label = "config");
+#else
+        /** Creates an erased store.
+         *
+         *  @param fileNameVal If not empty the content is loaded from
+         *    the file and written back after every save.
+         */
+        explicit ConfigStore(const std::string& fileNameVal = "");
+#endif
+
+        ~ConfigStore();
+
+        ConfigStore(ConfigStore const&) = delete;
+        void operator=(ConfigStore const&) = delete;
+
+        /** Returns the newest valid configuration.
+         *
+         *  The span points into the mapped flash, it stays valid until the
+         *  second save() after this call (the first one writes the other slot).
+         *
+         *  @returns An empty span if no valid configuration is stored.
+         */
+        std::span<const uint8_t> load() const;
+
+        /** Stores the configuration in the inactive slot and
+         *  makes that the active one.
+         *
+         *  Nothing is written if the active slot already contains the same data.
+         *
+         *  @returns false if the data doesn't fit into a slot or there is no partition.
+         */
+        bool save(std::span<const uint8_t> data);
+
+        /** Largest configuration that can be stored */
+        uint32_t maxSize() const {
+            return (slotSize > sizeof(SlotHeader)) ? slotSize - sizeof(SlotHeader) : 0u;
+        }
+
+        /** The slot load() returns, NO_SLOT if none is valid */
+        uint8_t activeSlot() const {
+            return active;
+        }
+
+#ifndef HAVE_NV
+        /** The raw partition content (host only, to simulate broken writes in tests). */
+        std::span<uint8_t> raw() {
+            return std::span<uint8_t>(const_cast<uint8_t*>(mapPtr), NUM_SLOTS * slotSize);
+        }
+
+        /** Re-reads the slot headers, like after a restart (host only). */
+        void rescan() {
+            scan();
+        }
+
+        /** Number of erased slots (host only). */
+        uint32_t getEraseCount() const {
+            return eraseCount;
+        }
+#endif
+};
+
+#endif // _RC_CONFIG_STORE_H_
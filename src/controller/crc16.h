@@ -0,0 +1,53 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  CRC16 as used for the audio samples.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_CRC16_H_
+#define _RC_CRC16_H_
+
+#ifdef HAVE_NV
+#include <esp_crc.h>
+#endif
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#ifndef HAVE_NV
+/** Lookup table for crc16le(), the same as in esp_rom_crc.c. */
+inline constexpr auto CRC16_LE_TABLE = [] {
+    std::array<uint16_t, 256> table{};
+    for (uint16_t i = 0u; i < 256u; i++) {
+        uint16_t crc = i;
+        for (uint8_t bit = 0u; bit < 8u; bit++) {
+            crc = (crc & 1u) ? (crc >> 1) ^ 0x8408u : (crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+#endif
+
+/** Continues the CRC16 over the data.
+ *
+ *  Same as esp_crc16_le() (and esp_rom_crc16_le() in samples.js),
+ *  start with UINT16_MAX.
+ *  On the host (for the unit tests) the same table is used.
+ */
+inline uint16_t crc16le(uint16_t crc, std::span<const uint8_t> data) {
+#ifdef HAVE_NV
+    return esp_crc16_le(crc, data.data(), data.size());
+#else
+    crc = ~crc;
+    for (const uint8_t byte : data) {
+        crc = CRC16_LE_TABLE[(crc ^ byte) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+#endif
+}
+
+#endif // _RC_CRC16_H_
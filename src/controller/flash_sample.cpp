@@ -6,6 +6,7 @@
 */
 
 #include "flash_sample.h"
+#include "audio_adpcm.h"
 
 #ifdef HAVE_NV
 #include <esp_log.h>
@@ -17,8 +18,10 @@
 static const char* TAG = "FlashSample";
 #endif
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <span>
@@ -33,7 +36,8 @@ FlashSingleton::FlashSingleton() :
 #endif
     mapPtr(nullptr),
     maxSectors(0),
-    sectorBufferIndex(0) {
+    useCounter(0u),
+    statistics{} {
 
 #ifdef HAVE_NV
     part = esp_partition_find_first(
@@ -43,7 +47,6 @@ FlashSingleton::FlashSingleton() :
 
     if (part) {
         maxSectors = part->size / SPI_FLASH_SEC_SIZE;
-        sectorBufferIndex = maxSectors;
 
         // map the partition to data memory
         const void* maddr = nullptr;
@@ -58,11 +61,17 @@ FlashSingleton::FlashSingleton() :
     }
 
 #else
-    // for unit tests we just allocate some memory
-    maxSectors = 10;
-    mapPtr = new uint8_t[maxSectors * SPI_FLASH_SEC_SIZE];
+    // for unit tests we just allocate some (erased) memory
+    maxSectors = 64;
+    uint8_t* memory = new uint8_t[maxSectors * SPI_FLASH_SEC_SIZE];
+    std::fill(memory, memory + maxSectors * SPI_FLASH_SEC_SIZE, 0xFFu);
+    mapPtr = memory;
+    eraseCounts.assign(maxSectors, 0u);
 #endif
 
+    for (auto& entry : cache) {
+        entry = CacheEntry{.index = maxSectors, .validBegin = 0u, .validEnd = 0u, .lastUse = 0u};
+    }
 }
 
 FlashSingleton::~FlashSingleton() {
@@ -82,39 +91,188 @@ FlashSingleton::~FlashSingleton() {
 
 void FlashSingleton::flush() {
 
-    if (sectorBufferIndex >= maxSectors) {
-        // no buffer to flush
+    // -- collect the cached sectors sorted by index
+    std::array<uint8_t, CACHE_SECTORS> slots;
+    uint8_t numSlots = 0u;
+    for (uint8_t slot = 0u; slot < CACHE_SECTORS; slot++) {
+        if (cache[slot].index < maxSectors) {
+            slots[numSlots++] = slot;
+        }
+    }
+    std::sort(slots.begin(), slots.begin() + numSlots, [this](uint8_t a, uint8_t b) {
+        return cache[a].index < cache[b].index;
+    });
+
+    // -- write back contiguous regions
+    uint8_t first = 0u;
+    for (uint8_t i = 1u; i <= numSlots; i++) {
+        if (i == numSlots || cache[slots[i]].index != cache[slots[i - 1u]].index + 1u) {
+            writeBack(slots.data() + first, i - first);
+            first = i;
+        }
+    }
+}
+
+
+uint8_t FlashSingleton::findSlot(uint16_t index) const {
+    for (uint8_t slot = 0u; slot < CACHE_SECTORS; slot++) {
+        if (cache[slot].index == index) {
+            return slot;
+        }
+    }
+    return CACHE_SECTORS;
+}
+
+
+uint8_t FlashSingleton::getSlot(uint16_t index) {
+    uint8_t slot = findSlot(index);
+    if (slot < CACHE_SECTORS) {
+        return slot;
+    }
+
+    slot = findSlot(maxSectors);
+    if (slot >= CACHE_SECTORS) {
+        evict();
+        slot = findSlot(maxSectors);
+    }
+
+    cache[slot] = CacheEntry{.index = index, .validBegin = 0u, .validEnd = 0u, .lastUse = 0u};
+    return slot;
+}
+
+
+void FlashSingleton::writeSlot(uint8_t slot, uint32_t offset, std::span<const uint8_t> data) {
+    CacheEntry& entry = cache[slot];
+    const uint32_t end = offset + data.size();
+
+    if (entry.validBegin == entry.validEnd) {
+        entry.validBegin = offset;
+        entry.validEnd = end;
+
+    } else {
+        // a gap can only be filled from the flash content
+        if (offset > entry.validEnd || end < entry.validBegin) {
+            completeSlot(slot);
+        }
+        entry.validBegin = std::min(offset, static_cast<uint32_t>(entry.validBegin));
+        entry.validEnd = std::max(end, static_cast<uint32_t>(entry.validEnd));
+    }
+
+    std::copy(data.begin(), data.end(), cacheBuffers[slot].data() + offset);
+    entry.lastUse = ++useCounter;
+}
+
+
+void FlashSingleton::completeSlot(uint8_t slot) {
+    if (isComplete(slot)) {
+        return;
+    }
+
+    CacheEntry& entry = cache[slot];
+    const uint8_t* flashData = static_cast<const uint8_t*>(data(entry.index));
+    uint8_t* buffer = cacheBuffers[slot].data();
+    std::copy(flashData, flashData + entry.validBegin, buffer);
+    std::copy(flashData + entry.validEnd, flashData + SPI_FLASH_SEC_SIZE, buffer + entry.validEnd);
+    entry.validBegin = 0u;
+    entry.validEnd = SPI_FLASH_SEC_SIZE;
+    statistics.sectorsRead++;
+}
+
+
+bool FlashSingleton::isComplete(uint8_t slot) const {
+    return cache[slot].validBegin == 0u && cache[slot].validEnd == SPI_FLASH_SEC_SIZE;
+}
+
+
+void FlashSingleton::evict() {
+    uint8_t lru = 0u;
+    for (uint8_t slot = 1u; slot < CACHE_SECTORS; slot++) {
+        if (cache[slot].lastUse < cache[lru].lastUse) {
+            lru = slot;
+        }
+    }
+
+    // -- extend the region with complete sectors before and after
+    std::array<uint8_t, CACHE_SECTORS> slots;
+    uint8_t first = CACHE_SECTORS - 1u;
+    uint8_t last = first;
+    slots[first] = lru;
+    while (first > 0u && cache[slots[first]].index > 0u) {
+        const uint8_t slot = findSlot(cache[slots[first]].index - 1u);
+        if (slot >= CACHE_SECTORS || !isComplete(slot)) {
+            break;
+        }
+        slots[--first] = slot;
+    }
+    // shift down to make room for the sectors after the lru
+    std::copy(slots.begin() + first, slots.begin() + last + 1u, slots.begin());
+    last -= first;
+    while (last + 1u < CACHE_SECTORS && cache[slots[last]].index + 1u < maxSectors) {
+        const uint8_t slot = findSlot(cache[slots[last]].index + 1u);
+        if (slot >= CACHE_SECTORS || !isComplete(slot)) {
+            break;
+        }
+        slots[++last] = slot;
+    }
+
+    writeBack(slots.data(), last + 1u);
+}
+
+
+void FlashSingleton::writeBack(const uint8_t* slots, uint8_t numSlots) {
+    if (numSlots == 0u) {
         return;
     }
 
+    for (uint8_t i = 0u; i < numSlots; i++) {
+        completeSlot(slots[i]);
+    }
+
+    const uint16_t firstIndex = cache[slots[0]].index;
+    statistics.eraseOperations++;
+    statistics.sectorsErased += numSlots;
+    statistics.sectorsWritten += numSlots;
+
 #ifdef HAVE_NV
     if (part != nullptr) {
         ESP_ERROR_CHECK(
             esp_flash_erase_region(
                 part->flash_chip,
-                part->address + sectorBufferIndex * SPI_FLASH_SEC_SIZE,
-                SPI_FLASH_SEC_SIZE));
-
-        ESP_ERROR_CHECK(
-            esp_flash_write(
-                part->flash_chip,
-                sectorBuffer.data(),
-                part->address + sectorBufferIndex * SPI_FLASH_SEC_SIZE,
-                SPI_FLASH_SEC_SIZE));
+                part->address + firstIndex * SPI_FLASH_SEC_SIZE,
+                numSlots * SPI_FLASH_SEC_SIZE));
+
+        for (uint8_t i = 0u; i < numSlots; i++) {
+            ESP_ERROR_CHECK(
+                esp_flash_write(
+                    part->flash_chip,
+                    cacheBuffers[slots[i]].data(),
+                    part->address + cache[slots[i]].index * SPI_FLASH_SEC_SIZE,
+                    SPI_FLASH_SEC_SIZE));
+        }
     }
 #else
-    std::copy(sectorBuffer.begin(),
-        sectorBuffer.end(),
-        const_cast<uint8_t*>(mapPtr) + sectorBufferIndex * SPI_FLASH_SEC_SIZE);
+    uint8_t* flashData = const_cast<uint8_t*>(mapPtr) + firstIndex * SPI_FLASH_SEC_SIZE;
+    std::fill(flashData, flashData + numSlots * SPI_FLASH_SEC_SIZE, 0xFFu);
+    for (uint8_t i = 0u; i < numSlots; i++) {
+        eraseCounts[firstIndex + i]++;
+    }
+    for (uint8_t i = 0u; i < numSlots; i++) {
+        std::copy(cacheBuffers[slots[i]].begin(),
+            cacheBuffers[slots[i]].end(),
+            const_cast<uint8_t*>(mapPtr) + cache[slots[i]].index * SPI_FLASH_SEC_SIZE);
+    }
 #endif
-    sectorBufferIndex = maxSectors;
+
+    for (uint8_t i = 0u; i < numSlots; i++) {
+        cache[slots[i]].index = maxSectors;
+    }
 }
 
 
 uint32_t FlashSingleton::setData(uint16_t index, uint32_t offset, const std::span<const uint8_t>& data) {
 
     // sanity handling for too large offset
-    while (offset > SPI_FLASH_SEC_SIZE) {
+    while (offset >= SPI_FLASH_SEC_SIZE) {
         index++;
         offset -= SPI_FLASH_SEC_SIZE;
     }
@@ -131,22 +289,12 @@ uint32_t FlashSingleton::setData(uint16_t index, uint32_t offset, const std::spa
     }
 #endif
 
-    // need to flush the old buffer
-    if (index != sectorBufferIndex) {
-        flush();
-
-        // read the current flash content
-        memcpy(sectorBuffer.data(), this->data(index), sizeof(sectorBuffer));
-        sectorBufferIndex = index;
-    }
-
     // this is how much we have to write
     uint32_t count = std::min(
-        static_cast<uint32_t>(SPI_FLASH_SEC_SIZE - (offset % SPI_FLASH_SEC_SIZE)),
+        static_cast<uint32_t>(SPI_FLASH_SEC_SIZE - offset),
         static_cast<uint32_t>(data.size()));
 
-
-    std::copy(data.begin(), data.begin() + count, sectorBuffer.data() + offset);
+    writeSlot(getSlot(index), offset, data.subspan(0, count));
 
     return count;
 }
@@ -174,59 +322,84 @@ void FlashSingleton::reset(uint16_t index) {
 
     // to invalidate a sector we zero out the first bytes
     // this saves an erasing step
-    uint64_t zeros = 0u;
+    const std::array<uint8_t, 8> zeros{};
+    clearBits(index, 0u, zeros);
+}
+
+
+void FlashSingleton::clearBits(uint16_t index, uint32_t offset, std::span<const uint8_t> data) {
+
+    if (index >= maxSectors || offset + data.size() > SPI_FLASH_SEC_SIZE) {
+        return;
+    }
 
 #ifdef HAVE_NV
     if (part != nullptr) {
+        // programming can only clear bits, so this is an AND
         ESP_ERROR_CHECK(
             esp_flash_write(
                 part->flash_chip,
-                &zeros,
-                part->address + index * SPI_FLASH_SEC_SIZE,
-                sizeof(zeros)));
+                data.data(),
+                part->address + index * SPI_FLASH_SEC_SIZE + offset,
+                data.size()));
     }
 #else
-    std::copy(&zeros,
-        &zeros + sizeof(zeros),
-        const_cast<uint8_t*>(mapPtr) + index * SPI_FLASH_SEC_SIZE);
+    uint8_t* flashData = const_cast<uint8_t*>(mapPtr) + index * SPI_FLASH_SEC_SIZE + offset;
+    for (size_t i = 0u; i < data.size(); i++) {
+        flashData[i] &= data[i];
+    }
 #endif
+
+    // a cached sector must not bring the old bits back
+    const uint8_t slot = findSlot(index);
+    if (slot < CACHE_SECTORS) {
+        completeSlot(slot);
+        uint8_t* buffer = cacheBuffers[slot].data() + offset;
+        for (size_t i = 0u; i < data.size(); i++) {
+            buffer[i] &= data[i];
+        }
+    }
 }
 
 
 // --------- SampleBlock
 
-const SampleBlock* SampleBlock::first() {
+const SampleBlock* SampleBlock::at(uint16_t sectorIndex) {
     FlashSingleton& flash = FlashSingleton::getInstance();
-    const SampleBlock* result = static_cast<const SampleBlock*>(flash.data(0));
+    const SampleBlock* block = static_cast<const SampleBlock*>(flash.data(sectorIndex));
 
-    if (result->magic != MAGIC) {
-        result = nullptr;
-    };
+    // sample data could look like a header, so check it a bit more
+    if ((block == nullptr) ||
+        (block->magic != MAGIC) ||
+        (block->numSectors == 0u) ||
+        (sectorIndex + block->numSectors > flash.getMaxSectors()) ||
+        (block->size > block->maxSize())) {
+        return nullptr;
+    }
 
-    return result;
+    return block;
 }
 
 
-const SampleBlock* SampleBlock::addBlock(const rcSamples::AudioId& id, uint32_t size) {
-    FlashSingleton& flash = FlashSingleton::getInstance();
-
-    // -- find the first empty sector
-    uint16_t sectorIndex = 0;
-    const SampleBlock* block = first();
+const SampleBlock* SampleBlock::first() {
+    const SampleBlock* result = at(0u);
 
-    // iterate (and increase sectorIndex) until we can't find a
-    // valid block any more
-    while ((block != nullptr) &&
-           (block->magic == MAGIC)) {
-        sectorIndex += block->numSectors;
-        block = block->next();
+    if (result != nullptr && !result->isLive()) {
+        result = nullptr;
     }
 
+    return result;
+}
+
+
+const SampleBlock* SampleBlock::addBlock(uint16_t sectorIndex,
+    const rcSamples::AudioId& id, uint32_t size, uint32_t version) {
+
+    FlashSingleton& flash = FlashSingleton::getInstance();
 
-    uint16_t numSectors =
-        (sizeof(SampleBlock) + size + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE;
     // check if block fits
-    if (sectorIndex + numSectors >= flash.getMaxSectors()) {
+    const uint16_t numSectors = sectorsFor(size);
+    if (sectorIndex + numSectors > flash.getMaxSectors()) {
         return nullptr;
     }
 
@@ -235,7 +408,12 @@ const SampleBlock* SampleBlock::addBlock(const rcSamples::AudioId& id, uint32_t
         .magic = MAGIC,
         .numSectors = numSectors,
         .id = id,
-        .size = size
+        .flags = 0u,
+        .size = size,
+        .sourceSize = size,
+        .sourceCrc = 0u,
+        .state = STATE_LIVE,
+        .version = version
     };
     std::span<const uint8_t> span(
             static_cast<const uint8_t*>(static_cast<const void*>(&newBlock)), sizeof(SampleBlock));
@@ -244,7 +422,7 @@ const SampleBlock* SampleBlock::addBlock(const rcSamples::AudioId& id, uint32_t
     // -- return reference to new block
     if (written > 0) { // if no byte was written, something went wrong
         flash.flush(); // so we can immediately use the block
-        return static_cast<const SampleBlock*>(flash.data(sectorIndex));
+        return at(sectorIndex);
     } else {
         return nullptr;
     }
@@ -254,26 +432,27 @@ const SampleBlock* SampleBlock::next() const {
     FlashSingleton& flash = FlashSingleton::getInstance();
 
     // check if we are a valid block ourselves
-    if (this->magic != MAGIC) {
+    if (!isLive()) {
         return nullptr;
     }
 
-    const uint16_t sectorIndex = flash.getIndex(this) + numSectors;
-    if (sectorIndex >= flash.getMaxSectors()) {
+    const uint32_t nextIndex = sectorIndex() + numSectors;
+    if (nextIndex >= flash.getMaxSectors()) {
         return nullptr;
     }
 
-    const SampleBlock* block = static_cast<const SampleBlock*>(
-        flash.data(sectorIndex));
-
-    if ((block == nullptr) ||
-        (block->magic != MAGIC)) {
+    const SampleBlock* block = at(nextIndex);
+    if ((block == nullptr) || !block->isLive()) {
         return nullptr;
     }
 
     return block;
 }
 
+uint16_t SampleBlock::sectorIndex() const {
+    return FlashSingleton::getInstance().getIndex(this);
+}
+
 void SampleBlock::setData(uint32_t offset, std::span<const uint8_t> data) const {
     FlashSingleton& flash = FlashSingleton::getInstance();
 
@@ -298,20 +477,53 @@ void SampleBlock::setData(uint32_t offset, std::span<const uint8_t> data) const
     }
 }
 
-/** Go through all the blocks (starting with first) and call FlashSingleton::reset() for the
- *  first sector.
+/** Writes a modified copy of the block header back to flash.
+ *
+ *  The header is flushed immediately, so that it can be used
+ *  directly from the mapped memory.
  */
-void SampleBlock::reset() {
+static void writeHeader(const SampleBlock* block, const SampleBlock& header) {
     FlashSingleton& flash = FlashSingleton::getInstance();
 
-    const SampleBlock* block = first();
+    std::span<const uint8_t> span(
+            static_cast<const uint8_t*>(static_cast<const void*>(&header)), sizeof(SampleBlock));
+    flash.setData(flash.getIndex(block), 0, span);
+    flash.flush();
+}
 
-    while ((block != nullptr) &&
-           (block->magic == MAGIC)) {
+void SampleBlock::setSize(uint32_t newSize, uint16_t newNumSectors) const {
+    SampleBlock header = *this;
+    header.size = newSize;
+    header.numSectors = newNumSectors;
+    writeHeader(this, header);
+}
 
-        uint16_t sectIndex = flash.getIndex(block);
-        block = block->next();
-        flash.reset(sectIndex);
+void SampleBlock::setSource(uint32_t newSourceSize, uint16_t newSourceCrc, uint8_t extraFlags) const {
+    SampleBlock header = *this;
+    header.flags |= FLAG_CONVERTED | extraFlags;
+    header.sourceSize = newSourceSize;
+    header.sourceCrc = newSourceCrc;
+    writeHeader(this, header);
+}
+
+void SampleBlock::remove() const {
+    const std::array<uint8_t, 1> deleted = {STATE_DELETED};
+    FlashSingleton::getInstance().clearBits(
+        sectorIndex(), offsetof(SampleBlock, state), deleted);
+}
+
+/** Go through all the sectors and delete the live blocks. */
+void SampleBlock::reset() {
+    FlashSingleton& flash = FlashSingleton::getInstance();
+
+    for (uint16_t index = 0u; index < flash.getMaxSectors();) {
+        const SampleBlock* block = at(index);
+        if (block != nullptr && block->isLive()) {
+            block->remove();
+            index += block->numSectors;
+        } else {
+            index++;
+        }
     }
 }
 
@@ -324,22 +536,155 @@ uint32_t SampleBlock::maxSize() const {
 }
 
 rcSamples::SampleFile SampleBlock::getFile() const {
-    return rcSamples::SampleFile(
+    rcSamples::SampleFile file(
         id,
         std::span<const uint8_t>(
             static_cast<const uint8_t*>(data()), size));
+
+    // converted uploads are already raw (or ADPCM) samples
+    if ((flags & FLAG_ADPCM) != 0u) {
+        file.info = rcSamples::SampleInfo{
+            .format = rcSamples::SampleInfo::ADPCM,
+            .blockSize = rcAudio::ADPCM_BLOCK_SIZE,
+            .offset = 0u,
+            .size = size,
+            .numSamples = rcAudio::adpcmSamples(size)};
+    } else if ((flags & FLAG_CONVERTED) != 0u) {
+        file.info = rcSamples::SampleInfo{
+            .format = rcSamples::SampleInfo::PCM,
+            .blockSize = 0u,
+            .offset = 0u,
+            .size = size,
+            .numSamples = size};
+    }
+    return file;
 }
 
 // ---------- SampleStorage
 
+namespace {
+
+/** Returns the largest number of contiguous unused sectors. */
+uint16_t largestRun(const std::vector<bool>& used) {
+    uint16_t largest = 0u;
+    uint16_t run = 0u;
+    for (const bool sectorUsed : used) {
+        run = sectorUsed ? 0u : run + 1u;
+        largest = std::max(largest, run);
+    }
+    return largest;
+}
+
+void markSectors(std::vector<bool>& used, uint16_t first, uint16_t num, bool value) {
+    std::fill(used.begin() + first, used.begin() + first + num, value);
+}
+
+} // namespace
+
 void SampleStorage::readFromFlash() {
 
+    FlashSingleton& flash = FlashSingleton::getInstance();
+
+    // -- scan all sectors for headers, skipping the data of live blocks
     sampleBlocks.resize(0);
-    for (const SampleBlock* block = SampleBlock::first();
-            block != nullptr;
-            block = block->next()) {
-        sampleBlocks.push_back(block);
+    for (uint16_t index = 0u; index < flash.getMaxSectors();) {
+        const SampleBlock* block = SampleBlock::at(index);
+        if (block == nullptr) {
+            index++;
+            continue;
+        }
+
+        // the newest block (also deleted) ends at the log head
+        if (block->version >= nextVersion) {
+            nextVersion = block->version + 1u;
+            head = (index + block->numSectors) % flash.getMaxSectors();
+        }
+
+        if (block->isLive()) {
+            sampleBlocks.push_back(block);
+            index += block->numSectors;
+        } else {
+            index++;
+        }
+    }
+
+    std::sort(sampleBlocks.begin(), sampleBlocks.end(),
+        [](const SampleBlock* a, const SampleBlock* b) {
+            return a->version < b->version;
+        });
+
+    // -- only keep the newest version of a sample
+    // (an older one is left if the power was lost while replacing it)
+    for (size_t i = sampleBlocks.size(); i-- > 0u;) {
+        for (size_t j = i + 1u; j < sampleBlocks.size(); j++) {
+            if (sampleBlocks[i]->id == sampleBlocks[j]->id) {
+                removeBlock(sampleBlocks[i]);
+                break;
+            }
+        }
+    }
+}
+
+const SampleBlock* SampleStorage::findBlock(const rcSamples::AudioId& id) const {
+    for (const auto& block: sampleBlocks) {
+        if (id == block->id) {
+            return block;
+        }
     }
+    return nullptr;
+}
+
+std::vector<bool> SampleStorage::usedSectors() const {
+    FlashSingleton& flash = FlashSingleton::getInstance();
+
+    std::vector<bool> used(flash.getMaxSectors(), false);
+    for (const auto& block: sampleBlocks) {
+        markSectors(used, block->sectorIndex(), block->numSectors, true);
+    }
+    return used;
+}
+
+uint16_t SampleStorage::findFree(const std::vector<bool>& used, uint16_t numSectors) const {
+    const uint16_t maxSectors = used.size();
+
+    for (uint16_t i = 0u; i < maxSectors; i++) {
+        const uint16_t first = (head + i) % maxSectors;
+        if (first + numSectors > maxSectors) {
+            continue;
+        }
+        if (std::none_of(used.begin() + first, used.begin() + first + numSectors,
+                [](bool sectorUsed) { return sectorUsed; })) {
+            return first;
+        }
+    }
+    return maxSectors;
+}
+
+const SampleBlock* SampleStorage::appendBlock(const rcSamples::AudioId& id, uint32_t size) {
+    FlashSingleton& flash = FlashSingleton::getInstance();
+
+    const uint16_t numSectors = SampleBlock::sectorsFor(size);
+    if (numSectors > flash.getMaxSectors()) {
+        return nullptr;
+    }
+
+    // no compaction here, the procs might still play the blocks it moves
+    const uint16_t first = findFree(usedSectors(), numSectors);
+    if (first >= flash.getMaxSectors()) {
+        return nullptr;
+    }
+
+    const SampleBlock* block = SampleBlock::addBlock(first, id, size, nextVersion);
+    if (block != nullptr) {
+        nextVersion++;
+        head = (first + numSectors) % flash.getMaxSectors();
+    }
+    return block;
+}
+
+void SampleStorage::removeBlock(const SampleBlock* block) {
+    block->remove();
+    sampleBlocks.erase(std::find(sampleBlocks.begin(), sampleBlocks.end(), block));
 }
 
 void SampleStorage::reset() {
@@ -349,9 +694,6 @@ void SampleStorage::reset() {
 
 std::vector<rcSamples::SampleFile> SampleStorage::getFiles() const {
 
-    FlashSingleton& flash = FlashSingleton::getInstance();
-    flash.flush();
-
     std::vector<rcSamples::SampleFile> result;
     for (const auto& block: sampleBlocks) {
         result.push_back(block->getFile());
@@ -359,32 +701,206 @@ std::vector<rcSamples::SampleFile> SampleStorage::getFiles() const {
     return result;
 }
 
+void SampleStorage::flush() {
+    FlashSingleton::getInstance().flush();
+}
+
 bool SampleStorage::addId(const rcSamples::AudioId& id, uint32_t size) {
 
-    // check if we already have such an ID
-    for (const auto& block: sampleBlocks) {
-        if (id == block->id) {
+    const SampleBlock* oldBlock = findBlock(id);
+    const SampleBlock* newBlock = appendBlock(id, size);
+
+    // no space for both versions, the old one has to go first
+    if (newBlock == nullptr) {
+        if (oldBlock == nullptr) {
+            return false;
+        }
+        removeBlock(oldBlock);
+        oldBlock = nullptr;
+        newBlock = appendBlock(id, size);
+        if (newBlock == nullptr) {
             return false;
         }
     }
 
-    const SampleBlock* newBlock = SampleBlock::addBlock(id, size);
-    if (newBlock != nullptr) {
-        sampleBlocks.push_back(newBlock);
-        return true;
+    if (oldBlock != nullptr) {
+        removeBlock(oldBlock);
+    }
+    sampleBlocks.push_back(newBlock);
+    return true;
+}
 
-    } else {
+bool SampleStorage::remove(const rcSamples::AudioId& id) {
+    const SampleBlock* block = findBlock(id);
+    if (block == nullptr) {
         return false;
     }
+    removeBlock(block);
+    return true;
 }
 
 void SampleStorage::setData(const rcSamples::AudioId& id, uint32_t offset, const std::span<const uint8_t>& data) {
+    const SampleBlock* block = findBlock(id);
+    if (block != nullptr) {
+        block->setData(offset, data);
+    }
+}
+
+bool SampleStorage::setSize(const rcSamples::AudioId& id, uint32_t size) {
+    FlashSingleton& flash = FlashSingleton::getInstance();
+
+    const SampleBlock* block = findBlock(id);
+    if (block == nullptr) {
+        return false;
+    }
+
+    const uint16_t first = block->sectorIndex();
+    const uint16_t oldNumSectors = block->numSectors;
+    const uint16_t numSectors = SampleBlock::sectorsFor(size);
+
+    // grow into the following sectors if they are free
+    if (numSectors > oldNumSectors) {
+        if (first + numSectors > flash.getMaxSectors()) {
+            return false;
+        }
+        const auto used = usedSectors();
+        if (std::any_of(used.begin() + first + oldNumSectors, used.begin() + first + numSectors,
+                [](bool sectorUsed) { return sectorUsed; })) {
+            return false;
+        }
+    }
+
+    block->setSize(size, numSectors);
+    if (head == (first + oldNumSectors) % flash.getMaxSectors()) {
+        head = (first + numSectors) % flash.getMaxSectors();
+    }
+    return true;
+}
+
+void SampleStorage::setSource(const rcSamples::AudioId& id, uint32_t size, uint16_t crc, uint8_t extraFlags) {
+    const SampleBlock* block = findBlock(id);
+    if (block != nullptr) {
+        block->setSource(size, crc, extraFlags);
+    }
+}
+
+bool SampleStorage::getSource(const rcSamples::AudioId& id, uint32_t& size, uint16_t& crc) const {
+    const SampleBlock* block = findBlock(id);
+    if (block == nullptr || (block->flags & SampleBlock::FLAG_CONVERTED) == 0u) {
+        return false;
+    }
+    size = block->sourceSize;
+    crc = block->sourceCrc;
+    return true;
+}
+
+uint8_t SampleStorage::getFlags(const rcSamples::AudioId& id) const {
+    const SampleBlock* block = findBlock(id);
+    return (block != nullptr) ? block->flags : 0u;
+}
+
+bool SampleStorage::compact(SampleMove* move) {
+    SampleMove result;
+    if (!prepareCompact(result)) {
+        return false;
+    }
+    commitCompact(result);
+
+    if (move != nullptr) {
+        *move = result;
+    }
+    return true;
+}
+
+bool SampleStorage::prepareCompact(SampleMove& move) {
+    FlashSingleton& flash = FlashSingleton::getInstance();
+
+    // the moved data is read from the mapped flash
+    flash.flush();
+
+    auto used = usedSectors();
+    const uint16_t maxSectors = used.size();
+
+    // -- find the move giving the largest free region
+    uint16_t bestRun = largestRun(used);
+    const SampleBlock* bestBlock = nullptr;
+    uint16_t bestTarget = maxSectors;
+
     for (const auto& block: sampleBlocks) {
-        if (id == block->id) {
-            block->setData(offset, data);
-            return;
+        const uint16_t first = block->sectorIndex();
+        const uint16_t num = block->numSectors;
+
+        // targets are the beginning and the end of each free region
+        // (the block can't overlap its old place)
+        for (uint16_t runStart = 0u; runStart < maxSectors;) {
+            if (used[runStart]) {
+                runStart++;
+                continue;
+            }
+            uint16_t runEnd = runStart;
+            while (runEnd < maxSectors && !used[runEnd]) {
+                runEnd++;
+            }
+
+            if (runEnd - runStart >= num) {
+                for (const uint16_t target : {runStart, static_cast<uint16_t>(runEnd - num)}) {
+                    auto moved = used;
+                    markSectors(moved, first, num, false);
+                    markSectors(moved, target, num, true);
+                    const uint16_t run = largestRun(moved);
+                    if (run > bestRun ||
+                        (run == bestRun && bestBlock != nullptr && num < bestBlock->numSectors)) {
+                        bestRun = run;
+                        bestBlock = block;
+                        bestTarget = target;
+                    }
+                }
+            }
+            runStart = runEnd;
         }
     }
+
+    if (bestBlock == nullptr) {
+        return false;
+    }
+
+    // -- write the copy as the newest version
+    SampleBlock header = *bestBlock;
+    header.state = SampleBlock::STATE_LIVE;
+    header.version = nextVersion;
+    flash.setData(bestTarget, 0u, std::span<const uint8_t>(
+        static_cast<const uint8_t*>(static_cast<const void*>(&header)), sizeof(SampleBlock)));
+
+    uint32_t offset = sizeof(SampleBlock);
+    std::span<const uint8_t> data(bestBlock->data(), bestBlock->size);
+    while (!data.empty()) {
+        const auto written = flash.setData(bestTarget + offset / SPI_FLASH_SEC_SIZE,
+            offset % SPI_FLASH_SEC_SIZE, data);
+        if (written == 0u) {
+            break;
+        }
+        offset += written;
+        data = data.subspan(written);
+    }
+    flash.flush();
+
+    const SampleBlock* newBlock = SampleBlock::at(bestTarget);
+    if (newBlock == nullptr) {
+        return false;
+    }
+    nextVersion++;
+    head = (bestTarget + newBlock->numSectors) % maxSectors;
+
+    move.from = std::span<const uint8_t>(bestBlock->data(), bestBlock->size);
+    move.to = newBlock->data();
+    move.oldBlock = bestBlock;
+    move.newBlock = newBlock;
+    return true;
+}
+
+void SampleStorage::commitCompact(const SampleMove& move) {
+    removeBlock(move.oldBlock);
+    sampleBlocks.push_back(move.newBlock);
 }
 
 uint16_t SampleStorage::sectorsFree() const {
@@ -394,12 +910,13 @@ uint16_t SampleStorage::sectorsFree() const {
 }
 
 uint16_t SampleStorage::sectorsUsed() const {
-    FlashSingleton& flash = FlashSingleton::getInstance();
-
-    if (sampleBlocks.size() == 0) {
-        return 0;
-    } else {
-        return flash.getIndex(sampleBlocks.back()) + sampleBlocks.back()->numSectors;
+    uint16_t used = 0u;
+    for (const auto& block: sampleBlocks) {
+        used += block->numSectors;
     }
+    return used;
 }
 
+uint16_t SampleStorage::largestFree() const {
+    return largestRun(usedSectors());
+}
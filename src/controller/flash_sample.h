@@ -31,10 +31,44 @@ namespace FlashSample {
 
 /** Low level flash access wrapper.
  *
- *  All writes are immediate.
+ *  Writes go to a write-back cache of CACHE_SECTORS sectors, so
+ *  interleaved or out of order chunks don't cause an erase for
+ *  every chunk.
+ *
+ *  - Only the written byte range of a cached sector is kept. A sector
+ *    that is written completely is programmed without reading the old
+ *    content first.
+ *  - When the cache is full, the least recently used sector is
+ *    written back, together with the completely written sectors next to
+ *    it (one erase for the whole region).
+ *  - flush() writes back everything, also erasing contiguous regions
+ *    at once.
  */
 class FlashSingleton {
+    public:
+        /** Number of sectors in the write-back cache. */
+        static constexpr uint8_t CACHE_SECTORS = 4u;
+
+        /** Counters for the flash operations (e.g. to check the wear in tests). */
+        struct Statistics {
+            uint32_t eraseOperations;  ///< number of erase calls (one per region)
+            uint32_t sectorsErased;
+            uint32_t sectorsWritten;
+            uint32_t sectorsRead;  ///< partially written sectors completed from flash
+        };
+
     private:
+        /** A sector in the write-back cache. */
+        struct CacheEntry {
+            uint16_t index;  ///< the sector index, maxSectors if unused
+
+            /** The written byte range, the rest is still in the flash. */
+            uint16_t validBegin;
+            uint16_t validEnd;
+
+            uint32_t lastUse;
+        };
+
 #ifdef HAVE_NV
         /** The partition used for storing the audio samples. */
         const esp_partition_t* part;
@@ -47,17 +81,39 @@ class FlashSingleton {
         /** Maximum number of available sectors for flash content */
         uint16_t maxSectors;
 
-        /** Index of the sector in the sectorBuffer.
-         *
-         *  When we are writing partial sectors, we store the partial
-         *  data in the sectorBuffer.
-         *  This variable indicates the sector index for the data
-         *  contained in the sectorBuffer.
-         *
-         *  maxSectors if unused.
+        std::array<CacheEntry, CACHE_SECTORS> cache;
+        std::array<std::array<uint8_t, SPI_FLASH_SEC_SIZE>, CACHE_SECTORS> cacheBuffers;
+
+        /** Incremented for every access, for the LRU eviction. */
+        uint32_t useCounter;
+
+        Statistics statistics;
+
+#ifndef HAVE_NV
+        std::vector<uint32_t> eraseCounts;
+#endif
+
+        /** Returns the cache slot for the sector, CACHE_SECTORS if not cached. */
+        uint8_t findSlot(uint16_t index) const;
+
+        /** Returns the cache slot for the sector, evicting another one if needed. */
+        uint8_t getSlot(uint16_t index);
+
+        /** Copies data into the cached sector, keeping the written range contiguous. */
+        void writeSlot(uint8_t slot, uint32_t offset, std::span<const uint8_t> data);
+
+        /** Completes a partially written sector with the content from the flash. */
+        void completeSlot(uint8_t slot);
+
+        bool isComplete(uint8_t slot) const;
+
+        /** Writes back the LRU sector and the complete sectors next to it. */
+        void evict();
+
+        /** Writes back the given cached sectors (sorted by sector index
+         *  and contiguous) with one erase.
          */
-        uint16_t sectorBufferIndex;
-        std::array<uint8_t, SPI_FLASH_SEC_SIZE> sectorBuffer;
+        void writeBack(const uint8_t* slots, uint8_t numSlots);
 
         /** Constructor */
         FlashSingleton();
@@ -76,7 +132,7 @@ class FlashSingleton {
         FlashSingleton(FlashSingleton const&) = delete;
         void operator=(FlashSingleton const&) = delete;
 
-        /** Ensures that the data buffered in "sectorBuffer" is
+        /** Ensures that all data in the write-back cache is
          *  written to flash.
          */
         void flush();
@@ -85,7 +141,7 @@ class FlashSingleton {
          *
          *  Add data to an id in the list of dynamic files
          *
-         *  The data migh only actually be written when calling "flush()"
+         *  The data might only actually be written when calling "flush()"
          *
          *  @param index The sector index
          *  @param offset The offset of the data inside the sector
@@ -111,53 +167,124 @@ class FlashSingleton {
 
         /** Resets the flash memory behind the block. */
         void reset(uint16_t index);
+
+        /** Clears bits in the flash without erasing the sector.
+         *
+         *  Like programming NOR flash, the result is the old content
+         *  AND the data. Used to invalidate or delete block headers.
+         */
+        void clearBits(uint16_t index, uint32_t offset, std::span<const uint8_t> data);
+
+#ifndef HAVE_NV
+        /** Number of times the sector was erased (host only, for the wear simulation). */
+        uint32_t getEraseCount(uint16_t index) const {
+            return (index < eraseCounts.size()) ? eraseCounts[index] : 0u;
+        }
+#endif
+
+        const Statistics& getStatistics() const {
+            return statistics;
+        }
+
+        void resetStatistics() {
+            statistics = Statistics{};
+        }
 };
 
 /** A block of one or more sectors in the flash.
  *
  *  Instances of SampleBlock are memory mapped directly from flash.
  *  The data of this block directly succeeds this blocks instance members.
+ *
+ *  Blocks can start at any sector. Every new block gets a higher
+ *  version, so the order in which they were written is known after
+ *  a restart. A deleted block keeps its header (with cleared state), so
+ *  the version survives until the sectors are used again.
  */
 struct SampleBlock {
-    static constexpr uint32_t MAGIC = 0xABCDu;
+    static constexpr uint32_t MAGIC = 0xABCFu;  ///< 0xABCE before the log layout
+
+    /** The data was converted from an uploaded WAV file (see WavConverter). */
+    static constexpr uint8_t FLAG_CONVERTED = 0x01u;
+
+    /** The data is IMA-ADPCM encoded (rcAudio::ADPCM_BLOCK_SIZE blocks). */
+    static constexpr uint8_t FLAG_ADPCM = 0x02u;
 
-    uint32_t magic; ///< an indicator that the block header is actually valid. 0xABCD
+    /** The state of a written block (erased flash). */
+    static constexpr uint8_t STATE_LIVE = 0xFFu;
+
+    /** The state of a deleted block, cleared without erasing. */
+    static constexpr uint8_t STATE_DELETED = 0x00u;
+
+    uint32_t magic; ///< an indicator that the block header is actually valid. 0xABCF
     uint16_t numSectors;  ///< number of sector in this block
 
     /** The audio ID contained within the block (and the following ones). */
     rcSamples::AudioId id;
 
+    uint8_t flags; ///< FLAG_CONVERTED, FLAG_ADPCM
+
     uint32_t size; ///< sample size
 
-    /** Returns the first block in flash
+    uint32_t sourceSize; ///< size of the uploaded file (with FLAG_CONVERTED)
+    uint16_t sourceCrc; ///< esp_crc16_le of the uploaded file (with FLAG_CONVERTED)
+
+    uint8_t state; ///< STATE_LIVE or STATE_DELETED
+
+    uint32_t version; ///< increases with every written block
+
+    /** Returns the block header (live or deleted) starting at the sector.
+     *
+     *  @returns nullptr if the sector doesn't start with a valid header.
+     */
+    static const SampleBlock* at(uint16_t sectorIndex);
+
+    /** Returns the live block in the first sector.
      *
      *  @returns nullptr if there is no such block.
      */
     static const SampleBlock* first();
 
-    /** Returns a block after the last valid block.
+    /** Writes a new block header at the sector.
      *
-     *  Flash::setData() for this block has already been called to
-     *  set magic, numSectors and audio ID.
-     *
-     *  @returns nullptr if there is no space available or something else went wrong.
+     *  @returns nullptr if the block doesn't fit or something else went wrong.
      */
-    static const SampleBlock* addBlock(const rcSamples::AudioId& id, uint32_t size);
+    static const SampleBlock* addBlock(uint16_t sectorIndex,
+        const rcSamples::AudioId& id, uint32_t size, uint32_t version);
 
-    /** Returns the Block following this one.
+    /** Returns the live block directly following this one.
      *
      *  @returns nullptr if there is no such block.
      */
     const SampleBlock* next() const;
 
+    bool isLive() const {
+        return magic == MAGIC && state == STATE_LIVE;
+    }
+
+    /** The first sector of this block. */
+    uint16_t sectorIndex() const;
+
     /** Set data in the sample Block. */
     void setData(uint32_t offset, std::span<const uint8_t> data) const;
 
-    /** Reset all blocks.
+    /** Changes the sample size and the number of sectors.
+     *
+     *  The caller has to make sure that additional sectors are free.
+     */
+    void setSize(uint32_t newSize, uint16_t newNumSectors) const;
+
+    /** Remembers the size and crc of the uploaded file the data
+     *  was converted from and sets FLAG_CONVERTED.
      *
-     *  This will overwrite all block headers, invalidating the magic
-     *  numbers.
+     *  @param extraFlags Additional flags, e.g. FLAG_ADPCM.
      */
+    void setSource(uint32_t newSourceSize, uint16_t newSourceCrc, uint8_t extraFlags = 0u) const;
+
+    /** Marks the block as deleted (without erasing). */
+    void remove() const;
+
+    /** Delete all blocks. */
     static void reset();
 
     /** Get a pointer to the memory mapped location of this block (excluding the header.*/
@@ -166,30 +293,81 @@ struct SampleBlock {
     /** Total available size for this block (excluding the header. */
     uint32_t maxSize() const;
 
-    /** Returns an audio SampleFile pointing to the data inside this block. */
+    /** Returns an audio SampleFile pointing to the data inside this block.
+     *
+     *  The SampleInfo is filled from the flags for converted uploads.
+     */
     rcSamples::SampleFile getFile() const;
+
+    /** Number of sectors needed for a sample of the size (with header). */
+    static uint16_t sectorsFor(uint32_t size) {
+        return (sizeof(SampleBlock) + size + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE;
+    }
+};
+
+
+/** Where SampleStorage::compact() moved the data of a sample. */
+struct SampleMove {
+    std::span<const uint8_t> from;  ///< the data of the old copy
+    const uint8_t* to = nullptr;    ///< the data of the new copy
+
+    const SampleBlock* oldBlock = nullptr;
+    const SampleBlock* newBlock = nullptr;
 };
 
 
-/** Internal implementation of a linked list mapped to flash memory.
+/** Log structured storage of the dynamic samples.
  *
- *  This class handles the structure of the dynamic samples,
- *  which is a linked list of blocks.
+ *  New blocks (also new versions of an existing sample) are appended at
+ *  the log head, the sector after the last written block, wrapping
+ *  around at the end of the partition. So the sectors are used in turn
+ *  instead of always starting at sector 0 (wear leveling) and replacing
+ *  or deleting one sample doesn't touch the others.
  *
- *  It also marks the sectors and places them in the correct
- *  position in memory.
+ *  The live blocks are kept in an index in the order they were
+ *  written. The free sectors between them are coalesced by moving
+ *  single blocks (compact()).
  */
 class SampleStorage {
     private:
-        /** List of SampleBlocks (the dynamic samples
-        */
+        /** List of live SampleBlocks (the dynamic samples) by version. */
         std::vector<const SampleBlock*> sampleBlocks;
 
+        /** The sector after the last written block. */
+        uint16_t head;
+
+        /** The version for the next written block. */
+        uint32_t nextVersion;
+
         /** Reads all blocks from flash memory into the sampleBlocks vector. */
         void readFromFlash();
 
+        /** Returns the block with the id or nullptr. */
+        const SampleBlock* findBlock(const rcSamples::AudioId& id) const;
+
+        /** Marks the sectors used by live blocks. */
+        std::vector<bool> usedSectors() const;
+
+        /** Returns the first sector of numSectors free sectors, starting
+         *  the search at the head.
+         *
+         *  @returns the number of sectors if there is no such space.
+         */
+        uint16_t findFree(const std::vector<bool>& used, uint16_t numSectors) const;
+
+        /** Writes a new block and updates the head.
+         *
+         *  @returns nullptr if there are not enough contiguous free sectors.
+         */
+        const SampleBlock* appendBlock(const rcSamples::AudioId& id, uint32_t size);
+
+        /** Removes the block from the index and marks it deleted. */
+        void removeBlock(const SampleBlock* block);
+
     public:
-        SampleStorage() {
+        SampleStorage() :
+            head(0u),
+            nextVersion(1u) {
             readFromFlash();
         }
 
@@ -197,29 +375,95 @@ class SampleStorage {
         void reset();
 
         /** Returns a list of all the files in flash.
+         *
+         *  Doesn't flush the cached sectors, so it can be called while
+         *  another task writes. Data written since the last flush()
+         *  might not be in the mapped flash yet.
          */
         std::vector<rcSamples::SampleFile> getFiles() const;
 
+        /** Writes the cached sectors, see FlashSingleton::flush(). */
+        void flush();
+
         /** Add an id to the list of dynamic files.
+         *
+         *  A sample with the same ID is replaced. The old version
+         *  stays until the new one is written (if there is space for both).
+         *
+         *  Nothing is compacted, the caller has to do this with compact()
+         *  when the samples are not used.
          *
          *  @param[in] The audio ID to create.
          *
-         *  @returns Returns false if the ID cannot be generated, e.g.
-         *    because it already exists.
+         *  @returns Returns false if there are not enough contiguous free sectors.
          */
         bool addId(const rcSamples::AudioId& id, uint32_t size);
 
+        /** Deletes the sample.
+         *
+         *  @returns false if the id is unknown.
+         */
+        bool remove(const rcSamples::AudioId& id);
+
         /** Add data to an id in the list of dynamic files
          *
          *  @param[in] The audio ID to add data to.
          */
         void setData(const rcSamples::AudioId& id, uint32_t offset, const std::span<const uint8_t>& data);
 
+        /** Changes the size of the sample.
+         *
+         *  The block grows into the following sectors if they are free.
+         *
+         *  @returns false if the new size doesn't fit or the id is unknown.
+         */
+        bool setSize(const rcSamples::AudioId& id, uint32_t size);
+
+        /** Stores size and crc of the uploaded file, see SampleBlock::setSource(). */
+        void setSource(const rcSamples::AudioId& id, uint32_t size, uint16_t crc, uint8_t extraFlags = 0u);
+
+        /** Returns size and crc of the uploaded file the sample was converted from.
+         *
+         *  @returns false if the sample was not converted.
+         */
+        bool getSource(const rcSamples::AudioId& id, uint32_t& size, uint16_t& crc) const;
+
+        /** Returns the SampleBlock flags of the sample (0 if the id is unknown). */
+        uint8_t getFlags(const rcSamples::AudioId& id) const;
+
+        /** Moves one block to coalesce the free sectors.
+         *
+         *  Picks the block whose move gives the largest free region.
+         *  The old copy is only deleted, the data stays readable until
+         *  the sectors are used again.
+         *  Same as prepareCompact() followed by commitCompact().
+         *
+         *  @param[out] move Where the data was moved to, if not nullptr.
+         *  @returns false if no move makes the largest free region larger.
+         */
+        bool compact(SampleMove* move = nullptr);
+
+        /** Writes the copy of the block compact() would move.
+         *
+         *  The index is not changed, getFiles() still returns the old
+         *  block. So this (the slow part with erasing and programming
+         *  the sectors) doesn't need to be synchronized with the readers.
+         *
+         *  @returns false if no move makes the largest free region larger.
+         */
+        bool prepareCompact(SampleMove& move);
+
+        /** Replaces the old block by the copy written with prepareCompact(). */
+        void commitCompact(const SampleMove& move);
+
         /** Number of unused sectors. */
         uint16_t sectorsFree() const;
 
         /** Number of used sectors. */
         uint16_t sectorsUsed() const;
+
+        /** The largest number of contiguous free sectors. */
+        uint16_t largestFree() const;
 };
 
 } // namespace
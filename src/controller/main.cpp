@@ -12,17 +12,24 @@
 #include <esp_log.h>
 #include <esp_sleep.h>
 #include <esp_heap_task_info.h> // for task info
+#include <esp_pthread.h> // for the proc worker thread
 
 #include <driver/gpio.h>  // for gpio_dump_all_io_configuration
 
+#include <mutex>
 #include <span>
+#include <vector>
 
 static const char* TAG = "RcVehicle";
 
 #include "proc_storage.h"
+#include "audio_renderer.h"
 
 #include "audio_ringbuffer.h"
+#include "audio_stats.h"
 #include "signals.h"
+#include "signals_snapshot.h"
+#include "signals_telemetry.h"
 #include "simple_byte_stream.h"
 #include "sample_storage_singleton.h"
 #include "bluetooth.h"
@@ -33,7 +40,9 @@ static const char* TAG = "RcVehicle";
 extern "C" {
 
 void mainTask(void *pvParameters);
+void renderTask(void *pvParameters);
 void statusTask(void *pvParameters);
+void audioWriterTask(void *pvParameters);
 
 using namespace rcSignals;
 
@@ -53,107 +62,230 @@ static Signals signalsBt;
 /** Main configuration containing all the procs */
 ProcStorage storage = ProcStorage();
 
+/** The signals published by the main task for the render task. */
+static SignalsSnapshot signalsSnapshot;
+
+/** Renders the audio procs in the render task. */
+static AudioRenderer audioRenderer(storage, rcAudio::getRingbuffer(), signalsSnapshot,
+    rcAudio::getAudioStats());
+
 int64_t minTaskTime = 999;
 int64_t maxTaskTime = 0;
 int64_t lastTaskTime = 0;
 
 void updateBluetoothAudioList();
 
+/** Serializes with the given function into an exactly sized buffer
+ *  and publishes it in the slot.
+ *
+ *  The buffer is released once the bluetooth callbacks are done with it.
+ */
+template<typename WriteFn>
+static void publishSerialized(SharedBufferSlot* slot, WriteFn write) {
+    // size the buffer exactly instead of growing it
+    auto counter = SimpleOutStream::counting();
+    write(counter);
+    SharedBuffer* buffer = sharedBufferCreate(counter.tellg());
+    if (buffer == nullptr) {
+        ESP_LOGW(TAG, "Out of memory for %lu byte bluetooth buffer",
+            static_cast<unsigned long>(counter.tellg()));
+        return;
+    }
+
+    SimpleOutStream out(sharedBufferCapacitySpan(buffer));
+    write(out);
+    sharedBufferSetLen(buffer, out.fail() ? 0u : out.tellg());
+    sharedBufferSlotPublish(slot, buffer);
+}
+
+/** Returns the next buffer received via bluetooth or nullptr.
+ *
+ *  The caller has to release the buffer.
+ */
+static SharedBuffer* receiveBuffer(QueueHandle_t queue) {
+    SharedBuffer* buffer = nullptr;
+    if (!xQueueReceive(queue, &buffer, static_cast<TickType_t>(0))) {
+        return nullptr;
+    }
+    return buffer;
+}
+
 /** This function interfaces between the signals used in the main
  *  task and the signals send and received via bluetooth.
  *
- *  - writes the signals output queue
+ *  - publishes the next telemetry frame in the output slot
  *  - checks the signals input queue for new message and reads it.
  */
 void updateBluetoothSignals() {
+    // only the changed signals are sent, see SignalsTelemetryEncoder
+    static SignalsTelemetryEncoder encoder;
+
+    // receive signals
+    SharedBuffer* inBuffer = receiveBuffer(queueInSignals);
+    if (inBuffer != nullptr) {
+        ESP_LOGI(TAG, "Received new signals");  // might delay audio long enough to cause issues
+        SimpleInStream in(sharedBufferSpan(inBuffer));
+        in >> signalsBt.signals;
+
+        sharedBufferRelease(inBuffer);
+
+        // probably a new client, so it doesn't have to wait for the keyframe
+        encoder.requestKeyframe();
+    }
+
     // send new signals out
     {
-        // Two full signal buffers for output.
-        // So we can swap those two around without reallocs
-        static std::array<SimpleOutStream, 2> signalOutStreams;
-        static uint8_t bufferIndex = 0u;
-
-        signalOutStreams[bufferIndex].seekg(0);
-        signalOutStreams[bufferIndex] << signals.signals;
+        // A few fixed signal buffers for output, reused once the
+        // bluetooth callbacks released them. So no allocation here.
+        static SharedBufferPool<3> signalOutBuffers(SignalsTelemetryEncoder::MAX_FRAME_SIZE);
+
+        SharedBuffer* buffer = signalOutBuffers.get();
+        if (buffer != nullptr) {
+            SimpleOutStream out(sharedBufferCapacitySpan(buffer));
+            encoder.encode(signals, out);
+            sharedBufferSetLen(buffer, out.tellg());
+            sharedBufferSlotPublish(slotOutSignals, buffer);
+        }
+    }
+}
 
-        QueueByteBuffer newOutBuffer(
-            signalOutStreams[bufferIndex].buffer().data(),
-            signalOutStreams[bufferIndex].tellg());
-        xQueueOverwrite(queueOutSignals,
-            &(newOutBuffer));
+/** This function publishes the audio statistics of the last period
+ *  via bluetooth.
+ *
+ *  - publishes the audio statistics in the output slot
+ */
+void updateBluetoothAudioStats() {
+    // Fixed buffers for output. See updateBluetoothSignals()
+    // 5 counters, the fill level and the latency buckets
+    static SharedBufferPool<3> statsOutBuffers(
+        5u * 4u + 2u + rcAudio::NUM_LATENCY_BUCKETS * 4u);
+    static rcAudio::AudioStatsSampler sampler(rcAudio::getAudioStats());
+
+    // sample in any case, so that the period stays correct
+    const auto report = sampler.sample(rcAudio::AudioStats::nowUs());
+
+    SharedBuffer* buffer = statsOutBuffers.get();
+    if (buffer == nullptr) {
+        return;
+    }
 
-        bufferIndex = (bufferIndex + 1u) % signalOutStreams.size();
+    SimpleOutStream out(sharedBufferCapacitySpan(buffer));
+    out << report;
+    if (out.fail()) {
+        ESP_LOGW(TAG, "Audio stats buffer too small");
+        sharedBufferRelease(buffer);
+        return;
     }
 
-    // receive signals
-    QueueByteBuffer inBuffer;
-    bool signalsReceived = xQueueReceive(
-        queueInSignals,
-        &inBuffer,
-        static_cast<TickType_t>(0));
-    if (signalsReceived) {
-        ESP_LOGI(TAG, "Received new signals");  // might delay audio long enough to cause issues
-        std::span<const uint8_t> sp(
-            static_cast<const uint8_t*>(inBuffer.data),
-            inBuffer.len);
-        SimpleInStream in(sp);
-        in >> signalsBt.signals;
+    sharedBufferSetLen(buffer, out.tellg());
+    sharedBufferSlotPublish(slotOutAudioStats, buffer);
+}
 
-        free(inBuffer.data);
+/** This function interfaces between the proc profiler of the Storage
+ *  and bluetooth.
+ *
+ *  - checks the profile input queue for the on/off command.
+ *  - publishes the profile in the output slot
+ */
+void updateBluetoothProfile() {
+    SharedBuffer* inBuffer = receiveBuffer(queueInProfile);
+    if (inBuffer != nullptr) {
+        const bool on = (sharedBufferLen(inBuffer) > 0) &&
+            (sharedBufferData(inBuffer)[0] != 0u);
+        ESP_LOGI(TAG, "Profiling %s", on ? "on" : "off");
+        {
+            std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+            storage.setProfiling(on);
+        }
+        sharedBufferRelease(inBuffer);
     }
+
+    // with profiling off the report stays empty, publish it only once
+    static bool emptyPublished = false;
+    if (!storage.isProfiling()) {
+        if (emptyPublished) {
+            return;
+        }
+        emptyPublished = true;
+    } else {
+        emptyPublished = false;
+    }
+
+    std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+    publishSerialized(slotOutProfile, [](SimpleOutStream& out) {
+        out << storage.getProfiler();
+    });
 }
 
 /** This function interfaces between the Storage used in the main
  *  task and the config send and received via bluetooth.
  *
- *  - writes the config output queue
+ *  - publishes the config in the output slot
  *  - checks the config input queue for new message and reads it.
  */
 void updateBluetoothConfig() {
-    // the last buffer SimpleOutStream allocated for us.
-    // we want to free it once we created a new one.
-    static QueueByteBuffer lastOutBuffer(static_cast<uint8_t*>(nullptr), 0);
+    // Patches are saved to the NVM only once they stopped coming in
+    // (e.g. while moving a slider), to spare the flash.
+    static constexpr uint8_t NVM_SAVE_DELAY_STEPS = 100u;  // 2s
+    static uint8_t nvmSaveCountdown = 0u;
 
     // receive config
-    QueueByteBuffer inBuffer;
-    bool configReceived = xQueueReceive(
-        queueInConfig,
-        &inBuffer,
-        static_cast<TickType_t>(0));
+    SharedBuffer* inBuffer = receiveBuffer(queueInConfig);
+    const bool configReceived = (inBuffer != nullptr);
     if (configReceived) {
-        ESP_LOGI(TAG, "Received new config");
-
-        std::span<const uint8_t> sp(
-            static_cast<const uint8_t*>(inBuffer.data),
-            inBuffer.len);
-        SimpleInStream in(sp);
-
-        storage.stop();
-        storage.deserialize(in);
-        storage.saveToNvm();
-        storage.start();
+        const auto data = sharedBufferSpan(inBuffer);
+        SimpleInStream in(data);
+
+        if (ProcStorage::isPatch(data)) {
+            bool patched;
+            {
+                // only the patched proc is restarted
+                std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+                patched = storage.patch(in);
+            }
+            if (!patched) {
+                ESP_LOGW(TAG, "Could not apply config patch");
+            }
+            nvmSaveCountdown = NVM_SAVE_DELAY_STEPS;
+
+        } else {
+            ESP_LOGI(TAG, "Received new config");
+            {
+                // the render task pauses (plays silence) in the mean time
+                std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+                storage.stop();
+                storage.deserialize(in);
+                storage.start();
+
+                // the procs look up their sample IDs in the sample storage
+                storage.saveToNvm();
+            }
+            nvmSaveCountdown = 0u;
+
+            // update the audio list:
+            // - a reset might have removed all samples
+            // - after uploading samples the config is also updated,
+            //    so this is a good time to refresh the list
+            updateBluetoothAudioList();
+        }
 
-        free(inBuffer.data);
+        sharedBufferRelease(inBuffer);
 
-        // update the audio list:
-        // - a reset might have removed all samples
-        // - after uploading samples the config is also updated,
-        //    so this is a good time to refresh the list
-        updateBluetoothAudioList();
+    } else if (nvmSaveCountdown > 0u) {
+        nvmSaveCountdown--;
+        if (nvmSaveCountdown == 0u) {
+            std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+            storage.saveToNvm();
+        }
     }
 
-    // send initial config out or update the out queue
-    if (configReceived ||
-        (uxQueueMessagesWaiting(queueOutConfig) == 0)) {
-
-        SimpleOutStream out;
-        storage.serialize(out);
-
-        QueueByteBuffer newOutBuffer(out.buffer().data(), out.tellg());
-        xQueueOverwrite(queueOutConfig, &newOutBuffer);
-        // TODO: we might be too quick deallocating the buffer
-        free(lastOutBuffer.data);
-        lastOutBuffer = newOutBuffer;
+    // send initial config out or update the out slot
+    if (configReceived || sharedBufferSlotIsEmpty(slotOutConfig)) {
+        // the procs look up their sample IDs in the sample storage
+        std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+        publishSerialized(slotOutConfig, [](SimpleOutStream& out) {
+            storage.serialize(out);
+        });
     }
 }
 
@@ -163,55 +295,91 @@ void updateBluetoothConfig() {
  *  This function is called whenever we suspect that the audio list
  *  changes are done.
  *
- *  - updates the audio out queue.
+ *  - publishes the audio list in the output slot
  */
 void updateBluetoothAudioList() {
-    // the last buffer SimpleOutStream allocated for us.
-    // we want to free it once we created a new one.
-    static QueueByteBuffer lastOutBuffer(static_cast<uint8_t*>(nullptr), 0);
-
     auto& ss = SampleStorageSingleton::getInstance();
 
-    SimpleOutStream out;
-    ss.serializeList(out);
+    // the audio writer task might be changing the dynamic samples
+    std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+    publishSerialized(slotOutAudioList, [&ss](SimpleOutStream& out) {
+        ss.serializeList(out);
+    });
+}
+
+/** Points the procs to the new copy of a sample moved by the audio writer task.
+ *
+ *  Called by the main task that also serializes and saves the
+ *  configuration. Until then the procs play the old copy and the
+ *  audio writer task doesn't write to the flash.
+ */
+static void updateMovedSamples() {
+    auto& ss = SampleStorageSingleton::getInstance();
+    if (!ss.isMovePending()) {
+        return;
+    }
 
-    QueueByteBuffer newOutBuffer(out.buffer().data(), out.tellg());
-    xQueueOverwrite(queueOutAudioList, &newOutBuffer);
-    // TODO: we might be too quick deallocating the buffer
-    // use shared ptr or atomic ref counter or something like that.
-    // isn't there a dynamic memory queue
-    free(lastOutBuffer.data);
-    lastOutBuffer = newOutBuffer;
+    std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+    const auto& move = ss.getPendingMove();
+    storage.relocateSamples(move.from, move.to);
+    ss.moveDone();
 }
 
-/** This function interfaces between the SampleStorage used in the main
- *  task and the audio sample received via bluetooth.
+/** Task function for the audio writer task.
+ *
+ *  Runs with low priority on core 0.
+ *  Waits for audio commands received via bluetooth, executes them
+ *  (which writes the samples to the flash) and publishes the
+ *  acknowledge for the sequenced upload.
+ *
+ *  The bluetooth callbacks only queue the chunks, so the client can
+ *  send the next chunks while the previous ones are written.
  *
- *  - checks the audio input queue for new message and reads it.
+ *  When no commands come in, the samples in the flash are compacted
+ *  one at a time. After each move the task waits until the main task
+ *  has pointed the procs to the new copy (see updateMovedSamples()),
+ *  the next write could overwrite the old one.
  */
-void updateBluetoothAudio() {
+void audioWriterTask(void *pvParameters) {
 
+    const TickType_t idleTicks = 2000U / portTICK_PERIOD_MS;
+    const TickType_t moveTicks = 20U / portTICK_PERIOD_MS;
     auto& ss = SampleStorageSingleton::getInstance();
 
-    // receive Audio
-    QueueByteBuffer inBuffer;
-    bool audioReceived = xQueueReceive(
-        queueInAudio,
-        &inBuffer,
-        static_cast<TickType_t>(0));
-    if (audioReceived) {
-        ESP_LOGI(TAG, "Received new audio");
+    for (;;) {
+        if (ss.isMovePending()) {
+            vTaskDelay(moveTicks);
+            continue;
+        }
+
+        SharedBuffer* inBuffer = nullptr;
+        if (!xQueueReceive(queueInAudio, &inBuffer, idleTicks)) {
+            ss.flush();
+
+            // the copy is written while the procs keep playing the old one,
+            // only switching to it needs the lock
+            if (ss.isCompactPending() && ss.prepareCompact()) {
+                std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+                ss.commitCompact();
+            }
+            continue;
+        }
+        ESP_LOGD(TAG, "Received new audio");
 
         // we should stop audio playback here in case of a reset of the dynamic samples
-        std::span<const uint8_t> sp(
-            static_cast<const uint8_t*>(inBuffer.data),
-            inBuffer.len);
-        SimpleInStream in(sp);
-        ss.executeCommand(in);
+        SimpleInStream in(sharedBufferSpan(inBuffer));
+        {
+            // the audio procs might still reference the samples
+            std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+            ss.executeCommand(in);
+
+            publishSerialized(slotOutAudioAck, [&ss](SimpleOutStream& out) {
+                ss.serializeAck(out, AUDIO_QUEUE_DEPTH);
+            });
+        }
 
-        free(inBuffer.data);
+        sharedBufferRelease(inBuffer);
     }
-
 }
 
 #define MAX_TASK_NUM 20                         // Max number of per tasks info that it can store
@@ -265,10 +433,40 @@ void app_main(void) {
     }
     ESP_ERROR_CHECK(ret);
 
+    // uploaded samples are stored IMA-ADPCM encoded to fit twice as many
+    SampleStorageSingleton::getInstance().setAdpcm(true);
+
     // -- setup pipeline
     ESP_LOGI(TAG, "Setup pipeline");
 
     storage.loadFromNvm();
+    storage.setSeparateAudio(true);
+
+    // The parallel lanes of the procs (storage.setParallel()) stay off:
+    // there is no measurement showing a net gain over the pipeline for the
+    // usual configurations and the main task would wait for a worker
+    // sharing core 1 with the render task.
+    // Enable it only with on-device measurements backing it.
+    // The worker then runs on core 1 (the main task is running on core 0),
+    // with a lower priority than the render task on the same core,
+    // so it can't take time from the audio, but a higher one than
+    // the main task that waits for it:
+    /*
+    esp_pthread_cfg_t workerCfg = esp_pthread_get_default_config();
+    workerCfg.thread_name = "procWorker";
+    workerCfg.core_id = 1;
+    workerCfg.prio = 2;
+    workerCfg.stack_size = 8192;
+    esp_pthread_set_cfg(&workerCfg);
+    storage.setParallel(true);
+    */
+
+    // The second audio lane (storage.setParallelAudio()) stays off as well:
+    // the host bench shows no gain for the usual configurations and its
+    // worker would have to run on core 0 next to bluetooth and the flash
+    // writes, making the render deadline depend on them.
+    // Enable it only with on-device measurements backing it.
+
     storage.start();
 
     // -- setup bluetooth
@@ -279,6 +477,11 @@ void app_main(void) {
     updateBluetoothConfig();
     updateBluetoothAudioList();
 
+    // the client reads the acknowledge before the first upload
+    publishSerialized(slotOutAudioAck, [](SimpleOutStream& out) {
+        SampleStorageSingleton::getInstance().serializeAck(out, AUDIO_QUEUE_DEPTH);
+    });
+
     // -- setup watchdog
     // TODO: watchdogs
 
@@ -287,6 +490,16 @@ void app_main(void) {
     // and the bluetooth stuff which also has a task
 
     ESP_LOGI(TAG, "Setup tasks");
+    TaskHandle_t Task1;
+    xTaskCreatePinnedToCore(
+        renderTask,   // Task function
+        "renderTask", // name of task
+        8192,       // Stack size of task
+        nullptr,    // parameter of the task
+        3,          // priority of the task (1 = low, 3 = medium, 5 = highest)
+        &Task1,     // Task handle to keep track of created task
+        1);         // pin task to core 1 (the main task is running on core 0)
+
     TaskHandle_t Task2;
     xTaskCreatePinnedToCore(
         statusTask,   // Task function
@@ -297,6 +510,16 @@ void app_main(void) {
         &Task2,     // Task handle to keep track of created task
         0);         // pin task to core 0
 
+    TaskHandle_t Task3;
+    xTaskCreatePinnedToCore(
+        audioWriterTask,   // Task function
+        "audioWriterTask", // name of task
+        8192,       // Stack size of task
+        nullptr,    // parameter of the task
+        1,          // priority of the task (1 = low, 3 = medium, 5 = highest)
+        &Task3,     // Task handle to keep track of created task
+        0);         // pin task to core 0, the flash writes must not delay rendering
+
     ESP_LOGI(TAG, "Setup finished");
 
     mainTask(nullptr); // will not return
@@ -311,17 +534,16 @@ void app_main(void) {
  *
  *  - prepares a StepInfo structure by
  *    - initializing all signals from the BT input signals
- *    - initializing audio buffers from ringbuffer
- *  - call proc storage to execute all procs
+ *  - call proc storage to execute all procs (but not the audio procs)
+ *  - publishes the signals for the render task
  *  - updates bluetooth signals
  *
  */
 void mainTask(void *pvParameters) {
 
     const TickType_t frequencyTick = 20U / portTICK_PERIOD_MS;  // wake up ever 20 ms
-    uint8_t btNotifyCounter = 0u;  // keep track if we want to send out bt notification
+    uint8_t btStatsCounter = 0u;  // keep track if we want to update the audio stats
 
-    auto& ringbuffer = rcAudio::getRingbuffer();
     TickType_t lastWakeTime;
 
     lastWakeTime = xTaskGetTickCount();
@@ -333,28 +555,33 @@ void mainTask(void *pvParameters) {
         // signals.reset();
         signals = signalsBt;
 
+        // audio is rendered by the render task
         rcProc::StepInfo info = {
             .deltaMs = 20U, // TODO: might not be accurate
             .signals = &signals,
-            .intervals = {ringbuffer.getEmptyBlocks(),
-                ringbuffer.getEmptyBlocks()}
+            .intervals = {
+                rcProc::SamplesInterval{.first = nullptr, .last = nullptr},
+                rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
         };
 
         // -- call all the steps
         storage.step(info);
+        signalsSnapshot.publish(signals);
 
-        ringbuffer.setBlocksFull(info.intervals[0]);
-        ringbuffer.setBlocksFull(info.intervals[1]);
+        // -- samples moved by the audio writer task, before the config is serialized
+        updateMovedSamples();
 
         // -- update bluetooth
         updateBluetoothSignals();
         updateBluetoothConfig();
-        updateBluetoothAudio();
-        // send out notifications every 200ms
-        btNotifyCounter++;
-        if (btNotifyCounter > 10u) {
-            btNotify();
-            btNotifyCounter = 0u;
+        // send out the signals telemetry frame every step
+        btNotify();
+        // update the audio statistics and the profile every second
+        btStatsCounter++;
+        if (btStatsCounter >= 50u) {
+            updateBluetoothAudioStats();
+            updateBluetoothProfile();
+            btStatsCounter = 0u;
         }
         // rtc_wdt_feed();
 
@@ -370,6 +597,54 @@ void mainTask(void *pvParameters) {
     }
 }
 
+/** Task function for the audio render task.
+ *
+ *  Runs on core 1.
+ *  Renders the audio procs block by block as soon as the
+ *  audio output frees a ringbuffer block.
+ */
+void renderTask(void *pvParameters) {
+    for (;;) {
+        if (audioRenderer.render() == 0u) {
+            // ringbuffer full (or config update), wait for the audio output
+            vTaskDelay(1);
+        }
+    }
+}
+
+/** Prints a profiler report (see architecture.md) to the serial port.
+ *
+ *  Prints nothing for the empty report when profiling is off.
+ */
+static void printProfile(std::span<const uint8_t> data) {
+    SimpleInStream in(data);
+    uint8_t id0 = 0u;
+    uint8_t id1 = 0u;
+    uint8_t version = 0u;
+    uint8_t numProcs = 0u;
+    in >> id0 >> id1 >> version >> numProcs;
+    if (in.fail() || (id0 != 'R') || (id1 != 'T') || (version != 1u) || (numProcs == 0u)) {
+        return;
+    }
+
+    printf("Proc step us: min/avg/max/p99\n");
+    for (unsigned i = 0u; (i < numProcs) && !in.fail(); i++) {
+        uint16_t minUs, avgUs, maxUs, p99Us;
+        in >> minUs >> avgUs >> maxUs >> p99Us;
+        printf("  %2u: %u/%u/%u/%u\n", i, minUs, avgUs, maxUs, p99Us);
+    }
+
+    uint8_t numTypes = 0u;
+    in >> numTypes;
+    for (unsigned i = 0u; (i < numTypes) && !in.fail(); i++) {
+        uint16_t type, count, minUs, avgUs, maxUs, p99Us;
+        in >> type >> count >> minUs >> avgUs >> maxUs >> p99Us;
+        printf("  %c%c: %u/%u/%u/%u\n",
+               static_cast<char>(type >> 8), static_cast<char>(type & 0xFF),
+               minUs, avgUs, maxUs, p99Us);
+    }
+}
+
 /** Task function for the status task.
  *
  *  Runs on core 0
@@ -377,6 +652,8 @@ void mainTask(void *pvParameters) {
  *  prints out status information via the serial port.
  */
 void statusTask(void *pvParameters) {
+    rcAudio::AudioStatsSampler audioStatsSampler(rcAudio::getAudioStats());
+
     for (;;) {
         vTaskDelay(5000U / portTICK_PERIOD_MS);
         /* for debugging heap usage
@@ -388,6 +665,32 @@ void statusTask(void *pvParameters) {
         minTaskTime = lastTaskTime;
         maxTaskTime = lastTaskTime;
 
+        const auto audioStats = audioStatsSampler.sample(rcAudio::AudioStats::nowUs());
+        printf("Audio per s: underruns: %lu overruns: %lu rendered: %lu played: %lu fill: %u.%02u\n",
+               audioStats.perSecond(audioStats.underruns),
+               audioStats.perSecond(audioStats.overruns),
+               audioStats.perSecond(audioStats.blocksRendered),
+               audioStats.perSecond(audioStats.blocksPlayed),
+               audioStats.fillAvg / 100u, audioStats.fillAvg % 100u);
+        printf("Audio latency ms:");
+        for (size_t i = 0u; i < audioStats.latency.size(); i++) {
+            if (i < rcAudio::LATENCY_BUCKET_LIMITS_US.size()) {
+                printf(" <%lu: %lu", rcAudio::LATENCY_BUCKET_LIMITS_US[i] / 1000u,
+                       audioStats.latency[i]);
+            } else {
+                printf(" more: %lu", audioStats.latency[i]);
+            }
+        }
+        printf("\n");
+
+        // the report published by the main task, reading the profiler
+        // here would race with the steps of the main task
+        SharedBuffer* profile = sharedBufferSlotAcquire(slotOutProfile);
+        if (profile != nullptr) {
+            printProfile(sharedBufferSpan(profile));
+            sharedBufferRelease(profile);
+        }
+
         /* for debugging of outputs
         vTaskDelay(5000U / portTICK_PERIOD_MS);
         gpio_dump_io_configuration(stdout, SOC_GPIO_VALID_GPIO_MASK);
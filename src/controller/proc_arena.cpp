@@ -0,0 +1,49 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation of the proc arena allocator.
+ *
+ *  @file
+ *
+*/
+
+#include "proc_arena.h"
+
+#include <new>
+
+static_assert(ProcArena::ALIGNMENT <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+    "the arena block needs to be aligned for all procs");
+
+ProcArena::ProcArena() :
+    block(nullptr),
+    capacity(0u),
+    used(0u) {
+}
+
+ProcArena::~ProcArena() {
+    delete[] block;
+}
+
+void ProcArena::reserve(size_t size) {
+    size = alignedSize(size);
+    if (used != 0u || (size <= capacity && capacity <= size * 2u)) {
+        return;
+    }
+
+    delete[] block;
+    block = nullptr;
+    capacity = 0u;
+    if (size > 0u) {
+        block = new(std::nothrow) uint8_t[size];
+        capacity = (block != nullptr) ? size : 0u;
+    }
+}
+
+void* ProcArena::allocate(size_t size) {
+    size = alignedSize(size);
+    if (block == nullptr || capacity - used < size) {
+        return nullptr;
+    }
+    void* result = block + used;
+    used += size;
+    return result;
+}
@@ -0,0 +1,80 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for the proc arena allocator.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_PROC_ARENA_H_
+#define _RC_PROC_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/** A simple bump allocator for the procs of the ProcStorage.
+ *
+ *  The ProcStorage sizes the arena for a whole configuration before
+ *  creating the procs. The procs are then placed one after the other
+ *  in one memory block instead of being spread over the heap.
+ *
+ *  Memory is only given back all at once with reset(), so the
+ *  objects have to be destroyed (not deleted) by the owner before.
+ */
+class ProcArena {
+    public:
+        /** The alignment of every allocation. */
+        static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+        /** Returns the size rounded up to the alignment. */
+        static constexpr size_t alignedSize(size_t size) {
+            return (size + ALIGNMENT - 1u) & ~(ALIGNMENT - 1u);
+        }
+
+    private:
+        uint8_t* block;
+        size_t capacity;
+        size_t used;
+
+    public:
+        ProcArena();
+        ~ProcArena();
+
+        ProcArena(const ProcArena&) = delete;
+        ProcArena& operator=(const ProcArena&) = delete;
+
+        /** Makes sure that the (empty) arena can hold the given size.
+         *
+         *  The block is re-allocated only if it is too small or much
+         *  bigger than needed, so uploading the same configuration
+         *  again doesn't touch the heap.
+         */
+        void reserve(size_t size);
+
+        /** Returns memory for an object of the given size.
+         *
+         *  @returns nullptr if the arena is full.
+         */
+        void* allocate(size_t size);
+
+        /** Returns true if the pointer is inside the arena. */
+        bool contains(const void* ptr) const {
+            const auto p = static_cast<const uint8_t*>(ptr);
+            return block != nullptr && p >= block && p < block + capacity;
+        }
+
+        /** Frees all allocations at once (but keeps the block). */
+        void reset() {
+            used = 0u;
+        }
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+
+        size_t getUsed() const {
+            return used;
+        }
+};
+
+#endif // _RC_PROC_ARENA_H_
@@ -0,0 +1,132 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation of the proc step time profiler.
+ *
+ *  @file
+*/
+
+#include "proc_profiler.h"
+#include "simple_byte_stream.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+size_t StepTimes::bucketIndex(uint32_t us) {
+    if (us < 8u) {
+        return us;
+    }
+    // four buckets per power of two
+    const uint32_t octave = std::bit_width(us) - 1u;
+    const uint32_t sub = (us >> (octave - 2u)) & 3u;
+    return std::min<size_t>(8u + (octave - 3u) * 4u + sub, NUM_BUCKETS - 1u);
+}
+
+uint32_t StepTimes::bucketLimit(size_t index) {
+    if (index < 8u) {
+        return index + 1u;
+    }
+    const uint32_t octave = 3u + (index - 8u) / 4u;
+    const uint32_t sub = (index - 8u) % 4u;
+    return (5u + sub) << (octave - 2u);
+}
+
+StepTimes::StepTimes() {
+    clearWindow();
+    last = current();
+}
+
+void StepTimes::clearWindow() {
+    buckets.fill(0u);
+    count = 0u;
+    minUs = std::numeric_limits<uint32_t>::max();
+    maxUs = 0u;
+    sumUs = 0u;
+}
+
+void StepTimes::add(uint32_t us) {
+    buckets[bucketIndex(us)]++;
+    count++;
+    minUs = std::min(minUs, us);
+    maxUs = std::max(maxUs, us);
+    sumUs += us;
+
+    if (count >= WINDOW_SIZE) {
+        last = current();
+        clearWindow();
+    }
+}
+
+StepTimesSummary StepTimes::current() const {
+    if (count == 0u) {
+        return StepTimesSummary{0u, 0u, 0u, 0u, 0u};
+    }
+
+    // the 99th percentile is the first bucket reaching 99% of the steps
+    const uint32_t p99Count = (count * 99u + 99u) / 100u;
+    uint32_t sum = 0u;
+    uint32_t p99 = maxUs;
+    for (size_t i = 0u; i < NUM_BUCKETS - 1u; i++) {
+        sum += buckets[i];
+        if (sum >= p99Count) {
+            p99 = std::min(bucketLimit(i), maxUs);
+            break;
+        }
+    }
+
+    return StepTimesSummary{count, minUs, sumUs / count, maxUs, p99};
+}
+
+StepTimesSummary StepTimes::summary() const {
+    if (last.count == 0u) {
+        return current();
+    }
+    return last;
+}
+
+void ProcProfiler::reset(const std::vector<ProcTypeId>& procTypesVal) {
+    procTypes = procTypesVal;
+    procTimes.assign(procTypes.size(), StepTimes());
+
+    types.clear();
+    typeSlots.clear();
+    for (const auto type : procTypes) {
+        auto it = std::find(types.begin(), types.end(), type);
+        typeSlots.push_back(static_cast<uint8_t>(it - types.begin()));
+        if (it == types.end()) {
+            types.push_back(type);
+        }
+    }
+    typeTimes.assign(types.size(), StepTimes());
+}
+
+/** Writes a time saturated to 16 bit. */
+static void writeTime(SimpleOutStream& out, uint32_t us) {
+    out << static_cast<uint16_t>(std::min<uint32_t>(us, 0xFFFFu));
+}
+
+SimpleOutStream& operator<<(SimpleOutStream& out, const ProcProfiler& profiler) {
+    out << 'R' << 'T';
+    out << static_cast<uint8_t>(1u);  // version
+
+    out << static_cast<uint8_t>(profiler.getNumProcs());
+    for (size_t i = 0u; i < profiler.getNumProcs(); i++) {
+        const auto summary = profiler.getProcSummary(i);
+        writeTime(out, summary.minUs);
+        writeTime(out, summary.avgUs);
+        writeTime(out, summary.maxUs);
+        writeTime(out, summary.p99Us);
+    }
+
+    out << static_cast<uint8_t>(profiler.getNumTypes());
+    for (size_t i = 0u; i < profiler.getNumTypes(); i++) {
+        const auto summary = profiler.getTypeSummary(i);
+        out << static_cast<uint16_t>(profiler.getType(i));
+        out << static_cast<uint16_t>(std::min<uint32_t>(summary.count, 0xFFFFu));
+        writeTime(out, summary.minUs);
+        writeTime(out, summary.avgUs);
+        writeTime(out, summary.maxUs);
+        writeTime(out, summary.p99Us);
+    }
+    return out;
+}
@@ -0,0 +1,150 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for the proc step time profiler.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_PROC_PROFILER_H_
+#define _RC_PROC_PROFILER_H_
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class SimpleOutStream;
+
+/** Identifies the type of a proc.
+ *
+ *  These are the two characters of the serialization ID,
+ *  e.g. 'D' << 8 | 'E' for the InputDemo.
+ */
+typedef uint16_t ProcTypeId;
+
+/** Summary of the step times in micro seconds. */
+struct StepTimesSummary {
+    uint32_t count;  ///< Number of steps in the summary
+    uint32_t minUs;
+    uint32_t avgUs;
+    uint32_t maxUs;
+    uint32_t p99Us;  ///< 99th percentile (upper limit of the histogram bucket)
+};
+
+/** Collects the step times of one proc (or one proc type).
+ *
+ *  The times are collected in windows of WINDOW_SIZE steps.
+ *  The summary is always computed for the last complete window,
+ *  so the values roll over without keeping every single time.
+ *
+ *  For the percentile we keep a small histogram with four
+ *  buckets per power of two.
+ */
+class StepTimes {
+    public:
+        /** Number of steps in one window (5s in the main task). */
+        static constexpr uint32_t WINDOW_SIZE = 250u;
+
+        static constexpr size_t NUM_BUCKETS = 64u;
+
+        /** Returns the histogram bucket for the time. */
+        static size_t bucketIndex(uint32_t us);
+
+        /** Returns the (exclusive) upper limit of the bucket. */
+        static uint32_t bucketLimit(size_t index);
+
+    private:
+        std::array<uint8_t, NUM_BUCKETS> buckets;
+        uint32_t count;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint32_t sumUs;
+
+        /** The summary of the last complete window. */
+        StepTimesSummary last;
+
+        /** Computes the summary for the current window. */
+        StepTimesSummary current() const;
+
+        void clearWindow();
+
+    public:
+        StepTimes();
+
+        /** Adds the time of one step. */
+        void add(uint32_t us);
+
+        /** Returns the summary of the last complete window.
+         *
+         *  Returns the current window if there is no complete window yet.
+         */
+        StepTimesSummary summary() const;
+};
+
+/** Keeps the step times of all procs in a ProcStorage.
+ *
+ *  The times are kept per proc index and per proc type.
+ */
+class ProcProfiler {
+    private:
+        /** The type of every proc (by index). */
+        std::vector<ProcTypeId> procTypes;
+
+        /** The index into \ref types for every proc (by index). */
+        std::vector<uint8_t> typeSlots;
+
+        std::vector<StepTimes> procTimes;
+
+        /** All the different types in the order of appearance. */
+        std::vector<ProcTypeId> types;
+
+        std::vector<StepTimes> typeTimes;
+
+    public:
+        /** Resets the profiler for a new list of procs.
+         *
+         *  @param procTypesVal The type for every proc.
+         */
+        void reset(const std::vector<ProcTypeId>& procTypesVal);
+
+        /** Adds the time of one step for the proc at the index. */
+        void add(size_t index, uint32_t us) {
+            if (index < procTimes.size()) {
+                procTimes[index].add(us);
+                typeTimes[typeSlots[index]].add(us);
+            }
+        }
+
+        size_t getNumProcs() const {
+            return procTimes.size();
+        }
+
+        ProcTypeId getProcType(size_t index) const {
+            return procTypes[index];
+        }
+
+        StepTimesSummary getProcSummary(size_t index) const {
+            return procTimes[index].summary();
+        }
+
+        size_t getNumTypes() const {
+            return types.size();
+        }
+
+        ProcTypeId getType(size_t slot) const {
+            return types[slot];
+        }
+
+        StepTimesSummary getTypeSummary(size_t slot) const {
+            return typeTimes[slot].summary();
+        }
+};
+
+/** Writes the profiler report.
+ *
+ *  See architecture.md for the format.
+ */
+SimpleOutStream& operator<<(SimpleOutStream& out, const ProcProfiler& profiler);
+
+#endif // _RC_PROC_PROFILER_H_
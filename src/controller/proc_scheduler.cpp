@@ -0,0 +1,245 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation of the parallel proc scheduler.
+ *
+ *  @file
+ *
+*/
+
+#include "proc_scheduler.h"
+#include "audio_mix.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+using namespace rcSignals;
+using namespace rcProc;
+
+namespace {
+
+static constexpr size_t NONE_INDEX = static_cast<size_t>(SignalType::ST_NONE);
+
+/** Returns true if the procs need to be stepped in order. */
+bool conflicts(const SignalUsage& a, const SignalUsage& b) {
+    return (a.writes & (b.reads | b.writes)).any() ||
+        (a.reads & b.writes).any();
+}
+
+/** Returns the root of the set in the union-find parents. */
+size_t findRoot(std::vector<size_t>& parents, size_t i) {
+    while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+size_t intervalSize(const SamplesInterval& interval) {
+    return interval.last - interval.first;
+}
+
+} // namespace
+
+ProcScheduler::ProcScheduler() :
+    job(nullptr),
+    jobInfo{},
+    jobDone(false),
+    quit(false) {
+}
+
+ProcScheduler::~ProcScheduler() {
+    stopWorker();
+}
+
+void ProcScheduler::plan(const std::vector<ProcStep>& steps) {
+    stages.clear();
+
+    std::vector<SignalUsage> usages(steps.size());
+    std::vector<size_t> segment;
+    for (size_t i = 0u; i < steps.size(); i++) {
+        steps[i].proc->getSignalUsage(usages[i]);
+
+        if (usages[i].barrier) {
+            planSegment(steps, usages, segment);
+            segment.clear();
+
+            Stage stage{};
+            stage.lanes[0].push_back(Item{.step = steps[i], .resetNone = true});
+            stages.push_back(std::move(stage));
+
+        } else {
+            segment.push_back(i);
+        }
+    }
+    planSegment(steps, usages, segment);
+}
+
+void ProcScheduler::planSegment(const std::vector<ProcStep>& steps,
+        const std::vector<SignalUsage>& usages,
+        const std::vector<size_t>& segment) {
+
+    if (segment.empty()) {
+        return;
+    }
+
+    // -- find the independent chains
+    std::vector<size_t> parents(segment.size());
+    std::iota(parents.begin(), parents.end(), 0u);
+    for (size_t a = 0u; a < segment.size(); a++) {
+        for (size_t b = a + 1u; b < segment.size(); b++) {
+            if (conflicts(usages[segment[a]], usages[segment[b]])) {
+                parents[findRoot(parents, b)] = findRoot(parents, a);
+            }
+        }
+    }
+
+    struct Chain {
+        std::vector<size_t> members;  // indices into segment
+        bool writesNone;
+    };
+    std::vector<Chain> chains;
+    std::vector<size_t> chainOfRoot(segment.size(), SIZE_MAX);
+    for (size_t i = 0u; i < segment.size(); i++) {
+        const size_t root = findRoot(parents, i);
+        if (chainOfRoot[root] == SIZE_MAX) {
+            chainOfRoot[root] = chains.size();
+            chains.push_back(Chain{.members = {}, .writesNone = false});
+        }
+        auto& chain = chains[chainOfRoot[root]];
+        chain.members.push_back(i);
+        chain.writesNone |= usages[segment[i]].writes.test(NONE_INDEX);
+    }
+
+    // -- distribute the chains, the longest first
+    std::vector<size_t> order(chains.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&chains](size_t a, size_t b) {
+        return chains[a].members.size() > chains[b].members.size();
+    });
+
+    std::array<std::vector<size_t>, NUM_LANES> laneMembers;
+    std::vector<bool> resetNone(segment.size(), false);
+    for (const auto c : order) {
+        auto& lane = (laneMembers[1].size() < laneMembers[0].size()) ?
+            laneMembers[1] : laneMembers[0];
+        for (const auto i : chains[c].members) {
+            lane.push_back(i);
+            resetNone[i] = chains[c].writesNone;
+        }
+    }
+
+    Stage stage{};
+    for (uint8_t l = 0u; l < NUM_LANES; l++) {
+        std::sort(laneMembers[l].begin(), laneMembers[l].end());
+        for (const auto i : laneMembers[l]) {
+            stage.lanes[l].push_back(Item{.step = steps[segment[i]], .resetNone = resetNone[i]});
+            if (l > 0u && usages[segment[i]].audio) {
+                stage.audio = true;
+            }
+        }
+    }
+    stages.push_back(std::move(stage));
+}
+
+void ProcScheduler::startWorker() {
+    if (worker.joinable()) {
+        return;
+    }
+    quit = false;
+    worker = std::thread(&ProcScheduler::workerLoop, this);
+}
+
+void ProcScheduler::stopWorker() {
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wakeWorker.notify_one();
+    worker.join();
+}
+
+void ProcScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wakeWorker.wait(lock, [this] { return (job != nullptr) || quit; });
+        if (quit) {
+            return;
+        }
+
+        const auto items = job;
+        const auto info = jobInfo;
+        lock.unlock();
+        stepLane(*items, info);
+        lock.lock();
+
+        job = nullptr;
+        jobDone = true;
+        wakeCaller.notify_one();
+    }
+}
+
+void ProcScheduler::stepLane(const std::vector<Item>& items, const StepInfo& info) {
+    RcSignal& none = (*(info.signals))[SignalType::ST_NONE];
+    for (const auto& item : items) {
+        if (item.resetNone) {
+            none = RCSIGNAL_NEUTRAL;
+        }
+        item.step.fn(item.step.proc, info);
+    }
+}
+
+void ProcScheduler::step(const StepInfo& info) {
+    for (const auto& stage : stages) {
+        (*(info.signals))[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+
+        if (stage.lanes[1].empty()) {
+            stepLane(stage.lanes[0], info);
+            continue;
+        }
+
+        // -- the second lane renders into the scratch buffer
+        StepInfo info1 = info;
+        if (stage.audio) {
+            scratch.assign(intervalSize(info.intervals[0]) + intervalSize(info.intervals[1]),
+                AudioSample{0, 0});
+            AudioSample* pos = scratch.data();
+            for (size_t i = 0u; i < info.intervals.size(); i++) {
+                const size_t size = intervalSize(info.intervals[i]);
+                info1.intervals[i] = SamplesInterval{.first = pos, .last = pos + size};
+                pos += size;
+            }
+        }
+
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = &stage.lanes[1];
+                jobInfo = info1;
+                jobDone = false;
+            }
+            wakeWorker.notify_one();
+            stepLane(stage.lanes[0], info);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCaller.wait(lock, [this] { return jobDone; });
+
+        } else {
+            stepLane(stage.lanes[0], info);
+            stepLane(stage.lanes[1], info1);
+        }
+
+        // -- sum up the audio of both lanes
+        if (stage.audio) {
+            const AudioSample* in = scratch.data();
+            for (const auto& interval : info.intervals) {
+                const size_t size = intervalSize(interval);
+                rcAudio::addBlock(in, interval.first, size);
+                in += size;
+            }
+        }
+    }
+}
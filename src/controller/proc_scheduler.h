@@ -0,0 +1,141 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for the parallel proc scheduler.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_PROC_SCHEDULER_H_
+#define _RC_PROC_SCHEDULER_H_
+
+#include "proc.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** A proc together with a step function called without virtual dispatch.
+ *
+ *  See ProcStorage::getStepFn()
+ */
+struct ProcStep {
+    typedef void (*Fn)(rcProc::Proc* proc, const rcProc::StepInfo& info);
+
+    Fn fn;
+    rcProc::Proc* proc;
+};
+
+/** Steps independent procs on two lanes in parallel.
+ *
+ *  plan() builds a dependency graph out of the rcProc::SignalUsage of
+ *  the procs. Two procs depend on each other if one of them writes
+ *  a signal the other one reads or writes. Procs reporting a barrier
+ *  split the list into stages.
+ *
+ *  Within a stage the independent chains of procs are distributed
+ *  on the two lanes. The first lane is stepped by the calling task,
+ *  the second one by a worker thread (on the ESP32 on the other core).
+ *  Both lanes keep the original order of the procs, so the signals
+ *  are the same as when stepping the procs one after the other.
+ *
+ *  The audio procs of the second lane add their samples to a
+ *  separate buffer which is mixed into the StepInfo::intervals
+ *  after the stage. The result only differs from the sequential
+ *  stepping if the audio is clipping or by rounding for procs mixing
+ *  with floats (Audio::copySample()), but it is always the same for
+ *  the same inputs.
+ *
+ *  ST_NONE is treated like a real signal. It is reset before the
+ *  procs of a chain that writes it.
+ */
+class ProcScheduler {
+    public:
+        static constexpr uint8_t NUM_LANES = 2u;
+
+        /** A proc in a lane. */
+        struct Item {
+            ProcStep step;
+
+            /** ST_NONE needs to be reset before the step. */
+            bool resetNone;
+        };
+
+        /** Procs that are stepped in parallel.
+         *
+         *  The next stage only starts after both lanes finished.
+         */
+        struct Stage {
+            std::array<std::vector<Item>, NUM_LANES> lanes;
+
+            /** The second lane contains audio procs and needs the scratch buffer. */
+            bool audio;
+        };
+
+    private:
+        std::vector<Stage> stages;
+
+        /** Audio buffer for the second lane. */
+        std::vector<rcProc::AudioSample> scratch;
+
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable wakeWorker;
+        std::condition_variable wakeCaller;
+
+        /** The lane the worker should step or nullptr. */
+        const std::vector<Item>* job;
+        rcProc::StepInfo jobInfo;
+        bool jobDone;
+        bool quit;
+
+        /** Adds the stages for procs without barriers. */
+        void planSegment(const std::vector<ProcStep>& steps,
+            const std::vector<rcProc::SignalUsage>& usages,
+            const std::vector<size_t>& segment);
+
+        void workerLoop();
+
+        static void stepLane(const std::vector<Item>& items, const rcProc::StepInfo& info);
+
+    public:
+        ProcScheduler();
+        ~ProcScheduler();
+
+        ProcScheduler(const ProcScheduler&) = delete;
+        ProcScheduler& operator=(const ProcScheduler&) = delete;
+
+        /** Creates the stages for the procs.
+         *
+         *  Calls rcProc::Proc::getSignalUsage() for every proc.
+         */
+        void plan(const std::vector<ProcStep>& steps);
+
+        /** Starts the worker thread for the second lane.
+         *
+         *  Without the worker step() steps both lanes one after the
+         *  other (with the same result).
+         *  On the ESP32 the thread is created with the current
+         *  esp_pthread configuration (core, stack size, priority).
+         */
+        void startWorker();
+
+        /** Stops the worker thread. */
+        void stopWorker();
+
+        bool hasWorker() const {
+            return worker.joinable();
+        }
+
+        /** Steps all stages. */
+        void step(const rcProc::StepInfo& info);
+
+        const std::vector<Stage>& getStages() const {
+            return stages;
+        }
+};
+
+#endif // _RC_PROC_SCHEDULER_H_
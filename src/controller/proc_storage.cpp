@@ -9,8 +9,10 @@
 #include "proc_storage.h"
 #include "simple_byte_stream.h"
 #include "sample_storage_singleton.h"
+#include "config_store.h"
 
 #include "signals.h"
+#include "clock.h"
 
 #include "input.h"
 #include "input_demo.h"
@@ -53,6 +55,7 @@ static const char* TAG = "ProcStorage";
 #include <vector>
 #include <array>
 #include <span>
+#include <typeinfo>
 
 #define STORAGE_NAMESPACE "storage"
 
@@ -67,7 +70,14 @@ using namespace rcAudio;
  */
 Proc* createProc(ProcType type);
 
-ProcStorage::ProcStorage() {
+ProcStorage::ProcStorage() :
+    separateAudio(false),
+    profiling(false),
+    pipeline(true),
+    parallel(false),
+    schedulerDirty(true),
+    parallelAudio(false),
+    audioSchedulerDirty(true) {
 
     createDefaultConfig();
 }
@@ -96,6 +106,7 @@ void ProcStorage::createDefaultConfig() {
     procs.push_back(new rcOutput::OutputAudio());
 #endif
 
+    updateProcLists();
 }
 
 void ProcStorage::vehicleSteamTrain() {
@@ -427,9 +438,54 @@ void ProcStorage::vehicleCar() {
 void ProcStorage::clear() {
     // destroy the old procs
     for (const auto& proc : procs) {
-        delete proc;  // no need to call proc->stop(). The destructor does that automatically
+        destroyProc(proc);  // no need to call proc->stop(). The destructor does that automatically
     }
     procs.resize(0);
+    arena.reset();
+    updateProcLists();
+}
+
+void ProcStorage::destroyProc(rcProc::Proc* proc) {
+    if (proc == nullptr) {
+        return;
+    }
+    if (arena.contains(proc)) {
+        proc->~Proc();
+    } else {
+        delete proc;
+    }
+}
+
+void ProcStorage::updateProcLists() {
+    controlProcs.clear();
+    audioProcs.clear();
+    allPipeline.clear();
+    controlPipeline.clear();
+    audioPipeline.clear();
+    for (uint16_t i = 0u; i < procs.size(); i++) {
+        const bool isAudio = (dynamic_cast<rcAudio::Audio*>(procs[i]) != nullptr);
+        if (isAudio) {
+            audioProcs.push_back(i);
+        } else {
+            controlProcs.push_back(i);
+        }
+
+        if (typeid(*procs[i]) == typeid(rcProc::ProcGroup)) {
+            continue;  // the groups are only used by the UI
+        }
+        StepFn fn = getStepFn(*procs[i]);
+        const PipelineEntry entry{
+            .fn = (fn != nullptr) ? fn : &stepVirtual,
+            .proc = procs[i]};
+        allPipeline.push_back(entry);
+        (isAudio ? audioPipeline : controlPipeline).push_back(entry);
+    }
+    schedulerDirty = true;
+    audioSchedulerDirty = true;
+
+    if (profiling) {
+        setProfiling(true);  // reset for the new procs
+    }
 }
 
 void ProcStorage::start() {
@@ -444,73 +500,216 @@ void ProcStorage::stop() {
     }
 }
 
+void ProcStorage::relocateSamples(std::span<const uint8_t> from, const uint8_t* to) {
+    for (const auto index : audioProcs) {
+        static_cast<rcAudio::Audio*>(procs[index])->relocateSamples(from, to);
+    }
+}
+
+void ProcStorage::stepProc(uint16_t index, const StepInfo& info) {
+    (*(info.signals))[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL; // ensure that this signal stays neutral.
+
+    if (profiling) {
+        const TimeUs start = getTimeUs();
+        procs[index]->step(info);
+        profiler.add(index, static_cast<uint32_t>(getTimeUs() - start));
+    } else {
+        procs[index]->step(info);
+    }
+}
+
+void ProcStorage::stepPipeline(const std::vector<PipelineEntry>& entries,
+        const StepInfo& info) {
+
+    RcSignal& none = (*(info.signals))[SignalType::ST_NONE];
+    for (const auto& entry : entries) {
+        none = RCSIGNAL_NEUTRAL; // ensure that this signal stays neutral.
+        entry.fn(entry.proc, info);
+    }
+}
+
+void ProcStorage::stepVirtual(Proc* proc, const StepInfo& info) {
+    proc->step(info);
+}
+
 void ProcStorage::step(const StepInfo& info) {
 
-    for (Proc* proc : procs) {
-        (*(info.signals))[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL; // ensure that this signal stays neutral.
-        proc->step(info);
+    if (pipeline && !profiling && parallel) {
+        if (schedulerDirty) {
+            scheduler.plan(separateAudio ? controlPipeline : allPipeline);
+            schedulerDirty = false;
+        }
+        scheduler.step(info);
+
+    } else if (pipeline && !profiling) {
+        stepPipeline(separateAudio ? controlPipeline : allPipeline, info);
+
+    } else if (separateAudio) {
+        for (const auto index : controlProcs) {
+            stepProc(index, info);
+        }
+    } else {
+        for (uint16_t i = 0u; i < procs.size(); i++) {
+            stepProc(i, info);
+        }
     }
 }
 
-void ProcStorage::loadFromNvm() {
+void ProcStorage::setSeparateAudio(bool separate) {
+    separateAudio = separate;
+    schedulerDirty = true;
+}
+
+void ProcStorage::setParallel(bool on) {
+    parallel = on;
+    if (on) {
+        scheduler.startWorker();
+    } else {
+        scheduler.stopWorker();
+    }
+}
+
+void ProcStorage::setParallelAudio(bool on) {
+    parallelAudio = on;
+    if (on) {
+        audioScheduler.startWorker();
+    } else {
+        audioScheduler.stopWorker();
+    }
+}
+
+void ProcStorage::stepAudio(const StepInfo& info) {
+
+    if (pipeline && !profiling && parallelAudio) {
+        if (audioSchedulerDirty) {
+            audioScheduler.plan(audioPipeline);
+            audioSchedulerDirty = false;
+        }
+        audioScheduler.step(info);
+        return;
+
+    } else if (pipeline && !profiling) {
+        stepPipeline(audioPipeline, info);
+        return;
+    }
+
+    for (const auto index : audioProcs) {
+        stepProc(index, info);
+    }
+}
+
+void ProcStorage::setProfiling(bool on) {
+    profiling = on;
+
+    std::vector<ProcTypeId> types;
+    if (on) {
+        for (const auto proc : procs) {
+            types.push_back(getProcTypeId(*proc));
+        }
+    }
+    profiler.reset(types);
+}
+
 #ifdef HAVE_NV
+/** The store in the "config" partition, mapped on first use. */
+static ConfigStore& configStore() {
+    static ConfigStore store;
+    return store;
+}
+
+/** Reads a configuration saved by an older firmware in the NVS. */
+static std::vector<uint8_t> readFromNvs() {
+    std::vector<uint8_t> buffer;
     nvs_handle_t nvsHandle;
 
-    // Open
-    ESP_ERROR_CHECK(
-        nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &nvsHandle));
+    if (nvs_open(STORAGE_NAMESPACE, NVS_READONLY, &nvsHandle) != ESP_OK) {
+        return buffer;
+    }
 
     size_t bufferSize = 0;
+    if (nvs_get_blob(nvsHandle, "config", NULL, &bufferSize) == ESP_OK &&
+        bufferSize > 0) {
 
-    esp_err_t ret;
-    ret = nvs_get_blob(nvsHandle, "config", NULL, &bufferSize);
-    if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
-        ESP_LOGI(TAG, "No NVM found");
-
-    } else if (bufferSize == 0) {
-        ESP_LOGI(TAG, "No config NVM found");
-
-    } else {
-        uint8_t* buffer = new uint8_t[bufferSize];
+        buffer.resize(bufferSize);
         ESP_ERROR_CHECK(
-            nvs_get_blob(nvsHandle, "config", buffer, &bufferSize));
-        std::span<const uint8_t> sp(buffer, bufferSize);
-        SimpleInStream stream(sp);
-        deserialize(stream);
+            nvs_get_blob(nvsHandle, "config", buffer.data(), &bufferSize));
+    }
 
-        delete[] buffer;
+    nvs_close(nvsHandle);
+    return buffer;
+}
+
+/** Removes the configuration from the NVS once it is in the config partition. */
+static void eraseFromNvs() {
+    nvs_handle_t nvsHandle;
 
-        ESP_LOGI(TAG, "Loaded config from NVM");
+    if (nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &nvsHandle) != ESP_OK) {
+        return;
     }
 
+    nvs_erase_key(nvsHandle, "config");
+    nvs_commit(nvsHandle);
     nvs_close(nvsHandle);
+}
+#endif
+
+void ProcStorage::loadFromNvm() {
+#ifdef HAVE_NV
+    auto& store = configStore();
+
+    if (loadFrom(store)) {
+        ESP_LOGI(TAG, "Loaded config from slot %d", store.activeSlot());
+        return;
+    }
+
+    const auto buffer = readFromNvs();
+    if (buffer.empty()) {
+        ESP_LOGI(TAG, "No config found");
+        return;
+    }
+
+    // the NVS copy is kept until the config partition has it
+    SimpleInStream stream(buffer);
+    if (deserialize(stream) && store.save(buffer)) {
+        eraseFromNvs();
+        ESP_LOGI(TAG, "Moved config from NVS to the config partition");
+    }
 #endif
 }
 
 void ProcStorage::saveToNvm() const {
 #ifdef HAVE_NV
-    nvs_handle_t nvsHandle;
+    if (saveTo(configStore())) {
+        ESP_LOGI(TAG, "Wrote config to slot %d", configStore().activeSlot());
+    } else {
+        ESP_LOGW(TAG, "Could not write the config");
+    }
+#endif
+}
+
+bool ProcStorage::loadFrom(const ConfigStore& store) {
+    const auto data = store.load();
+    if (data.empty()) {
+        return false;
+    }
 
-    // Open
-    ESP_ERROR_CHECK(
-        nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &nvsHandle));
+    // read directly from the mapped flash
+    SimpleInStream stream(data);
+    return deserialize(stream);
+}
 
-    SimpleOutStream stream;
+bool ProcStorage::saveTo(ConfigStore& store) const {
+    // size the buffer exactly
+    auto counter = SimpleOutStream::counting();
+    serialize(counter);
+    std::vector<uint8_t> buffer(counter.tellg());
+    SimpleOutStream stream(buffer);
     serialize(stream);
 
     if (stream.fail()) {
-        ESP_LOGW(TAG, "Ran out of buffer writing NVM");
-    } else {
-        ESP_ERROR_CHECK(
-            nvs_set_blob(nvsHandle, "config",
-                stream.buffer().data(), stream.buffer().size()));
-
-        ESP_LOGI(TAG, "Wrote config to NVM");
+        return false;
     }
-
-    free(stream.buffer().data());
-    nvs_close(nvsHandle);
-#endif
+    return store.save(std::span<const uint8_t>(buffer.data(), stream.tellg()));
 }
 
 void ProcStorage::serialize(SimpleOutStream& out) const {
@@ -542,8 +741,19 @@ bool ProcStorage::deserialize(SimpleInStream& in) {
 
     clear();
 
-    // insert procs
+    // size the arena for all procs before creating them
     const uint8_t count = in.read<uint8_t>();
+    const auto startPos = in.tellg();
+    size_t arenaSize = 0u;
+    const auto& buffer = in.buffer();
+    for (uint32_t i = 0u, pos = startPos; i < count && pos + 3u <= buffer.size(); i++) {
+        const ProcTypeId id = (buffer[pos] << 8) | buffer[pos + 1u];
+        pos += 3u + buffer[pos + 2u];  // id, length and data
+        arenaSize += getProcSize(id);
+    }
+    arena.reserve(arenaSize);
+
+    // insert procs
     for (uint8_t i = 0; i < count; i++) {
         auto proc = deserializeProc(in);
 #ifdef HAVE_NV
@@ -570,6 +780,79 @@ bool ProcStorage::deserialize(SimpleInStream& in) {
     if (procs.size() == 0) {
         createDefaultConfig();
     }
+    updateProcLists();
     return true;
 };
 
+bool ProcStorage::isPatch(const std::span<const uint8_t>& data) {
+    return data.size() >= 3u &&
+        data[0] == 'R' && data[1] == 'P' && data[2] == 1U;
+}
+
+bool ProcStorage::patch(SimpleInStream& in) {
+
+    // check header
+    auto b1 = in.read<uint8_t>();
+    auto b2 = in.read<uint8_t>();
+    auto b3 = in.read<uint8_t>();
+    if (b1 != 'R' || b2 != 'P' || b3 != 1U) {
+#ifdef HAVE_NV
+        ESP_LOGW(TAG, "Patch header incorrect.");
+#endif
+        return false;
+    }
+
+    const auto op = static_cast<PatchOp>(in.read<uint8_t>());
+    const uint8_t index = in.read<uint8_t>();
+    if (in.fail()) {
+        return false;
+    }
+
+    switch (op) {
+    case PatchOp::REPLACE:
+    case PatchOp::INSERT: {
+        const bool insert = (op == PatchOp::INSERT);
+        if ((insert && (index > procs.size() || procs.size() >= UINT8_MAX)) ||
+            (!insert && index >= procs.size())) {
+            return false;
+        }
+
+        auto proc = deserializeProc(in);
+        if (proc == nullptr) {
+            return false;
+        }
+        if (in.fail()) {
+            destroyProc(proc);
+            return false;
+        }
+
+        proc->start();
+        if (insert) {
+            procs.insert(procs.begin() + index, proc);
+        } else {
+            destroyProc(procs[index]);  // the destructor calls stop()
+            procs[index] = proc;
+        }
+        break;
+    }
+
+    case PatchOp::REMOVE:
+        if (index >= procs.size()) {
+            return false;
+        }
+        destroyProc(procs[index]);
+        procs.erase(procs.begin() + index);
+        break;
+
+    default:
+        return false;
+    }
+
+#ifdef HAVE_NV
+    ESP_LOGI(TAG, "Patched proc %d with op %c.",
+        static_cast<int>(index), static_cast<char>(op));
+#endif
+
+    updateProcLists();
+    return true;
+}
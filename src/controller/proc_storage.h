@@ -11,6 +11,13 @@
 
 #include "signals.h"
 #include "sample.h"
+#include "proc_arena.h"
+#include "proc_profiler.h"
+#include "proc_scheduler.h"
+#include <mutex>
+#include <new>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace rcProc {
@@ -20,6 +27,7 @@ class Proc;
 
 class SimpleInStream;
 class SimpleOutStream;
+class ConfigStore;
 
 /** This class manages the functions controller configuration.
  *
@@ -30,6 +38,17 @@ class SimpleOutStream;
  *  - deserialize from binary stream
  */
 class ProcStorage {
+    public:
+        /** The operations of a configuration patch.
+         *
+         *  See patch()
+         */
+        enum class PatchOp : uint8_t {
+            REPLACE = 'R',  ///< Replaces the proc at the index
+            INSERT = 'I',  ///< Inserts the proc before the index
+            REMOVE = 'D'  ///< Removes the proc at the index (no proc in the patch)
+        };
+
     private:
 
         /** List of all procs.
@@ -37,14 +56,131 @@ class ProcStorage {
          *  Storage manages the lists of procs, meaning processing
          *  nodes for the signals.
          *
-         *  Note: not using unique_ptr here. Content has to be deleted.
+         *  Note: not using unique_ptr here. Content has to be
+         *  destroyed with destroyProc().
          */
         std::vector<rcProc::Proc*> procs;
 
+        /** Memory for the procs created by deserialize(). */
+        ProcArena arena;
+
+        /** True if the audio procs are stepped separately via stepAudio(). */
+        bool separateAudio;
+
+        /** Indices of the procs that are not rcAudio::Audio procs. */
+        std::vector<uint16_t> controlProcs;
+
+        /** Indices of the rcAudio::Audio procs. */
+        std::vector<uint16_t> audioProcs;
+
+        /** True if the step times of the procs are recorded. */
+        bool profiling;
+
+        /** The step times of the procs if \ref profiling is on. */
+        ProcProfiler profiler;
+
+        /** A step function called without virtual dispatch.
+         *
+         *  See getStepFn()
+         */
+        typedef ProcStep::Fn StepFn;
+
+        /** A proc together with its step function. */
+        typedef ProcStep PipelineEntry;
+
+        /** True if step() and stepAudio() run the pipelines below
+         *  instead of the virtual step() functions.
+         */
+        bool pipeline;
+
+        /** All procs except the ones doing nothing (rcProc::ProcGroup). */
+        std::vector<PipelineEntry> allPipeline;
+
+        /** Same as \ref allPipeline, but without the rcAudio::Audio procs. */
+        std::vector<PipelineEntry> controlPipeline;
+
+        /** The rcAudio::Audio procs. */
+        std::vector<PipelineEntry> audioPipeline;
+
+        /** True if step() runs the procs on two lanes, see setParallel(). */
+        bool parallel;
+
+        /** True if the \ref scheduler needs a new plan. */
+        bool schedulerDirty;
+
+        /** Steps the pipeline of step() in parallel mode. */
+        ProcScheduler scheduler;
+
+        /** True if stepAudio() runs the audio procs on two lanes, see setParallelAudio(). */
+        bool parallelAudio;
+
+        /** True if the \ref audioScheduler needs a new plan. */
+        bool audioSchedulerDirty;
+
+        /** Steps the audio procs in parallel audio mode.
+         *
+         *  Separate from the \ref scheduler since step() and
+         *  stepAudio() are called by different tasks.
+         */
+        ProcScheduler audioScheduler;
+
+        /** Protects the audio procs against modification while rendering.
+         *
+         *  See getAudioMutex()
+         */
+        std::mutex audioMutex;
+
+        /** Sorts the procs into \ref controlProcs and \ref audioProcs
+         *  and creates the pipelines.
+         *
+         *  Needs to be called after every change of \ref procs.
+         */
+        void updateProcLists();
+
+        /** Calls step() for the proc at the index, recording the time
+         *  if profiling is on.
+         */
+        void stepProc(uint16_t index, const rcProc::StepInfo& info);
+
+        /** Calls the step functions of all entries in the pipeline. */
+        static void stepPipeline(const std::vector<PipelineEntry>& entries,
+            const rcProc::StepInfo& info);
+
+        /** Calls T::step() for a proc with the exact type T.
+         *
+         *  The qualified call is resolved at compile time, so there
+         *  is no lookup in the vtable.
+         */
+        template<typename T>
+        static void stepThunk(rcProc::Proc* proc, const rcProc::StepInfo& info) {
+            static_cast<T*>(proc)->T::step(info);
+        }
+
+        /** Calls the virtual step() for procs without a stepThunk(). */
+        static void stepVirtual(rcProc::Proc* proc, const rcProc::StepInfo& info);
+
         /** Removes all procs from the procs vector and frees their memory.
          */
         void clear();
 
+        /** Creates a proc in the arena.
+         *
+         *  Falls back to the heap if the arena is full, e.g. for procs
+         *  added by patch().
+         */
+        template<typename T, typename... Args>
+        T* createProc(Args&&... args) {
+            static_assert(alignof(T) <= ProcArena::ALIGNMENT);
+            void* mem = arena.allocate(sizeof(T));
+            if (mem != nullptr) {
+                return new(mem) T(std::forward<Args>(args)...);
+            }
+            return new T(std::forward<Args>(args)...);
+        }
+
+        /** Destroys a proc created by createProc() or new. */
+        void destroyProc(rcProc::Proc* proc);
+
         /** Serializes a proc to the output stream.
          *
          *  This function is created by a python script out of the proc
@@ -63,6 +199,38 @@ class ProcStorage {
          */
         rcProc::Proc* deserializeProc(SimpleInStream& in);
 
+        /** Returns the type of the proc (the serialization ID).
+         *
+         *  This function is created by a python script out of the proc
+         *  configuration file.
+         *
+         *  Look for it in serialize.cpp.
+         */
+        static ProcTypeId getProcTypeId(const rcProc::Proc& proc);
+
+        /** Returns the arena size needed for the proc with the type.
+         *
+         *  This function is created by a python script out of the proc
+         *  configuration file.
+         *
+         *  Look for it in serialize.cpp.
+         *
+         *  @returns 0 for unknown types.
+         */
+        static size_t getProcSize(ProcTypeId id);
+
+        /** Returns the stepThunk() for the type of the proc.
+         *
+         *  This function is created by a python script out of the proc
+         *  configuration file.
+         *
+         *  Look for it in serialize.cpp.
+         *
+         *  @returns nullptr for unknown types (e.g. procs derived from
+         *    a configurable proc).
+         */
+        static StepFn getStepFn(const rcProc::Proc& proc);
+
         /** Returns the sample file for the audio id.
          *
          *  Searches in static and dynamic samples list.
@@ -121,6 +289,14 @@ class ProcStorage {
         /** Calls stop() for all the procs. */
         void stop();
 
+        /** Points the samples of the audio procs inside from to their copy at to.
+         *
+         *  Used after a sample was moved in the flash, the other procs
+         *  are not touched. The caller needs to hold the lock from
+         *  getAudioMutex().
+         */
+        void relocateSamples(std::span<const uint8_t> from, const uint8_t* to);
+
         /** Applies the signal transformation for all the *procs*.
          *
          *  This function needs to be called sufficiently often
@@ -131,12 +307,143 @@ class ProcStorage {
          */
         void step(const rcProc::StepInfo& info);
 
-        /** Tries to load the configuration from non volatile memory (flash) */
+        /** Switches the separate audio rendering on or off.
+         *
+         *  When on, step() skips all rcAudio::Audio procs and
+         *  they need to be driven by stepAudio(), usually from
+         *  a dedicated audio render task.
+         */
+        void setSeparateAudio(bool separate);
+
+        /** Applies step() for the rcAudio::Audio procs only.
+         *
+         *  This is used by the AudioRenderer in separate audio mode.
+         *  The caller needs to hold the lock from getAudioMutex().
+         *
+         *  @param info The (read-only) signals and the audio intervals
+         *    to render.
+         */
+        void stepAudio(const rcProc::StepInfo& info);
+
+        /** Switches the step pipelines on or off (default on).
+         *
+         *  With the pipelines, step() and stepAudio() call the step
+         *  functions of the procs directly instead of via the vtable
+         *  and skip the procs doing nothing.
+         *  The pipelines are not used while profiling.
+         *  In separate audio mode the caller needs to hold the lock
+         *  from getAudioMutex().
+         */
+        void setPipeline(bool on) {
+            pipeline = on;
+        }
+
+        bool isPipeline() const {
+            return pipeline;
+        }
+
+        /** Switches the parallel stepping on or off (default off).
+         *
+         *  When on, step() runs independent procs (see
+         *  rcProc::Proc::getSignalUsage()) on two lanes, the second
+         *  one in a worker thread. See ProcScheduler.
+         *  stepAudio() is not affected.
+         *  Only used together with the pipelines and not while profiling.
+         *  In separate audio mode the caller needs to hold the lock
+         *  from getAudioMutex().
+         */
+        void setParallel(bool on);
+
+        bool isParallel() const {
+            return parallel;
+        }
+
+        /** Returns the scheduler used in parallel mode. */
+        const ProcScheduler& getScheduler() const {
+            return scheduler;
+        }
+
+        /** Switches the parallel rendering of the audio procs on or off (default off).
+         *
+         *  When on, stepAudio() distributes the audio procs on two
+         *  lanes, the second one in its own worker thread. Each lane
+         *  mixes into its own buffer and the buffers are added up at
+         *  the end. See ProcScheduler.
+         *  Only used together with the pipelines and not while profiling.
+         *  In separate audio mode the caller needs to hold the lock
+         *  from getAudioMutex().
+         */
+        void setParallelAudio(bool on);
+
+        bool isParallelAudio() const {
+            return parallelAudio;
+        }
+
+        /** Returns the scheduler used in parallel audio mode. */
+        const ProcScheduler& getAudioScheduler() const {
+            return audioScheduler;
+        }
+
+        /** Returns the mutex protecting the audio procs.
+         *
+         *  In separate audio mode the render task holds this lock while
+         *  rendering, and the main task needs to hold it while
+         *  modifying the configuration (e.g. stop(), deserialize(), start())
+         *  or the audio samples.
+         */
+        std::mutex& getAudioMutex() {
+            return audioMutex;
+        }
+
+        /** Switches the recording of the step times on or off.
+         *
+         *  In separate audio mode the caller needs to hold the lock
+         *  from getAudioMutex().
+         */
+        void setProfiling(bool on);
+
+        /** Returns true if the step times are recorded.
+         *
+         *  Only for the task calling setProfiling(), the other tasks
+         *  use the report published by it.
+         */
+        bool isProfiling() const {
+            return profiling;
+        }
+
+        /** Returns the step times of the procs.
+         *
+         *  The profiler is reset whenever the configuration changes.
+         *  In separate audio mode the caller needs to hold the lock
+         *  from getAudioMutex() while reading.
+         */
+        const ProcProfiler& getProfiler() const {
+            return profiler;
+        }
+
+        /** Tries to load the configuration from non volatile memory (flash)
+         *
+         *  A configuration still stored in the NVS (by an older firmware)
+         *  is moved to the config partition.
+         */
         void loadFromNvm();
 
-        /** Tries to save the configuration from non volatile memory (flash) */
+        /** Tries to save the configuration from non volatile memory (flash)
+         *
+         *  The procs look up their sample IDs, in separate audio mode the
+         *  caller needs to hold the lock from getAudioMutex().
+         */
         void saveToNvm() const;
 
+        /** Deserializes the configuration directly from the mapped flash.
+         *
+         *  @returns false if the store is empty or the configuration is invalid.
+         */
+        bool loadFrom(const ConfigStore& store);
+
+        /** Serializes the configuration into the store. */
+        bool saveTo(ConfigStore& store) const;
+
 
         /** Serialize the Proc to a SimpleByteStream.
          *
@@ -154,6 +461,31 @@ class ProcStorage {
          *  @returns false if deserialization didn't work
          */
         bool deserialize(SimpleInStream& in);
+
+        /** Returns the arena containing the deserialized procs. */
+        const ProcArena& getArena() const {
+            return arena;
+        }
+
+        /** Returns true if the data contains a configuration patch
+         *  instead of a full configuration.
+         */
+        static bool isPatch(const std::span<const uint8_t>& data);
+
+        /** Applies a configuration patch from the stream.
+         *
+         *  Format: 'R', 'P', 1, PatchOp, u8 index, [proc]
+         *
+         *  In contrast to deserialize() only the affected proc is
+         *  created (and started) or deleted. All the other procs keep
+         *  their state.
+         *  In separate audio mode the caller needs to hold the lock
+         *  from getAudioMutex().
+         *
+         *  @returns false if the patch could not be applied. The
+         *    configuration is unchanged in this case.
+         */
+        bool patch(SimpleInStream& in);
 };
 
 
@@ -0,0 +1,115 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation of the hash index of the audio samples.
+ *
+ *  @file
+ *
+*/
+
+#include "sample_index.h"
+
+#include <cstdint>
+
+namespace {
+
+/** 2^32 / golden ratio, spreads consecutive keys over the table. */
+static constexpr uint32_t FIBONACCI = 0x9E3779B9u;
+
+static constexpr size_t MIN_SLOTS = 4u;
+
+} // namespace
+
+SampleIndex::SampleIndex() :
+    mask(0u),
+    shift(32u),
+    count(0u),
+    dataCount(0u) {
+    reset(0u);
+}
+
+void SampleIndex::reset(size_t numSamples) {
+    size_t slots = MIN_SLOTS;
+    shift = 30u;
+    while (slots < numSamples * 2u) {
+        slots *= 2u;
+        shift--;
+    }
+    mask = static_cast<uint32_t>(slots - 1u);
+    count = 0u;
+    dataCount = 0u;
+
+    idSlots.assign(slots, IdSlot{.id = {0, 0, 0}, .index = NOT_FOUND});
+    dataSlots.assign(slots, DataSlot{.data = nullptr, .index = NOT_FOUND});
+}
+
+uint32_t SampleIndex::slotOf(const rcSamples::AudioId& id) const {
+    const uint32_t key =
+        static_cast<uint32_t>(static_cast<uint8_t>(id[0])) |
+        (static_cast<uint32_t>(static_cast<uint8_t>(id[1])) << 8) |
+        (static_cast<uint32_t>(static_cast<uint8_t>(id[2])) << 16);
+    return (key * FIBONACCI) >> shift;
+}
+
+uint32_t SampleIndex::slotOf(const uint8_t* data) const {
+    const auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(data));
+    const uint32_t key = static_cast<uint32_t>(address ^ (address >> 32));
+    return (key * FIBONACCI) >> shift;
+}
+
+void SampleIndex::add(const rcSamples::AudioId& id, const uint8_t* data, uint16_t index) {
+    add(id, index);
+    add(data, index);
+}
+
+void SampleIndex::add(const rcSamples::AudioId& id, uint16_t index) {
+    // keep the load factor at most 1/2
+    if ((count + 1u) * 2u > idSlots.size()) {
+        return;
+    }
+    count++;
+
+    for (uint32_t slot = slotOf(id); ; slot = (slot + 1u) & mask) {
+        if (idSlots[slot].index == NOT_FOUND) {
+            idSlots[slot] = IdSlot{.id = id, .index = index};
+            break;
+        }
+        if (idSlots[slot].id == id) {
+            break;
+        }
+    }
+}
+
+void SampleIndex::add(const uint8_t* data, uint16_t index) {
+    if ((dataCount + 1u) * 2u > dataSlots.size()) {
+        return;
+    }
+    dataCount++;
+
+    for (uint32_t slot = slotOf(data); ; slot = (slot + 1u) & mask) {
+        if (dataSlots[slot].index == NOT_FOUND) {
+            dataSlots[slot] = DataSlot{.data = data, .index = index};
+            break;
+        }
+        if (dataSlots[slot].data == data) {
+            break;
+        }
+    }
+}
+
+uint16_t SampleIndex::find(const rcSamples::AudioId& id) const {
+    for (uint32_t slot = slotOf(id); ; slot = (slot + 1u) & mask) {
+        const IdSlot& entry = idSlots[slot];
+        if (entry.index == NOT_FOUND || entry.id == id) {
+            return entry.index;
+        }
+    }
+}
+
+uint16_t SampleIndex::find(const uint8_t* data) const {
+    for (uint32_t slot = slotOf(data); ; slot = (slot + 1u) & mask) {
+        const DataSlot& entry = dataSlots[slot];
+        if (entry.index == NOT_FOUND || entry.data == data) {
+            return entry.index;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for the hash index of the audio samples.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_SAMPLE_INDEX_H_
+#define _RC_SAMPLE_INDEX_H_
+
+#include "sample.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Finds the position of a sample in a sample list by audio ID or
+ *  by data pointer.
+ *
+ *  Two open addressing hash tables (linear probing) with at least
+ *  twice as many slots as samples, so a lookup usually needs one or
+ *  two probes instead of a scan over the whole list.
+ *
+ *  The index doesn't support removing single samples. When the list
+ *  changes, the index is filled again with reset() and add().
+ */
+class SampleIndex {
+    public:
+        /** Returned by find() for unknown keys. */
+        static constexpr uint16_t NOT_FOUND = UINT16_MAX;
+
+    private:
+        struct IdSlot {
+            rcSamples::AudioId id;
+            uint16_t index;  ///< NOT_FOUND for an empty slot
+        };
+
+        struct DataSlot {
+            const uint8_t* data;
+            uint16_t index;  ///< NOT_FOUND for an empty slot
+        };
+
+        std::vector<IdSlot> idSlots;
+        std::vector<DataSlot> dataSlots;
+
+        /** Number of slots - 1 (the number of slots is a power of two). */
+        uint32_t mask;
+
+        /** 32 - log2(number of slots), for the Fibonacci hashing. */
+        uint8_t shift;
+
+        uint16_t count;  ///< number of IDs
+        uint16_t dataCount;
+
+        uint32_t slotOf(const rcSamples::AudioId& id) const;
+        uint32_t slotOf(const uint8_t* data) const;
+
+    public:
+        SampleIndex();
+
+        /** Removes all samples and sizes the tables for numSamples. */
+        void reset(size_t numSamples);
+
+        /** Adds the sample at position index of the list.
+         *
+         *  If another sample with the same ID or data was already added,
+         *  find() keeps returning the first one (like a linear search).
+         *  Samples beyond the numSamples given to reset() are ignored.
+         */
+        void add(const rcSamples::AudioId& id, const uint8_t* data, uint16_t index);
+
+        /** Adds only the ID, e.g. while the data is not known yet. */
+        void add(const rcSamples::AudioId& id, uint16_t index);
+
+        /** Adds the data of a sample whose ID was added before. */
+        void add(const uint8_t* data, uint16_t index);
+
+        /** @returns the list position of the sample or NOT_FOUND. */
+        uint16_t find(const rcSamples::AudioId& id) const;
+
+        /** @returns the list position of the sample data or NOT_FOUND. */
+        uint16_t find(const uint8_t* data) const;
+
+        /** Number of added samples. */
+        uint16_t size() const {
+            return count;
+        }
+};
+
+#endif // _RC_SAMPLE_INDEX_H_
@@ -0,0 +1,82 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation of the list of audio samples that are resolved on demand.
+ *
+ *  @file
+ *
+*/
+
+#include "sample_list.h"
+#include "wav_sample.h"
+
+#include <cstdint>
+#include <span>
+
+using namespace rcSamples;
+
+SampleList::SampleList() :
+    numResolved(0u) {
+}
+
+void SampleList::reset(std::span<const SampleFile> filesVal) {
+    files = filesVal;
+    data.assign(files.size(), rcAudio::SampleData());
+    resolved.assign(files.size(), false);
+    numResolved = 0u;
+
+    index.reset(files.size());
+    for (size_t i = 0u; i < files.size(); i++) {
+        index.add(files[i].id, i);
+    }
+}
+
+const rcAudio::SampleData& SampleList::getData(uint16_t i) const {
+    if (!resolved[i]) {
+        data[i] = resolve(files[i]);
+        resolved[i] = true;
+        numResolved++;
+        index.add(data[i].data(), i);
+    }
+    return data[i];
+}
+
+uint16_t SampleList::findInContent(const uint8_t* sampleData) const {
+    const uint16_t found = index.find(sampleData);
+    if (found != SampleIndex::NOT_FOUND) {
+        return found;
+    }
+
+    // pointers into different files can't be compared directly
+    const auto address = reinterpret_cast<uintptr_t>(sampleData);
+    for (size_t i = 0u; i < files.size(); i++) {
+        const auto begin = reinterpret_cast<uintptr_t>(files[i].content.data());
+        if (address >= begin && address - begin < files[i].content.size()) {
+            getData(i);
+            return i;
+        }
+    }
+    return SampleIndex::NOT_FOUND;
+}
+
+void SampleList::resolveAll() const {
+    for (size_t i = 0u; i < files.size(); i++) {
+        getData(i);
+    }
+}
+
+rcAudio::SampleData SampleList::resolve(const SampleFile& file) {
+    const SampleInfo& info = file.info;
+    const size_t contentSize = file.content.size();
+
+    if (info.format != SampleInfo::UNKNOWN &&
+        info.offset <= contentSize && info.size <= contentSize - info.offset) {
+
+        const auto bytes = file.content.subspan(info.offset, info.size);
+        if (info.format == SampleInfo::ADPCM) {
+            return rcAudio::SampleData::adpcm(bytes, info.blockSize, info.numSamples);
+        }
+        return rcAudio::SampleData(bytes);
+    }
+
+    return getWavSampleData(file.content);
+}
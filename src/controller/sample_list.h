@@ -0,0 +1,103 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for a list of audio samples that are resolved on demand.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_SAMPLE_LIST_H_
+#define _RC_SAMPLE_LIST_H_
+
+#include "sample.h"
+#include "audio.h"
+#include "sample_index.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/** A list of sample files with their SampleData.
+ *
+ *  The SampleData of a file (where the samples start, their format
+ *  and number) is only resolved when the sample is used the first time,
+ *  usually when a proc of the configuration looks it up. Files with a
+ *  precomputed SampleInfo are resolved without reading the WAV header.
+ *
+ *  The list doesn't own the files, they have to stay valid until the
+ *  next reset().
+ */
+class SampleList {
+    private:
+        std::span<const rcSamples::SampleFile> files;
+
+        /** The resolved SampleData, matching to the files */
+        mutable std::vector<rcAudio::SampleData> data;
+        mutable std::vector<bool> resolved;
+        mutable uint16_t numResolved;
+
+        /** All IDs and the data of the resolved samples */
+        mutable SampleIndex index;
+
+    public:
+        SampleList();
+
+        /** Replaces the files. Nothing is resolved yet. */
+        void reset(std::span<const rcSamples::SampleFile> filesVal);
+
+        /** @returns the list position of the sample or SampleIndex::NOT_FOUND. */
+        uint16_t find(const rcSamples::AudioId& id) const {
+            return index.find(id);
+        }
+
+        /** @returns the list position of the sample data or SampleIndex::NOT_FOUND.
+         *
+         *  Only finds resolved samples, but all SampleData handed out
+         *  since the last reset() are.
+         */
+        uint16_t find(const uint8_t* sampleData) const {
+            return index.find(sampleData);
+        }
+
+        /** Like find(), but also finds SampleData handed out before the last reset().
+         *
+         *  If the data is not in the index, the file containing it is
+         *  searched and resolved.
+         */
+        uint16_t findInContent(const uint8_t* sampleData) const;
+
+        const rcSamples::SampleFile& getFile(uint16_t i) const {
+            return files[i];
+        }
+
+        /** Returns the SampleData of the file, resolving it if needed. */
+        const rcAudio::SampleData& getData(uint16_t i) const;
+
+        /** Resolves all files (what was done before starting). */
+        void resolveAll() const;
+
+        bool isResolved(uint16_t i) const {
+            return resolved[i];
+        }
+
+        uint16_t getNumResolved() const {
+            return numResolved;
+        }
+
+        size_t size() const {
+            return files.size();
+        }
+
+        bool empty() const {
+            return files.empty();
+        }
+
+        /** Returns the SampleData of a file.
+         *
+         *  Uses the SampleInfo if there is one, otherwise the WAV header is parsed.
+         */
+        static rcAudio::SampleData resolve(const rcSamples::SampleFile& file);
+};
+
+#endif // _RC_SAMPLE_LIST_H_
@@ -8,11 +8,10 @@
 #include "sample_storage_singleton.h"
 #include "simple_byte_stream.h"
 #include "flash_sample.h"
-#include "wav_sample.h"
+#include "crc16.h"
 
 #ifdef HAVE_NV
 #include <esp_log.h>
-#include <esp_crc.h>
 
 static const char* TAG = "SampleStorage";
 #endif
@@ -28,14 +27,21 @@ using namespace rcSamples;
 
 
 SampleStorageSingleton::SampleStorageSingleton() :
-    dynamicDirty(true) {
-
-    // fill static data
-    auto staticFiles = rcSamples::getStaticSamples();
-    for (const auto& file: staticFiles) {
-        staticData.push_back(rcAudio::SampleData(
-            getWavSamples(file.content)));
-    }
+    compactPending(true),
+    movePending(false),
+    dynamicDirty(true),
+    uploadId{},
+    uploadSize(0u),
+    uploadReceived(0u),
+    uploadWritten(0u),
+    uploadCrc(UINT16_MAX),
+    uploadSeq(0u),
+    uploadErrors(0u),
+    uploadActive(false),
+    uploadConverting(false) {
+
+    // the static samples are resolved when a proc uses them
+    staticList.reset(rcSamples::getStaticSamples());
 }
 
 
@@ -44,32 +50,30 @@ SampleStorageSingleton::~SampleStorageSingleton() {
 
 void SampleStorageSingleton::updateDynamic() const {
 
-    dynamicFiles.resize(0);
-    dynamicData.resize(0);
+    // Rebuilt as a whole instead of updating the index: the commands
+    // only set dynamicDirty, the rebuild happens with the next lookup
+    // (a received config or the published audio list), so once for a
+    // whole upload. It walks the block headers and hashes at most one
+    // ID per flash sector, no WAV header is parsed any more.
 
-    // fill dynamic data
+    // converted uploads come with their SampleInfo, the others are
+    // only parsed when they are used
     dynamicFiles = flashSampleStorage.getFiles();
-    for (const auto& file: dynamicFiles) {
-        rcAudio::SampleData sample(getWavSamples(file.content));
 #ifdef HAVE_NV
+    for (const auto& file: dynamicFiles) {
         ESP_LOGI(TAG, "Dynamic sample: %c%c%c size %d.",
             file.id[0], file.id[1], file.id[2], file.content.size());
-#endif
-        dynamicData.push_back(sample);
     }
+#endif
+    dynamicList.reset(dynamicFiles);
 
     dynamicDirty = false;
 }
 
 
 int32_t SampleStorageSingleton::getStaticIndex(const rcSamples::AudioId& id) const {
-    auto staticFiles = rcSamples::getStaticSamples();
-    for (size_t i = 0; i < staticFiles.size(); i++) {
-        if (staticFiles[i].id == id) {
-            return i;
-        }
-    }
-    return -1;
+    const uint16_t index = staticList.find(id);
+    return (index == SampleIndex::NOT_FOUND) ? -1 : index;
 }
 
 
@@ -79,34 +83,24 @@ int32_t SampleStorageSingleton::getDynamicIndex(const rcSamples::AudioId& id) co
         updateDynamic();
     }
 
-    for (size_t i = 0; i < dynamicFiles.size(); i++) {
-        if (dynamicFiles[i].id == id) {
-            return i;
-        }
-    }
-    return -1;
+    const uint16_t index = dynamicList.find(id);
+    return (index == SampleIndex::NOT_FOUND) ? -1 : index;
 }
 
 
 const rcSamples::SampleFile& SampleStorageSingleton::getSampleFile(const rcSamples::AudioId& id) const {
 
-    if (dynamicDirty) {
-        updateDynamic();
-    }
-    for (const rcSamples::SampleFile& file : dynamicFiles) {
-        if (file.id == id) {
-            return file;
-        }
+    auto index = getDynamicIndex(id);
+    if (index >= 0) {
+        return dynamicList.getFile(index);
     }
 
-    auto staticFiles = rcSamples::getStaticSamples();
-    for (const rcSamples::SampleFile& file : staticFiles) {
-        if (file.id == id) {
-            return file;
-        }
+    index = getStaticIndex(id);
+    if (index >= 0) {
+        return staticList.getFile(index);
     }
 
-    return staticFiles.front();
+    return staticList.getFile(0u);
 }
 
 
@@ -114,20 +108,19 @@ const rcAudio::SampleData& SampleStorageSingleton::getSampleData(const rcSamples
 
     auto index = getDynamicIndex(id);
     if (index >= 0) {
-        return dynamicData[index];
+        return dynamicList.getData(index);
     }
 
-    auto staticFiles = rcSamples::getStaticSamples();
     index = getStaticIndex(id);
     if (index >= 0) {
-        return staticData[index];
+        return staticList.getData(index);
     }
 
 #ifdef HAVE_NV
     ESP_LOGW(TAG, "Sample not found: %c%c%c.\n", id[0], id[1], id[2]);
 #endif
 
-    return staticData.front();
+    return staticList.getData(0u);
 }
 
 
@@ -136,20 +129,123 @@ const rcSamples::AudioId& SampleStorageSingleton::getAudioId(const rcAudio::Samp
     if (dynamicDirty) {
         updateDynamic();
     }
-    for (size_t i = 0; i < dynamicData.size(); i++) {
-        if (data.data() == dynamicData[i].data()) {
-            return dynamicFiles[i].id;
+    uint16_t index = dynamicList.find(data.data());
+    if (index != SampleIndex::NOT_FOUND) {
+        return dynamicList.getFile(index).id;
+    }
+
+    index = staticList.find(data.data());
+    if (index != SampleIndex::NOT_FOUND) {
+        return staticList.getFile(index).id;
+    }
+
+    // the procs keep their SampleData when the dynamic list is rebuilt
+    index = dynamicList.findInContent(data.data());
+    if (index != SampleIndex::NOT_FOUND) {
+        return dynamicList.getFile(index).id;
+    }
+
+    return staticList.getFile(0u).id;
+}
+
+
+void SampleStorageSingleton::addData(const rcSamples::AudioId& id,
+        uint32_t offset, std::span<const uint8_t> data) {
+
+    const bool inOrder = uploadActive && (id == uploadId) && (offset == uploadReceived);
+
+    // the first chunk decides if the upload is converted
+    if (inOrder && offset == 0u) {
+        uploadConverting = WavConverter::isWav(data);
+    }
+
+    if (!uploadActive || !(id == uploadId) || !uploadConverting) {
+        if (inOrder) {
+            uploadReceived += data.size();
         }
+        flashSampleStorage.setData(id, offset, data);
+        return;
+    }
+
+    if (!inOrder) {
+#ifdef HAVE_NV
+        ESP_LOGW(TAG, "Audio data out of order: offset %lu, expected %lu.",
+            offset, uploadReceived);
+#endif
+        return;
+    }
+
+    uploadReceived += data.size();
+    uploadCrc = crc16le(uploadCrc, data);
+
+    convertBuffer.clear();
+    const bool wasSized = converter.isSized();
+    if (!wasSized) {
+        uploadHeader.insert(uploadHeader.end(), data.begin(), data.end());
+    }
+    converter.write(data, convertBuffer);
+    if (uploadReceived >= uploadSize) {
+        converter.finish(convertBuffer);
     }
 
-    auto staticFiles = rcSamples::getStaticSamples();
-    for (size_t i = 0; i < staticData.size(); i++) {
-        if (data.data() == staticData[i].data()) {
-            return staticFiles[i].id;
+    // not a WAV file we understand, store it as it is
+    // (nothing is written before the header is accepted)
+    if (converter.getState() == WavConverter::State::ERROR ||
+        (!converter.isSized() && uploadHeader.size() > MAX_UPLOAD_HEADER)) {
+#ifdef HAVE_NV
+        ESP_LOGW(TAG, "Unsupported WAV format, storing the raw data.");
+#endif
+        uploadConverting = false;
+        flashSampleStorage.setData(id, 0u, uploadHeader);
+        uploadHeader.clear();
+        return;
+    }
+
+    if (!wasSized && converter.isSized()) {
+        uploadHeader.clear();
+#ifdef HAVE_NV
+        ESP_LOGI(TAG, "Converting %u channel(s), %u bit, %lu Hz to %lu samples.",
+            converter.getChannels(), converter.getBitsPerSample(),
+            converter.getSampleRate(), converter.getConvertedSize());
+#endif
+        if (!flashSampleStorage.setSize(id, converter.getConvertedSize())) {
+#ifdef HAVE_NV
+            ESP_LOGW(TAG, "Converted sample does not fit, removing it.");
+#endif
+            // the block still has the raw size, the following chunks
+            // must not end up in it. The client sees the stopped upload
+            // in the acknowledge.
+            flashSampleStorage.remove(id);
+            uploadActive = false;
+            uploadErrors++;
+            dynamicDirty = true;
+            compactPending = true;
+            return;
         }
     }
 
-    return staticFiles.front().id;
+    flashSampleStorage.setData(id, uploadWritten, convertBuffer);
+    uploadWritten += convertBuffer.size();
+
+    if (uploadReceived >= uploadSize) {
+        flashSampleStorage.setSource(id, uploadSize, uploadCrc,
+            converter.isAdpcm() ? FlashSample::SampleBlock::FLAG_ADPCM : 0u);
+        uploadActive = false;
+    }
+}
+
+
+void SampleStorageSingleton::flushUploadEnd(const rcSamples::AudioId& id, uint32_t end) {
+    // the readers of the mapped flash don't flush (see
+    // FlashSample::SampleStorage::getFiles()), so the complete
+    // sample has to be written now
+    if (id == uploadId && end >= uploadSize) {
+        flashSampleStorage.flush();
+    }
+}
+
+void SampleStorageSingleton::flush() {
+    flashSampleStorage.flush();
 }
 
 
@@ -172,7 +268,9 @@ void SampleStorageSingleton::executeCommand(SimpleInStream& in) {
     case CMD_RESET:
         {
             flashSampleStorage.reset();
+            uploadActive = false;
             dynamicDirty = true;
+            compactPending = true;
         }
         break;
     case CMD_ADD:
@@ -183,8 +281,24 @@ void SampleStorageSingleton::executeCommand(SimpleInStream& in) {
             ESP_LOGI(TAG, "New dynamic sample: %c%c%c size %lu.",
                 id[0], id[1], id[2], size);
 #endif
-            flashSampleStorage.addId(id, size);
+            uploadActive = flashSampleStorage.addId(id, size);
+#ifdef HAVE_NV
+            if (!uploadActive) {
+                ESP_LOGW(TAG, "No space for the sample, retry the upload after the deferred compaction.");
+            }
+#endif
+            uploadConverting = false;
+            uploadId = id;
+            uploadSize = size;
+            uploadReceived = 0u;
+            uploadWritten = 0u;
+            uploadCrc = UINT16_MAX;
+            uploadSeq = 0u;
+            uploadErrors = 0u;
+            uploadHeader.clear();
+            converter.reset(size);
             dynamicDirty = true;
+            compactPending = true;
         }
         break;
     case CMD_ADD_DATA:
@@ -206,15 +320,117 @@ void SampleStorageSingleton::executeCommand(SimpleInStream& in) {
                 );
 #endif
 
-            flashSampleStorage.setData(id, offset, newData);
+            addData(id, offset, newData);
+            flushUploadEnd(id, offset + newData.size());
+            dynamicDirty = true;
+        }
+        break;
+    case CMD_ADD_DATA_SEQ:
+        {
+            auto id = in.read<rcSamples::AudioId>();
+            auto seq = in.read<uint16_t>();
+            auto offset = in.read<uint32_t>();
+            auto size = in.read<uint32_t>();
+            auto crc = in.read<uint16_t>();
+            if (in.fail() || size > in.buffer().size() - in.tellg()) {
+                uploadErrors++;
+                break;
+            }
+            auto newData = in.buffer().subspan(in.tellg(), size);
+
+            // duplicates and chunks after a lost one are dropped, the
+            // client sends them again starting with the acknowledged seq
+            if (!uploadActive || !(id == uploadId) || seq != uploadSeq) {
+                break;
+            }
+            if (crc16le(UINT16_MAX, newData) != crc) {
+#ifdef HAVE_NV
+                ESP_LOGW(TAG, "Audio data crc error: seq %u.", seq);
+#endif
+                uploadErrors++;
+                break;
+            }
+            // addData() would drop it, the client has to send it again
+            if (offset != uploadReceived) {
+#ifdef HAVE_NV
+                ESP_LOGW(TAG, "Audio data out of order: seq %u offset %lu, expected %lu.",
+                    seq, offset, uploadReceived);
+#endif
+                uploadErrors++;
+                break;
+            }
+#ifdef HAVE_NV
+            ESP_LOGD(TAG, "New audio data: seq: %u offset: %lu size: %lu.",
+                seq, offset, size);
+#endif
+
+            addData(id, offset, newData);
+            flushUploadEnd(id, offset + newData.size());
+            uploadSeq++;
             dynamicDirty = true;
         }
         break;
+    case CMD_REMOVE:
+        {
+            auto id = in.read<rcSamples::AudioId>();
+#ifdef HAVE_NV
+            ESP_LOGI(TAG, "Remove dynamic sample: %c%c%c.", id[0], id[1], id[2]);
+#endif
+            if (uploadActive && id == uploadId) {
+                uploadActive = false;
+            }
+            flashSampleStorage.remove(id);
+            dynamicDirty = true;
+            compactPending = true;
+        }
+        break;
     default:
         ; // nothing to do
     }
 }
 
+bool SampleStorageSingleton::compact() {
+    if (!prepareCompact()) {
+        return false;
+    }
+    commitCompact();
+    return true;
+}
+
+bool SampleStorageSingleton::prepareCompact() {
+    if (!compactPending || movePending) {
+        return false;
+    }
+
+    if (!flashSampleStorage.prepareCompact(pendingMove)) {
+        compactPending = false;
+        return false;
+    }
+    return true;
+}
+
+void SampleStorageSingleton::commitCompact() {
+    flashSampleStorage.commitCompact(pendingMove);
+    movePending = true;
+    dynamicDirty = true;
+
+#ifdef HAVE_NV
+    ESP_LOGI(TAG, "Compacted samples, largest free region: %u sectors.",
+        flashSampleStorage.largestFree());
+#endif
+}
+
+void SampleStorageSingleton::serializeAck(SimpleOutStream& out, uint8_t window) const {
+    out.writeUint8('R');
+    out.writeUint8('K');
+    out.writeUint8(1U);  // binary format version
+    out << uploadId;
+    out.write<uint16_t>(uploadSeq);
+    out.write<uint8_t>(window);
+    out.write<uint16_t>(uploadErrors);
+    out.write<uint8_t>(uploadActive ? 1u : 0u);
+}
+
 void SampleStorageSingleton::serializeList(SimpleOutStream& out) const {
 
     if (dynamicDirty) {
@@ -229,13 +445,15 @@ void SampleStorageSingleton::serializeList(SimpleOutStream& out) const {
     out.write<uint16_t>(flashSampleStorage.sectorsFree());
     out.write<uint8_t>(dynamicFiles.size());
     for (const auto& file : dynamicFiles) {
+        // converted samples are listed like the uploaded file
+        uint32_t size = file.content.size();
         uint16_t crc = 0u;
 
-#ifdef HAVE_NV
-        crc = esp_crc16_le(UINT16_MAX, &(*file.content.begin()), file.content.size());
-#endif
+        if (!flashSampleStorage.getSource(file.id, size, crc)) {
+            crc = crc16le(UINT16_MAX, file.content);
+        }
 
-        out << file.id << static_cast<uint32_t>(file.content.size()) << crc;
+        out << file.id << size << crc;
     }
 }
 
@@ -12,7 +12,10 @@
 #include "sample.h"
 #include "audio.h"
 #include "flash_sample.h"
+#include "wav_converter.h"
+#include "sample_list.h"
 
+#include <atomic>
 #include <span>
 #include <vector>
 
@@ -20,8 +23,8 @@
  *
  *  The class provides methods to:
  *
- *  - find samples by id
- *  - manages wav to raw conversion
+ *  - find samples by id (and ids by sample data, see SampleIndex)
+ *  - manages wav to raw conversion (also while uploading, see WavConverter)
  *  - handles bluetooth commands
  *  - stores and restores dynamic samples form NVM
  *
@@ -29,11 +32,29 @@
 class SampleStorageSingleton {
     private:
         static constexpr uint8_t CMD_RESET = 0u; ///< this bt command will remove all existing samples
-        static constexpr uint8_t CMD_ADD = 1u; ///< Create a new sample that data can be added onto later. You can't create an existing ID
+        static constexpr uint8_t CMD_ADD = 1u; ///< Create a new sample that data can be added onto later. An existing ID is replaced
         static constexpr uint8_t CMD_ADD_DATA = 2u;
 
+        /** Like CMD_ADD_DATA with a sequence number and a crc of the chunk.
+         *
+         *  Chunks are only accepted in sequence, see serializeAck().
+         */
+        static constexpr uint8_t CMD_ADD_DATA_SEQ = 3u;
+
+        static constexpr uint8_t CMD_REMOVE = 4u; ///< Remove the sample with the ID
+
+        /** Uploads with a longer WAV header (large meta data chunks) are stored unconverted. */
+        static constexpr uint32_t MAX_UPLOAD_HEADER = 4096u;
+
         FlashSample::SampleStorage flashSampleStorage;
 
+        /** The dynamic samples changed since compact() last found nothing to do. */
+        bool compactPending;
+
+        /** The last sample moved by compact(), see isMovePending(). */
+        FlashSample::SampleMove pendingMove;
+        std::atomic<bool> movePending;
+
         /** Indicates if we have modified the dynamic files but not
          *  flushed or re-read them.
          */
@@ -43,13 +64,36 @@ class SampleStorageSingleton {
          */
         mutable std::vector<rcSamples::SampleFile> dynamicFiles;
 
-        /** List of data (matching to the dynamicFiles)
-         */
-        mutable std::vector<rcAudio::SampleData> dynamicData;
+        /** The dynamic samples (matching to the dynamicFiles), rebuilt with the files. */
+        mutable SampleList dynamicList;
+
+        /** The static samples, only resolved when used. */
+        SampleList staticList;
+
+        /** Converts uploaded WAV files into the internal format. */
+        WavConverter converter;
 
-        /** List of data (matching to the staticFiles)
+        /** Buffer for the converted samples of one chunk. */
+        std::vector<uint8_t> convertBuffer;
+
+        /** The uploaded bytes until the converter accepted the WAV header.
+         *
+         *  Written to flash as they are if the format is not supported.
          */
-        mutable std::vector<rcAudio::SampleData> staticData;
+        std::vector<uint8_t> uploadHeader;
+
+        /** The sample currently uploaded with CMD_ADD and CMD_ADD_DATA. */
+        rcSamples::AudioId uploadId;
+        uint32_t uploadSize; ///< size announced with CMD_ADD
+        uint32_t uploadReceived; ///< bytes received in order
+        uint32_t uploadWritten; ///< converted bytes written to flash
+        uint16_t uploadCrc; ///< crc of the bytes received so far
+        uint16_t uploadSeq; ///< the next expected CMD_ADD_DATA_SEQ sequence number
+        uint16_t uploadErrors; ///< chunks rejected (wrong crc or offset), sample not fitting
+        bool uploadActive;
+
+        /** The upload is a WAV file that is converted while receiving it. */
+        bool uploadConverting;
 
         /** Constructor. */
         SampleStorageSingleton();
@@ -57,9 +101,12 @@ class SampleStorageSingleton {
         /** Destructor */
         ~SampleStorageSingleton();
 
-        /** Re-creates dynamic samples lists, filling dynamicFiles and dynamicData */
+        /** Re-creates dynamic samples lists, filling dynamicFiles and dynamicList */
         void updateDynamic() const;
 
+        /** Flushes the flash cache if the chunk ending at end completes the upload. */
+        void flushUploadEnd(const rcSamples::AudioId& id, uint32_t end);
+
         /** Returns the index of a static sample
          *
          *  Searches in static samples list and return an index to the audio id.
@@ -74,6 +121,14 @@ class SampleStorageSingleton {
          */
         int32_t getDynamicIndex(const rcSamples::AudioId& id) const;
 
+        /** Stores the data of a CMD_ADD_DATA command.
+         *
+         *  WAV files uploaded in order (starting with offset 0) are
+         *  converted chunk by chunk. Everything else is stored as
+         *  it is.
+         */
+        void addData(const rcSamples::AudioId& id, uint32_t offset, std::span<const uint8_t> data);
+
     public:
         static SampleStorageSingleton& getInstance()
         {
@@ -92,6 +147,77 @@ class SampleStorageSingleton {
          */
         void executeCommand(SimpleInStream& in);
 
+        /** Writes the acknowledge for the sequenced upload.
+         *
+         *  Contains the id of the current upload, the next expected sequence
+         *  number, the number of chunks the client may send without an
+         *  acknowledge (window) and the number of crc errors.
+         *
+         *  @param window The number of chunks the receive queue can hold.
+         */
+        void serializeAck(SimpleOutStream& out, uint8_t window) const;
+
+        /** Moves one dynamic sample to coalesce the free flash sectors.
+         *
+         *  Called when there is nothing else to do, see
+         *  FlashSample::SampleStorage::compact(). The procs keep playing
+         *  the old copy, which stays until its sectors are used again.
+         *  So after a move no more commands may be executed until the
+         *  procs are relocated to the new copy, see getPendingMove().
+         *
+         *  Same as prepareCompact() followed by commitCompact().
+         *
+         *  @returns true if a sample was moved.
+         */
+        bool compact();
+
+        /** Writes the copy of the sample compact() moves.
+         *
+         *  The readers still get the old copy, so they don't need
+         *  to be locked out while the sectors are written.
+         *
+         *  @returns false if there is nothing to move.
+         */
+        bool prepareCompact();
+
+        /** Switches to the copy written by prepareCompact().
+         *
+         *  The readers of the dynamic samples (and the procs) have to be locked out.
+         */
+        void commitCompact();
+
+        /** Writes the cached flash sectors, e.g. when no commands come in. */
+        void flush();
+
+        /** @returns false if compact() has nothing to do. */
+        bool isCompactPending() const {
+            return compactPending;
+        }
+
+        /** @returns true after compact() moved a sample until moveDone() is called. */
+        bool isMovePending() const {
+            return movePending;
+        }
+
+        /** The sample moved by compact(), see ProcStorage::relocateSamples(). */
+        const FlashSample::SampleMove& getPendingMove() const {
+            return pendingMove;
+        }
+
+        /** The procs use the new copy of the moved sample. */
+        void moveDone() {
+            movePending = false;
+        }
+
+        /** Stores converted uploads IMA-ADPCM encoded instead of 8 bit PCM.
+         *
+         *  Needs about half the flash, but the procs have to decode
+         *  the samples while playing.
+         */
+        void setAdpcm(bool adpcm) {
+            converter.setAdpcm(adpcm);
+        }
+
         /** Returns the sample file for the audio id.
          *
          *  Searches in static and dynamic samples list.
@@ -118,6 +244,11 @@ class SampleStorageSingleton {
         /** Fills the output buffer with the list of dynamic files.
          */
         void serializeList(SimpleOutStream& out) const;
+
+        /** The static samples, e.g. to check which ones were resolved. */
+        const SampleList& getStaticList() const {
+            return staticList;
+        }
 };
 
 
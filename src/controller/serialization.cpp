@@ -1,7 +1,7 @@
 /** Serialization code for the proc classes.
  *
  * This file is auto generated by serialization_tool.py
- * 2025-06-08
+ * 2026-10-16
  *
  * Do not modify.
  *
@@ -12,6 +12,7 @@
 #include "proc.h"
 #include "simple_byte_stream.h"
 #include <cstdio>
+#include <typeinfo>
 
 #include "input_demo.h"
 #ifdef ARDUINO
@@ -1713,6 +1714,361 @@ void ProcStorage::serializeProc(SimpleOutStream& out, const rcProc::Proc& proc)
 }
 
 
+ProcTypeId ProcStorage::getProcTypeId(const rcProc::Proc& proc) {
+
+    // note: see serializeProc() regarding the order
+    if (false) {  // just need an 'if' case
+    // -- Input
+    } else if (dynamic_cast<const rcInput::InputDemo*>(&proc)) {
+        return ('D' << 8) | 'E';
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcInput::InputAdc*>(&proc)) {
+        return ('A' << 8) | 'D';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcInput::InputPin*>(&proc)) {
+        return ('P' << 8) | 'I';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcInput::InputPwm*>(&proc)) {
+        return ('P' << 8) | 'W';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcInput::InputPpm*>(&proc)) {
+        return ('P' << 8) | 'P';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcInput::InputSbus*>(&proc)) {
+        return ('S' << 8) | 'B';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcInput::InputSrxl*>(&proc)) {
+        return ('S' << 8) | 'R';
+#endif
+    // -- Output
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcOutput::OutputAudio*>(&proc)) {
+        return ('O' << 8) | 'A';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcOutput::OutputLed*>(&proc)) {
+        return ('O' << 8) | 'L';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcOutput::OutputEsc*>(&proc)) {
+        return ('O' << 8) | 'E';
+#endif
+#ifdef ARDUINO
+    } else if (dynamic_cast<const rcOutput::OutputPwm*>(&proc)) {
+        return ('O' << 8) | 'P';
+#endif
+    // -- General
+    } else if (dynamic_cast<const rcProc::ProcGroup*>(&proc)) {
+        return ('G' << 8) | 'R';
+    } else if (dynamic_cast<const rcProc::ProcAuto*>(&proc)) {
+        return ('A' << 8) | 'U';
+    } else if (dynamic_cast<const rcProc::ProcCombine*>(&proc)) {
+        return ('C' << 8) | 'O';
+    } else if (dynamic_cast<const rcProc::ProcCranking*>(&proc)) {
+        return ('C' << 8) | 'R';
+    } else if (dynamic_cast<const rcProc::ProcDelay*>(&proc)) {
+        return ('d' << 8) | 'e';
+    } else if (dynamic_cast<const rcProc::ProcDirection*>(&proc)) {
+        return ('D' << 8) | 'I';
+    } else if (dynamic_cast<const rcProc::ProcExcavator*>(&proc)) {
+        return ('E' << 8) | 'X';
+    } else if (dynamic_cast<const rcProc::ProcExpo*>(&proc)) {
+        return ('E' << 8) | 'x';
+    } else if (dynamic_cast<const rcProc::ProcFade*>(&proc)) {
+        return ('F' << 8) | 'A';
+    } else if (dynamic_cast<const rcProc::ProcIndicator*>(&proc)) {
+        return ('I' << 8) | 'N';
+    } else if (dynamic_cast<const rcProc::ProcMap*>(&proc)) {
+        return ('M' << 8) | 'a';
+    } else if (dynamic_cast<const rcProc::ProcMisfire*>(&proc)) {
+        return ('M' << 8) | 'i';
+    } else if (dynamic_cast<const rcProc::ProcNeutral*>(&proc)) {
+        return ('N' << 8) | 'e';
+    } else if (dynamic_cast<const rcProc::ProcPeriodic*>(&proc)) {
+        return ('P' << 8) | 'E';
+    } else if (dynamic_cast<const rcProc::ProcPower*>(&proc)) {
+        return ('P' << 8) | 'O';
+    } else if (dynamic_cast<const rcProc::ProcRandom*>(&proc)) {
+        return ('R' << 8) | 'A';
+    } else if (dynamic_cast<const rcProc::ProcSequence*>(&proc)) {
+        return ('S' << 8) | 'E';
+    } else if (dynamic_cast<const rcProc::ProcScenario*>(&proc)) {
+        return ('S' << 8) | 'C';
+    } else if (dynamic_cast<const rcProc::ProcSwitch*>(&proc)) {
+        return ('S' << 8) | 'W';
+    } else if (dynamic_cast<const rcProc::ProcThreshold*>(&proc)) {
+        return ('T' << 8) | 'R';
+    } else if (dynamic_cast<const rcProc::ProcXenon*>(&proc)) {
+        return ('X' << 8) | 'E';
+    // -- Engine
+    } else if (dynamic_cast<const rcEngine::EngineReverse*>(&proc)) {
+        return ('E' << 8) | 'R';
+    } else if (dynamic_cast<const rcEngine::EngineBrake*>(&proc)) {
+        return ('E' << 8) | 'B';
+    } else if (dynamic_cast<const rcEngine::EngineGear*>(&proc)) {
+        return ('E' << 8) | 'G';
+    } else if (dynamic_cast<const rcEngine::EngineSimple*>(&proc)) {
+        return ('E' << 8) | 'S';
+    // -- Audio
+    } else if (dynamic_cast<const rcAudio::AudioDynamic*>(&proc)) {
+        return ('A' << 8) | 'd';
+    } else if (dynamic_cast<const rcAudio::AudioLoop*>(&proc)) {
+        return ('A' << 8) | 'L';
+    } else if (dynamic_cast<const rcAudio::AudioEngine*>(&proc)) {
+        return ('A' << 8) | 'E';
+    } else if (dynamic_cast<const rcAudio::AudioNoise*>(&proc)) {
+        return ('A' << 8) | 'N';
+    } else if (dynamic_cast<const rcAudio::AudioSimple*>(&proc)) {
+        return ('A' << 8) | 'S';
+    } else if (dynamic_cast<const rcAudio::AudioSteam*>(&proc)) {
+        return ('A' << 8) | 's';
+    }
+    return ('u' << 8) | 'u';
+}
+
+
+size_t ProcStorage::getProcSize(ProcTypeId id) {
+
+    if (false) {  // just need an 'if' case
+    // -- Input
+    } else if (id == (('D' << 8) | 'E')) {
+        return ProcArena::alignedSize(sizeof(rcInput::InputDemo));
+#ifdef ARDUINO
+    } else if (id == (('A' << 8) | 'D')) {
+        return ProcArena::alignedSize(sizeof(rcInput::InputAdc));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('P' << 8) | 'I')) {
+        return ProcArena::alignedSize(sizeof(rcInput::InputPin));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('P' << 8) | 'W')) {
+        return ProcArena::alignedSize(sizeof(rcInput::InputPwm));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('P' << 8) | 'P')) {
+        return ProcArena::alignedSize(sizeof(rcInput::InputPpm));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('S' << 8) | 'B')) {
+        return ProcArena::alignedSize(sizeof(rcInput::InputSbus));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('S' << 8) | 'R')) {
+        return ProcArena::alignedSize(sizeof(rcInput::InputSrxl));
+#endif
+    // -- Output
+#ifdef ARDUINO
+    } else if (id == (('O' << 8) | 'A')) {
+        return ProcArena::alignedSize(sizeof(rcOutput::OutputAudio));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('O' << 8) | 'L')) {
+        return ProcArena::alignedSize(sizeof(rcOutput::OutputLed));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('O' << 8) | 'E')) {
+        return ProcArena::alignedSize(sizeof(rcOutput::OutputEsc));
+#endif
+#ifdef ARDUINO
+    } else if (id == (('O' << 8) | 'P')) {
+        return ProcArena::alignedSize(sizeof(rcOutput::OutputPwm));
+#endif
+    // -- General
+    } else if (id == (('G' << 8) | 'R')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcGroup));
+    } else if (id == (('A' << 8) | 'U')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcAuto));
+    } else if (id == (('C' << 8) | 'O')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcCombine));
+    } else if (id == (('C' << 8) | 'R')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcCranking));
+    } else if (id == (('d' << 8) | 'e')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcDelay));
+    } else if (id == (('D' << 8) | 'I')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcDirection));
+    } else if (id == (('E' << 8) | 'X')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcExcavator));
+    } else if (id == (('E' << 8) | 'x')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcExpo));
+    } else if (id == (('F' << 8) | 'A')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcFade));
+    } else if (id == (('I' << 8) | 'N')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcIndicator));
+    } else if (id == (('M' << 8) | 'a')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcMap));
+    } else if (id == (('M' << 8) | 'i')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcMisfire));
+    } else if (id == (('N' << 8) | 'e')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcNeutral));
+    } else if (id == (('P' << 8) | 'E')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcPeriodic));
+    } else if (id == (('P' << 8) | 'O')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcPower));
+    } else if (id == (('R' << 8) | 'A')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcRandom));
+    } else if (id == (('S' << 8) | 'E')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcSequence));
+    } else if (id == (('S' << 8) | 'C')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcScenario));
+    } else if (id == (('S' << 8) | 'W')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcSwitch));
+    } else if (id == (('T' << 8) | 'R')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcThreshold));
+    } else if (id == (('X' << 8) | 'E')) {
+        return ProcArena::alignedSize(sizeof(rcProc::ProcXenon));
+    // -- Engine
+    } else if (id == (('E' << 8) | 'R')) {
+        return ProcArena::alignedSize(sizeof(rcEngine::EngineReverse));
+    } else if (id == (('E' << 8) | 'B')) {
+        return ProcArena::alignedSize(sizeof(rcEngine::EngineBrake));
+    } else if (id == (('E' << 8) | 'G')) {
+        return ProcArena::alignedSize(sizeof(rcEngine::EngineGear));
+    } else if (id == (('E' << 8) | 'S')) {
+        return ProcArena::alignedSize(sizeof(rcEngine::EngineSimple));
+    // -- Audio
+    } else if (id == (('A' << 8) | 'd')) {
+        return ProcArena::alignedSize(sizeof(rcAudio::AudioDynamic));
+    } else if (id == (('A' << 8) | 'L')) {
+        return ProcArena::alignedSize(sizeof(rcAudio::AudioLoop));
+    } else if (id == (('A' << 8) | 'E')) {
+        return ProcArena::alignedSize(sizeof(rcAudio::AudioEngine));
+    } else if (id == (('A' << 8) | 'N')) {
+        return ProcArena::alignedSize(sizeof(rcAudio::AudioNoise));
+    } else if (id == (('A' << 8) | 'S')) {
+        return ProcArena::alignedSize(sizeof(rcAudio::AudioSimple));
+    } else if (id == (('A' << 8) | 's')) {
+        return ProcArena::alignedSize(sizeof(rcAudio::AudioSteam));
+    }
+    return 0u;
+}
+
+
+ProcStorage::StepFn ProcStorage::getStepFn(const rcProc::Proc& proc) {
+
+    // the exact type is needed here, a derived proc
+    // might override step()
+    const std::type_info& type = typeid(proc);
+    if (false) {  // just need an 'if' case
+    // -- Input
+    } else if (type == typeid(rcInput::InputDemo)) {
+        return &stepThunk<rcInput::InputDemo>;
+#ifdef ARDUINO
+    } else if (type == typeid(rcInput::InputAdc)) {
+        return &stepThunk<rcInput::InputAdc>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcInput::InputPin)) {
+        return &stepThunk<rcInput::InputPin>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcInput::InputPwm)) {
+        return &stepThunk<rcInput::InputPwm>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcInput::InputPpm)) {
+        return &stepThunk<rcInput::InputPpm>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcInput::InputSbus)) {
+        return &stepThunk<rcInput::InputSbus>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcInput::InputSrxl)) {
+        return &stepThunk<rcInput::InputSrxl>;
+#endif
+    // -- Output
+#ifdef ARDUINO
+    } else if (type == typeid(rcOutput::OutputAudio)) {
+        return &stepThunk<rcOutput::OutputAudio>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcOutput::OutputLed)) {
+        return &stepThunk<rcOutput::OutputLed>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcOutput::OutputEsc)) {
+        return &stepThunk<rcOutput::OutputEsc>;
+#endif
+#ifdef ARDUINO
+    } else if (type == typeid(rcOutput::OutputPwm)) {
+        return &stepThunk<rcOutput::OutputPwm>;
+#endif
+    // -- General
+    } else if (type == typeid(rcProc::ProcGroup)) {
+        return &stepThunk<rcProc::ProcGroup>;
+    } else if (type == typeid(rcProc::ProcAuto)) {
+        return &stepThunk<rcProc::ProcAuto>;
+    } else if (type == typeid(rcProc::ProcCombine)) {
+        return &stepThunk<rcProc::ProcCombine>;
+    } else if (type == typeid(rcProc::ProcCranking)) {
+        return &stepThunk<rcProc::ProcCranking>;
+    } else if (type == typeid(rcProc::ProcDelay)) {
+        return &stepThunk<rcProc::ProcDelay>;
+    } else if (type == typeid(rcProc::ProcDirection)) {
+        return &stepThunk<rcProc::ProcDirection>;
+    } else if (type == typeid(rcProc::ProcExcavator)) {
+        return &stepThunk<rcProc::ProcExcavator>;
+    } else if (type == typeid(rcProc::ProcExpo)) {
+        return &stepThunk<rcProc::ProcExpo>;
+    } else if (type == typeid(rcProc::ProcFade)) {
+        return &stepThunk<rcProc::ProcFade>;
+    } else if (type == typeid(rcProc::ProcIndicator)) {
+        return &stepThunk<rcProc::ProcIndicator>;
+    } else if (type == typeid(rcProc::ProcMap)) {
+        return &stepThunk<rcProc::ProcMap>;
+    } else if (type == typeid(rcProc::ProcMisfire)) {
+        return &stepThunk<rcProc::ProcMisfire>;
+    } else if (type == typeid(rcProc::ProcNeutral)) {
+        return &stepThunk<rcProc::ProcNeutral>;
+    } else if (type == typeid(rcProc::ProcPeriodic)) {
+        return &stepThunk<rcProc::ProcPeriodic>;
+    } else if (type == typeid(rcProc::ProcPower)) {
+        return &stepThunk<rcProc::ProcPower>;
+    } else if (type == typeid(rcProc::ProcRandom)) {
+        return &stepThunk<rcProc::ProcRandom>;
+    } else if (type == typeid(rcProc::ProcSequence)) {
+        return &stepThunk<rcProc::ProcSequence>;
+    } else if (type == typeid(rcProc::ProcScenario)) {
+        return &stepThunk<rcProc::ProcScenario>;
+    } else if (type == typeid(rcProc::ProcSwitch)) {
+        return &stepThunk<rcProc::ProcSwitch>;
+    } else if (type == typeid(rcProc::ProcThreshold)) {
+        return &stepThunk<rcProc::ProcThreshold>;
+    } else if (type == typeid(rcProc::ProcXenon)) {
+        return &stepThunk<rcProc::ProcXenon>;
+    // -- Engine
+    } else if (type == typeid(rcEngine::EngineReverse)) {
+        return &stepThunk<rcEngine::EngineReverse>;
+    } else if (type == typeid(rcEngine::EngineBrake)) {
+        return &stepThunk<rcEngine::EngineBrake>;
+    } else if (type == typeid(rcEngine::EngineGear)) {
+        return &stepThunk<rcEngine::EngineGear>;
+    } else if (type == typeid(rcEngine::EngineSimple)) {
+        return &stepThunk<rcEngine::EngineSimple>;
+    // -- Audio
+    } else if (type == typeid(rcAudio::AudioDynamic)) {
+        return &stepThunk<rcAudio::AudioDynamic>;
+    } else if (type == typeid(rcAudio::AudioLoop)) {
+        return &stepThunk<rcAudio::AudioLoop>;
+    } else if (type == typeid(rcAudio::AudioEngine)) {
+        return &stepThunk<rcAudio::AudioEngine>;
+    } else if (type == typeid(rcAudio::AudioNoise)) {
+        return &stepThunk<rcAudio::AudioNoise>;
+    } else if (type == typeid(rcAudio::AudioSimple)) {
+        return &stepThunk<rcAudio::AudioSimple>;
+    } else if (type == typeid(rcAudio::AudioSteam)) {
+        return &stepThunk<rcAudio::AudioSteam>;
+    }
+    return nullptr;
+}
+
+
 rcProc::Proc* ProcStorage::deserializeProc(SimpleInStream& in) {
 
     const ProcId id{in.read<char>(), in.read<char>()};
@@ -1723,195 +2079,195 @@ rcProc::Proc* ProcStorage::deserializeProc(SimpleInStream& in) {
     if (false) {  // just need an 'if' case
     // -- Input
     } else if (id == ProcId{'D', 'E'}) {
-        auto proc2 = new rcInput::InputDemo;
+        auto proc2 = createProc<rcInput::InputDemo>();
         in >> *proc2;
         proc = proc2;
 #ifdef ARDUINO
     } else if (id == ProcId{'A', 'D'}) {
-        auto proc2 = new rcInput::InputAdc;
+        auto proc2 = createProc<rcInput::InputAdc>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'P', 'I'}) {
-        auto proc2 = new rcInput::InputPin;
+        auto proc2 = createProc<rcInput::InputPin>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'P', 'W'}) {
-        auto proc2 = new rcInput::InputPwm;
+        auto proc2 = createProc<rcInput::InputPwm>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'P', 'P'}) {
-        auto proc2 = new rcInput::InputPpm;
+        auto proc2 = createProc<rcInput::InputPpm>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'S', 'B'}) {
-        auto proc2 = new rcInput::InputSbus;
+        auto proc2 = createProc<rcInput::InputSbus>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'S', 'R'}) {
-        auto proc2 = new rcInput::InputSrxl;
+        auto proc2 = createProc<rcInput::InputSrxl>();
         in >> *proc2;
         proc = proc2;
 #endif
     // -- Output
 #ifdef ARDUINO
     } else if (id == ProcId{'O', 'A'}) {
-        auto proc2 = new rcOutput::OutputAudio;
+        auto proc2 = createProc<rcOutput::OutputAudio>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'O', 'L'}) {
-        auto proc2 = new rcOutput::OutputLed;
+        auto proc2 = createProc<rcOutput::OutputLed>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'O', 'E'}) {
-        auto proc2 = new rcOutput::OutputEsc;
+        auto proc2 = createProc<rcOutput::OutputEsc>();
         in >> *proc2;
         proc = proc2;
 #endif
 #ifdef ARDUINO
     } else if (id == ProcId{'O', 'P'}) {
-        auto proc2 = new rcOutput::OutputPwm;
+        auto proc2 = createProc<rcOutput::OutputPwm>();
         in >> *proc2;
         proc = proc2;
 #endif
     // -- General
     } else if (id == ProcId{'G', 'R'}) {
-        auto proc2 = new rcProc::ProcGroup;
+        auto proc2 = createProc<rcProc::ProcGroup>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'A', 'U'}) {
-        auto proc2 = new rcProc::ProcAuto;
+        auto proc2 = createProc<rcProc::ProcAuto>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'C', 'O'}) {
-        auto proc2 = new rcProc::ProcCombine;
+        auto proc2 = createProc<rcProc::ProcCombine>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'C', 'R'}) {
-        auto proc2 = new rcProc::ProcCranking;
+        auto proc2 = createProc<rcProc::ProcCranking>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'d', 'e'}) {
-        auto proc2 = new rcProc::ProcDelay;
+        auto proc2 = createProc<rcProc::ProcDelay>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'D', 'I'}) {
-        auto proc2 = new rcProc::ProcDirection;
+        auto proc2 = createProc<rcProc::ProcDirection>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'E', 'X'}) {
-        auto proc2 = new rcProc::ProcExcavator;
+        auto proc2 = createProc<rcProc::ProcExcavator>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'E', 'x'}) {
-        auto proc2 = new rcProc::ProcExpo;
+        auto proc2 = createProc<rcProc::ProcExpo>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'F', 'A'}) {
-        auto proc2 = new rcProc::ProcFade;
+        auto proc2 = createProc<rcProc::ProcFade>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'I', 'N'}) {
-        auto proc2 = new rcProc::ProcIndicator;
+        auto proc2 = createProc<rcProc::ProcIndicator>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'M', 'a'}) {
-        auto proc2 = new rcProc::ProcMap;
+        auto proc2 = createProc<rcProc::ProcMap>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'M', 'i'}) {
-        auto proc2 = new rcProc::ProcMisfire;
+        auto proc2 = createProc<rcProc::ProcMisfire>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'N', 'e'}) {
-        auto proc2 = new rcProc::ProcNeutral;
+        auto proc2 = createProc<rcProc::ProcNeutral>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'P', 'E'}) {
-        auto proc2 = new rcProc::ProcPeriodic;
+        auto proc2 = createProc<rcProc::ProcPeriodic>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'P', 'O'}) {
-        auto proc2 = new rcProc::ProcPower;
+        auto proc2 = createProc<rcProc::ProcPower>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'R', 'A'}) {
-        auto proc2 = new rcProc::ProcRandom;
+        auto proc2 = createProc<rcProc::ProcRandom>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'S', 'E'}) {
-        auto proc2 = new rcProc::ProcSequence;
+        auto proc2 = createProc<rcProc::ProcSequence>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'S', 'C'}) {
-        auto proc2 = new rcProc::ProcScenario;
+        auto proc2 = createProc<rcProc::ProcScenario>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'S', 'W'}) {
-        auto proc2 = new rcProc::ProcSwitch;
+        auto proc2 = createProc<rcProc::ProcSwitch>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'T', 'R'}) {
-        auto proc2 = new rcProc::ProcThreshold;
+        auto proc2 = createProc<rcProc::ProcThreshold>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'X', 'E'}) {
-        auto proc2 = new rcProc::ProcXenon;
+        auto proc2 = createProc<rcProc::ProcXenon>();
         in >> *proc2;
         proc = proc2;
     // -- Engine
     } else if (id == ProcId{'E', 'R'}) {
-        auto proc2 = new rcEngine::EngineReverse;
+        auto proc2 = createProc<rcEngine::EngineReverse>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'E', 'B'}) {
-        auto proc2 = new rcEngine::EngineBrake;
+        auto proc2 = createProc<rcEngine::EngineBrake>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'E', 'G'}) {
-        auto proc2 = new rcEngine::EngineGear;
+        auto proc2 = createProc<rcEngine::EngineGear>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'E', 'S'}) {
-        auto proc2 = new rcEngine::EngineSimple;
+        auto proc2 = createProc<rcEngine::EngineSimple>();
         in >> *proc2;
         proc = proc2;
     // -- Audio
     } else if (id == ProcId{'A', 'd'}) {
-        auto proc2 = new rcAudio::AudioDynamic;
+        auto proc2 = createProc<rcAudio::AudioDynamic>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'A', 'L'}) {
-        auto proc2 = new rcAudio::AudioLoop;
+        auto proc2 = createProc<rcAudio::AudioLoop>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'A', 'E'}) {
-        auto proc2 = new rcAudio::AudioEngine;
+        auto proc2 = createProc<rcAudio::AudioEngine>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'A', 'N'}) {
-        auto proc2 = new rcAudio::AudioNoise;
+        auto proc2 = createProc<rcAudio::AudioNoise>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'A', 'S'}) {
-        auto proc2 = new rcAudio::AudioSimple;
+        auto proc2 = createProc<rcAudio::AudioSimple>();
         in >> *proc2;
         proc = proc2;
     } else if (id == ProcId{'A', 's'}) {
-        auto proc2 = new rcAudio::AudioSteam;
+        auto proc2 = createProc<rcAudio::AudioSteam>();
         in >> *proc2;
         proc = proc2;
     } else {
@@ -1927,12 +2283,12 @@ rcProc::Proc* ProcStorage::deserializeProc(SimpleInStream& in) {
         printf("Actual length and received len for proc ID %c%c does not match.\n", id.c1, id.c2);
         printf("%d vs. %d.\n", static_cast<int>(endPos - startPos), static_cast<int>(len));
         in.seekg(startPos + len);
-        delete proc;
+        destroyProc(proc);
         proc = nullptr;
     }
     if (in.fail()) {
         printf("Error while reading proc ID %c%c.\n", id.c1, id.c2);
-        delete proc;
+        destroyProc(proc);
         proc = nullptr;
     }
     return proc;
@@ -4,6 +4,7 @@
 # rc function controller proc modules.
 #
 # example usage: serialization_tool.py --procs procs_config.json --cpp serialization.cpp
+#                serialization_tool.py --config ../../configs/full_truck.json --bin truck.rc
 #
 
 import argparse
@@ -11,6 +12,7 @@ import datetime
 import json
 import pathlib
 import re
+import struct
 
 
 def to_camel_case(name):
@@ -164,6 +166,103 @@ void ProcStorage::serializeProc(SimpleOutStream& out, const rcProc::Proc& proc)
         file=out_file,
     )
 
+def output_cpp_type_id(defs_proc, out_file):
+    """Outputs the function returning the type id of a proc into the out file.
+    """
+
+    cases = []
+
+    for proc in defs_proc:
+        if "name" in proc:
+            proc_name = to_camel_case(proc["name"])
+            case = (f"    }} else if (dynamic_cast<const {proc['namespace']}::{proc_name}*>(&proc)) {{\n"
+                    f"        return ('{proc["id"][0]}' << 8) | '{proc["id"][1]}';")
+            if "ifdef" in proc:
+                case = (f"#ifdef {proc['ifdef']}\n"
+                        f"{case}\n"
+                        f"#endif")
+            cases.append(case)
+        else:
+            cases.append(f"    // -- {proc['description']}")
+
+    print(f"""
+ProcTypeId ProcStorage::getProcTypeId(const rcProc::Proc& proc) {{
+
+    // note: see serializeProc() regarding the order
+    if (false) {{  // just need an 'if' case
+{"\n".join(cases)}
+    }}
+    return ('u' << 8) | 'u';
+}}
+""",
+        file=out_file,
+    )
+
+def output_cpp_proc_size(defs_proc, out_file):
+    """Outputs the function returning the arena size of a proc type into the out file.
+    """
+
+    cases = []
+
+    for proc in defs_proc:
+        if "name" in proc:
+            proc_name = to_camel_case(proc["name"])
+            case = (f"    }} else if (id == (('{proc["id"][0]}' << 8) | '{proc["id"][1]}')) {{\n"
+                    f"        return ProcArena::alignedSize(sizeof({proc['namespace']}::{proc_name}));")
+            if "ifdef" in proc:
+                case = (f"#ifdef {proc['ifdef']}\n"
+                        f"{case}\n"
+                        f"#endif")
+            cases.append(case)
+        else:
+            cases.append(f"    // -- {proc['description']}")
+
+    print(f"""
+size_t ProcStorage::getProcSize(ProcTypeId id) {{
+
+    if (false) {{  // just need an 'if' case
+{"\n".join(cases)}
+    }}
+    return 0u;
+}}
+""",
+        file=out_file,
+    )
+
+def output_cpp_step_fn(defs_proc, out_file):
+    """Outputs the function returning the non-virtual step function of a proc into the out file.
+    """
+
+    cases = []
+
+    for proc in defs_proc:
+        if "name" in proc:
+            proc_name = to_camel_case(proc["name"])
+            case = (f"    }} else if (type == typeid({proc['namespace']}::{proc_name})) {{\n"
+                    f"        return &stepThunk<{proc['namespace']}::{proc_name}>;")
+            if "ifdef" in proc:
+                case = (f"#ifdef {proc['ifdef']}\n"
+                        f"{case}\n"
+                        f"#endif")
+            cases.append(case)
+        else:
+            cases.append(f"    // -- {proc['description']}")
+
+    print(f"""
+ProcStorage::StepFn ProcStorage::getStepFn(const rcProc::Proc& proc) {{
+
+    // the exact type is needed here, a derived proc
+    // might override step()
+    const std::type_info& type = typeid(proc);
+    if (false) {{  // just need an 'if' case
+{"\n".join(cases)}
+    }}
+    return nullptr;
+}}
+""",
+        file=out_file,
+    )
+
 def output_cpp_deserialize_factory(defs_proc, out_file):
     """Outputs the deserialize method into the out file
     """
@@ -174,7 +273,7 @@ def output_cpp_deserialize_factory(defs_proc, out_file):
         if "name" in proc:
             proc_name = to_camel_case(proc["name"])
             case = (f"    }} else if (id == ProcId{{'{proc['id'][0]}', '{proc['id'][1]}'}}) {{\n"
-                    f"        auto proc2 = new {proc['namespace']}::{proc_name};\n"
+                    f"        auto proc2 = createProc<{proc['namespace']}::{proc_name}>();\n"
                     f"        in >> *proc2;\n"
                     f"        proc = proc2;")
             if "ifdef" in proc:
@@ -208,12 +307,12 @@ rcProc::Proc* ProcStorage::deserializeProc(SimpleInStream& in) {{
         printf("Actual length and received len for proc ID %c%c does not match.\\n", id.c1, id.c2);
         printf("%d vs. %d.\\n", static_cast<int>(endPos - startPos), static_cast<int>(len));
         in.seekg(startPos + len);
-        delete proc;
+        destroyProc(proc);
         proc = nullptr;
     }}
     if (in.fail()) {{
         printf("Error while reading proc ID %c%c.\\n", id.c1, id.c2);
-        delete proc;
+        destroyProc(proc);
         proc = nullptr;
     }}
     return proc;
@@ -254,6 +353,7 @@ def output_cpp(defs_proc, out_file):
 #include "proc.h"
 #include "simple_byte_stream.h"
 #include <cstdio>
+#include <typeinfo>
 
 {'\n'.join(header_files)}
 
@@ -276,9 +376,98 @@ using namespace rcInput;
     for proc in defs_proc:
         output_cpp_proc(proc, out_file)
     output_cpp_serialize_factory(defs_proc, out_file)
+    output_cpp_type_id(defs_proc, out_file)
+    output_cpp_proc_size(defs_proc, out_file)
+    output_cpp_step_fn(defs_proc, out_file)
     output_cpp_deserialize_factory(defs_proc, out_file)
 
 
+def to_int(value):
+    """Converts a config value to int. Enum values are sometimes strings."""
+
+    if value is None or value == "":
+        return 0
+    return int(float(value))
+
+
+def output_bin_value(value_type, value, signal_ids, out):
+    """Appends a single config value with the given type to the bytearray."""
+
+    if value_type in ("bool", "uint8_t", "gpio_num_t", "Volume",
+                      "EngineSimple::EngineType", "InputDemo::DemoType",
+                      "AudioNoise::NoiseType", "ProcCombine::Function",
+                      "OutputEsc::FreqType"):
+        out += struct.pack(">B", to_int(value) & 0xFF)
+    elif value_type == "uint16_t":
+        out += struct.pack(">H", to_int(value))
+    elif value_type in ("uint32_t", "TimeMs"):
+        out += struct.pack(">I", to_int(value))
+    elif value_type == "float":
+        out += struct.pack(">f", float(value or 0.0))
+    elif value_type == "RcSignal":
+        out += struct.pack(">h", to_int(value))
+    elif value_type == "SignalType":
+        out += signal_ids.get(value, "0").encode("ascii")
+    elif value_type == "SampleData":
+        if isinstance(value, dict):
+            value = value.get("id")
+        if not isinstance(value, str) or len(value) < 3:
+            value = "NAS"
+        out += value[:3].encode("ascii")
+    elif value_type == "rcEngine::GearCollection":
+        ratios = [r for r in (value or []) if r]
+        out += struct.pack(">b", len(ratios))
+        for ratio in ratios:
+            out += struct.pack(">b", max(-127, min(127, int(ratio * 10.0))))
+    elif value_type == "rcEngine::Idle":
+        value = value or {}
+        out += struct.pack(">HHhIH",
+                           to_int(value.get("rpmIdleStart")),
+                           to_int(value.get("rpmIdleRunning")),
+                           to_int(value.get("loadStart")),
+                           to_int(value.get("timeStart")),
+                           to_int(value.get("throttleStep")))
+    else:
+        exit(f"Unhandled value type {value_type}")
+
+
+def output_bin_config(defs_proc, defs_signals, config, out_file):
+    """Converts a json configuration (as created by the web interface)
+    into the binary RC format that ProcStorage::deserialize() reads.
+    """
+
+    procs_by_name = {proc["name"]: proc for proc in defs_proc if "name" in proc}
+    signal_ids = {signal["name"]: signal["id"]
+                  for signal in defs_signals if "id" in signal}
+
+    out = bytearray(b"RC\x01")
+    out += struct.pack(">B", len(config))
+    for value in config:
+        if value.get("name") not in procs_by_name:
+            exit(f"Unknown proc {value.get('name')} in configuration")
+        proc = procs_by_name[value["name"]]
+
+        payload = bytearray()
+        for proc_type in proc.get("types", []):
+            types = value.get("types", {}).get(proc_type["name"], [])
+            for i in range(proc_type.get("num", 1)):
+                type_value = types[i] if i < len(types) else "ST_NONE"
+                output_bin_value("SignalType", type_value, signal_ids, payload)
+
+        for proc_value in proc.get("values", []):
+            values = value.get("values", {}).get(proc_value["name"], [])
+            for i in range(proc_value.get("num", 1)):
+                output_bin_value(proc_value["type"],
+                                 values[i] if i < len(values) else None,
+                                 signal_ids, payload)
+
+        out += proc["id"].encode("ascii")
+        out += struct.pack(">B", len(payload))
+        out += payload
+
+    out_file.write(out)
+
+
 # --- main code
 
 parser = argparse.ArgumentParser(
@@ -307,6 +496,17 @@ parser.add_argument(
     type=argparse.FileType("w"),
     help="Create .cpp file for proc serialization.",
 )
+parser.add_argument(
+    "--config",
+    type=argparse.FileType("r"),
+    help="Json configuration (e.g. configs/full_truck.json) to convert with --bin.",
+)
+parser.add_argument(
+    "--bin",
+    "-b",
+    type=argparse.FileType("wb"),
+    help="Create a binary configuration (as stored in NVM) from --config.",
+)
 
 args = parser.parse_args()
 
@@ -346,3 +546,8 @@ for proc in defs_proc:
 if args.cpp:
     output_cpp(defs_proc, args.cpp)
     output_signals_array(defs_signals, args.cpp)
+
+if args.bin:
+    if not args.config:
+        exit("--bin needs a --config")
+    output_bin_config(defs_proc, defs_signals, json.load(args.config), args.bin)
@@ -0,0 +1,150 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Delta encoding of the signals for the bluetooth telemetry.
+ *
+ *  @file
+ *
+*/
+
+#include "signals_telemetry.h"
+#include "simple_byte_stream.h"
+
+using namespace rcSignals;
+
+namespace {
+
+static constexpr uint8_t FRAME_KEY = 'K';
+static constexpr uint8_t FRAME_DELTA = 'D';
+
+/** Writes the value as zigzag varint (7 bits per byte, LSB first). */
+void writeZigzag(SimpleOutStream& out, int32_t value) {
+    uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^
+        static_cast<uint32_t>(value >> 31);
+    while (zigzag >= 0x80u) {
+        out << static_cast<uint8_t>(zigzag | 0x80u);
+        zigzag >>= 7;
+    }
+    out << static_cast<uint8_t>(zigzag);
+}
+
+/** Reads a zigzag varint written by writeZigzag(). */
+int32_t readZigzag(SimpleInStream& in) {
+    uint32_t zigzag = 0u;
+    for (uint8_t shift = 0u; shift < 32u; shift += 7u) {
+        uint8_t byte = 0u;
+        in >> byte;
+        zigzag |= static_cast<uint32_t>(byte & 0x7fu) << shift;
+        if ((byte & 0x80u) == 0u) {
+            break;
+        }
+    }
+    return static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1u);
+}
+
+} // namespace
+
+SignalsTelemetryEncoder::SignalsTelemetryEncoder() :
+    seq(0u),
+    frames(0u),
+    keyframeRequested(true) {
+    last.fill(RCSIGNAL_INVALID);
+}
+
+void SignalsTelemetryEncoder::encode(const Signals& signals, SimpleOutStream& out) {
+    const bool keyframe = keyframeRequested || (frames >= KEYFRAME_INTERVAL);
+
+    out << (keyframe ? FRAME_KEY : FRAME_DELTA);
+    out << seq;
+    out << NUM_SIGNALS;
+
+    if (keyframe) {
+        for (uint8_t i = 0u; i < NUM_SIGNALS; i++) {
+            writeZigzag(out, signals.signals[i]);
+        }
+        keyframeRequested = false;
+        frames = 0u;
+
+    } else {
+        std::array<uint8_t, MASK_SIZE> mask = {};
+        for (uint8_t i = 0u; i < NUM_SIGNALS; i++) {
+            if (signals.signals[i] != last[i]) {
+                mask[i / 8u] |= static_cast<uint8_t>(1u << (i % 8u));
+            }
+        }
+        for (const auto byte : mask) {
+            out << byte;
+        }
+        for (uint8_t i = 0u; i < NUM_SIGNALS; i++) {
+            if (signals.signals[i] != last[i]) {
+                writeZigzag(out, static_cast<int32_t>(signals.signals[i]) - last[i]);
+            }
+        }
+    }
+
+    last = signals.signals;
+    seq++;
+    frames++;
+}
+
+SignalsTelemetryDecoder::SignalsTelemetryDecoder() :
+    seq(0u),
+    synced(false) {
+    signals.reset();
+}
+
+bool SignalsTelemetryDecoder::decode(SimpleInStream& in) {
+    uint8_t type = 0u;
+    uint8_t frameSeq = 0u;
+    uint8_t count = 0u;
+    in >> type >> frameSeq >> count;
+    if (in.fail()) {
+        return false;
+    }
+
+    // decode into a copy, so that a broken frame doesn't change anything
+    Signals result = signals;
+
+    if (type == FRAME_KEY) {
+        for (uint8_t i = 0u; i < count; i++) {
+            const int32_t value = readZigzag(in);
+            if (i < NUM_SIGNALS) {
+                result.signals[i] = static_cast<RcSignal>(value);
+            }
+        }
+
+    } else if (type == FRAME_DELTA) {
+        if (synced && frameSeq == seq) {
+            return false;  // the same frame again
+        }
+        if (!synced || frameSeq != static_cast<uint8_t>(seq + 1u)) {
+            synced = false;
+            return false;
+        }
+
+        std::array<uint8_t, (255u + 7u) / 8u> mask;
+        for (uint8_t i = 0u; i < (count + 7u) / 8u; i++) {
+            in >> mask[i];
+        }
+        for (uint8_t i = 0u; i < count; i++) {
+            if (mask[i / 8u] & (1u << (i % 8u))) {
+                const int32_t delta = readZigzag(in);
+                if (i < NUM_SIGNALS) {
+                    result.signals[i] = static_cast<RcSignal>(result.signals[i] + delta);
+                }
+            }
+        }
+
+    } else {
+        return false;
+    }
+
+    if (in.fail()) {
+        synced = false;
+        return false;
+    }
+
+    signals = result;
+    seq = frameSeq;
+    synced = true;
+    return true;
+}
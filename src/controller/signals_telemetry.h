@@ -0,0 +1,116 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Delta encoding of the signals for the bluetooth telemetry.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_SIGNALS_TELEMETRY_H_
+#define _RC_SIGNALS_TELEMETRY_H_
+
+#include "signals.h"
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+class SimpleInStream;
+class SimpleOutStream;
+
+/** Encodes the signals as a stream of keyframes and delta frames.
+ *
+ *  Instead of sending all signals every time, only the changes to the
+ *  previous frame are sent. A keyframe with all signals is sent
+ *  periodically so that a receiver can start (or resync) at any time.
+ *
+ *  Keyframe:
+ *  - 'K', u8 sequence number, u8 number of signals
+ *  - the signals as zigzag varints
+ *
+ *  Delta frame:
+ *  - 'D', u8 sequence number, u8 number of signals
+ *  - a bitmask with one bit per signal (LSB first), set if the signal changed
+ *  - the differences to the previous frame of the changed signals
+ *    as zigzag varints
+ *
+ *  The sequence number increments with every frame. A receiver that
+ *  missed a frame has to wait for the next keyframe.
+ */
+class SignalsTelemetryEncoder {
+    public:
+        static constexpr uint8_t NUM_SIGNALS = rcSignals::Signals::NUM_SIGNALS;
+
+        /** Number of frames from one keyframe to the next. */
+        static constexpr uint8_t KEYFRAME_INTERVAL = 25u;
+
+        /** Size of the bitmask in a delta frame. */
+        static constexpr size_t MASK_SIZE = (NUM_SIGNALS + 7u) / 8u;
+
+        /** Maximum size of a frame.
+         *
+         *  A difference of two RcSignals needs at most three varint bytes.
+         */
+        static constexpr size_t MAX_FRAME_SIZE = 3u + MASK_SIZE + NUM_SIGNALS * 3u;
+
+    private:
+        std::array<rcSignals::RcSignal, NUM_SIGNALS> last;
+        uint8_t seq;
+
+        /** Frames since the last keyframe. */
+        uint8_t frames;
+
+        bool keyframeRequested;
+
+    public:
+        SignalsTelemetryEncoder();
+
+        /** The next frame will be a keyframe. */
+        void requestKeyframe() {
+            keyframeRequested = true;
+        }
+
+        /** Writes the next frame for the signals. */
+        void encode(const rcSignals::Signals& signals, SimpleOutStream& out);
+};
+
+/** Decodes the frames created by the SignalsTelemetryEncoder.
+ *
+ *  Used by the host tools and tests. See also the javascript
+ *  implementation in simple_stream.js.
+ */
+class SignalsTelemetryDecoder {
+    public:
+        static constexpr uint8_t NUM_SIGNALS = rcSignals::Signals::NUM_SIGNALS;
+
+    private:
+        rcSignals::Signals signals;
+        uint8_t seq;
+        bool synced;
+
+    public:
+        SignalsTelemetryDecoder();
+
+        /** Reads one frame and updates the signals.
+         *
+         *  Delta frames are ignored until the first keyframe and after
+         *  a missing frame. Repeated frames are ignored.
+         *
+         *  @returns true if the signals were updated.
+         */
+        bool decode(SimpleInStream& in);
+
+        /** Returns true if the decoder received a keyframe and no frame
+         *  was missed since.
+         */
+        bool isSynced() const {
+            return synced;
+        }
+
+        /** Returns the last decoded signals. */
+        const rcSignals::Signals& getSignals() const {
+            return signals;
+        }
+};
+
+#endif // _RC_SIGNALS_TELEMETRY_H_
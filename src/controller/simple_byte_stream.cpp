@@ -66,7 +66,9 @@ uint32_t SimpleInStream::readUint32le() {
 SimpleOutStream::SimpleOutStream() :
     indexWrite(0),
     buf(static_cast<uint8_t*>(nullptr), 0),
-    failFlag(false)
+    failFlag(false),
+    dynamic(true),
+    countOnly(false)
 {
     // allocate an initial memory segment
     uint8_t* data = static_cast<uint8_t*>(malloc(32));
@@ -75,8 +77,32 @@ SimpleOutStream::SimpleOutStream() :
     }
 }
 
+SimpleOutStream::SimpleOutStream(const std::span<uint8_t>& bufVal) :
+    indexWrite(0),
+    buf(bufVal),
+    failFlag(false),
+    dynamic(false),
+    countOnly(false)
+{}
+
+SimpleOutStream SimpleOutStream::counting() {
+    SimpleOutStream out(std::span<uint8_t>(static_cast<uint8_t*>(nullptr), 0));
+    out.countOnly = true;
+    return out;
+}
+
 void SimpleOutStream::writeUint8(const uint8_t val) {
+    if (countOnly) {
+        indexWrite++;
+        return;
+    }
+
     if (eof()) {
+        if (!dynamic) {
+            failFlag = true;
+            return;
+        }
+
         // try to realloc
         size_t newSize = buf.size() + buf.size() / 2;
         uint8_t* newData = static_cast<uint8_t*>(realloc(
@@ -371,3 +397,29 @@ SimpleInStream& operator>>(SimpleInStream& in, rcOutput::FreqType& val) {
     return in;
 }
 
+/** The audio statistics as send via bluetooth.
+ *
+ *  See architecture.md for the format.
+ */
+SimpleOutStream& operator<<(SimpleOutStream& out, const rcAudio::AudioStatsReport& val) {
+    out << val.periodMs;
+    out << val.underruns;
+    out << val.overruns;
+    out << val.blocksRendered;
+    out << val.blocksPlayed;
+    out << val.fillAvg;
+    out << val.latency;
+    return out;
+}
+
+SimpleInStream& operator>>(SimpleInStream& in, rcAudio::AudioStatsReport& val) {
+    in >> val.periodMs;
+    in >> val.underruns;
+    in >> val.overruns;
+    in >> val.blocksRendered;
+    in >> val.blocksPlayed;
+    in >> val.fillAvg;
+    in >> val.latency;
+    return in;
+}
+
@@ -13,6 +13,7 @@
 #include "signals.h"
 #include "sample.h"
 #include "audio.h"
+#include "audio_stats.h"
 
 #ifdef ARDUINO
 #include <hal/gpio_types.h>  // for the declaration of gpio_num_t
@@ -114,11 +115,16 @@ class SimpleInStream {
  *
  *  The data is little endian.
  *
- *  Regarding buffer management:
- *  The buffer is assumed to be dynamically allocated.
- *  It will be re-allocated if it's too small, so be aware of that.
+ *  Regarding buffer management, the stream has three modes:
+ *
+ *  - dynamic (default constructor): The buffer is dynamically allocated.
+ *    It will be re-allocated if it's too small, so be aware of that.
+ *    Vital: the buffer has to be freed or memory will leak.
+ *  - fixed: The caller provides the buffer. The stream never allocates.
+ *    Writing beyond the end sets the fail flag.
+ *  - counting (see counting()): Nothing is stored, only the write index
+ *    moves. Use it to get the exact size for a fixed buffer.
  *
- *  Vital: the buffer has to be freed or memory will leak.
  *  Note: C-style memory management is used because we want to use the
  *    buffer in the C-style queue and bluetooth parts of the code.
  */
@@ -132,12 +138,29 @@ class SimpleOutStream {
          */
         bool failFlag;
 
+        /** True if the buffer was allocated by us and can be re-allocated. */
+        bool dynamic;
+
+        /** True if we only count the bytes. */
+        bool countOnly;
+
     public:
-        /** Construct a new byte stream.
+        /** Construct a new byte stream with a dynamic buffer. */
+        SimpleOutStream();
+
+        /** Construct a new byte stream writing into a fixed buffer.
          *
          *  @param bufVal The underlaying memory for the output.
+         *    It's not re-allocated or freed by the stream.
          */
-        SimpleOutStream();
+        explicit SimpleOutStream(const std::span<uint8_t>& bufVal);
+
+        /** Returns a stream that only counts the written bytes.
+         *
+         *  After writing, tellg() returns the size needed for
+         *  the same data.
+         */
+        static SimpleOutStream counting();
 
         /** Returns the buffer */
         const std::span<uint8_t>& buffer() const {
@@ -164,7 +187,7 @@ class SimpleOutStream {
 
         /** Set the current write index in bytes from the start. */
         void seekg(uint32_t pos) {
-            if (pos > buf.size()) {
+            if (!countOnly && pos > buf.size()) {
                 failFlag = true;
             }
             indexWrite = pos;
@@ -223,6 +246,9 @@ SimpleInStream& operator>>(SimpleInStream& in, rcAudio::Volume&);
 SimpleOutStream& operator<<(SimpleOutStream& out, const rcOutput::FreqType&);
 SimpleInStream& operator>>(SimpleInStream& in, rcOutput::FreqType&);
 
+SimpleOutStream& operator<<(SimpleOutStream& out, const rcAudio::AudioStatsReport&);
+SimpleInStream& operator>>(SimpleInStream& in, rcAudio::AudioStatsReport&);
+
 namespace rcEngine {
     SimpleOutStream& operator<<(::SimpleOutStream& out, const GearCollection&);
     SimpleInStream& operator>>(::SimpleInStream& in, GearCollection&);
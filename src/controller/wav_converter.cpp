@@ -0,0 +1,385 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Implementation of the streaming WAV converter.
+ *
+ *  @file
+ *
+*/
+
+#include "wav_converter.h"
+#include "audio.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+using rcAudio::SAMPLE_RATE;
+
+namespace {
+
+static constexpr uint8_t CHUNK_HEADER_SIZE = 8u;
+static constexpr uint8_t RIFF_HEADER_SIZE = 12u;
+static constexpr uint8_t MIN_FORMAT_SIZE = 16u;
+static constexpr uint16_t FORMAT_PCM = 1u;
+static constexpr uint16_t FORMAT_EXTENSIBLE = 0xFFFEu;
+
+static constexpr uint8_t HALF_TAPS = WavConverter::NUM_TAPS / 2u;
+static constexpr int32_t COEFFICIENT_ONE = 1 << 14;
+
+uint16_t readUint16le(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t readUint32le(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) |
+        (static_cast<uint32_t>(data[1]) << 8) |
+        (static_cast<uint32_t>(data[2]) << 16) |
+        (static_cast<uint32_t>(data[3]) << 24);
+}
+
+} // namespace
+
+WavConverter::WavConverter() :
+    pending{},
+    adpcm(false),
+    coefficients{},
+    history{} {
+    reset(0u);
+}
+
+bool WavConverter::isWav(std::span<const uint8_t> data) {
+    return data.size() >= RIFF_HEADER_SIZE &&
+        memcmp(data.data(), "RIFF", 4) == 0 &&
+        memcmp(data.data() + 8, "WAVE", 4) == 0;
+}
+
+void WavConverter::reset(uint32_t sourceSize) {
+    state = State::HEADER;
+    section = Section::RIFF;
+    pendingSize = 0u;
+    pendingNeeded = RIFF_HEADER_SIZE;
+    skip = 0u;
+    sourceLeft = sourceSize;
+
+    hasFormat = false;
+    channels = 0u;
+    bitsPerSample = 0u;
+    sampleRate = 0u;
+    dataLeft = 0u;
+
+    frameSize = 1u;
+    frameFill = 0u;
+
+    convertedSize = 0u;
+    outputCount = 0u;
+    encoder.reset();
+
+    history.fill(0);
+    historyPos = 0u;
+    position = 0u;
+    random = 0x12345678u;
+}
+
+void WavConverter::write(std::span<const uint8_t> data, std::vector<uint8_t>& out) {
+    while (!data.empty() && (state == State::HEADER || state == State::DATA)) {
+        size_t used;
+        if (state == State::DATA) {
+            used = convertData(data, out);
+
+        } else if (section == Section::SKIP) {
+            used = std::min(static_cast<size_t>(skip), data.size());
+            skip -= used;
+
+        } else {
+            used = fill(data);
+        }
+
+        data = data.subspan(used);
+        sourceLeft -= std::min(sourceLeft, static_cast<uint32_t>(used));
+
+        if (state != State::HEADER) {
+            continue;
+        }
+        if (section == Section::SKIP) {
+            if (skip == 0u) {
+                section = Section::CHUNK;
+                pendingSize = 0u;
+                pendingNeeded = CHUNK_HEADER_SIZE;
+            }
+        } else if (pendingSize == pendingNeeded) {
+            parseSection();
+        }
+    }
+}
+
+void WavConverter::finish(std::vector<uint8_t>& out) {
+    if (state == State::DATA && !isNative() && sampleRate != SAMPLE_RATE) {
+        for (uint8_t i = 0u; i < HALF_TAPS; i++) {
+            addSample(0, out);
+        }
+    }
+
+    if (isSized()) {
+        while (outputCount < convertedSize) {
+            emitSample(0, out);
+        }
+        if (adpcm) {
+            encoder.finish(out);
+        }
+        state = State::DONE;
+
+    } else {
+        state = State::ERROR;
+    }
+}
+
+size_t WavConverter::fill(std::span<const uint8_t> data) {
+    const size_t count = std::min(static_cast<size_t>(pendingNeeded - pendingSize), data.size());
+    std::copy(data.begin(), data.begin() + count, pending.begin() + pendingSize);
+    pendingSize += count;
+    return count;
+}
+
+void WavConverter::parseSection() {
+    const auto nextChunk = [this](uint32_t skipSize) {
+        if (skipSize > 0u) {
+            section = Section::SKIP;
+            skip = skipSize;
+        } else {
+            section = Section::CHUNK;
+            pendingSize = 0u;
+            pendingNeeded = CHUNK_HEADER_SIZE;
+        }
+    };
+
+    switch (section) {
+    case Section::RIFF:
+        if (!isWav(std::span<const uint8_t>(pending.data(), pendingSize))) {
+            state = State::ERROR;
+            return;
+        }
+        nextChunk(0u);
+        break;
+
+    case Section::CHUNK:
+        {
+            const uint32_t size = readUint32le(pending.data() + 4);
+            const uint32_t padding = size & 1u;  // chunks are word aligned
+
+            if (memcmp(pending.data(), "fmt ", 4) == 0) {
+                if (size < MIN_FORMAT_SIZE) {
+                    state = State::ERROR;
+                    return;
+                }
+                section = Section::FORMAT;
+                pendingSize = 0u;
+                pendingNeeded = static_cast<uint8_t>(
+                    std::min(size, static_cast<uint32_t>(pending.size())));
+                skip = size - pendingNeeded + padding;  // after the format
+
+            } else if (memcmp(pending.data(), "data", 4) == 0) {
+                startData(size);
+
+            } else {
+                nextChunk(size + padding);
+            }
+        }
+        break;
+
+    case Section::FORMAT:
+        parseFormat();
+        if (state != State::ERROR) {
+            nextChunk(skip);
+        }
+        break;
+
+    case Section::SKIP:
+        break;
+    }
+}
+
+void WavConverter::parseFormat() {
+    uint16_t formatType = readUint16le(pending.data());
+    channels = readUint16le(pending.data() + 2);
+    sampleRate = readUint32le(pending.data() + 4);
+    bitsPerSample = readUint16le(pending.data() + 14);
+
+    // the sub format GUID starts with the actual format type
+    if (formatType == FORMAT_EXTENSIBLE && pendingSize >= 26u) {
+        formatType = readUint16le(pending.data() + 24);
+    }
+
+    if (formatType != FORMAT_PCM ||
+        channels < 1u || channels > 2u ||
+        (bitsPerSample != 8u && bitsPerSample != 16u) ||
+        sampleRate < MIN_RATE || sampleRate > MAX_RATE) {
+        state = State::ERROR;
+        return;
+    }
+
+    frameSize = static_cast<uint8_t>(channels * bitsPerSample / 8u);
+    hasFormat = true;
+}
+
+void WavConverter::startData(uint32_t size) {
+    if (!hasFormat) {
+        state = State::ERROR;
+        return;
+    }
+
+    // some writers leave the size open when streaming
+    dataLeft = std::min(size, sourceLeft);
+
+    const uint32_t frames = dataLeft / frameSize;
+    if (sampleRate == SAMPLE_RATE) {
+        convertedSize = frames;
+    } else {
+        convertedSize = static_cast<uint32_t>(
+            (static_cast<uint64_t>(frames) * SAMPLE_RATE + sampleRate - 1u) / sampleRate);
+        initResampler();
+    }
+
+    state = (dataLeft > 0u) ? State::DATA : State::DONE;
+}
+
+void WavConverter::initResampler() {
+    // cut off a little below the lower nyquist frequency (in cycles per input sample)
+    const float cutoff = 0.45f *
+        std::min(1.0f, static_cast<float>(SAMPLE_RATE) / static_cast<float>(sampleRate));
+    const float pi = std::numbers::pi_v<float>;
+
+    for (uint8_t p = 0u; p < NUM_PHASES; p++) {
+        const float fraction = static_cast<float>(p) / NUM_PHASES;
+
+        // the window holds the oldest sample first
+        std::array<float, NUM_TAPS> row;
+        float sum = 0.0f;
+        for (uint8_t j = 0u; j < NUM_TAPS; j++) {
+            const float x = static_cast<float>(HALF_TAPS - 1 - j) + fraction;
+            const float sinc = (x == 0.0f) ?
+                2.0f * cutoff :
+                std::sin(2.0f * pi * cutoff * x) / (pi * x);
+            const float window = 0.42f +
+                0.5f * std::cos(pi * x / HALF_TAPS) +
+                0.08f * std::cos(2.0f * pi * x / HALF_TAPS);
+            row[j] = sinc * window;
+            sum += row[j];
+        }
+
+        // normalize every phase to a gain of exactly one
+        int32_t total = 0;
+        uint8_t largest = 0u;
+        for (uint8_t j = 0u; j < NUM_TAPS; j++) {
+            coefficients[p][j] = static_cast<int16_t>(std::lround(row[j] / sum * COEFFICIENT_ONE));
+            total += coefficients[p][j];
+            if (coefficients[p][j] > coefficients[p][largest]) {
+                largest = j;
+            }
+        }
+        coefficients[p][largest] += static_cast<int16_t>(COEFFICIENT_ONE - total);
+    }
+
+    history.fill(0);
+    historyPos = 0u;
+    position = HALF_TAPS * SAMPLE_RATE;
+}
+
+size_t WavConverter::convertData(std::span<const uint8_t> data, std::vector<uint8_t>& out) {
+    const size_t size = std::min(data.size(), static_cast<size_t>(dataLeft));
+    size_t used = 0u;
+
+    while (used < size) {
+        const uint8_t* frameData;
+        if (frameFill == 0u && size - used >= frameSize) {
+            frameData = data.data() + used;
+            used += frameSize;
+
+        } else {
+            frame[frameFill++] = data[used++];
+            if (frameFill < frameSize) {
+                continue;
+            }
+            frameFill = 0u;
+            frameData = frame.data();
+        }
+
+        if (isNative()) {
+            emit(frameData[0], out);
+        } else if (sampleRate == SAMPLE_RATE) {
+            emitSample(decodeFrame(frameData), out);
+        } else {
+            addSample(decodeFrame(frameData), out);
+        }
+    }
+
+    dataLeft -= used;
+    if (dataLeft == 0u) {
+        finish(out);
+    }
+    return used;
+}
+
+int32_t WavConverter::decodeFrame(const uint8_t* data) const {
+    int32_t sum = 0;
+    for (uint16_t c = 0u; c < channels; c++) {
+        if (bitsPerSample == 8u) {
+            sum += (static_cast<int32_t>(data[c]) - 128) * 256;
+        } else {
+            sum += static_cast<int16_t>(readUint16le(data + c * 2u));
+        }
+    }
+    return (channels == 2u) ? (sum >> 1) : sum;
+}
+
+void WavConverter::addSample(int32_t sample, std::vector<uint8_t>& out) {
+    historyPos = (historyPos + 1u) % NUM_TAPS;
+    history[historyPos] = sample;
+    history[historyPos + NUM_TAPS] = sample;
+    const int32_t* window = history.data() + historyPos + 1u;
+
+    // all output samples between this and the next input sample
+    while (position < SAMPLE_RATE) {
+        const auto& row = coefficients[position * NUM_PHASES / SAMPLE_RATE];
+        int32_t acc = 0;
+        for (uint8_t j = 0u; j < NUM_TAPS; j++) {
+            acc += row[j] * window[j];
+        }
+        emitSample((acc + COEFFICIENT_ONE / 2) >> 14, out);
+        position += sampleRate;
+    }
+    position -= SAMPLE_RATE;
+}
+
+void WavConverter::emit(uint8_t sample, std::vector<uint8_t>& out) {
+    if (outputCount < convertedSize) {
+        out.push_back(sample);
+        outputCount++;
+    }
+}
+
+void WavConverter::emitSample(int32_t sample, std::vector<uint8_t>& out) {
+    if (!adpcm) {
+        emit(dither(sample), out);
+
+    } else if (outputCount < convertedSize) {
+        encoder.add(static_cast<int16_t>(std::clamp<int32_t>(sample, INT16_MIN, INT16_MAX)), out);
+        outputCount++;
+    }
+}
+
+uint8_t WavConverter::dither(int32_t sample) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+
+    // triangular noise of +-1 LSB of the result
+    const int32_t noise = static_cast<int32_t>(random & 0xFFu) -
+        static_cast<int32_t>((random >> 8) & 0xFFu);
+    const int32_t value = (sample + noise + 128) >> 8;
+    return static_cast<uint8_t>(std::clamp<int32_t>(value, -128, 127) + 128);
+}
+
+bool WavConverter::isNative() const {
+    return !adpcm && channels == 1u && bitsPerSample == 8u && sampleRate == SAMPLE_RATE;
+}
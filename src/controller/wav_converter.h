@@ -0,0 +1,225 @@
+/** RC functions controller for Arduino ESP32
+ *
+ *  Definitions for the streaming WAV converter.
+ *
+ *  @file
+ *
+*/
+
+#ifndef _RC_WAV_CONVERTER_H_
+#define _RC_WAV_CONVERTER_H_
+
+#include "audio_adpcm.h"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/** Converts an uploaded WAV file chunk by chunk into the internal
+ *  sample format (unsigned 8 bit, mono, rcAudio::SAMPLE_RATE).
+ *
+ *  The converter understands PCM WAV files with 8 or 16 bit,
+ *  one or two channels and sample rates between MIN_RATE and
+ *  MAX_RATE. The chunks can be split at any position, also inside
+ *  the header or inside a sample frame.
+ *
+ *  - Stereo is mixed down to mono.
+ *  - Other sample rates are converted with a polyphase resampler
+ *    (windowed sinc, NUM_TAPS taps in NUM_PHASES phases) that also
+ *    acts as anti aliasing filter.
+ *  - 16 bit samples (and resampled 8 bit ones) are reduced to 8 bit
+ *    with TPDF dithering.
+ *
+ *  Files already in the internal format are copied unchanged
+ *  (without the header).
+ *
+ *  With setAdpcm() the result is IMA-ADPCM encoded instead
+ *  (rcAudio::ADPCM_BLOCK_SIZE blocks), which needs about half the
+ *  flash.
+ *
+ *  The size of the result is known as soon as the header was read,
+ *  see getConvertedSize(), so the flash block can be sized before
+ *  the first samples are written.
+ */
+class WavConverter {
+    public:
+        static constexpr uint32_t MIN_RATE = 8000u;
+        static constexpr uint32_t MAX_RATE = 48000u;
+
+        static constexpr uint8_t NUM_TAPS = 16u;
+        static constexpr uint8_t NUM_PHASES = 64u;
+
+        enum class State : uint8_t {
+            HEADER,  ///< reading the RIFF header and the chunks before the data
+            DATA,    ///< converting the samples of the data chunk
+            DONE,    ///< the data chunk is complete
+            ERROR    ///< no (supported) WAV file
+        };
+
+    private:
+        /** Where the header parser currently is. */
+        enum class Section : uint8_t {
+            RIFF,
+            CHUNK,
+            FORMAT,
+            SKIP
+        };
+
+        State state;
+        Section section;
+
+        /** Bytes of the current header section, see fill(). */
+        std::array<uint8_t, 40> pending;
+        uint8_t pendingSize;
+        uint8_t pendingNeeded;
+
+        /** Bytes to skip (rest of a chunk). */
+        uint32_t skip;
+
+        /** Bytes left of the whole upload. */
+        uint32_t sourceLeft;
+
+        bool hasFormat;
+        uint16_t channels;
+        uint16_t bitsPerSample;
+        uint32_t sampleRate;
+
+        /** Bytes left in the data chunk. */
+        uint32_t dataLeft;
+
+        /** A sample frame split between two chunks. */
+        std::array<uint8_t, 4> frame;
+        uint8_t frameSize;
+        uint8_t frameFill;
+
+        /** Number of output samples (not bytes). */
+        uint32_t convertedSize;
+        uint32_t outputCount;
+
+        bool adpcm;
+        rcAudio::AdpcmEncoder encoder;
+
+        // -- resampler
+        /** Q14 filter coefficients, one row for each phase. */
+        std::array<std::array<int16_t, NUM_TAPS>, NUM_PHASES> coefficients;
+
+        /** The last NUM_TAPS input samples, stored twice so that
+         *  the window for the filter is always contiguous.
+         */
+        std::array<int32_t, NUM_TAPS * 2> history;
+        uint8_t historyPos;
+
+        /** Position of the next output sample relative to the
+         *  window, in units of 1/SAMPLE_RATE input samples.
+         */
+        uint32_t position;
+
+        /** State of the dither noise generator. */
+        uint32_t random;
+
+        /** Collects pendingNeeded bytes, returns the number of bytes used. */
+        size_t fill(std::span<const uint8_t> data);
+
+        /** Evaluates the collected bytes of the current section. */
+        void parseSection();
+
+        void parseFormat();
+
+        /** Called when the header of the data chunk was read. */
+        void startData(uint32_t size);
+
+        void initResampler();
+
+        /** Converts the bytes of the data chunk, returns the number of bytes used. */
+        size_t convertData(std::span<const uint8_t> data, std::vector<uint8_t>& out);
+
+        /** Decodes a frame into a 16 bit mono sample. */
+        int32_t decodeFrame(const uint8_t* data) const;
+
+        /** Adds one input sample (16 bit range) to the resampler. */
+        void addSample(int32_t sample, std::vector<uint8_t>& out);
+
+        /** Writes one raw output sample, at most convertedSize ones. */
+        void emit(uint8_t sample, std::vector<uint8_t>& out);
+
+        /** Writes one output sample in 16 bit range (dithered or ADPCM encoded). */
+        void emitSample(int32_t sample, std::vector<uint8_t>& out);
+
+        /** Reduces a sample in 16 bit range to unsigned 8 bit with dither. */
+        uint8_t dither(int32_t sample);
+
+        bool isNative() const;
+
+    public:
+        WavConverter();
+
+        /** Quickly checks for the RIFF/WAVE header.
+         *
+         *  @returns false if the data doesn't start like a WAV file.
+         */
+        static bool isWav(std::span<const uint8_t> data);
+
+        /** Enables ADPCM encoding for the following conversions. */
+        void setAdpcm(bool adpcmVal) {
+            adpcm = adpcmVal;
+        }
+
+        bool isAdpcm() const {
+            return adpcm;
+        }
+
+        /** Starts a new conversion.
+         *
+         *  @param sourceSize The size of the whole uploaded file.
+         *    Used to limit the data chunk for broken headers.
+         */
+        void reset(uint32_t sourceSize);
+
+        /** Converts the next chunk of the file.
+         *
+         *  The converted samples are appended to out.
+         */
+        void write(std::span<const uint8_t> data, std::vector<uint8_t>& out);
+
+        /** Flushes the resampler at the end of the file.
+         *
+         *  Pads the output with silence if the file was shorter
+         *  than announced, so that exactly getConvertedSize() samples
+         *  are written in total.
+         */
+        void finish(std::vector<uint8_t>& out);
+
+        State getState() const {
+            return state;
+        }
+
+        /** Returns true if the format was read and getConvertedSize() is valid. */
+        bool isSized() const {
+            return state == State::DATA || state == State::DONE;
+        }
+
+        /** Number of bytes the converted file will have. */
+        uint32_t getConvertedSize() const {
+            return adpcm ? rcAudio::adpcmBytes(convertedSize) : convertedSize;
+        }
+
+        /** Number of samples the converted file will have. */
+        uint32_t getNumSamples() const {
+            return convertedSize;
+        }
+
+        uint16_t getChannels() const {
+            return channels;
+        }
+
+        uint16_t getBitsPerSample() const {
+            return bitsPerSample;
+        }
+
+        uint32_t getSampleRate() const {
+            return sampleRate;
+        }
+};
+
+#endif // _RC_WAV_CONVERTER_H_
@@ -4,14 +4,29 @@
  */
 
 #include "wav_sample.h"
+#include "audio_adpcm.h"
 #include "simple_byte_stream.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <cstdio>
 
 static constexpr const char* const FORMAT_CHUNK_NAME = "fmt ";
 static constexpr const char* const DATA_CHUNK_NAME = "data";
+static constexpr const char* const FACT_CHUNK_NAME = "fact";
+
+static constexpr uint16_t FORMAT_PCM = 1u;
+static constexpr uint16_t FORMAT_IMA_ADPCM = 0x11u;
+
+/** The parts of the format section we are interested in. */
+struct WavFormat {
+    uint16_t formatType;
+    uint16_t blockAlign;
+
+    /** Number of samples from the fact chunk (0 if there is none). */
+    uint32_t numSamples;
+};
 
 /** Reads information from a wave data section
  *
@@ -38,7 +53,7 @@ static std::span<const uint8_t> readDataChunk(SimpleInStream& is) {
  *
  *  @returns False in case of an error with the steam
  */
-static bool readFormatChunk(SimpleInStream& is) {
+static bool readFormatChunk(SimpleInStream& is, WavFormat& format, bool allowAdpcm) {
     auto sectionLength = is.readUint32le();
     if (sectionLength < 16) {
         printf("WAV: Invalid format section length.\n");
@@ -51,16 +66,35 @@ static bool readFormatChunk(SimpleInStream& is) {
     /*auto sampleRate =*/ is.readUint32le();
 
     /*auto bytePerSec =*/ is.readUint32le();
-    /*auto bytePerBlock =*/ is.readUint16le();
+    auto bytePerBlock = is.readUint16le();
     auto bitsPerSample = is.readUint16le();
 
-    if (formatType != 1u ||
-        channels != 1 ||
-        bitsPerSample != 8) {
+    const bool pcm = (formatType == FORMAT_PCM && bitsPerSample == 8);
+    const bool adpcm = (allowAdpcm && formatType == FORMAT_IMA_ADPCM &&
+        bitsPerSample == 4 && bytePerBlock > rcAudio::ADPCM_HEADER_SIZE);
+    if (!(pcm || adpcm) || channels != 1) {
         printf("WAV: Invalid format, channel or bitcount for wav file.\n");
         return false;
     }
 
+    format.formatType = formatType;
+    format.blockAlign = bytePerBlock;
+
+    is.seekg(sectionEnd);
+    return true;
+}
+
+/** Reads the number of samples from a fact section
+ *
+ *  The input stream should be just after the section lable
+ */
+static bool readFactChunk(SimpleInStream& is, WavFormat& format) {
+    auto sectionLength = is.readUint32le();
+    auto sectionEnd = is.tellg() + sectionLength;
+    if (sectionLength >= 4) {
+        format.numSamples = is.readUint32le();
+    }
+
     is.seekg(sectionEnd);
     return true;
 }
@@ -80,9 +114,16 @@ static bool readAnyChunk(SimpleInStream& is) {
     return true;
 }
 
-std::span<const uint8_t> getWavSamples(const std::span<const uint8_t>& wavData) {
+/** Reads the wav header and returns the data chunk content
+ *
+ *  @returns The data chunk content or the whole content in case
+ *    it couldn't be decoded.
+ */
+static std::span<const uint8_t> readWav(const std::span<const uint8_t>& wavData,
+    WavFormat& format, bool allowAdpcm) {
 
     SimpleInStream is(wavData);
+    format = WavFormat{.formatType = FORMAT_PCM, .blockAlign = 1u, .numSamples = 0u};
 
     if (is.read<char>() != 'R' ||
         is.read<char>() != 'I' ||
@@ -115,7 +156,9 @@ std::span<const uint8_t> getWavSamples(const std::span<const uint8_t>& wavData)
         // read the section
         bool ok;
         if (strcmp(name, FORMAT_CHUNK_NAME) == 0) {
-            ok = readFormatChunk(is);
+            ok = readFormatChunk(is, format, allowAdpcm);
+        } else if (strcmp(name, FACT_CHUNK_NAME) == 0) {
+            ok = readFactChunk(is, format);
         } else if (strcmp(name, DATA_CHUNK_NAME) == 0) {
             auto sampleData = readDataChunk(is);
             return sampleData;
@@ -125,8 +168,29 @@ std::span<const uint8_t> getWavSamples(const std::span<const uint8_t>& wavData)
 
         // in case of invalid section, fall back to raw
         if (!ok) {
+            format.formatType = FORMAT_PCM;
             return wavData;
         }
     }
+    format.formatType = FORMAT_PCM;
     return wavData;
 }
+
+std::span<const uint8_t> getWavSamples(const std::span<const uint8_t>& wavData) {
+    WavFormat format;
+    return readWav(wavData, format, false);
+}
+
+rcAudio::SampleData getWavSampleData(const std::span<const uint8_t>& wavData) {
+    WavFormat format;
+    auto data = readWav(wavData, format, true);
+
+    if (format.formatType != FORMAT_IMA_ADPCM) {
+        return rcAudio::SampleData(data);
+    }
+
+    const uint32_t maxSamples = rcAudio::adpcmSamples(data.size(), format.blockAlign);
+    const uint32_t numSamples = (format.numSamples > 0u) ?
+        std::min(format.numSamples, maxSamples) : maxSamples;
+    return rcAudio::SampleData::adpcm(data, format.blockAlign, numSamples);
+}
@@ -6,6 +6,8 @@
 #ifndef _WAV_SAMPLE_H_
 #define _WAV_SAMPLE_H_
 
+#include "audio.h"
+
 #include <cstdint>
 #include <span>
 
@@ -31,5 +33,16 @@ static constexpr uint32_t SAMPLE_RATE = 22050; // fixed sample rate for audio
  */
 std::span<const uint8_t> getWavSamples(const std::span<const uint8_t>& wavData);
 
+/** Same as getWavSamples() but also understands IMA-ADPCM wav files.
+ *
+ *  ADPCM files need to be mono with 4 bits per sample.
+ *  The number of samples is taken from the "fact" chunk, if there
+ *  is one.
+ *
+ *  @returns The samples or the whole content as 8 bit raw data in case
+ *    it couldn't be decoded.
+ */
+rcAudio::SampleData getWavSampleData(const std::span<const uint8_t>& wavData);
+
 #endif // _WAV_SAMPLE_H_
 
@@ -13,6 +13,18 @@ import re
 import xml.etree.ElementTree as ET
 
 
+def lut_size(points):
+    """Returns the number of samples for the lookup table of the points.
+
+    The points are rounded to 0.01 (see curve_points), so with one
+    sample every 0.01 the table contains all the points.
+    The points are still in svg coordinates (scaled by 100).
+    """
+    first = round(float(points[0][0]))
+    last = round(float(points[-1][0]))
+    return last - first + 1
+
+
 def output_cpp(power_graphs, out_file):
     """Outputs the cpp file with all the power curve types."""
 
@@ -36,10 +48,12 @@ def output_cpp(power_graphs, out_file):
             {"id": "id", "title": "title", "points": ["x,y", ...]}
         """
         return f"""
-const rcProc::Curve<{len(graph["points"])}> powerCurve{graph["id"]}{{
+constexpr rcProc::Curve<{len(graph["points"])}> powerCurve{graph["id"]}{{
     .points={{
 {",\n".join(curve_points(graph["points"]))}
     }}}};
+
+constexpr rcProc::UniformCurve<{lut_size(graph["points"])}> powerLut{graph["id"]}(powerCurve{graph["id"]});
 """
 
     print(
@@ -81,6 +95,9 @@ def output_h(power_graphs, out_file):
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<{len(graph["points"])}> powerCurve{graph["id"]};
+
+/** Lookup table for powerCurve{graph["id"]}. */
+extern const rcProc::UniformCurve<{lut_size(graph["points"])}> powerLut{graph["id"]};
 """
 
     print(
@@ -36,38 +36,38 @@ float EngineSimple::getPower(const float rpm, float throttle, const bool ignitio
     float negativePower = 0.0f;
     switch (engineType) {
     case EngineType::ELECTRIC:
-        positivePower = powerCurveElectric.map(relativeRPM);
+        positivePower = powerLutElectric.map(relativeRPM);
         break;
     case EngineType::DIESEL:
-        positivePower = powerCurveDiesel.map(relativeRPM);
+        positivePower = powerLutDiesel.map(relativeRPM);
         if (ignition) {
-            negativePower = powerCurveMotorBrake.map(relativeRPM);
+            negativePower = powerLutMotorBrake.map(relativeRPM);
         } else {
             negativePower = -0.4f;
         }
         break;
     case EngineType::PETROL:
-        positivePower = powerCurvePetrol.map(relativeRPM);
+        positivePower = powerLutPetrol.map(relativeRPM);
         if (ignition) {
-            negativePower = powerCurveMotorBrake.map(relativeRPM);
+            negativePower = powerLutMotorBrake.map(relativeRPM);
         } else {
             negativePower = -0.4f;
         }
         break;
     case EngineType::PETROL_TURBO:
-        positivePower = powerCurvePetrolTurbo.map(relativeRPM);
+        positivePower = powerLutPetrolTurbo.map(relativeRPM);
         if (ignition) {
-            negativePower = powerCurveMotorBrake.map(relativeRPM);
+            negativePower = powerLutMotorBrake.map(relativeRPM);
         } else {
             negativePower = -0.4f;
         }
         break;
     case EngineType::STEAM:
-        positivePower = powerCurveSteam.map(relativeRPM);
+        positivePower = powerLutSteam.map(relativeRPM);
         negativePower = relativeRPM / 2.0f - 0.2f;
         break;
     case EngineType::TURBINE:
-        positivePower = powerCurveTurbine.map(relativeRPM);
+        positivePower = powerLutTurbine.map(relativeRPM);
         negativePower = relativeRPM / 3.0f - 0.1f;
         break;
     default:
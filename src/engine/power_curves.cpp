@@ -1,7 +1,7 @@
 /** Power curve definitions.
  *
  * This file is auto generated by serialization_tool.py
- * 2025-06-06
+ * 2026-10-16
  *
  * Do not modify.
  *
@@ -13,7 +13,7 @@
 namespace rcEngine {
 
 
-const rcProc::Curve<4> powerCurveElectric{
+constexpr rcProc::Curve<4> powerCurveElectric{
     .points={
         rcProc::CurvePoint{0.00f, 1.00f},
         rcProc::CurvePoint{0.62f, 0.68f},
@@ -21,8 +21,10 @@ const rcProc::Curve<4> powerCurveElectric{
         rcProc::CurvePoint{1.00f, 0.00f}
     }};
 
+constexpr rcProc::UniformCurve<101> powerLutElectric(powerCurveElectric);
 
-const rcProc::Curve<6> powerCurvePetrolTwinTurbo{
+
+constexpr rcProc::Curve<6> powerCurvePetrolTwinTurbo{
     .points={
         rcProc::CurvePoint{-0.00f, 0.00f},
         rcProc::CurvePoint{0.13f, 0.22f},
@@ -32,8 +34,10 @@ const rcProc::Curve<6> powerCurvePetrolTwinTurbo{
         rcProc::CurvePoint{1.00f, 0.00f}
     }};
 
+constexpr rcProc::UniformCurve<101> powerLutPetrolTwinTurbo(powerCurvePetrolTwinTurbo);
+
 
-const rcProc::Curve<7> powerCurveDiesel{
+constexpr rcProc::Curve<7> powerCurveDiesel{
     .points={
         rcProc::CurvePoint{-0.00f, 0.00f},
         rcProc::CurvePoint{0.28f, 0.37f},
@@ -44,8 +48,10 @@ const rcProc::Curve<7> powerCurveDiesel{
         rcProc::CurvePoint{1.00f, 0.00f}
     }};
 
+constexpr rcProc::UniformCurve<101> powerLutDiesel(powerCurveDiesel);
 
-const rcProc::Curve<8> powerCurvePetrol{
+
+constexpr rcProc::Curve<8> powerCurvePetrol{
     .points={
         rcProc::CurvePoint{-0.00f, 0.00f},
         rcProc::CurvePoint{0.21f, 0.29f},
@@ -57,8 +63,10 @@ const rcProc::Curve<8> powerCurvePetrol{
         rcProc::CurvePoint{1.00f, 0.00f}
     }};
 
+constexpr rcProc::UniformCurve<101> powerLutPetrol(powerCurvePetrol);
+
 
-const rcProc::Curve<7> powerCurvePetrolTurbo{
+constexpr rcProc::Curve<7> powerCurvePetrolTurbo{
     .points={
         rcProc::CurvePoint{-0.00f, 0.00f},
         rcProc::CurvePoint{0.14f, 0.22f},
@@ -69,8 +77,10 @@ const rcProc::Curve<7> powerCurvePetrolTurbo{
         rcProc::CurvePoint{1.00f, 0.00f}
     }};
 
+constexpr rcProc::UniformCurve<101> powerLutPetrolTurbo(powerCurvePetrolTurbo);
 
-const rcProc::Curve<5> powerCurveMotorBrake{
+
+constexpr rcProc::Curve<5> powerCurveMotorBrake{
     .points={
         rcProc::CurvePoint{0.00f, -0.91f},
         rcProc::CurvePoint{0.12f, -0.04f},
@@ -79,8 +89,10 @@ const rcProc::Curve<5> powerCurveMotorBrake{
         rcProc::CurvePoint{1.02f, -0.34f}
     }};
 
+constexpr rcProc::UniformCurve<103> powerLutMotorBrake(powerCurveMotorBrake);
+
 
-const rcProc::Curve<5> powerCurveSteam{
+constexpr rcProc::Curve<5> powerCurveSteam{
     .points={
         rcProc::CurvePoint{0.00f, 0.46f},
         rcProc::CurvePoint{0.54f, 0.89f},
@@ -89,8 +101,10 @@ const rcProc::Curve<5> powerCurveSteam{
         rcProc::CurvePoint{1.00f, 0.00f}
     }};
 
+constexpr rcProc::UniformCurve<101> powerLutSteam(powerCurveSteam);
 
-const rcProc::Curve<5> powerCurveTurbine{
+
+constexpr rcProc::Curve<5> powerCurveTurbine{
     .points={
         rcProc::CurvePoint{-0.00f, 0.00f},
         rcProc::CurvePoint{0.37f, 0.21f},
@@ -99,6 +113,8 @@ const rcProc::Curve<5> powerCurveTurbine{
         rcProc::CurvePoint{1.00f, 0.00f}
     }};
 
+constexpr rcProc::UniformCurve<101> powerLutTurbine(powerCurveTurbine);
+
 
 } // namespace
 
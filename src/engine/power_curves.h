@@ -1,7 +1,7 @@
 /** Power curve declarations.
  *
  * This file is auto generated by serialization_tool.py
- * 2025-06-06
+ * 2026-10-16
  *
  * Do not modify.
  *
@@ -26,48 +26,72 @@ namespace rcEngine {
  */
 extern const rcProc::Curve<4> powerCurveElectric;
 
+/** Lookup table for powerCurveElectric. */
+extern const rcProc::UniformCurve<101> powerLutElectric;
+
 /** Power curve definition for BMW 3l twin-turbo.
  *
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<6> powerCurvePetrolTwinTurbo;
 
+/** Lookup table for powerCurvePetrolTwinTurbo. */
+extern const rcProc::UniformCurve<101> powerLutPetrolTwinTurbo;
+
 /** Power curve definition for Yanmar 6LY 400 HP Marine Diesel.
  *
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<7> powerCurveDiesel;
 
+/** Lookup table for powerCurveDiesel. */
+extern const rcProc::UniformCurve<101> powerLutDiesel;
+
 /** Power curve definition for Porsche 911 ca 1980.
  *
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<8> powerCurvePetrol;
 
+/** Lookup table for powerCurvePetrol. */
+extern const rcProc::UniformCurve<101> powerLutPetrol;
+
 /** Power curve definition for Ecoboost 50HP.
  *
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<7> powerCurvePetrolTurbo;
 
+/** Lookup table for powerCurvePetrolTurbo. */
+extern const rcProc::UniformCurve<101> powerLutPetrolTurbo;
+
 /** Power curve definition for Motor braking power.
  *
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<5> powerCurveMotorBrake;
 
+/** Lookup table for powerCurveMotorBrake. */
+extern const rcProc::UniformCurve<103> powerLutMotorBrake;
+
 /** Power curve definition for invented steam engine.
  *
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<5> powerCurveSteam;
 
+/** Lookup table for powerCurveSteam. */
+extern const rcProc::UniformCurve<101> powerLutSteam;
+
 /** Power curve definition for Invented jet turbine torque.
  *
  * Used by ProcSimpleEngine.
  */
 extern const rcProc::Curve<5> powerCurveTurbine;
 
+/** Lookup table for powerCurveTurbine. */
+extern const rcProc::UniformCurve<101> powerLutTurbine;
+
 
 } // namespace
 
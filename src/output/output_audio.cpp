@@ -7,11 +7,14 @@
 #include "output_audio.h"
 
 #include "audio_ringbuffer.h"
+#include "audio_mix.h"
+#include "audio_stats.h"
 
 #include "signals.h"
 #include <cstdint>
 
 #include <esp_check.h>
+#include <freertos/idf_additions.h> // for xTaskCreatePinnedToCore
 
 #include <esp_log.h>
 #include <algorithm>
@@ -24,6 +27,11 @@ using namespace rcAudio;
 
 namespace rcOutput {
 
+/** Number of DMA events dropped because the audio task was too late.
+ *
+ *  Only written by the interrupt. The audio task forwards it to the AudioStats.
+ */
+static volatile uint32_t numDroppedEvents = 0u;
 
 /** This is just a freerunning interrupt indicating that a DMA buffer
  *  has been processed and communicating the location of that buffer.
@@ -37,6 +45,7 @@ static bool IRAM_ATTR  dac_on_convert_done_callback(dac_continuous_handle_t hand
     if (xQueueIsQueueFullFromISR(queue)) {
         dac_event_data_t dummy;
         xQueueReceiveFromISR(queue, &dummy, &need_awoke);
+        numDroppedEvents = numDroppedEvents + 1u;
     }
     // Send the event from callback
     xQueueSendFromISR(queue, event, &need_awoke);
@@ -46,7 +55,9 @@ static bool IRAM_ATTR  dac_on_convert_done_callback(dac_continuous_handle_t hand
 
 OutputAudio::OutputAudio() :
     handleDac(nullptr),
-    handleQueue(nullptr) {
+    handleQueue(nullptr),
+    handleTask(nullptr),
+    masterGain(GAIN_Q15_ONE) {
 
     // Create a queue for the DMA buffer locations
     handleQueue = xQueueCreate(rcAudio::AudioRingbuffer::NUM_BLOCKS, sizeof(dac_event_data_t));
@@ -96,6 +107,16 @@ void OutputAudio::start()
         ESP_ERROR_CHECK(
             dac_continuous_start_async_writing(handleDac));
 
+        // the audio task feeds the DMA on the second core
+        xTaskCreatePinnedToCore(
+            audioTask,    // Task function
+            "audioTask",  // name of task
+            4096,         // Stack size of task
+            this,         // parameter of the task
+            4,            // priority of the task (1 = low, 3 = medium, 5 = highest)
+            &handleTask,  // Task handle to keep track of created task
+            1);           // pin task to core 1
+
         ESP_LOGI(TAG, "Setup Done");
     }
 
@@ -121,12 +142,18 @@ void OutputAudio::start()
         }
     }
 
+    getAudioStats().blocksFull(interval, AudioStats::nowUs());
     ringbuffer.setBlocksFull(interval);
 }
 
 /** De-initialize this Output module. */
 void OutputAudio::stop() {
 
+    if (handleTask != nullptr) {
+        vTaskDelete(handleTask);
+        handleTask = nullptr;
+    }
+
     if (handleDac != nullptr) {
         /*
         // clear the DMA buffer to prevent strange noises
@@ -144,60 +171,62 @@ void OutputAudio::stop() {
     }
 }
 
-void OutputAudio::step(const rcProc::StepInfo& info) {
+void OutputAudio::audioTask(void* pvParameters) {
+    OutputAudio* output = static_cast<OutputAudio*>(pvParameters);
+    uint32_t lastDroppedEvents = numDroppedEvents;
+
+    for (;;) {
+        dac_event_data_t evtData;
+        if (xQueueReceive(output->handleQueue, &evtData, portMAX_DELAY)) {
+            output->fillDmaBuffer(evtData);
+        }
+
+        const uint32_t droppedEvents = numDroppedEvents;
+        if (droppedEvents != lastDroppedEvents) {
+            getAudioStats().countOverruns(droppedEvents - lastDroppedEvents);
+            lastDroppedEvents = droppedEvents;
+        }
+    }
+}
+
+void OutputAudio::fillDmaBuffer(const dac_event_data_t& evtData) {
     auto& ringbuffer = rcAudio::getRingbuffer();
 
-    if (handleDac == nullptr) {
-        return;
+    // the DMA buffer is twice as long because of the 16 bit align
+    assert(evtData.buf_size == rcAudio::AudioRingbuffer::BLOCK_SIZE * 4);
+
+    // convert the buffer to interleaved 8 bit.
+    static std::array<uint8_t, rcAudio::AudioRingbuffer::BLOCK_SIZE * 2> buffer;
+
+    const uint8_t numFull = ringbuffer.getNumFull();
+    auto interval = ringbuffer.getFullBlocks();
+    getAudioStats().blockPlayed(interval, numFull, AudioStats::nowUs());
+    if (interval.last - interval.first == rcAudio::AudioRingbuffer::BLOCK_SIZE) {
+        convertBlockU8(interval.first, buffer.data(),
+            rcAudio::AudioRingbuffer::BLOCK_SIZE,
+            masterGain.load(std::memory_order_relaxed));
+        ringbuffer.setBlocksEmpty(interval);
+
+    } else {
+        // underrun. Better silence than repeating the old DMA buffer.
+        buffer.fill(127);
     }
 
+    // write to DMA
+    ESP_ERROR_CHECK(
+        dac_continuous_write_asynchronously(handleDac,
+            static_cast<uint8_t*>(evtData.buf),
+            evtData.buf_size,
+            buffer.begin(),
+            buffer.size(),
+            nullptr));
+}
+
+void OutputAudio::step(const rcProc::StepInfo& info) {
     rcSignals::RcSignal masterVolume =
         info.signals->get(SignalType::ST_MASTER_VOLUME, rcSignals::RCSIGNAL_MAX);
-    float fVolume = masterVolume / 1000.0f;
-
-    // while we have full ringbuffer blocks and a DMA buffer to fill
-    while (ringbuffer.getNumFull() > 0) {
-
-        dac_event_data_t evt_data;
-        if (xQueueReceive(handleQueue, &evt_data, 0)) {
-
-            auto interval = ringbuffer.getFullBlocks();
-
-            // we should get exactly one block now.
-            // not zero and not more than one.
-            assert(interval.last - interval.first == rcAudio::AudioRingbuffer::BLOCK_SIZE);
-            // the DMA buffer is twice as long because of the 16 bit align
-            assert(evt_data.buf_size == rcAudio::AudioRingbuffer::BLOCK_SIZE * 4);
-
-            // convert the buffer to interleaved 8 bit.
-            std::array<uint8_t, rcAudio::AudioRingbuffer::BLOCK_SIZE * 2> buffer;
-            for (int32_t i = 0; i < rcAudio::AudioRingbuffer::BLOCK_SIZE; i++) {
-                buffer[i * 2] =
-                    std::clamp(
-                        interval.first[i].channel1 * fVolume + 127,
-                        0.0f, 255.0f);
-                buffer[i * 2 + 1] =
-                    std::clamp(
-                        interval.first[i].channel2 * fVolume + 127,
-                        0.0f, 255.0f);
-            }
-
-            // write to DMA
-            ESP_ERROR_CHECK(
-                dac_continuous_write_asynchronously(handleDac,
-                    static_cast<uint8_t*>(evt_data.buf),
-                    evt_data.buf_size,
-                    buffer.begin(),
-                    buffer.size(),
-                    nullptr));
-            ringbuffer.setBlocksEmpty(interval);
-
-        } else {
-            break; // no new free DMA buffer
-        }
-    }
+    masterGain.store(toGainQ15(masterVolume / 1000.0f), std::memory_order_relaxed);
 }
 
 
 } // namespace
-
@@ -8,11 +8,14 @@
 #define _OUTPUT_AUDIO_H_
 
 #include "output.h"
+#include "audio.h"
 
+#include <atomic>
 #include <cstdint>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
+#include <freertos/task.h>
 #include <driver/dac_continuous.h>
 
 namespace rcOutput {
@@ -38,18 +41,35 @@ class OutputAudio : public Output {
         static constexpr uint32_t SAMPLE_RATE = 22050;
     private:
         dac_continuous_handle_t handleDac;
-        QueueHandle_t handleQueue;
+        QueueHandle_t handleQueue;  ///< Queue with the free DMA buffers
+        TaskHandle_t handleTask;  ///< The task filling the DMA buffers
+
+        /** The master volume, written by step() and read by the audio task. */
+        std::atomic<rcAudio::GainQ15> masterGain;
+
+        /** Task function of the audio task.
+         *
+         *  Waits for a free DMA buffer and fills it with the next full
+         *  ringbuffer block (or with silence if there is none).
+         *
+         *  The task is the consumer of the AudioRingbuffer.
+         */
+        static void audioTask(void* pvParameters);
+
+        /** Fills one free DMA buffer. */
+        void fillDmaBuffer(const dac_event_data_t& evtData);
 
     public:
         OutputAudio();
         ~OutputAudio();
 
-        /** Checks for finished DMA jobs and starts new ones.
+        /** Updates the master volume.
          *
          * The AudioRingbuffer is filled by the audio procs in
          * by their own step() functions.
          *
-         * The sample output is done a continous DMA job.
+         * The sample output is done a continous DMA job which is fed
+         * by a dedicated audio task, independent of the main task.
          */
         virtual void step(const rcProc::StepInfo& info) override;
         virtual void start();
@@ -1,5 +1,5 @@
 /**
- *  This file contains the rc::Curves class
+ *  This file contains the rc::Curves classes
  *
  *  @file
 */
@@ -8,6 +8,7 @@
 #define _RC_CURVE_H_
 
 #include <array>
+#include <cstdint>
 
 namespace rcProc {
 
@@ -31,7 +32,7 @@ public:
      *
      * Input values outside the curve are mapped to the first/last point depending.
      */
-    float map(float in) const {
+    constexpr float map(float in) const {
         static_assert(N >= 2, "curve needs at least two points");
 
         if (in < points.front().in) {
@@ -51,6 +52,85 @@ public:
     }
 };
 
+/** A curve sampled at M equidistant points (a lookup table).
+ *
+ *  In contrast to Curve::map() the mapping does not search the
+ *  segment and needs no division. The input is converted to a
+ *  fixed-point position (16 bit fraction) which directly gives the
+ *  table index and the interpolation weight.
+ *
+ *  The table is exact at the sample points. Between them the
+ *  corners of the original curve are cut, so the sample points
+ *  should include the points of the original curve (e.g. 101
+ *  samples for points on a 0.01 grid from 0.0 to 1.0).
+ *
+ *  The constructor is constexpr, so tables for constant curves are
+ *  created at compile time. Curves configured at runtime should
+ *  create their table in start().
+ */
+template<std::size_t M> class UniformCurve {
+    static_assert(M >= 2, "uniform curve needs at least two samples");
+
+    private:
+        static constexpr uint32_t FRAC_BITS = 16u;
+        static constexpr uint32_t FRAC_MASK = (1u << FRAC_BITS) - 1u;
+
+        float inMin;
+        float inMax;
+
+        /** Factor from input to fixed-point position. */
+        float scale;
+
+        std::array<float, M> table;
+
+    public:
+        /** Creates a flat curve with output 0.0 */
+        constexpr UniformCurve() :
+            inMin(0.0f),
+            inMax(1.0f),
+            scale(static_cast<float>((M - 1u) << FRAC_BITS)),
+            table{} {
+        }
+
+        /** Samples the curve between its first and last point. */
+        template<std::size_t N>
+        constexpr explicit UniformCurve(const Curve<N>& curve) :
+            inMin(curve.points.front().in),
+            inMax(curve.points.back().in),
+            scale(0.0f),
+            table{} {
+
+            const float range = inMax - inMin;
+            if (range > 0.0f) {
+                scale = static_cast<float>((M - 1u) << FRAC_BITS) / range;
+            }
+            for (std::size_t i = 0u; i < M; i++) {
+                table[i] = curve.map(inMin + range * static_cast<float>(i) / static_cast<float>(M - 1u));
+            }
+        }
+
+        /** Map the input value via the table to an output signal.
+         *
+         *  Input values outside the curve are mapped to the first/last point.
+         */
+        float map(float in) const {
+            if (!(in > inMin)) {
+                return table.front();
+            }
+            if (in >= inMax) {
+                return table.back();
+            }
+
+            const uint32_t pos = static_cast<uint32_t>((in - inMin) * scale);
+            const uint32_t index = pos >> FRAC_BITS;
+            if (index >= M - 1u) {  // rounding just below inMax
+                return table.back();
+            }
+            const float frac = static_cast<float>(pos & FRAC_MASK) * (1.0f / (FRAC_MASK + 1u));
+            return table[index] + (table[index + 1u] - table[index]) * frac;
+        }
+};
+
 
 } // namespace
 
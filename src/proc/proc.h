@@ -10,6 +10,7 @@
 
 #include "signals.h"
 #include <array>
+#include <bitset>
 
 class SimpleInStream;
 class SimpleOutStream;
@@ -79,6 +80,42 @@ struct StepInfo {
     std::array<SamplesInterval, 2> intervals;
 };
 
+/** The signals a proc reads and writes in step().
+ *
+ *  Used by the ProcStorage to find procs that are independent of
+ *  each other and can be stepped in parallel.
+ */
+struct SignalUsage {
+    typedef std::bitset<rcSignals::Signals::NUM_SIGNALS> SignalSet;
+
+    SignalSet reads;  ///< Signals read in step()
+    SignalSet writes;  ///< Signals (possibly) written in step()
+
+    /** The proc adds samples to the StepInfo::intervals. */
+    bool audio = false;
+
+    /** The usage is not known (or the proc has other side effects).
+     *
+     *  The proc needs to be stepped after all procs before and
+     *  before all procs after it.
+     */
+    bool barrier = false;
+
+    void read(rcSignals::SignalType type) {
+        reads.set(static_cast<size_t>(type));
+    }
+
+    void write(rcSignals::SignalType type) {
+        writes.set(static_cast<size_t>(type));
+    }
+
+    /** For signals that are only written if they are not already set (e.g. Signals::safeSet()). */
+    void readWrite(rcSignals::SignalType type) {
+        read(type);
+        write(type);
+    }
+};
+
 /** This class *processes* signals in one way or another.
  *
  *  This is the abstract baseclass of all the processors.
@@ -120,6 +157,18 @@ class Proc {
          *  @param[in,out] info The input/output signals.
          */
         virtual void step(const StepInfo& info) = 0;
+
+        /** Returns the signals used by step().
+         *
+         *  The default is a barrier. Procs should only override this if
+         *  their step() doesn't touch anything else than the
+         *  given signals, the audio intervals and their own members.
+         *
+         *  @param[out] usage The (empty) usage to fill out.
+         */
+        virtual void getSignalUsage(SignalUsage& usage) const {
+            usage.barrier = true;
+        }
 };
 
 } // namespace
@@ -56,6 +56,24 @@ class ProcAuto: public Proc {
 
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            using rcSignals::SignalType;
+            usage.read(SignalType::ST_YAW);
+            usage.read(SignalType::ST_BRAKE);
+            usage.read(SignalType::ST_GEAR);
+            usage.read(SignalType::ST_SPEED);
+            usage.read(SignalType::ST_LI_HAZARD);
+            usage.read(SignalType::ST_LOWBEAM);
+            usage.readWrite(SignalType::ST_PARKING_BRAKE);
+            usage.readWrite(SignalType::ST_LI_INDICATOR_LEFT);
+            usage.readWrite(SignalType::ST_LI_INDICATOR_RIGHT);
+            usage.readWrite(SignalType::ST_INDICATOR_LEFT);
+            usage.readWrite(SignalType::ST_INDICATOR_RIGHT);
+            usage.readWrite(SignalType::ST_REVERSING);
+            usage.readWrite(SignalType::ST_SHIFTING);
+            usage.readWrite(SignalType::ST_TAIL);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcAuto&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcAuto&);
 };
@@ -63,6 +63,15 @@ class ProcCombine: public Proc {
 
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            for (const auto type : inTypes) {
+                usage.read(type);
+            }
+            for (const auto type : outTypes) {
+                usage.write(type);
+            }
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcCombine&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcCombine&);
 };
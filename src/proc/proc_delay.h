@@ -53,6 +53,11 @@ class ProcDelay: public Proc{
         virtual void start() override;
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.read(inType);
+            usage.write(outType);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcDelay&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcDelay&);
 
@@ -52,6 +52,11 @@ class ProcDirection: public Proc {
         virtual void start() override;
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.read(inType);
+            usage.write(outType);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcDirection&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcDirection&);
 };
@@ -33,6 +33,11 @@ class ProcExpo: public Proc {
 
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.read(inType);
+            usage.write(outType);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcExpo&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcExpo&);
 };
@@ -54,6 +54,12 @@ class ProcFade: public Proc{
 
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            for (const auto type : types) {
+                usage.readWrite(type);
+            }
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcFade&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcFade&);
 
@@ -65,6 +65,12 @@ class ProcIndicator: public Proc {
         virtual void start() override;
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            for (const auto type : types) {
+                usage.readWrite(type);
+            }
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcIndicator&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcIndicator&);
 
@@ -36,6 +36,11 @@ class ProcMap: public Proc {
 
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.read(inType);
+            usage.write(outType);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcMap&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcMap&);
 };
@@ -46,6 +46,10 @@ class ProcNeutral: public Proc {
         virtual void start() override;
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.readWrite(type);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcNeutral&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcNeutral&);
 };
@@ -43,6 +43,11 @@ class ProcPeriodic : public Proc {
         virtual void start() override;
         virtual void step(const rcProc::StepInfo& info) override;
 
+        virtual void getSignalUsage(rcProc::SignalUsage& usage) const override {
+            usage.read(freqType);
+            usage.readWrite(outType);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcPeriodic&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcPeriodic&);
 };
@@ -57,6 +57,11 @@ class ProcSequence: public Proc {
         virtual void start() override;
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.read(inputType);
+            usage.write(outputType);
+        }
+
         friend ProcSequenceTest_Sequence_Test;
 
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcSequence&);
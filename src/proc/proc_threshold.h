@@ -41,6 +41,11 @@ class ProcThreshold: public Proc {
         virtual void start() override;
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.read(inType);
+            usage.write(outType);
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcThreshold&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcThreshold&);
 };
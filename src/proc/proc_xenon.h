@@ -54,6 +54,12 @@ class ProcXenon: public Proc {
         virtual void start() override;
         virtual void step(const StepInfo& info) override;
 
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            for (const auto type : types) {
+                usage.readWrite(type);
+            }
+        }
+
         friend SimpleOutStream& operator<<(::SimpleOutStream& out, const ProcXenon&);
         friend SimpleInStream& operator>>(::SimpleInStream& in, ProcXenon&);
 
@@ -4,16 +4,110 @@
 #
 # example usage: audio_tool.py --audio sample_config.json --cpp samples.cpp
 #
+# It can also encode a sample as IMA-ADPCM wav file (needs half the flash):
+#   audio_tool.py --adpcm input.wav output.wav
+#
 
 import argparse
 import datetime
 import pathlib
 import json
 import re
+import struct
+import wave
+
+ADPCM_BLOCK_SIZE = 256
+ADPCM_HEADER_SIZE = 4
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+
+
+def adpcm_samples(num_bytes, block_size):
+    """Number of samples in ADPCM blocks (like rcAudio::adpcmSamples).
+    """
+
+    rest = num_bytes % block_size
+    samples = (num_bytes // block_size) * ((block_size - ADPCM_HEADER_SIZE) * 2 + 1)
+    if rest >= ADPCM_HEADER_SIZE:
+        samples += 1 + (rest - ADPCM_HEADER_SIZE) * 2
+    return samples
+
+
+def sample_info(filename):
+    """Returns the SampleInfo initializer for a wav file.
+
+    Same checks as getWavSampleData() in wav_sample.cpp. Files it
+    doesn't understand get an unknown format and are parsed at runtime.
+    """
+
+    unknown = "{}"
+    try:
+        with open(filename, "rb") as wav_file:
+            content = wav_file.read()
+    except OSError:
+        return unknown
+
+    if len(content) < 12 or content[0:4] != b"RIFF" or content[8:12] != b"WAVE":
+        return unknown
+
+    fmt = None
+    num_samples = 0
+    pos = 12
+    while pos + 8 <= len(content):
+        name = content[pos:pos + 4]
+        length = struct.unpack("<I", content[pos + 4:pos + 8])[0]
+        pos += 8
+
+        if name == b"fmt ":
+            if length < 16:
+                return unknown
+            format_type, channels, _, _, block_align, bits = struct.unpack(
+                "<HHIIHH", content[pos:pos + 16])
+            if channels == 1 and format_type == 1 and bits == 8:
+                fmt = ("PCM", 0)
+            elif (channels == 1 and format_type == 0x11 and bits == 4 and
+                  block_align > ADPCM_HEADER_SIZE):
+                fmt = ("ADPCM", block_align)
+            else:
+                return unknown
+
+        elif name == b"fact":
+            if length >= 4:
+                num_samples = struct.unpack("<I", content[pos:pos + 4])[0]
+
+        elif name == b"data":
+            if fmt is None:
+                fmt = ("PCM", 0)
+            size = min(length, len(content) - pos)
+            if fmt[0] == "PCM":
+                num_samples = size
+            else:
+                max_samples = adpcm_samples(size, fmt[1])
+                num_samples = min(num_samples, max_samples) if num_samples else max_samples
+            return (f"{{.format = SampleInfo::{fmt[0]}, .blockSize = {fmt[1]}, "
+                    f".offset = {pos}, .size = {size}, .numSamples = {num_samples}}}")
+
+        pos += length
+    return unknown
 
 
 def output_cpp(defs_audio, out_file):
     """Outputs the code for the static audio list.
+
+    The position and format of the samples inside the wav files
+    are precomputed, so they don't have to be parsed when starting.
     """
 
     sample_symbols = []
@@ -28,10 +122,12 @@ def output_cpp(defs_audio, out_file):
                     )
 
             if "id" in audio:
+                info = sample_info(pathlib.Path(__file__).parent / audio["filename"])
                 samples.append(
                         f"  SampleFile{{.id = {{'{audio["id"][0]}', '{audio["id"][1]}', '{audio["id"][2]}'}},\n"
                         f"    .content = std::span{{_binary_{symbol}_start,\n"
-                        f"       static_cast<size_t>(_binary_{symbol}_end - _binary_{symbol}_start)}}\n"
+                        f"       static_cast<size_t>(_binary_{symbol}_end - _binary_{symbol}_start)}},\n"
+                        f"    .info = {info}\n"
                         f"  }}"
                         )
 
@@ -67,6 +163,90 @@ const std::span<const rcSamples::SampleFile>& rcSamples::getStaticSamples() {{
         file=out_file,
     )
 
+def encode_adpcm(samples):
+    """Encodes 16 bit samples to IMA-ADPCM blocks (like rcAudio::AdpcmEncoder).
+    """
+
+    samples_per_block = (ADPCM_BLOCK_SIZE - ADPCM_HEADER_SIZE) * 2 + 1
+    out = bytearray()
+    step_index = 0
+    for start in range(0, len(samples), samples_per_block):
+        block = samples[start:start + samples_per_block]
+        predictor = block[0]
+        out += struct.pack("<hBB", predictor, step_index, 0)
+
+        codes = []
+        for sample in block[1:]:
+            step = STEP_TABLE[step_index]
+            diff = sample - predictor
+            code = 0
+            if diff < 0:
+                code = 8
+                diff = -diff
+            if diff >= step:
+                code |= 4
+                diff -= step
+            if diff >= step >> 1:
+                code |= 2
+                diff -= step >> 1
+            if diff >= step >> 2:
+                code |= 1
+
+            # the predictor follows the decoder
+            delta = step >> 3
+            if code & 1:
+                delta += step >> 2
+            if code & 2:
+                delta += step >> 1
+            if code & 4:
+                delta += step
+            predictor = predictor - delta if code & 8 else predictor + delta
+            predictor = max(-32768, min(32767, predictor))
+            step_index = max(0, min(88, step_index + INDEX_TABLE[code]))
+            codes.append(code)
+
+        if len(codes) % 2:
+            codes.append(0)
+        for i in range(0, len(codes), 2):
+            out.append(codes[i] | (codes[i + 1] << 4))
+    return bytes(out)
+
+
+def output_adpcm(in_filename, out_filename):
+    """Converts an 8 or 16 bit mono PCM wav file to IMA-ADPCM.
+
+    The sample rate is not changed, so the input should already
+    have the rate of the controller.
+    """
+
+    with wave.open(in_filename, "rb") as wav:
+        if wav.getnchannels() != 1 or wav.getsampwidth() not in (1, 2):
+            exit(f"{in_filename}: only 8 or 16 bit mono files are supported")
+        rate = wav.getframerate()
+        frames = wav.readframes(wav.getnframes())
+
+    if len(frames) == wav.getnframes():
+        samples = [(value - 128) * 256 for value in frames]
+    else:
+        samples = list(struct.unpack(f"<{len(frames) // 2}h", frames))
+
+    data = encode_adpcm(samples)
+    samples_per_block = (ADPCM_BLOCK_SIZE - ADPCM_HEADER_SIZE) * 2 + 1
+    fmt = struct.pack("<HHIIHHHH", 0x11, 1, rate,
+                      rate * ADPCM_BLOCK_SIZE // samples_per_block,
+                      ADPCM_BLOCK_SIZE, 4, 2, samples_per_block)
+    fact = struct.pack("<I", len(samples))
+    padding = b"\0" if len(data) % 2 else b""
+
+    with open(out_filename, "wb") as out:
+        out.write(b"RIFF")
+        out.write(struct.pack("<I", 4 + 8 + len(fmt) + 8 + len(fact) + 8 + len(data) + len(padding)))
+        out.write(b"WAVE")
+        out.write(b"fmt " + struct.pack("<I", len(fmt)) + fmt)
+        out.write(b"fact" + struct.pack("<I", len(fact)) + fact)
+        out.write(b"data" + struct.pack("<I", len(data)) + data + padding)
+
+
 # --- main code
 
 parser = argparse.ArgumentParser(
@@ -87,8 +267,19 @@ parser.add_argument(
     type=argparse.FileType("w"),
     help="Create .cpp file for the audio list.",
 )
+parser.add_argument(
+    "--adpcm",
+    nargs=2,
+    metavar=("INPUT", "OUTPUT"),
+    help="Encode a PCM wav file as IMA-ADPCM wav file.",
+)
 
 args = parser.parse_args()
+
+if args.adpcm:
+    output_adpcm(args.adpcm[0], args.adpcm[1])
+    exit()
+
 defs_audio = json.load(args.audio)
 
 # ensure no duplicate IDs
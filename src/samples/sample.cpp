@@ -1,7 +1,7 @@
 /** The static sample list.
  *
  * This file is auto generated by audio_tool.py
- * 2025-05-05
+ * 2026-10-16
  *
  * Do not modify.
  *
@@ -92,151 +92,188 @@ extern const uint8_t _binary_silence_wav_end[];
 const SampleFile staticSamplesArray[]{
   SampleFile{.id = {'T', 'D', 'S'},
     .content = std::span{_binary_diesel_start_wav_start,
-       static_cast<size_t>(_binary_diesel_start_wav_end - _binary_diesel_start_wav_start)}
+       static_cast<size_t>(_binary_diesel_start_wav_end - _binary_diesel_start_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 25149, .numSamples = 25149}
   },
   SampleFile{.id = {'T', 'D', '1'},
     .content = std::span{_binary_diesel0i_wav_start,
-       static_cast<size_t>(_binary_diesel0i_wav_end - _binary_diesel0i_wav_start)}
+       static_cast<size_t>(_binary_diesel0i_wav_end - _binary_diesel0i_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1610, .numSamples = 1610}
   },
   SampleFile{.id = {'T', 'D', '2'},
     .content = std::span{_binary_diesel2i_wav_start,
-       static_cast<size_t>(_binary_diesel2i_wav_end - _binary_diesel2i_wav_start)}
+       static_cast<size_t>(_binary_diesel2i_wav_end - _binary_diesel2i_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1665, .numSamples = 1665}
   },
   SampleFile{.id = {'T', 'D', '3'},
     .content = std::span{_binary_diesel0r_wav_start,
-       static_cast<size_t>(_binary_diesel0r_wav_end - _binary_diesel0r_wav_start)}
+       static_cast<size_t>(_binary_diesel0r_wav_end - _binary_diesel0r_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 576, .numSamples = 576}
   },
   SampleFile{.id = {'T', 'D', '4'},
     .content = std::span{_binary_diesel9r_wav_start,
-       static_cast<size_t>(_binary_diesel9r_wav_end - _binary_diesel9r_wav_start)}
+       static_cast<size_t>(_binary_diesel9r_wav_end - _binary_diesel9r_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 725, .numSamples = 725}
   },
   SampleFile{.id = {'T', 'H', 'O'},
     .content = std::span{_binary_truck_horn_wav_start,
-       static_cast<size_t>(_binary_truck_horn_wav_end - _binary_truck_horn_wav_start)}
+       static_cast<size_t>(_binary_truck_horn_wav_end - _binary_truck_horn_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 6293, .numSamples = 6293}
   },
   SampleFile{.id = {'T', 'A', 'B'},
     .content = std::span{_binary_airbrake_wav_start,
-       static_cast<size_t>(_binary_airbrake_wav_end - _binary_airbrake_wav_start)}
+       static_cast<size_t>(_binary_airbrake_wav_end - _binary_airbrake_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 13650, .numSamples = 13650}
   },
   SampleFile{.id = {'T', 'R', 'E'},
     .content = std::span{_binary_reversing_wav_start,
-       static_cast<size_t>(_binary_reversing_wav_end - _binary_reversing_wav_start)}
+       static_cast<size_t>(_binary_reversing_wav_end - _binary_reversing_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 14599, .numSamples = 14599}
   },
   SampleFile{.id = {'C', 'I', 'N'},
     .content = std::span{_binary_indicator_wav_start,
-       static_cast<size_t>(_binary_indicator_wav_end - _binary_indicator_wav_start)}
+       static_cast<size_t>(_binary_indicator_wav_end - _binary_indicator_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 17690, .numSamples = 17690}
   },
   SampleFile{.id = {'C', 'H', 'O'},
     .content = std::span{_binary_beetle_horn_wav_start,
-       static_cast<size_t>(_binary_beetle_horn_wav_end - _binary_beetle_horn_wav_start)}
+       static_cast<size_t>(_binary_beetle_horn_wav_end - _binary_beetle_horn_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 5416, .numSamples = 5416}
   },
   SampleFile{.id = {'C', 'V', '1'},
     .content = std::span{_binary_beetle_start_wav_start,
-       static_cast<size_t>(_binary_beetle_start_wav_end - _binary_beetle_start_wav_start)}
+       static_cast<size_t>(_binary_beetle_start_wav_end - _binary_beetle_start_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 21568, .numSamples = 21568}
   },
   SampleFile{.id = {'C', 'V', '2'},
     .content = std::span{_binary_beetle1i_wav_start,
-       static_cast<size_t>(_binary_beetle1i_wav_end - _binary_beetle1i_wav_start)}
+       static_cast<size_t>(_binary_beetle1i_wav_end - _binary_beetle1i_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1547, .numSamples = 1547}
   },
   SampleFile{.id = {'C', 'V', '3'},
     .content = std::span{_binary_beetle9i_wav_start,
-       static_cast<size_t>(_binary_beetle9i_wav_end - _binary_beetle9i_wav_start)}
+       static_cast<size_t>(_binary_beetle9i_wav_end - _binary_beetle9i_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1525, .numSamples = 1525}
   },
   SampleFile{.id = {'C', 'V', '4'},
     .content = std::span{_binary_beetle1r_wav_start,
-       static_cast<size_t>(_binary_beetle1r_wav_end - _binary_beetle1r_wav_start)}
+       static_cast<size_t>(_binary_beetle1r_wav_end - _binary_beetle1r_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1032, .numSamples = 1032}
   },
   SampleFile{.id = {'C', 'V', '5'},
     .content = std::span{_binary_beetle9r_wav_start,
-       static_cast<size_t>(_binary_beetle9r_wav_end - _binary_beetle9r_wav_start)}
+       static_cast<size_t>(_binary_beetle9r_wav_end - _binary_beetle9r_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1099, .numSamples = 1099}
   },
   SampleFile{.id = {'S', 'i', '1'},
     .content = std::span{_binary_siren1_wav_start,
-       static_cast<size_t>(_binary_siren1_wav_end - _binary_siren1_wav_start)}
+       static_cast<size_t>(_binary_siren1_wav_end - _binary_siren1_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 14244, .numSamples = 14244}
   },
   SampleFile{.id = {'S', 'i', '2'},
     .content = std::span{_binary_siren2_wav_start,
-       static_cast<size_t>(_binary_siren2_wav_end - _binary_siren2_wav_start)}
+       static_cast<size_t>(_binary_siren2_wav_end - _binary_siren2_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 165171, .numSamples = 165171}
   },
   SampleFile{.id = {'S', 'i', '3'},
     .content = std::span{_binary_siren3_wav_start,
-       static_cast<size_t>(_binary_siren3_wav_end - _binary_siren3_wav_start)}
+       static_cast<size_t>(_binary_siren3_wav_end - _binary_siren3_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 2019, .numSamples = 2019}
   },
   SampleFile{.id = {'T', 'B', 'R'},
     .content = std::span{_binary_braking_wav_start,
-       static_cast<size_t>(_binary_braking_wav_end - _binary_braking_wav_start)}
+       static_cast<size_t>(_binary_braking_wav_end - _binary_braking_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 75869, .numSamples = 75869}
   },
   SampleFile{.id = {'T', 'C', 'O'},
     .content = std::span{_binary_coupling_wav_start,
-       static_cast<size_t>(_binary_coupling_wav_end - _binary_coupling_wav_start)}
+       static_cast<size_t>(_binary_coupling_wav_end - _binary_coupling_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 20313, .numSamples = 20313}
   },
   SampleFile{.id = {'T', 'R', 'A'},
     .content = std::span{_binary_rattle_squeek_wav_start,
-       static_cast<size_t>(_binary_rattle_squeek_wav_end - _binary_rattle_squeek_wav_start)}
+       static_cast<size_t>(_binary_rattle_squeek_wav_end - _binary_rattle_squeek_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 123880, .numSamples = 123880}
   },
   SampleFile{.id = {'T', 'S', 'T'},
     .content = std::span{_binary_steam_wav_start,
-       static_cast<size_t>(_binary_steam_wav_end - _binary_steam_wav_start)}
+       static_cast<size_t>(_binary_steam_wav_end - _binary_steam_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1998, .numSamples = 1998}
   },
   SampleFile{.id = {'T', 'S', 'w'},
     .content = std::span{_binary_steam_whistle_wav_start,
-       static_cast<size_t>(_binary_steam_whistle_wav_end - _binary_steam_whistle_wav_start)}
+       static_cast<size_t>(_binary_steam_whistle_wav_end - _binary_steam_whistle_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 8728, .numSamples = 8728}
   },
   SampleFile{.id = {'T', 'S', 'W'},
     .content = std::span{_binary_whistle_wav_start,
-       static_cast<size_t>(_binary_whistle_wav_end - _binary_whistle_wav_start)}
+       static_cast<size_t>(_binary_whistle_wav_end - _binary_whistle_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 27349, .numSamples = 27349}
   },
   SampleFile{.id = {'T', 'S', 'R'},
     .content = std::span{_binary_stroke_wav_start,
-       static_cast<size_t>(_binary_stroke_wav_end - _binary_stroke_wav_start)}
+       static_cast<size_t>(_binary_stroke_wav_end - _binary_stroke_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 15096, .numSamples = 15096}
   },
   SampleFile{.id = {'S', 'B', 'L'},
     .content = std::span{_binary_bell_wav_start,
-       static_cast<size_t>(_binary_bell_wav_end - _binary_bell_wav_start)}
+       static_cast<size_t>(_binary_bell_wav_end - _binary_bell_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 107470, .numSamples = 107470}
   },
   SampleFile{.id = {'S', 'H', 'O'},
     .content = std::span{_binary_horn_wav_start,
-       static_cast<size_t>(_binary_horn_wav_end - _binary_horn_wav_start)}
+       static_cast<size_t>(_binary_horn_wav_end - _binary_horn_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 67599, .numSamples = 67599}
   },
   SampleFile{.id = {'O', 'T', 'R'},
     .content = std::span{_binary_track_ratteling_wav_start,
-       static_cast<size_t>(_binary_track_ratteling_wav_end - _binary_track_ratteling_wav_start)}
+       static_cast<size_t>(_binary_track_ratteling_wav_end - _binary_track_ratteling_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 110074, .numSamples = 110074}
   },
   SampleFile{.id = {'O', '4', '4'},
     .content = std::span{_binary_440_wav_start,
-       static_cast<size_t>(_binary_440_wav_end - _binary_440_wav_start)}
+       static_cast<size_t>(_binary_440_wav_end - _binary_440_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 50, .numSamples = 50}
   },
   SampleFile{.id = {'O', 'L', 'F'},
     .content = std::span{_binary_low_fuel_wav_start,
-       static_cast<size_t>(_binary_low_fuel_wav_end - _binary_low_fuel_wav_start)}
+       static_cast<size_t>(_binary_low_fuel_wav_end - _binary_low_fuel_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 17012, .numSamples = 17012}
   },
   SampleFile{.id = {'O', 'S', '1'},
     .content = std::span{_binary_sendling_start_wav_start,
-       static_cast<size_t>(_binary_sendling_start_wav_end - _binary_sendling_start_wav_start)}
+       static_cast<size_t>(_binary_sendling_start_wav_end - _binary_sendling_start_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 26647, .numSamples = 26647}
   },
   SampleFile{.id = {'O', 'S', '2'},
     .content = std::span{_binary_sendling_idle_wav_start,
-       static_cast<size_t>(_binary_sendling_idle_wav_end - _binary_sendling_idle_wav_start)}
+       static_cast<size_t>(_binary_sendling_idle_wav_end - _binary_sendling_idle_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 3204, .numSamples = 3204}
   },
   SampleFile{.id = {'O', 'S', '3'},
     .content = std::span{_binary_sendling_idle2_wav_start,
-       static_cast<size_t>(_binary_sendling_idle2_wav_end - _binary_sendling_idle2_wav_start)}
+       static_cast<size_t>(_binary_sendling_idle2_wav_end - _binary_sendling_idle2_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 3324, .numSamples = 3324}
   },
   SampleFile{.id = {'O', 'S', '4'},
     .content = std::span{_binary_sendling_idle3_wav_start,
-       static_cast<size_t>(_binary_sendling_idle3_wav_end - _binary_sendling_idle3_wav_start)}
+       static_cast<size_t>(_binary_sendling_idle3_wav_end - _binary_sendling_idle3_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 9624, .numSamples = 9624}
   },
   SampleFile{.id = {'O', 'S', '5'},
     .content = std::span{_binary_sendling_rev_wav_start,
-       static_cast<size_t>(_binary_sendling_rev_wav_end - _binary_sendling_rev_wav_start)}
+       static_cast<size_t>(_binary_sendling_rev_wav_end - _binary_sendling_rev_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 1553, .numSamples = 1553}
   },
   SampleFile{.id = {'O', 'S', 'H'},
     .content = std::span{_binary_shot_wav_start,
-       static_cast<size_t>(_binary_shot_wav_end - _binary_shot_wav_start)}
+       static_cast<size_t>(_binary_shot_wav_end - _binary_shot_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 13211, .numSamples = 13211}
   },
   SampleFile{.id = {'O', 's', 'i'},
     .content = std::span{_binary_silence_wav_start,
-       static_cast<size_t>(_binary_silence_wav_end - _binary_silence_wav_start)}
+       static_cast<size_t>(_binary_silence_wav_end - _binary_silence_wav_start)},
+    .info = {.format = SampleInfo::PCM, .blockSize = 0, .offset = 44, .size = 4, .numSamples = 4}
   }
 };
 
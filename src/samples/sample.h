@@ -17,6 +17,24 @@ namespace rcSamples {
  */
 typedef std::array<char, 3> AudioId;
 
+/** Position and format of the samples inside a SampleFile.
+ *
+ *  Precomputed by audio_tool.py for the static samples and
+ *  at upload time for the converted dynamic samples, so the
+ *  WAV header doesn't have to be parsed when starting.
+ */
+struct SampleInfo {
+    static constexpr uint8_t UNKNOWN = 0u;  ///< the WAV header has to be parsed
+    static constexpr uint8_t PCM = 1u;  ///< unsigned 8 bit
+    static constexpr uint8_t ADPCM = 2u;  ///< IMA-ADPCM blocks (mono, 4 bit)
+
+    uint8_t format = UNKNOWN;
+    uint16_t blockSize = 0u;  ///< bytes per ADPCM block, 0 for PCM
+    uint32_t offset = 0u;  ///< start of the samples in the content
+    uint32_t size = 0u;  ///< size of the samples in bytes
+    uint32_t numSamples = 0u;
+};
+
 /** Struct for audio sample definition.
  *
  *  This might be raw audio data but usually it is
@@ -26,6 +44,7 @@ struct SampleFile {
 public:
     AudioId id;
     std::span<const uint8_t> content;  ///< sample file content/data
+    SampleInfo info = {};
 };
 
 /** List of compiled in samples.
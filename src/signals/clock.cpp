@@ -0,0 +1,40 @@
+/**
+ *  This file contains the time source used for
+ *  measurements within the rc_functions_controller project.
+ *
+ *  @file
+*/
+
+#include "clock.h"
+
+#include <atomic>
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+namespace rcSignals {
+
+static TimeUs defaultClock() {
+#ifdef ARDUINO
+    return esp_timer_get_time();
+#else
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+#endif
+}
+
+static std::atomic<ClockFunction> currentClock(defaultClock);
+
+TimeUs getTimeUs() {
+    return currentClock.load(std::memory_order_relaxed)();
+}
+
+void setClock(ClockFunction clock) {
+    currentClock.store((clock != nullptr) ? clock : defaultClock,
+        std::memory_order_relaxed);
+}
+
+} // namespace
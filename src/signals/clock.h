@@ -0,0 +1,38 @@
+/**
+ *  This file contains the time source used for
+ *  measurements within the rc_functions_controller project.
+ *
+ *  @file
+*/
+
+#ifndef _RC_CLOCK_H_
+#define _RC_CLOCK_H_
+
+#include <cstdint>
+
+namespace rcSignals {
+
+/** Monotonic time in micro seconds. */
+typedef int64_t TimeUs;
+
+/** A function returning the current time. */
+typedef TimeUs (*ClockFunction)();
+
+/** Returns the current monotonic time in micro seconds.
+ *
+ *  On target this is esp_timer_get_time(), on the host
+ *  std::chrono::steady_clock, unless a different clock was set.
+ */
+TimeUs getTimeUs();
+
+/** Replaces the clock used by getTimeUs().
+ *
+ *  Used e.g. by tests and simulations to provide a deterministic time.
+ *
+ *  @param clock The new clock or nullptr for the default clock.
+ */
+void setClock(ClockFunction clock);
+
+} // namespace
+
+#endif // _RC_CLOCK_H_
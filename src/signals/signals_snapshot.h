@@ -0,0 +1,73 @@
+/* RC engine functions controller for Arduino ESP32.
+ *
+ * Lock free exchange of signals between two tasks.
+ *
+ */
+
+#ifndef _RC_SIGNALS_SNAPSHOT_H_
+#define _RC_SIGNALS_SNAPSHOT_H_
+
+#include "signals.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rcSignals {
+
+/** Triple buffer for publishing the Signals from one task to another.
+ *
+ *  The main task publishes the signals after every step, the
+ *  audio render task reads the latest published signals.
+ *  Neither side ever blocks or sees a partially written
+ *  Signals struct.
+ *
+ *  Only one writer and one reader task are allowed.
+ */
+class SignalsSnapshot {
+    private:
+        static constexpr uint8_t INDEX_MASK = 0x03u;
+        static constexpr uint8_t FLAG_NEW = 0x04u;  ///< middle buffer has not been read yet
+
+        std::array<Signals, 3> buffers;
+
+        /** The buffer exchanged between writer and reader (plus FLAG_NEW). */
+        std::atomic<uint8_t> middle;
+        uint8_t back;  ///< The buffer written by the writer.
+        uint8_t front;  ///< The buffer read by the reader.
+
+    public:
+        SignalsSnapshot() :
+            middle(1u),
+            back(0u),
+            front(2u) {
+            for (auto& buffer : buffers) {
+                buffer.reset();
+            }
+        }
+
+        /** Publishes a new version of the signals.
+         *
+         *  Writer task only.
+         */
+        void publish(const Signals& signals) {
+            buffers[back] = signals;
+            back = middle.exchange(back | FLAG_NEW, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        /** Returns the latest published signals.
+         *
+         *  Reader task only. The reference stays valid until
+         *  the next call to read().
+         */
+        const Signals& read() {
+            if (middle.load(std::memory_order_relaxed) & FLAG_NEW) {
+                front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+            }
+            return buffers[front];
+        }
+};
+
+} // namespace
+
+#endif // _RC_SIGNALS_SNAPSHOT_H_
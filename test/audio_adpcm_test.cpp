@@ -0,0 +1,160 @@
+/** Tests for the audio_adpcm.cpp */
+
+#include "audio_adpcm.h"
+#include "audio_loop.h"
+#include "audio_simple.h"
+#include "signals.h"
+#include "proc.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+
+using namespace rcAudio;
+using namespace rcSignals;
+
+namespace {
+
+/** Creates 16 bit samples with a sine. */
+std::vector<int16_t> createSine(uint32_t num, float frequency, float amplitude) {
+    std::vector<int16_t> samples;
+    for (uint32_t i = 0u; i < num; i++) {
+        samples.push_back(static_cast<int16_t>(std::lround(amplitude *
+            std::sin(2.0f * std::numbers::pi_v<float> * frequency * i / SAMPLE_RATE))));
+    }
+    return samples;
+}
+
+std::vector<uint8_t> encode(const std::vector<int16_t>& samples) {
+    std::vector<uint8_t> out;
+    AdpcmEncoder encoder;
+    for (const auto sample : samples) {
+        encoder.add(sample, out);
+    }
+    encoder.finish(out);
+    return out;
+}
+
+/** Decodes the whole sample in one go. */
+std::vector<uint8_t> decode(const SampleData& sample) {
+    std::vector<uint8_t> buffer(sample.size());
+    SampleReader reader;
+    const uint8_t* data = reader.read(sample, 0u, buffer.data(), buffer.size());
+    return std::vector<uint8_t>(data, data + sample.size());
+}
+
+} // namespace
+
+TEST(AdpcmTest, Sizes) {
+    EXPECT_EQ(505u, adpcmSamplesPerBlock(ADPCM_BLOCK_SIZE));
+
+    EXPECT_EQ(0u, adpcmBytes(0u));
+    EXPECT_EQ(5u, adpcmBytes(2u));
+    EXPECT_EQ(256u, adpcmBytes(505u));
+    EXPECT_EQ(260u, adpcmBytes(506u));
+
+    EXPECT_EQ(0u, adpcmSamples(0u));
+    EXPECT_EQ(505u, adpcmSamples(256u));
+    EXPECT_EQ(506u, adpcmSamples(260u));
+
+    // the encoder writes exactly the computed size
+    for (const uint32_t num : {1u, 2u, 3u, 504u, 505u, 506u, 1500u}) {
+        EXPECT_EQ(adpcmBytes(num), encode(std::vector<int16_t>(num, 0)).size()) << num;
+    }
+}
+
+/** Encoding and decoding keeps the signal within a few 8 bit steps. */
+TEST(AdpcmTest, RoundTrip) {
+    const auto samples = createSine(3000u, 440.0f, 12000.0f);
+    const auto data = encode(samples);
+    EXPECT_EQ(adpcmBytes(3000u), data.size());
+
+    const auto sample = SampleData::adpcm(data, ADPCM_BLOCK_SIZE, samples.size());
+    EXPECT_TRUE(sample.isAdpcm());
+    EXPECT_EQ(3000u, sample.size());
+
+    // the step size needs a few samples to adapt at the beginning
+    const auto decoded = decode(sample);
+    for (size_t i = 16u; i < samples.size(); i++) {
+        EXPECT_NEAR(128.0f + samples[i] / 256.0f, decoded[i], 3.0f) << "sample " << i;
+    }
+}
+
+/** Random access with at() and read() gives the same samples as decoding everything. */
+TEST(AdpcmTest, Seek) {
+    const auto samples = createSine(2000u, 1000.0f, 20000.0f);
+    const auto data = encode(samples);
+    const auto sample = SampleData::adpcm(data, ADPCM_BLOCK_SIZE, samples.size());
+    const auto decoded = decode(sample);
+
+    // forward, backward and crossing blocks
+    SampleReader reader;
+    for (uint32_t i = 0u; i < sample.size(); i += 7u) {
+        EXPECT_EQ(decoded[i], reader.at(sample, i)) << "sample " << i;
+    }
+    for (uint32_t i = sample.size(); i-- > 0u;) {
+        EXPECT_EQ(decoded[i], reader.at(sample, i)) << "sample " << i;
+    }
+
+    // loop jumps
+    std::array<uint8_t, 100> buffer;
+    for (const uint32_t start : {0u, 480u, 1500u, 10u, 1010u, 505u}) {
+        const uint8_t* out = reader.read(sample, start, buffer.data(), buffer.size());
+        for (uint32_t i = 0u; i < buffer.size(); i++) {
+            EXPECT_EQ(decoded[start + i], out[i]) << "sample " << start + i;
+        }
+    }
+
+    // PCM samples are not copied
+    const SampleData pcm(decoded);
+    EXPECT_EQ(decoded.data() + 5, reader.read(pcm, 5u, buffer.data(), 10u));
+    EXPECT_EQ(decoded[1999], reader.at(pcm, 1999u));
+}
+
+/** The procs play ADPCM samples exactly like the decoded PCM samples. */
+TEST(AdpcmTest, Procs) {
+    const auto data = encode(createSine(1200u, 300.0f, 15000.0f));
+    const auto adpcmSample = SampleData::adpcm(data, ADPCM_BLOCK_SIZE, 1200u);
+    const auto decoded = decode(adpcmSample);
+    const SampleData pcmSample(decoded);
+
+    rcSignals::Signals signals;
+    signals.reset();
+    signals[SignalType::ST_THROTTLE] = RCSIGNAL_MAX;
+
+    const auto play = [&signals](rcProc::Proc& proc) {
+        std::vector<rcProc::AudioSample> buffer(700u);
+        std::vector<int16_t> result;
+        rcProc::StepInfo info = {
+            .deltaMs = 20U,
+            .signals = &signals,
+            .intervals = {
+                rcProc::SamplesInterval{.first = buffer.data(), .last = buffer.data() + 300},
+                rcProc::SamplesInterval{.first = buffer.data() + 300, .last = buffer.data() + 700}
+                }
+        };
+        proc.start();
+        for (int i = 0; i < 3; i++) {
+            for (auto& s : buffer) {
+                s.channel1 = 0;
+            }
+            proc.step(info);
+            for (const auto& s : buffer) {
+                result.push_back(s.channel1);
+            }
+        }
+        return result;
+    };
+
+    AudioSimple simplePcm(pcmSample, SignalType::ST_THROTTLE);
+    AudioSimple simpleAdpcm(adpcmSample, SignalType::ST_THROTTLE);
+    EXPECT_EQ(play(simplePcm), play(simpleAdpcm));
+
+    // the loop crosses the block boundary at 505
+    AudioLoop loopPcm(pcmSample, 400u, 900u, SignalType::ST_THROTTLE);
+    AudioLoop loopAdpcm(adpcmSample, 400u, 900u, SignalType::ST_THROTTLE);
+    EXPECT_EQ(play(loopPcm), play(loopAdpcm));
+}
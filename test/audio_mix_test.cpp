@@ -0,0 +1,197 @@
+/** Tests for the audio mixing kernels */
+
+#include "audio_mix.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace rcAudio;
+
+namespace {
+
+/** Per-sample reference, same as the per-sample loops in the audio procs. */
+void referenceMix(uint8_t in, rcProc::AudioSample* out, const Gains& gains) {
+    const int32_t sample = static_cast<int32_t>(in) - 128;
+    out->channel1 = saturate16(out->channel1 + ((sample * gains[0]) >> 15));
+    out->channel2 = saturate16(out->channel2 + ((sample * gains[1]) >> 15));
+}
+
+std::vector<uint8_t> randomSamples(size_t num, std::mt19937& gen) {
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> result(num);
+    for (auto& val : result) {
+        val = static_cast<uint8_t>(dist(gen));
+    }
+    return result;
+}
+
+/** Random stereo block, including values near the saturation limits. */
+std::vector<rcProc::AudioSample> randomBlock(size_t num, std::mt19937& gen) {
+    std::uniform_int_distribution<int> dist(INT16_MIN, INT16_MAX);
+    std::vector<rcProc::AudioSample> result(num);
+    for (auto& val : result) {
+        val.channel1 = static_cast<int16_t>(dist(gen));
+        val.channel2 = static_cast<int16_t>(dist(gen) / 256);
+    }
+    return result;
+}
+
+void expectEqual(const std::vector<rcProc::AudioSample>& expected,
+                 const std::vector<rcProc::AudioSample>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(expected[i].channel1, actual[i].channel1) << "index " << i;
+        EXPECT_EQ(expected[i].channel2, actual[i].channel2) << "index " << i;
+    }
+}
+
+} // namespace
+
+/** Tests rcAudio::mixBlock()
+ *
+ *  Output needs to be bit-exact with the per-sample loop.
+ */
+TEST(AudioMixTest, MixBlock) {
+    std::mt19937 gen(42);
+    const auto in = randomSamples(1000, gen);
+
+    for (const Gains gains : {Gains{GAIN_Q15_ONE, GAIN_Q15_ONE},
+                              Gains{toGainQ15(0.3f), toGainQ15(2.55f)},
+                              Gains{0, toGainQ15(-1.0f)},
+                              Gains{toGainQ15(2.55f * 10.0f), 1}}) {
+
+        auto expected = randomBlock(in.size(), gen);
+        auto actual = expected;
+
+        for (size_t i = 0; i < in.size(); i++) {
+            referenceMix(in[i], &expected[i], gains);
+        }
+        mixBlock(in.data(), actual.data(), in.size(), gains);
+
+        expectEqual(expected, actual);
+    }
+}
+
+/** Tests rcAudio::mixBlockRamp() and rcAudio::interpolateGains()
+ */
+TEST(AudioMixTest, MixBlockRamp) {
+    std::mt19937 gen(43);
+    const auto in = randomSamples(300, gen);
+
+    const Gains gainsStart{0, toGainQ15(2.0f)};
+    const Gains gainsEnd{toGainQ15(1.5f), toGainQ15(0.1f)};
+
+    auto expected = randomBlock(in.size(), gen);
+    auto actual = expected;
+
+    const int32_t num = static_cast<int32_t>(in.size());
+    for (int32_t i = 0; i < num; i++) {
+        const Gains gains{
+            gainsStart[0] + i * ((gainsEnd[0] - gainsStart[0]) / num),
+            gainsStart[1] + i * ((gainsEnd[1] - gainsStart[1]) / num)};
+        referenceMix(in[i], &expected[i], gains);
+    }
+    mixBlockRamp(in.data(), actual.data(), in.size(), gainsStart, gainsEnd);
+
+    expectEqual(expected, actual);
+
+    // -- interpolate
+    EXPECT_EQ(gainsStart, interpolateGains(gainsStart, gainsEnd, 0, 10));
+    EXPECT_EQ(gainsEnd, interpolateGains(gainsStart, gainsEnd, 10, 10));
+    const Gains mid{toGainQ15(0.75f), toGainQ15(2.0f) + (toGainQ15(0.1f) - toGainQ15(2.0f)) / 2};
+    EXPECT_EQ(mid, interpolateGains(gainsStart, gainsEnd, 5, 10));
+}
+
+/** Tests rcAudio::accumulateBlock() and rcAudio::saturateBlock()
+ *
+ *  Several samples are summed up and saturated only once.
+ */
+TEST(AudioMixTest, AccumulateBlock) {
+    std::mt19937 gen(44);
+    const size_t num = 200;
+    const auto in1 = randomSamples(num, gen);
+    const auto in2 = randomSamples(num, gen);
+    const Gains gains1{toGainQ15(100.0f), toGainQ15(0.5f)};
+    const Gains gains2{toGainQ15(-100.0f), toGainQ15(0.25f)};
+
+    auto expected = randomBlock(num, gen);
+    auto actual = expected;
+
+    for (size_t i = 0; i < num; i++) {
+        const int32_t s1 = static_cast<int32_t>(in1[i]) - 128;
+        const int32_t s2 = static_cast<int32_t>(in2[i]) - 128;
+        expected[i].channel1 = saturate16(expected[i].channel1 +
+            ((s1 * gains1[0]) >> 15) + ((s2 * gains2[0]) >> 15));
+        expected[i].channel2 = saturate16(expected[i].channel2 +
+            ((s1 * gains1[1]) >> 15) + ((s2 * gains2[1]) >> 15));
+    }
+
+    std::vector<int32_t> acc1(num, 0);
+    std::vector<int32_t> acc2(num, 0);
+    accumulateBlock(in1.data(), acc1.data(), acc2.data(), num, gains1);
+    accumulateBlock(in2.data(), acc1.data(), acc2.data(), num, gains2);
+    saturateBlock(acc1.data(), acc2.data(), actual.data(), num);
+
+    expectEqual(expected, actual);
+}
+
+/** Tests rcAudio::addBlock() */
+TEST(AudioMixTest, AddBlock) {
+    std::mt19937 gen(45);
+    const size_t num = 301;  // not a multiple of the vector size
+    const auto in = randomBlock(num, gen);
+    auto expected = randomBlock(num, gen);
+    expected[0] = {INT16_MAX, INT16_MIN};
+    expected[1] = {INT16_MIN, INT16_MAX};
+    auto actual = expected;
+
+    for (size_t i = 0; i < num; i++) {
+        expected[i].channel1 = saturate16(expected[i].channel1 + in[i].channel1);
+        expected[i].channel2 = saturate16(expected[i].channel2 + in[i].channel2);
+    }
+
+    addBlock(in.data(), actual.data(), num);
+    expectEqual(expected, actual);
+}
+
+/** Tests rcAudio::resampleBlock(), rcAudio::toPhaseStep() and
+ *  rcAudio::samplesUntilWrap()
+ */
+TEST(AudioMixTest, Resample) {
+    std::mt19937 gen(45);
+    const auto data = randomSamples(1234, gen);
+    const SampleData sample(data);
+
+    // -- step of exactly one sample reproduces the sample
+    const Phase stepOne = toPhaseStep(1.0 / sample.size());
+    std::vector<uint8_t> out(sample.size());
+    Phase phase = resampleBlock(sample, 0, stepOne, out.data(), out.size());
+    EXPECT_EQ(data, out);
+    EXPECT_LT(phase, stepOne);  // wrapped around to the start
+
+    // -- arbitrary (also backwards) steps are the same as the per-sample loop
+    for (const float step : {0.37f, 1.7f, -0.5f, 0.0f}) {
+        const Phase posStep = toPhaseStep(static_cast<double>(step) / sample.size());
+        Phase refPhase = 0x12345678;
+        phase = refPhase;
+
+        std::vector<uint8_t> expected(700);
+        for (auto& val : expected) {
+            val = data[(static_cast<uint64_t>(refPhase) * data.size()) >> 32];
+            refPhase += posStep;
+        }
+
+        phase = resampleBlock(sample, phase, posStep, out.data(), expected.size());
+        EXPECT_EQ(refPhase, phase);
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), out.begin()));
+    }
+
+    // -- wrap
+    EXPECT_EQ(10u, samplesUntilWrap(0, 0x10000000u, 10));  // no wrap within 10
+    EXPECT_EQ(16u, samplesUntilWrap(0, 0x10000000u, 100));
+    EXPECT_EQ(2u, samplesUntilWrap(0, 0x80000000u, 100));
+    EXPECT_EQ(1u, samplesUntilWrap(0xFFFFFFFFu, 1u, 100));
+    EXPECT_EQ(100u, samplesUntilWrap(0xFFFFFFFFu, 0u, 100));
+}
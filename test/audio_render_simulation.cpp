@@ -0,0 +1,312 @@
+/** Tool for simulating the audio rendering with host threads.
+ *
+ *  The tool emulates the tasks running on the target:
+ *
+ *  - the main task, stepping the procs every 20ms.
+ *    Optionally with a jitter (e.g. caused by bluetooth messages).
+ *  - the render task (only in "render" mode) rendering
+ *    the audio procs on demand.
+ *  - the DAC, consuming one ringbuffer block per block time and
+ *    counting underruns if no block was ready.
+ *
+ *  In "legacy" mode the audio procs are rendered in the main task.
+ *
+ *  With --profile the step times of the procs are printed.
+ *
+ *  @file
+ */
+
+#include "proc_storage.h"
+#include "audio_renderer.h"
+#include "audio_ringbuffer.h"
+#include "audio_stats.h"
+#include "audio.h"
+#include "signals.h"
+#include "signals_snapshot.h"
+
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace rcSignals;
+using namespace rcAudio;
+
+typedef std::chrono::steady_clock Clock;
+
+/** Results of one simulation run. */
+struct SimulationResult {
+    uint32_t controlSteps;
+    AudioStatsReport audio;
+};
+
+/** Prints the step times of the procs. */
+void printProfile(const ProcProfiler& profiler) {
+    auto printSummary = [](const StepTimesSummary& summary) {
+        cout << setw(6) << summary.minUs << setw(6) << summary.avgUs <<
+            setw(6) << summary.maxUs << setw(6) << summary.p99Us << endl;
+    };
+    auto typeName = [](ProcTypeId type) {
+        return string({static_cast<char>(type >> 8), static_cast<char>(type & 0xFF)});
+    };
+
+    cout << "  step us per proc:     min   avg   max   p99" << endl;
+    for (size_t i = 0u; i < profiler.getNumProcs(); i++) {
+        cout << "    " << setw(2) << i << " " << typeName(profiler.getProcType(i)) <<
+            setw(13) << " ";
+        printSummary(profiler.getProcSummary(i));
+    }
+    cout << "  step us per type:" << endl;
+    for (size_t i = 0u; i < profiler.getNumTypes(); i++) {
+        const auto summary = profiler.getTypeSummary(i);
+        cout << "    " << typeName(profiler.getType(i)) << setw(7) << summary.count <<
+            setw(9) << " ";
+        printSummary(summary);
+    }
+}
+
+/** Simulation of the main task, the render task and the DAC.
+ */
+class RenderSimulator {
+    private:
+        const bool renderMode;
+        const chrono::milliseconds simTime;
+        const chrono::milliseconds jitter;
+        const uint32_t jitterPeriod;
+
+        ProcStorage storage;
+        AudioRingbuffer ringbuffer;
+        AudioStats stats;
+        SignalsSnapshot snapshot;
+        AudioRenderer renderer;
+
+        std::atomic<bool> running;
+
+        /** Emulates the DAC clock.
+         *
+         *  Consumes one block per block time, counting underruns.
+         */
+        void dacThread() {
+            const auto blockTime = chrono::nanoseconds(
+                1000000000LL * AudioRingbuffer::BLOCK_SIZE / SAMPLE_RATE);
+
+            // wait for the first blocks before starting the DAC
+            while (running && ringbuffer.getNumFull() < 2) {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+
+            auto nextTime = Clock::now();
+            while (running) {
+                nextTime += blockTime;
+                this_thread::sleep_until(nextTime);
+
+                const uint8_t numFull = ringbuffer.getNumFull();
+                auto interval = ringbuffer.getFullBlocks();
+                stats.blockPlayed(interval, numFull, AudioStats::nowUs());
+                ringbuffer.setBlocksEmpty(interval);
+            }
+        }
+
+        /** Emulates the render task. */
+        void renderThread() {
+            while (running) {
+                if (renderer.render() == 0u) {
+                    this_thread::sleep_for(chrono::milliseconds(1));
+                }
+            }
+        }
+
+        /** Emulates the main task. */
+        void mainThread(SimulationResult* result) {
+            const auto stepTime = chrono::milliseconds(20);
+            std::mt19937 gen(1);
+            std::uniform_int_distribution<uint32_t> dist(0, jitterPeriod);
+
+            Signals signals;
+            auto nextTime = Clock::now();
+            const auto endTime = nextTime + simTime;
+            while (Clock::now() < endTime) {
+                nextTime += stepTime;
+                this_thread::sleep_until(nextTime);
+
+                signals.reset();
+                rcProc::StepInfo info = {
+                    .deltaMs = 20U,
+                    .signals = &signals,
+                    .intervals = {
+                        rcProc::SamplesInterval{.first = nullptr, .last = nullptr},
+                        rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+                };
+
+                if (renderMode) {
+                    storage.step(info);
+                    snapshot.publish(signals);
+
+                } else {
+                    info.intervals = {ringbuffer.getEmptyBlocks(),
+                        ringbuffer.getEmptyBlocks()};
+                    storage.step(info);
+                    for (const auto& interval : info.intervals) {
+                        stats.blocksFull(interval, AudioStats::nowUs());
+                        ringbuffer.setBlocksFull(interval);
+                    }
+                }
+                result->controlSteps++;
+
+                // e.g. a bluetooth message or a log output delaying the main task
+                if (jitterPeriod > 0 && dist(gen) == 0) {
+                    this_thread::sleep_for(jitter);
+                }
+            }
+        }
+
+    public:
+        RenderSimulator(bool renderModeVal,
+                        chrono::milliseconds simTimeVal,
+                        chrono::milliseconds jitterVal,
+                        uint32_t jitterPeriodVal,
+                        bool profile) :
+            renderMode(renderModeVal),
+            simTime(simTimeVal),
+            jitter(jitterVal),
+            jitterPeriod(jitterPeriodVal),
+            stats(ringbuffer),
+            renderer(storage, ringbuffer, snapshot, stats),
+            running(true) {
+
+            storage.setSeparateAudio(renderMode);
+            storage.setProfiling(profile);
+            storage.start();
+        }
+
+        /** Prints the step times, if profiling is on. */
+        void printProfile() {
+            if (storage.isProfiling()) {
+                std::lock_guard<std::mutex> lock(storage.getAudioMutex());
+                ::printProfile(storage.getProfiler());
+            }
+        }
+
+        SimulationResult run() {
+            SimulationResult result;
+            result.controlSteps = 0u;
+            AudioStatsSampler sampler(stats);
+
+            thread dac(&RenderSimulator::dacThread, this);
+            thread render;
+            if (renderMode) {
+                render = thread(&RenderSimulator::renderThread, this);
+            }
+
+            mainThread(&result);
+
+            running = false;
+            dac.join();
+            if (render.joinable()) {
+                render.join();
+            }
+
+            result.audio = sampler.sample(AudioStats::nowUs());
+            return result;
+        }
+};
+
+
+/** Creates the complete options description for the simulator.
+ */
+po::options_description createOptions() {
+
+    po::options_description optSimulation("Simulation options");
+    optSimulation.add_options()
+        ("help,h", "produce help message")
+        ("time",
+            po::value<uint32_t>()->default_value(5000),
+            "Simulation time per mode in milli seconds.")
+        ("mode,m",
+            po::value<std::string>()->default_value("both"),
+            "Render mode. One of \"legacy\", \"render\" or \"both\".")
+        ("jitter,j",
+            po::value<uint32_t>()->default_value(100),
+            "Delay of the main task in milli seconds, added randomly.")
+        ("period,p",
+            po::value<uint32_t>()->default_value(25),
+            "Average number of main task steps between two delays (0 for no delays).")
+        ("profile",
+            "Print the step times of the procs.")
+    ;
+
+    return optSimulation;
+}
+
+
+int main(int argc, char* argv[]) {
+
+    auto optAll = createOptions();
+    po::variables_map vm;
+
+    try {
+        po::store(po::parse_command_line(argc, argv, optAll), vm);
+        po::notify(vm);
+
+    } catch (po::error const& e) {
+        std::cerr << e.what() << std::endl;
+        optAll.print(std::cerr);
+        return 1;
+    }
+
+    if (vm.count("help")) {
+        cout << optAll << "\n";
+        return 1;
+    }
+
+    const auto mode = vm["mode"].as<string>();
+    if (mode != "legacy" && mode != "render" && mode != "both") {
+        cerr << "Invalid parameter for --mode: " << mode << endl;
+        return 1;
+    }
+
+    for (const bool renderMode : {false, true}) {
+        if ((mode == "legacy" && renderMode) || (mode == "render" && !renderMode)) {
+            continue;
+        }
+
+        RenderSimulator simulator(renderMode,
+            chrono::milliseconds(vm["time"].as<uint32_t>()),
+            chrono::milliseconds(vm["jitter"].as<uint32_t>()),
+            vm["period"].as<uint32_t>(),
+            vm.count("profile") > 0);
+        auto result = simulator.run();
+
+        const auto& audio = result.audio;
+        cout << (renderMode ? "render: " : "legacy: ") <<
+            "main steps: " << result.controlSteps <<
+            ", blocks rendered: " << audio.blocksRendered <<
+            ", blocks played: " << audio.blocksPlayed <<
+            ", underruns: " << audio.underruns <<
+            ", fill: " << audio.fillAvg / 100.0f << endl;
+
+        cout << "  latency ms:";
+        for (size_t i = 0u; i < audio.latency.size(); i++) {
+            if (i < LATENCY_BUCKET_LIMITS_US.size()) {
+                cout << " <" << LATENCY_BUCKET_LIMITS_US[i] / 1000u << ": ";
+            } else {
+                cout << " more: ";
+            }
+            cout << audio.latency[i];
+        }
+        cout << endl;
+
+        simulator.printProfile();
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+/** Tests for the AudioStats class */
+
+#include "audio_stats.h"
+#include "audio_ringbuffer.h"
+#include <gtest/gtest.h>
+
+using namespace rcAudio;
+
+/** Tests the counters and the latency histogram
+ *
+ *  Tests
+ *
+ *  - rcAudio::AudioStats::blocksFull()
+ *  - rcAudio::AudioStats::blockPlayed()
+ *  - rcAudio::AudioStatsSampler::sample()
+ */
+TEST(AudioStatsTest, Counters) {
+
+    AudioRingbuffer buffer;
+    AudioStats stats(buffer);
+    AudioStatsSampler sampler(stats);
+    sampler.sample(0u);
+
+    // -- render three blocks at 1ms
+    auto ivWrite = buffer.getEmptyBlocks(3u);
+    stats.blocksFull(ivWrite, 1000u);
+    buffer.setBlocksFull(ivWrite);
+
+    // -- play two of them with different latencies
+    auto ivRead1 = buffer.getFullBlocks();
+    stats.blockPlayed(ivRead1, 3u, 1000u + 5000u);  // first bucket
+    buffer.setBlocksEmpty(ivRead1);
+
+    auto ivRead2 = buffer.getFullBlocks();
+    stats.blockPlayed(ivRead2, 2u, 1000u + 25000u);  // third bucket
+    buffer.setBlocksEmpty(ivRead2);
+
+    // -- underrun
+    stats.blockPlayed(rcProc::SamplesInterval{ivRead2.last, ivRead2.last}, 0u, 30000u);
+    stats.countOverruns(2u);
+
+    auto report = sampler.sample(500000u);
+    EXPECT_EQ(500u, report.periodMs);
+    EXPECT_EQ(3u, report.blocksRendered);
+    EXPECT_EQ(2u, report.blocksPlayed);
+    EXPECT_EQ(1u, report.underruns);
+    EXPECT_EQ(2u, report.overruns);
+    EXPECT_EQ(166u, report.fillAvg);  // (3 + 2 + 0) / 3
+    EXPECT_EQ(4u, report.perSecond(report.overruns));
+
+    EXPECT_EQ(1u, report.latency[0]);
+    EXPECT_EQ(0u, report.latency[1]);
+    EXPECT_EQ(1u, report.latency[2]);
+
+    // -- the next period starts at zero
+    auto ivRead3 = buffer.getFullBlocks();
+    stats.blockPlayed(ivRead3, 1u, 1000u + 200000u);  // last bucket
+    buffer.setBlocksEmpty(ivRead3);
+
+    report = sampler.sample(1500000u);
+    EXPECT_EQ(1000u, report.periodMs);
+    EXPECT_EQ(0u, report.blocksRendered);
+    EXPECT_EQ(1u, report.blocksPlayed);
+    EXPECT_EQ(0u, report.underruns);
+    EXPECT_EQ(0u, report.overruns);
+    EXPECT_EQ(100u, report.fillAvg);
+    EXPECT_EQ(0u, report.latency[0]);
+    EXPECT_EQ(1u, report.latency[NUM_LATENCY_BUCKETS - 1]);
+
+    // -- the totals are monotonic
+    auto totals = stats.getTotals();
+    EXPECT_EQ(3u, totals.blocksPlayed);
+    EXPECT_EQ(1u, totals.underruns);
+}
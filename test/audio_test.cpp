@@ -197,3 +197,47 @@ TEST(AudioEngineTest, getVolumes) {
     EXPECT_NEAR(0.25f, volumes[3], 0.1f);
 }
 
+
+/** Tests the Q15 fixed-point helpers
+ *
+ *  - toGainQ15()
+ *  - saturate16()
+ *  - integer mixing in AudioSimple (volume and saturation)
+ */
+TEST(AudioTest, FixedPoint) {
+    EXPECT_EQ(GAIN_Q15_ONE, toGainQ15(1.0f));
+    EXPECT_EQ(GAIN_Q15_ONE / 2, toGainQ15(0.5f));
+    EXPECT_EQ(0, toGainQ15(0.0f));
+    EXPECT_EQ(83558, toGainQ15(2.55f));
+
+    EXPECT_EQ(INT16_MAX, saturate16(100000));
+    EXPECT_EQ(INT16_MIN, saturate16(-100000));
+    EXPECT_EQ(-1234, saturate16(-1234));
+
+    rcProc::AudioSample buffer[16];
+
+    rcSignals::Signals signals;
+    signals.reset();
+    signals[SignalType::ST_THROTTLE] = RCSIGNAL_MAX;
+
+    rcProc::StepInfo info = {
+        .deltaMs = 20U,
+        .signals = &signals,
+        .intervals = {
+            rcProc::SamplesInterval{.first = buffer, .last = buffer + 16},
+            rcProc::SamplesInterval{.first = buffer, .last = buffer}
+            }
+    };
+
+    for (uint8_t i = 0; i < 16; i++) {
+        buffer[i].channel1 = 0;
+        buffer[i].channel2 = INT16_MIN + 10;
+    }
+
+    AudioSimple sound(testSample, SignalType::ST_THROTTLE, {0.5f, 2.0f});
+    sound.step(info);
+
+    EXPECT_EQ((8 - 128) / 2, buffer[0].channel1);
+    EXPECT_EQ((17 - 128 - 1) / 2, buffer[15].channel1);  // rounded down
+    EXPECT_EQ(INT16_MIN, buffer[0].channel2);  // saturated
+}
@@ -3,6 +3,9 @@
 #include "audio_ringbuffer.h"
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <thread>
+
 using namespace rcAudio;
 
 /** Tests basic functionality for the ringbuffer
@@ -119,3 +122,99 @@ TEST(AudioRingbufferTest, SetBlocks) {
     EXPECT_EQ(0, buffer.getNumFull());
 }
 
+
+/** Tests limiting the number of blocks and the order contract
+ *
+ *  Tests
+ *
+ *  - rcAudio::AudioRingbuffer::getEmptyBlocks() with maxBlocks
+ *  - rcAudio::AudioRingbuffer::setBlocksFull() out of order
+ */
+TEST(AudioRingbufferTest, MaxBlocks) {
+
+    rcAudio::AudioRingbuffer buffer;
+
+    auto iv1 = buffer.getEmptyBlocks(2);
+    EXPECT_EQ(2 * buffer.BLOCK_SIZE, iv1.last - iv1.first);
+    auto iv2 = buffer.getEmptyBlocks(1);
+    EXPECT_EQ(buffer.BLOCK_SIZE, iv2.last - iv2.first);
+    EXPECT_EQ(iv1.last, iv2.first);
+    EXPECT_EQ(buffer.NUM_BLOCKS - 3, buffer.getNumEmpty());
+
+    // setting the second interval first is ignored
+    buffer.setBlocksFull(iv2);
+    EXPECT_EQ(0, buffer.getNumFull());
+
+    buffer.setBlocksFull(iv1);
+    buffer.setBlocksFull(iv2);
+    EXPECT_EQ(3, buffer.getNumFull());
+
+    // intervals can't be set full twice
+    buffer.setBlocksFull(iv1);
+    EXPECT_EQ(3, buffer.getNumFull());
+}
+
+/** Runs a producer and a consumer thread on the ringbuffer.
+ *
+ *  The producer writes a running block number into every sample.
+ *  The consumer verifies that it reads all blocks in order and
+ *  that they are not modified while being read.
+ *
+ *  Build with -DSANITIZE_THREAD=ON to run this under ThreadSanitizer.
+ */
+TEST(AudioRingbufferTest, ThreadedProducerConsumer) {
+
+    static constexpr int32_t NUM_TEST_BLOCKS = 20000;
+    rcAudio::AudioRingbuffer buffer;
+
+    std::thread producer([&buffer]() {
+        int32_t blockNr = 0;
+        uint32_t maxBlocks = 1;
+        while (blockNr < NUM_TEST_BLOCKS) {
+            // vary the number of requested blocks
+            maxBlocks = maxBlocks % 3 + 1;
+            auto iv = buffer.getEmptyBlocks(
+                std::min<uint32_t>(maxBlocks, NUM_TEST_BLOCKS - blockNr));
+            if (iv.first == iv.last) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (auto sample = iv.first; sample < iv.last; sample += buffer.BLOCK_SIZE) {
+                for (int32_t i = 0; i < buffer.BLOCK_SIZE; i++) {
+                    sample[i].channel1 = static_cast<int16_t>(blockNr);
+                    sample[i].channel2 = static_cast<int16_t>(i);
+                }
+                blockNr++;
+            }
+            buffer.setBlocksFull(iv);
+        }
+    });
+
+    int32_t errors = 0;
+    int32_t blockNr = 0;
+    while (blockNr < NUM_TEST_BLOCKS) {
+        auto iv = buffer.getFullBlocks();
+        if (iv.first == iv.last) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (iv.last - iv.first != buffer.BLOCK_SIZE) {
+            errors++;
+        }
+        for (int32_t i = 0; i < buffer.BLOCK_SIZE; i++) {
+            if (iv.first[i].channel1 != static_cast<int16_t>(blockNr) ||
+                iv.first[i].channel2 != i) {
+                errors++;
+            }
+        }
+        blockNr++;
+        buffer.setBlocksEmpty(iv);
+    }
+
+    producer.join();
+
+    EXPECT_EQ(0, errors);
+    EXPECT_EQ(0, buffer.getNumFull());
+}
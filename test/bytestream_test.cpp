@@ -116,6 +116,53 @@ TEST(SimpleOutStreamTest, Realloc) {
   free(stream.buffer().data());
 }
 
+/** Tests writing into a fixed buffer.
+ *
+ *  Tests
+ *  - rc::SimpleOutStream(span)
+ *  - rc::SimpleOutStream.fail()
+ */
+TEST(SimpleOutStreamTest, FixedBuffer) {
+
+  std::array<uint8_t, 3> buf = {0u};
+  SimpleOutStream stream(buf);
+
+  stream.writeUint16le(0x0201U);
+  EXPECT_FALSE(stream.fail());
+  stream.writeUint16le(0x0403U);
+
+  // no realloc, just the fail flag
+  EXPECT_TRUE(stream.fail());
+  EXPECT_EQ(buf.data(), stream.buffer().data());
+  EXPECT_EQ(3u, stream.buffer().size());
+  EXPECT_EQ(3u, stream.tellg());
+  EXPECT_EQ(0x01U, buf[0]);
+  EXPECT_EQ(0x02U, buf[1]);
+  EXPECT_EQ(0x03U, buf[2]);
+}
+
+/** Tests counting the bytes.
+ *
+ *  Tests
+ *  - rc::SimpleOutStream::counting()
+ */
+TEST(SimpleOutStreamTest, Counting) {
+
+  auto stream = SimpleOutStream::counting();
+  stream.writeUint32le(0x01020304U);
+  stream << static_cast<uint8_t>(5U);
+
+  EXPECT_EQ(5u, stream.tellg());
+  EXPECT_FALSE(stream.fail());
+  EXPECT_EQ(0u, stream.buffer().size());
+
+  // seeking back and forth (e.g. for a length field) is fine
+  stream.seekg(1u);
+  stream.writeUint8(0x01U);
+  stream.seekg(5u);
+  EXPECT_FALSE(stream.fail());
+}
+
 TEST(SimpleOutStreamTest, WritingOperation) {
 
   SimpleOutStream stream;
@@ -227,3 +274,42 @@ TEST(SimpleByteStreamTest, SignalTypes) {
 
   free(os.buffer().data());
 }
+
+/** Tests reading and writing the audio statistics
+ *
+ *  Tests
+ *
+ *  - operator<<(SimpleOutStream&, const rcAudio::AudioStatsReport&)
+ *  - operator>>(SimpleInStream&, rcAudio::AudioStatsReport&)
+ */
+TEST(SimpleByteStreamTest, AudioStatsReport) {
+
+  rcAudio::AudioStatsReport report1 = {
+      .periodMs = 1000u,
+      .underruns = 1u,
+      .overruns = 2u,
+      .blocksRendered = 86u,
+      .blocksPlayed = 85u,
+      .fillAvg = 350u,
+      .latency = {1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u}};
+
+  SimpleOutStream os;
+  os << report1;
+  EXPECT_EQ(4u * 5u + 2u + 4u * rcAudio::NUM_LATENCY_BUCKETS, os.tellg());
+  EXPECT_FALSE(os.fail());
+
+  std::span<const uint8_t> spc(os.buffer().data(), os.tellg());
+  SimpleInStream in(spc);
+  rcAudio::AudioStatsReport report2;
+  in >> report2;
+  EXPECT_FALSE(in.fail());
+  EXPECT_EQ(1000u, report2.periodMs);
+  EXPECT_EQ(1u, report2.underruns);
+  EXPECT_EQ(2u, report2.overruns);
+  EXPECT_EQ(86u, report2.blocksRendered);
+  EXPECT_EQ(85u, report2.blocksPlayed);
+  EXPECT_EQ(350u, report2.fillAvg);
+  EXPECT_EQ(report1.latency, report2.latency);
+
+  free(os.buffer().data());
+}
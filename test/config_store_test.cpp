@@ -0,0 +1,161 @@
+/** Tests for the ConfigStore class */
+
+#include "config_store.h"
+#include "proc_storage.h"
+#include "simple_byte_stream.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> makeConfig(uint8_t value, size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0u; i < size; i++) {
+        data[i] = static_cast<uint8_t>(value + i);
+    }
+    return data;
+}
+
+bool equals(std::span<const uint8_t> a, const std::vector<uint8_t>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+} // namespace
+
+/** Test:
+ *
+ *  - ConfigStore::save()
+ *  - ConfigStore::load()
+ *
+ *  Saves alternate between the slots, the newest one wins.
+ */
+TEST(ConfigStoreTest, SwitchSlots) {
+    ConfigStore store;
+    EXPECT_EQ(ConfigStore::NO_SLOT, store.activeSlot());
+    EXPECT_TRUE(store.load().empty());
+
+    const auto config1 = makeConfig(1u, 100u);
+    const auto config2 = makeConfig(2u, 300u);
+    const auto config3 = makeConfig(3u, 50u);
+
+    EXPECT_TRUE(store.save(config1));
+    EXPECT_EQ(0u, store.activeSlot());
+    EXPECT_TRUE(equals(store.load(), config1));
+
+    EXPECT_TRUE(store.save(config2));
+    EXPECT_EQ(1u, store.activeSlot());
+    EXPECT_TRUE(equals(store.load(), config2));
+
+    EXPECT_TRUE(store.save(config3));
+    EXPECT_EQ(0u, store.activeSlot());
+    store.rescan();
+    EXPECT_EQ(0u, store.activeSlot());
+    EXPECT_TRUE(equals(store.load(), config3));
+
+    // -- the same configuration is not written again
+    const uint32_t erases = store.getEraseCount();
+    EXPECT_TRUE(store.save(config3));
+    EXPECT_EQ(erases, store.getEraseCount());
+    EXPECT_EQ(0u, store.activeSlot());
+
+    // -- too large
+    EXPECT_FALSE(store.save(std::vector<uint8_t>(store.maxSize() + 1u)));
+    EXPECT_TRUE(equals(store.load(), config3));
+}
+
+/** A save interrupted by a power loss (or a broken slot) falls back
+ *  to the previous configuration.
+ */
+TEST(ConfigStoreTest, PowerLoss) {
+    ConfigStore store;
+    const auto config1 = makeConfig(1u, 200u);
+    const auto config2 = makeConfig(2u, 200u);
+    const uint32_t slotSize = ConfigStore::HOST_SIZE / ConfigStore::NUM_SLOTS;
+
+    ASSERT_TRUE(store.save(config1));
+    ASSERT_TRUE(store.save(config2));
+    ASSERT_EQ(1u, store.activeSlot());
+
+    // -- header not written (power loss after writing the data)
+    auto raw = store.raw();
+    const auto header = raw.subspan(slotSize, sizeof(ConfigStore::SlotHeader));
+    const std::vector<uint8_t> backup(header.begin(), header.end());
+    std::fill(header.begin(), header.end(), 0xFFu);
+    store.rescan();
+    EXPECT_EQ(0u, store.activeSlot());
+    EXPECT_TRUE(equals(store.load(), config1));
+
+    // -- data partially written
+    std::copy(backup.begin(), backup.end(), raw.begin() + slotSize);
+    store.rescan();
+    EXPECT_EQ(1u, store.activeSlot());
+    raw[slotSize + sizeof(ConfigStore::SlotHeader) + 150u] = 0xFFu;
+    store.rescan();
+    EXPECT_EQ(0u, store.activeSlot());
+    EXPECT_TRUE(equals(store.load(), config1));
+
+    // -- the next save overwrites the broken slot
+    const auto config3 = makeConfig(3u, 10u);
+    EXPECT_TRUE(store.save(config3));
+    EXPECT_EQ(1u, store.activeSlot());
+    EXPECT_TRUE(equals(store.load(), config3));
+
+    // -- both broken
+    raw[sizeof(ConfigStore::SlotHeader)] ^= 0x01u;
+    raw[slotSize + sizeof(ConfigStore::SlotHeader)] ^= 0x01u;
+    store.rescan();
+    EXPECT_EQ(ConfigStore::NO_SLOT, store.activeSlot());
+    EXPECT_TRUE(store.load().empty());
+}
+
+/** The host store can be backed by a file. */
+TEST(ConfigStoreTest, File) {
+    const std::string fileName = testing::TempDir() + "config_store_test.bin";
+    std::remove(fileName.c_str());
+
+    const auto config1 = makeConfig(1u, 123u);
+    {
+        ConfigStore store(fileName);
+        EXPECT_TRUE(store.load().empty());
+        EXPECT_TRUE(store.save(config1));
+    }
+    {
+        ConfigStore store(fileName);
+        EXPECT_TRUE(equals(store.load(), config1));
+    }
+    std::remove(fileName.c_str());
+}
+
+/** Test:
+ *
+ *  - ProcStorage::saveTo()
+ *  - ProcStorage::loadFrom()
+ */
+TEST(ConfigStoreTest, ProcStorage) {
+    ConfigStore store;
+    ProcStorage storage;
+
+    EXPECT_FALSE(storage.loadFrom(store));
+    ASSERT_TRUE(storage.saveTo(store));
+
+    SimpleOutStream expected;
+    storage.serialize(expected);
+    EXPECT_EQ(expected.tellg(), store.load().size());
+
+    ProcStorage storage2;
+    EXPECT_TRUE(storage2.loadFrom(store));
+    SimpleOutStream loaded;
+    storage2.serialize(loaded);
+    ASSERT_EQ(expected.tellg(), loaded.tellg());
+    EXPECT_TRUE(std::equal(loaded.buffer().begin(), loaded.buffer().begin() + loaded.tellg(),
+        expected.buffer().begin()));
+
+    free(expected.buffer().data());
+    free(loaded.buffer().data());
+}
@@ -1,7 +1,10 @@
 /** Tests for the curve classes */
 
 #include "curve.h"
+#include "power_curves.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 
 namespace rcProc {
 
@@ -26,4 +29,56 @@ TEST(CurveTest, LinearCurve) {
     EXPECT_EQ(4.0, curve.map(3.0f));
 }
 
+/** Test UniformCurve::map with a curve not on the sample grid */
+TEST(CurveTest, UniformCurve) {
+
+    constexpr Curve<3> curve{
+        .points={
+            CurvePoint{1.0f, 2.0f},
+            CurvePoint{1.5f, 4.0f},
+            CurvePoint{3.0f, 1.0f}
+        }};
+    constexpr UniformCurve<5> lut(curve);
+
+    // the samples are exact
+    EXPECT_FLOAT_EQ(2.0f, lut.map(1.0f));
+    EXPECT_FLOAT_EQ(4.0f, lut.map(1.5f));
+    EXPECT_FLOAT_EQ(3.0f, lut.map(2.0f));
+    EXPECT_FLOAT_EQ(1.0f, lut.map(3.0f));
+
+    // linear between the samples
+    EXPECT_NEAR(3.5f, lut.map(1.75f), 0.001f);
+    EXPECT_NEAR(1.5f, lut.map(2.75f), 0.001f);
+
+    // mapping outside the curve
+    EXPECT_FLOAT_EQ(2.0f, lut.map(0.0f));
+    EXPECT_FLOAT_EQ(1.0f, lut.map(4.0f));
+
+    // default is flat
+    constexpr UniformCurve<2> flat;
+    EXPECT_FLOAT_EQ(0.0f, flat.map(0.5f));
+}
+
+/** Test that the power lookup tables match the power curves. */
+TEST(CurveTest, PowerLut) {
+
+    auto expectSame = [](const auto& curve, const auto& lut) {
+        float maxError = 0.0f;
+        for (int i = -100; i <= 1100; i++) {
+            const float in = i / 1000.0f;
+            maxError = std::max(maxError, std::abs(curve.map(in) - lut.map(in)));
+        }
+        EXPECT_LT(maxError, 0.0001f);
+    };
+
+    expectSame(rcEngine::powerCurveElectric, rcEngine::powerLutElectric);
+    expectSame(rcEngine::powerCurvePetrolTwinTurbo, rcEngine::powerLutPetrolTwinTurbo);
+    expectSame(rcEngine::powerCurveDiesel, rcEngine::powerLutDiesel);
+    expectSame(rcEngine::powerCurvePetrol, rcEngine::powerLutPetrol);
+    expectSame(rcEngine::powerCurvePetrolTurbo, rcEngine::powerLutPetrolTurbo);
+    expectSame(rcEngine::powerCurveMotorBrake, rcEngine::powerLutMotorBrake);
+    expectSame(rcEngine::powerCurveSteam, rcEngine::powerLutSteam);
+    expectSame(rcEngine::powerCurveTurbine, rcEngine::powerLutTurbine);
+}
+
 } // namespace
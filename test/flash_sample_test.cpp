@@ -3,6 +3,9 @@
 #include "flash_sample.h"
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace FlashSample;
 
 /** Unit test for FlashSingleton
@@ -50,6 +53,141 @@ TEST(FlashSampleTest, FlashSingleton) {
 }
 
 
+namespace {
+
+/** Creates test data for num sectors.
+ *
+ *  The content of every byte depends on its position and the pattern.
+ */
+std::vector<uint8_t> createSectors(uint16_t num, uint8_t pattern) {
+    std::vector<uint8_t> data(num * SPI_FLASH_SEC_SIZE);
+    for (size_t i = 0u; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 7u + i / 251u + pattern);
+    }
+    return data;
+}
+
+/** Writes the chunk (offset relative to the first sector) like SampleBlock::setData(). */
+void writeChunk(uint16_t first, uint32_t offset, std::span<const uint8_t> data) {
+    auto& flash = FlashSingleton::getInstance();
+    while (!data.empty()) {
+        const auto written = flash.setData(first + offset / SPI_FLASH_SEC_SIZE,
+            offset % SPI_FLASH_SEC_SIZE, data);
+        ASSERT_GT(written, 0u);
+        offset += written;
+        data = data.subspan(written);
+    }
+}
+
+void expectFlash(uint16_t first, const std::vector<uint8_t>& expected) {
+    const uint8_t* flashData = static_cast<const uint8_t*>(
+        FlashSingleton::getInstance().data(first));
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), flashData));
+}
+
+} // namespace
+
+/** The write-back cache of FlashSingleton
+ *
+ *  counts the flash operations for typical upload patterns.
+ */
+TEST(FlashSampleTest, WriteBackCache) {
+    auto& flash = FlashSingleton::getInstance();
+    flash.flush();
+
+    // -- one sample in order: one erase for all sectors, nothing read
+    {
+        const auto data = createSectors(3u, 1u);
+        flash.resetStatistics();
+        for (uint32_t offset = 0u; offset < data.size(); offset += 500u) {
+            writeChunk(2u, offset, std::span<const uint8_t>(data).subspan(
+                offset, std::min<size_t>(500u, data.size() - offset)));
+        }
+        EXPECT_EQ(0u, flash.getStatistics().eraseOperations);
+        flash.flush();
+        EXPECT_EQ(1u, flash.getStatistics().eraseOperations);
+        EXPECT_EQ(3u, flash.getStatistics().sectorsErased);
+        EXPECT_EQ(0u, flash.getStatistics().sectorsRead);
+        expectFlash(2u, data);
+    }
+
+    // -- two samples interleaved (a single buffer would erase for every chunk)
+    {
+        const auto data1 = createSectors(2u, 2u);
+        const auto data2 = createSectors(2u, 3u);
+        flash.resetStatistics();
+        for (uint32_t offset = 0u; offset < data1.size(); offset += 300u) {
+            const size_t size = std::min<size_t>(300u, data1.size() - offset);
+            writeChunk(1u, offset, std::span<const uint8_t>(data1).subspan(offset, size));
+            writeChunk(6u, offset, std::span<const uint8_t>(data2).subspan(offset, size));
+        }
+        flash.flush();
+        EXPECT_EQ(2u, flash.getStatistics().eraseOperations);
+        EXPECT_EQ(4u, flash.getStatistics().sectorsErased);
+        EXPECT_EQ(0u, flash.getStatistics().sectorsRead);
+        expectFlash(1u, data1);
+        expectFlash(6u, data2);
+    }
+
+    // -- chunks in reverse order
+    {
+        const auto data = createSectors(2u, 4u);
+        flash.resetStatistics();
+        for (uint32_t offset = data.size(); offset > 0u; offset -= 512u) {
+            writeChunk(3u, offset - 512u, std::span<const uint8_t>(data).subspan(offset - 512u, 512u));
+        }
+        flash.flush();
+        EXPECT_EQ(1u, flash.getStatistics().eraseOperations);
+        EXPECT_EQ(0u, flash.getStatistics().sectorsRead);
+        expectFlash(3u, data);
+    }
+
+    // -- more sectors than the cache: complete sectors are evicted together
+    {
+        const auto data = createSectors(8u, 5u);
+        flash.resetStatistics();
+        for (uint32_t offset = 0u; offset < data.size(); offset += 1000u) {
+            writeChunk(1u, offset, std::span<const uint8_t>(data).subspan(
+                offset, std::min<size_t>(1000u, data.size() - offset)));
+        }
+        flash.flush();
+        EXPECT_EQ(2u, flash.getStatistics().eraseOperations);
+        EXPECT_EQ(8u, flash.getStatistics().sectorsErased);
+        EXPECT_EQ(0u, flash.getStatistics().sectorsRead);
+        expectFlash(1u, data);
+    }
+
+    // -- partial writes keep the rest of the sector
+    {
+        auto data = createSectors(1u, 6u);
+        writeChunk(4u, 0u, data);
+        flash.flush();
+
+        const std::vector<uint8_t> patch(100u, 0x55u);
+        flash.resetStatistics();
+        writeChunk(4u, 1000u, patch);
+        writeChunk(4u, 3000u, patch);  // with a gap
+        flash.flush();
+        EXPECT_EQ(1u, flash.getStatistics().eraseOperations);
+        EXPECT_EQ(1u, flash.getStatistics().sectorsRead);
+
+        std::copy(patch.begin(), patch.end(), data.begin() + 1000);
+        std::copy(patch.begin(), patch.end(), data.begin() + 3000);
+        expectFlash(4u, data);
+    }
+
+    // -- a reset of a cached sector is not undone by the write back
+    writeChunk(5u, 100u, std::vector<uint8_t>(10u, 0x11u));
+    flash.reset(5u);
+    flash.flush();
+    EXPECT_EQ(0u, static_cast<const uint8_t*>(flash.data(5u))[0]);
+
+    for (uint16_t i = 0u; i < flash.getMaxSectors(); i++) {
+        flash.reset(i);
+    }
+}
+
+
 /** Unit test for SampleBlock
  *
  *  tests
@@ -71,13 +209,13 @@ TEST(FlashSampleTest, SampleBlock) {
 
     // -- first, addBlock
     ASSERT_EQ(nullptr, SampleBlock::first());
-    auto block1 = SampleBlock::addBlock(rcSamples::AudioId({'a', 'b', 'c'}), 100);
+    auto block1 = SampleBlock::addBlock(0u, rcSamples::AudioId({'a', 'b', 'c'}), 100, 1u);
     flash.flush();
     ASSERT_NE(nullptr, block1);
     EXPECT_EQ(block1, SampleBlock::first());
 
     // block to big
-    auto block5 = SampleBlock::addBlock(rcSamples::AudioId({'x', 'y', 'z'}), 10000000);
+    auto block5 = SampleBlock::addBlock(1u, rcSamples::AudioId({'x', 'y', 'z'}), 10000000, 2u);
     flash.flush();
     ASSERT_EQ(nullptr, block5);
 
@@ -92,7 +230,7 @@ TEST(FlashSampleTest, SampleBlock) {
     EXPECT_EQ(100, file.content.size());
 
     // -- setData
-    auto block2 = SampleBlock::addBlock(rcSamples::AudioId({'A', 'B', 'C'}), 5500);
+    auto block2 = SampleBlock::addBlock(1u, rcSamples::AudioId({'A', 'B', 'C'}), 5500, 2u);
     ASSERT_NE(nullptr, block2);
     EXPECT_EQ(block2, block1->next()); // block can be used immediately
     EXPECT_EQ(nullptr, block2->next());
@@ -138,8 +276,8 @@ TEST(FlashSampleTest, SampleStorage) {
     flash.reset(3);
     flash.reset(4);
 
-    SampleBlock::addBlock(rcSamples::AudioId({'a', 'b', 'c'}), 100);
-    SampleBlock::addBlock(rcSamples::AudioId({'A', 'B', 'C'}), 200);
+    SampleBlock::addBlock(0u, rcSamples::AudioId({'a', 'b', 'c'}), 100, 1u);
+    SampleBlock::addBlock(1u, rcSamples::AudioId({'A', 'B', 'C'}), 200, 2u);
 
     SampleStorage storage = SampleStorage();
 
@@ -180,3 +318,198 @@ TEST(FlashSampleTest, SampleStorage) {
     EXPECT_EQ(flash.getMaxSectors(), storage.sectorsFree());
 }
 
+
+namespace {
+
+/** Sample data that depends on the ID, so a mix up is noticed. */
+std::vector<uint8_t> createSample(const rcSamples::AudioId& id, uint32_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0u; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 3u + id[0] + id[1] * 7u);
+    }
+    return data;
+}
+
+void addSample(SampleStorage& storage, const rcSamples::AudioId& id, uint32_t size) {
+    ASSERT_TRUE(storage.addId(id, size));
+    storage.setData(id, 0u, createSample(id, size));
+    storage.flush();
+}
+
+void expectSample(const SampleStorage& storage, const rcSamples::AudioId& id, uint32_t size) {
+    const auto files = storage.getFiles();
+    const auto file = std::find_if(files.begin(), files.end(),
+        [&id](const rcSamples::SampleFile& f) { return f.id == id; });
+    ASSERT_NE(files.end(), file) << id[0] << id[1] << id[2];
+    const auto expected = createSample(id, size);
+    ASSERT_EQ(size, file->content.size());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), file->content.begin()))
+        << id[0] << id[1] << id[2];
+}
+
+uint16_t sectorOf(const SampleStorage& storage, const rcSamples::AudioId& id) {
+    const auto& flash = FlashSingleton::getInstance();
+    for (const auto& file : storage.getFiles()) {
+        if (file.id == id) {
+            return flash.getIndex(file.content.data());
+        }
+    }
+    return flash.getMaxSectors();
+}
+
+} // namespace
+
+/** The log structure of SampleStorage
+ *
+ *  tests
+ *  - SampleStorage::addId() replacing a sample
+ *  - SampleStorage::remove()
+ *  - reading the blocks again (versions, log head)
+ */
+TEST(FlashSampleTest, SampleStorageLog) {
+    auto& flash = FlashSingleton::getInstance();
+    const uint32_t size = 5000u;  // two sectors
+
+    SampleStorage storage;
+    storage.reset();
+
+    const rcSamples::AudioId a({'l', 'o', 'a'});
+    const rcSamples::AudioId b({'l', 'o', 'b'});
+    const rcSamples::AudioId c({'l', 'o', 'c'});
+    addSample(storage, a, size);
+    addSample(storage, b, size);
+    addSample(storage, c, size);
+    EXPECT_EQ(6u, storage.sectorsUsed());
+
+    // -- replacing b is appended, a and c are not touched
+    const uint16_t sectorA = sectorOf(storage, a);
+    const uint16_t sectorB = sectorOf(storage, b);
+    const uint16_t sectorC = sectorOf(storage, c);
+    const uint32_t erasesA = flash.getEraseCount(sectorA);
+    const uint32_t erasesC = flash.getEraseCount(sectorC);
+    flash.resetStatistics();
+
+    addSample(storage, b, size - 100u);
+    EXPECT_EQ(3u, storage.getFiles().size());
+    EXPECT_EQ((sectorC + 2u) % flash.getMaxSectors(), sectorOf(storage, b));
+    expectSample(storage, a, size);
+    expectSample(storage, b, size - 100u);
+    expectSample(storage, c, size);
+    EXPECT_EQ(6u, storage.sectorsUsed());
+
+    // header and data of the first sector, the second sector
+    EXPECT_EQ(3u, flash.getStatistics().sectorsErased);
+    EXPECT_EQ(erasesA, flash.getEraseCount(sectorA));
+    EXPECT_EQ(erasesC, flash.getEraseCount(sectorC));
+
+    // the old version is only marked deleted
+    const SampleBlock* oldB = SampleBlock::at(sectorB);
+    ASSERT_NE(nullptr, oldB);
+    EXPECT_FALSE(oldB->isLive());
+
+    // -- remove
+    EXPECT_TRUE(storage.remove(a));
+    EXPECT_FALSE(storage.remove(a));
+    EXPECT_EQ(2u, storage.getFiles().size());
+    EXPECT_EQ(4u, storage.sectorsUsed());
+
+    // -- read again: same samples in the same order, the log continues
+    {
+        SampleStorage reread;
+        auto files = reread.getFiles();
+        ASSERT_EQ(2u, files.size());
+        EXPECT_EQ(c, files[0].id);
+        EXPECT_EQ(b, files[1].id);
+
+        const rcSamples::AudioId d({'l', 'o', 'd'});
+        addSample(reread, d, size);
+        EXPECT_EQ((sectorOf(reread, b) + 2u) % flash.getMaxSectors(), sectorOf(reread, d));
+        ASSERT_TRUE(reread.remove(d));
+    }
+
+    // -- power loss while replacing: the newer version wins
+    {
+        const uint16_t free = (sectorOf(storage, b) + 2u) % flash.getMaxSectors();
+        ASSERT_NE(nullptr, SampleBlock::addBlock(free, c, 10u, 1000u));
+
+        SampleStorage reread;
+        auto files = reread.getFiles();
+        ASSERT_EQ(2u, files.size());
+        EXPECT_EQ(b, files[0].id);
+        EXPECT_EQ(c, files[1].id);
+        EXPECT_EQ(10u, files[1].content.size());
+        EXPECT_FALSE(SampleBlock::at(sectorC)->isLive());
+    }
+
+    SampleStorage().reset();
+}
+
+/** SampleStorage::compact() coalesces the free sectors. */
+TEST(FlashSampleTest, SampleStorageCompact) {
+    auto& flash = FlashSingleton::getInstance();
+    const uint16_t maxSectors = flash.getMaxSectors();
+
+    // -- every other pair of sectors used
+    SampleStorage().reset();
+    std::vector<rcSamples::AudioId> ids;
+    for (uint16_t sector = 0u; sector + 2u <= maxSectors; sector += 4u) {
+        const rcSamples::AudioId id({'c', static_cast<char>('a' + sector / 4u), 'x'});
+        const uint32_t size = 5000u;
+        const SampleBlock* block = SampleBlock::addBlock(sector, id, size, 100u + sector);
+        ASSERT_NE(nullptr, block);
+        block->setData(0u, createSample(id, size));
+        ids.push_back(id);
+    }
+    flash.flush();
+
+    SampleStorage storage;
+    EXPECT_EQ(ids.size(), storage.getFiles().size());
+    EXPECT_EQ(2u, storage.largestFree());
+    EXPECT_EQ(maxSectors / 2u, storage.sectorsFree());
+
+    // -- a large sample doesn't fit without compaction, adding doesn't compact
+    const rcSamples::AudioId large({'b', 'i', 'g'});
+    const uint32_t largeSize = 8u * SPI_FLASH_SEC_SIZE;
+    EXPECT_FALSE(storage.addId(large, largeSize));
+    EXPECT_EQ(2u, storage.largestFree());
+    for (const auto& id : ids) {
+        expectSample(storage, id, 5000u);
+    }
+
+    while (storage.largestFree() < SampleBlock::sectorsFor(largeSize)) {
+        ASSERT_TRUE(storage.compact());
+    }
+    addSample(storage, large, largeSize);
+    expectSample(storage, large, largeSize);
+    for (const auto& id : ids) {
+        expectSample(storage, id, 5000u);
+    }
+    ASSERT_TRUE(storage.remove(large));
+
+    // -- compact everything, the old copy stays readable
+    uint32_t moves = 0u;
+    SampleMove move;
+    while (storage.compact(&move)) {
+        ASSERT_NE(nullptr, move.to);
+        EXPECT_EQ(5000u, move.from.size());
+        EXPECT_TRUE(std::equal(move.from.begin(), move.from.end(), move.to));
+        moves++;
+        ASSERT_LT(moves, 100u);
+    }
+    EXPECT_LT(0u, moves);
+    EXPECT_EQ(maxSectors / 2u, storage.sectorsFree());
+    EXPECT_EQ(storage.sectorsFree(), storage.largestFree());
+    for (const auto& id : ids) {
+        expectSample(storage, id, 5000u);
+    }
+
+    // -- and the same after reading again
+    SampleStorage reread;
+    EXPECT_EQ(ids.size(), reread.getFiles().size());
+    EXPECT_EQ(reread.sectorsFree(), reread.largestFree());
+    for (const auto& id : ids) {
+        expectSample(reread, id, 5000u);
+    }
+
+    reread.reset();
+}
@@ -0,0 +1,429 @@
+/** Tool for running a complete configuration on the host.
+ *
+ *  The tool loads a configuration in the binary "RC" format
+ *  (as stored in NVM) into a ProcStorage and runs the step
+ *  loop as fast as possible, including the audio procs.
+ *
+ *  The json configurations in configs/ can be converted with:
+ *
+ *      serialization_tool.py --config configs/full_truck.json --bin truck.rc
+ *
+ *  The input signals are created by the procs in the configuration
+ *  (e.g. an INPUT_DEMO), by an additional InputDemo (--demo) or
+ *  are read from a recorded signal trace (--trace).
+ *
+ *  The trace is a csv file. The first line contains "timeMs" followed
+ *  by the serialization IDs of the signals (see signals_config.json),
+ *  the following lines the time and the signal values.
+ *  A value stays active until the next line:
+ *
+ *      timeMs,T,Y
+ *      0,0,0
+ *      1000,500,-200
+ *
+ *  The mixed audio is written to a wav file (--wav).
+ *  The DAC is emulated by consuming the samples for the simulated
+ *  time after every step.
+ *
+ *  @file
+ */
+
+#include "proc_storage.h"
+#include "audio_ringbuffer.h"
+#include "audio.h"
+#include "clock.h"
+#include "input_demo.h"
+#include "signals.h"
+#include "simple_byte_stream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+namespace rcSignals {
+extern const char signalsMap[];  // from serialization.cpp
+}
+
+using namespace std;
+using namespace rcSignals;
+using namespace rcAudio;
+
+/** A recorded signal trace. */
+class SignalTrace {
+    private:
+        struct Row {
+            TimeMs time;
+            vector<RcSignal> values;
+        };
+
+        vector<SignalType> types;
+        vector<Row> rows;
+        size_t current = 0u;
+
+        static bool findType(char id, SignalType* type) {
+            for (uint8_t i = 0u; i < static_cast<uint8_t>(SignalType::ST_NUM); i++) {
+                if (signalsMap[i] == id) {
+                    *type = static_cast<SignalType>(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    public:
+        /** Reads the trace from a csv file.
+         *
+         *  @returns false if the file could not be read.
+         */
+        bool load(const string& filename) {
+            ifstream in(filename);
+            string line;
+            if (!getline(in, line)) {
+                cerr << "Trace " << filename << " is empty." << endl;
+                return false;
+            }
+
+            istringstream header(line);
+            string cell;
+            getline(header, cell, ',');  // timeMs
+            while (getline(header, cell, ',')) {
+                SignalType type;
+                if (cell.size() != 1u || !findType(cell[0], &type)) {
+                    cerr << "Unknown signal \"" << cell << "\" in trace." << endl;
+                    return false;
+                }
+                types.push_back(type);
+            }
+
+            while (getline(in, line)) {
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                istringstream lineStream(line);
+                Row row;
+                getline(lineStream, cell, ',');
+                row.time = stoul(cell);
+                while (getline(lineStream, cell, ',') && row.values.size() < types.size()) {
+                    row.values.push_back(stoi(cell));
+                }
+                row.values.resize(types.size(), RCSIGNAL_NEUTRAL);
+                rows.push_back(row);
+            }
+            return true;
+        }
+
+        /** Sets the signals from the last row before (or at) the time. */
+        void apply(TimeMs time, Signals* signals) {
+            while (current + 1u < rows.size() && rows[current + 1u].time <= time) {
+                current++;
+            }
+            if (current < rows.size() && rows[current].time <= time) {
+                for (size_t i = 0u; i < types.size(); i++) {
+                    (*signals)[types[i]] = rows[current].values[i];
+                }
+            }
+        }
+};
+
+/** Collects the audio samples and writes them as a wav file.
+ *
+ *  Like the DAC, the output is 8 bit unsigned stereo.
+ */
+class WavWriter {
+    private:
+        vector<uint8_t> data;
+
+        static uint8_t toDac(int16_t value) {
+            return static_cast<uint8_t>(std::clamp<int16_t>(value, -128, 127) + 128);
+        }
+
+        static void write16(ostream& out, uint16_t value) {
+            out.put(value & 0xFF);
+            out.put(value >> 8);
+        }
+
+        static void write32(ostream& out, uint32_t value) {
+            write16(out, value & 0xFFFF);
+            write16(out, value >> 16);
+        }
+
+    public:
+        void add(const rcProc::SamplesInterval& interval) {
+            for (auto pos = interval.first; pos < interval.last; pos++) {
+                data.push_back(toDac(pos->channel1));
+                data.push_back(toDac(pos->channel2));
+            }
+        }
+
+        void addSilence(size_t num) {
+            data.insert(data.end(), num * 2u, toDac(0));
+        }
+
+        bool write(const string& filename) const {
+            ofstream out(filename, ios::binary);
+            out.write("RIFF", 4);
+            write32(out, 36u + data.size());
+            out.write("WAVEfmt ", 8);
+            write32(out, 16u);  // fmt chunk size
+            write16(out, 1u);   // PCM
+            write16(out, 2u);   // channels
+            write32(out, SAMPLE_RATE);
+            write32(out, SAMPLE_RATE * 2u);  // bytes per second
+            write16(out, 2u);   // block align
+            write16(out, 8u);   // bits per sample
+            out.write("data", 4);
+            write32(out, data.size());
+            out.write(reinterpret_cast<const char*>(data.data()), data.size());
+            return out.good();
+        }
+
+        /** Returns the length of the audio in milli seconds. */
+        uint32_t lengthMs() const {
+            return static_cast<uint64_t>(data.size() / 2u) * 1000u / SAMPLE_RATE;
+        }
+};
+
+/** Results of one pipeline run. */
+struct RunResult {
+    uint32_t steps;
+    TimeUs stepTimeUs;     ///< sum of the step times
+    TimeUs maxStepTimeUs;
+    uint32_t underruns;    ///< blocks the emulated DAC found empty
+};
+
+/** Runs the step loop of a ProcStorage without waiting.
+ */
+class PipelineRunner {
+    private:
+        const TimeMs stepMs;
+
+        ProcStorage& storage;
+        AudioRingbuffer ringbuffer;
+        WavWriter wav;
+
+        SignalTrace* trace;
+        rcInput::InputDemo* demo;
+
+        /** Samples consumed by the emulated DAC in 1/1000 samples. */
+        uint64_t samplesOwed = 0u;
+
+        /** Consumes the audio of one step, as the DAC would do. */
+        void consumeAudio(RunResult* result) {
+            samplesOwed += static_cast<uint64_t>(stepMs) * SAMPLE_RATE;
+            while (samplesOwed >= AudioRingbuffer::BLOCK_SIZE * 1000u) {
+                samplesOwed -= AudioRingbuffer::BLOCK_SIZE * 1000u;
+
+                auto interval = ringbuffer.getFullBlocks();
+                if (interval.first == interval.last) {
+                    wav.addSilence(AudioRingbuffer::BLOCK_SIZE);
+                    result->underruns++;
+                } else {
+                    wav.add(interval);
+                }
+                ringbuffer.setBlocksEmpty(interval);
+            }
+        }
+
+    public:
+        PipelineRunner(ProcStorage& storageVal, TimeMs stepMsVal,
+                       SignalTrace* traceVal, rcInput::InputDemo* demoVal) :
+            stepMs(stepMsVal),
+            storage(storageVal),
+            trace(traceVal),
+            demo(demoVal) {
+        }
+
+        RunResult run(TimeMs simTime) {
+            RunResult result = {0u, 0, 0, 0u};
+
+            Signals signals;
+            for (TimeMs time = 0u; time < simTime; time += stepMs) {
+                signals.reset();
+                rcProc::StepInfo info = {
+                    .deltaMs = stepMs,
+                    .signals = &signals,
+                    .intervals = {ringbuffer.getEmptyBlocks(),
+                        ringbuffer.getEmptyBlocks()}
+                };
+
+                const TimeUs startUs = getTimeUs();
+                if (trace != nullptr) {
+                    trace->apply(time, &signals);
+                }
+                if (demo != nullptr) {
+                    demo->step(info);
+                }
+                storage.step(info);
+                for (const auto& interval : info.intervals) {
+                    ringbuffer.setBlocksFull(interval);
+                }
+                const TimeUs stepUs = getTimeUs() - startUs;
+
+                result.steps++;
+                result.stepTimeUs += stepUs;
+                result.maxStepTimeUs = std::max(result.maxStepTimeUs, stepUs);
+
+                consumeAudio(&result);
+            }
+            return result;
+        }
+
+        const WavWriter& getWav() const {
+            return wav;
+        }
+};
+
+
+/** Reads the complete file. Returns an empty vector on errors. */
+vector<uint8_t> readFile(const string& filename) {
+    ifstream in(filename, ios::binary);
+    return vector<uint8_t>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+
+/** Creates the complete options description for the runner.
+ */
+po::options_description createOptions() {
+
+    po::options_description optRunner("Pipeline runner options");
+    optRunner.add_options()
+        ("help,h", "produce help message")
+        ("config,c",
+            po::value<std::string>(),
+            "Binary configuration file (\"RC\" format). Without it the default configuration is used.")
+        ("trace",
+            po::value<std::string>(),
+            "Csv file with a recorded signal trace.")
+        ("demo",
+            po::value<uint32_t>(),
+            "Type of an additional InputDemo stepped before the configuration.")
+        ("time",
+            po::value<uint32_t>()->default_value(60000),
+            "Simulated time in milli seconds.")
+        ("step",
+            po::value<uint32_t>()->default_value(20),
+            "Simulated time per step in milli seconds.")
+        ("wav,w",
+            po::value<std::string>(),
+            "Output wav file for the mixed audio.")
+        ("profile",
+            "Print the step times per proc type.")
+    ;
+
+    return optRunner;
+}
+
+
+int main(int argc, char* argv[]) {
+
+    auto optAll = createOptions();
+    po::variables_map vm;
+
+    try {
+        po::store(po::parse_command_line(argc, argv, optAll), vm);
+        po::notify(vm);
+
+    } catch (po::error const& e) {
+        std::cerr << e.what() << std::endl;
+        optAll.print(std::cerr);
+        return 1;
+    }
+
+    if (vm.count("help")) {
+        cout << optAll << "\n";
+        return 1;
+    }
+
+    const TimeMs stepMs = vm["step"].as<uint32_t>();
+    if (stepMs == 0u) {
+        cerr << "Invalid parameter for --step: 0" << endl;
+        return 1;
+    }
+
+    ProcStorage storage;
+    if (vm.count("config")) {
+        const auto filename = vm["config"].as<string>();
+        const auto buffer = readFile(filename);
+        SimpleInStream in(buffer);
+        if (buffer.size() < 4u || !storage.deserialize(in)) {
+            cerr << "Could not read configuration " << filename << endl;
+            return 1;
+        }
+
+        // procs not available on the host (e.g. outputs) are skipped
+        SimpleOutStream out;
+        storage.serialize(out);
+        cout << "config: " << filename << ", procs: " <<
+            static_cast<int>(out.buffer()[3]) << " of " <<
+            static_cast<int>(buffer[3]) << endl;
+        free(out.buffer().data());
+    }
+    storage.setProfiling(vm.count("profile") > 0);
+    storage.start();
+
+    SignalTrace trace;
+    if (vm.count("trace") && !trace.load(vm["trace"].as<string>())) {
+        return 1;
+    }
+
+    rcInput::InputDemo demo(static_cast<rcInput::InputDemo::DemoType>(
+        vm.count("demo") ? vm["demo"].as<uint32_t>() : 0u));
+    if (vm.count("demo")) {
+        demo.start();
+    }
+
+    PipelineRunner runner(storage, stepMs,
+        vm.count("trace") ? &trace : nullptr,
+        vm.count("demo") ? &demo : nullptr);
+
+    const TimeMs simTime = vm["time"].as<uint32_t>();
+    const TimeUs startUs = getTimeUs();
+    const auto result = runner.run(simTime);
+    const TimeUs wallUs = std::max<TimeUs>(getTimeUs() - startUs, 1);
+
+    storage.stop();
+
+    const double stepTimeUs = result.steps ? (double)result.stepTimeUs / result.steps : 0.0;
+    cout << fixed << setprecision(1) <<
+        "steps: " << result.steps <<
+        ", steps/s: " << result.steps * 1000000.0 / wallUs <<
+        ", us/step: " << stepTimeUs <<
+        " (max " << result.maxStepTimeUs << ")" <<
+        ", real time factor: " << simTime * 1000.0 / wallUs <<
+        ", audio underruns: " << result.underruns << endl;
+
+    if (storage.isProfiling()) {
+        const auto& profiler = storage.getProfiler();
+        cout << "  step us per type:  count   min   avg   max   p99" << endl;
+        for (size_t i = 0u; i < profiler.getNumTypes(); i++) {
+            const auto type = profiler.getType(i);
+            const auto summary = profiler.getTypeSummary(i);
+            cout << "    " << static_cast<char>(type >> 8) << static_cast<char>(type & 0xFF) <<
+                setw(15) << summary.count << setw(6) << summary.minUs <<
+                setw(6) << summary.avgUs << setw(6) << summary.maxUs <<
+                setw(6) << summary.p99Us << endl;
+        }
+    }
+
+    if (vm.count("wav")) {
+        const auto filename = vm["wav"].as<string>();
+        if (!runner.getWav().write(filename)) {
+            cerr << "Could not write " << filename << endl;
+            return 1;
+        }
+        cout << "wav: " << filename << ", " << runner.getWav().lengthMs() << " ms" << endl;
+    }
+
+    return 0;
+}
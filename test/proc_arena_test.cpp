@@ -0,0 +1,179 @@
+/** Tests for the proc arena allocator and its usage in the ProcStorage
+ *
+ *  Built as its own test executable, because the counting operator new
+ *  below replaces the global one for the whole executable.
+ *
+ *  @file
+ */
+
+#include "proc_arena.h"
+#include "proc_storage.h"
+#include "simple_byte_stream.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+
+/** Heap statistics of the counting operator new below. */
+struct HeapCounter {
+    std::atomic<size_t> numBlocks{0u};  ///< currently allocated blocks
+    std::atomic<size_t> bytes{0u};  ///< currently allocated bytes
+    std::atomic<size_t> peakBytes{0u};
+    std::atomic<size_t> numNew{0u};  ///< calls to operator new
+};
+
+HeapCounter heapCounter;
+
+/** Header in front of every allocation to remember the size. */
+struct alignas(std::max_align_t) BlockHeader {
+    size_t size;
+};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    auto header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+    if (header == nullptr) {
+        throw std::bad_alloc();
+    }
+    header->size = size;
+
+    heapCounter.numNew++;
+    heapCounter.numBlocks++;
+    const size_t bytes = heapCounter.bytes += size;
+    size_t peak = heapCounter.peakBytes;
+    while (bytes > peak && !heapCounter.peakBytes.compare_exchange_weak(peak, bytes)) {
+    }
+    return header + 1;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    auto header = static_cast<BlockHeader*>(ptr) - 1;
+    heapCounter.numBlocks--;
+    heapCounter.bytes -= header->size;
+    std::free(header);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+/** Tests the allocation from the arena.
+ *
+ *  Tests
+ *  - ProcArena::reserve()
+ *  - ProcArena::allocate()
+ *  - ProcArena::reset()
+ */
+TEST(ProcArenaTest, Allocate) {
+    ProcArena arena;
+    EXPECT_EQ(nullptr, arena.allocate(1u));
+
+    arena.reserve(100u);
+    const size_t capacity = arena.getCapacity();
+    EXPECT_EQ(ProcArena::alignedSize(100u), capacity);
+
+    auto p1 = static_cast<uint8_t*>(arena.allocate(1u));
+    auto p2 = static_cast<uint8_t*>(arena.allocate(17u));
+    ASSERT_NE(nullptr, p1);
+    ASSERT_NE(nullptr, p2);
+    EXPECT_EQ(ProcArena::ALIGNMENT, static_cast<size_t>(p2 - p1));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p2) % ProcArena::ALIGNMENT);
+    EXPECT_TRUE(arena.contains(p2));
+    EXPECT_FALSE(arena.contains(&arena));
+
+    // full
+    EXPECT_EQ(nullptr, arena.allocate(capacity));
+    EXPECT_EQ(ProcArena::ALIGNMENT + ProcArena::alignedSize(17u), arena.getUsed());
+
+    // not empty, so the block is kept
+    arena.reserve(1000u);
+    EXPECT_EQ(capacity, arena.getCapacity());
+
+    // the same size again reuses the block
+    arena.reset();
+    arena.reserve(90u);
+    EXPECT_EQ(capacity, arena.getCapacity());
+    EXPECT_EQ(p1, arena.allocate(1u));
+
+    arena.reset();
+    arena.reserve(1000u);
+    EXPECT_EQ(ProcArena::alignedSize(1000u), arena.getCapacity());
+}
+
+/** Tests that the deserialized procs are placed in the arena and that
+ *  uploading a configuration repeatedly doesn't grow or fragment the heap.
+ *
+ *  Tests
+ *  - ProcStorage::deserialize()
+ *  - ProcStorage::getArena()
+ */
+TEST(ProcArenaTest, StorageHeap) {
+    // the default configuration isn't created in the arena
+    ProcStorage defaultStorage;
+    EXPECT_EQ(0u, defaultStorage.getArena().getUsed());
+
+    auto counter = SimpleOutStream::counting();
+    defaultStorage.serialize(counter);
+    std::vector<uint8_t> config(counter.tellg());
+    SimpleOutStream out(config);
+    defaultStorage.serialize(out);
+
+    ProcStorage storage;
+    {
+        SimpleInStream in(config);
+        ASSERT_TRUE(storage.deserialize(in));
+    }
+    // the arena is sized exactly for all procs
+    EXPECT_LT(0u, storage.getArena().getUsed());
+    EXPECT_EQ(storage.getArena().getCapacity(), storage.getArena().getUsed());
+
+    const size_t numBlocks = heapCounter.numBlocks;
+    const size_t bytes = heapCounter.bytes;
+    const size_t numProcs = config[3];
+
+    for (int i = 0; i < 20; i++) {
+        heapCounter.peakBytes = heapCounter.bytes.load();
+        const size_t numNew = heapCounter.numNew;
+
+        SimpleInStream in(config);
+        ASSERT_TRUE(storage.deserialize(in));
+
+        // the procs reuse the arena, only their members are allocated
+        EXPECT_LT(heapCounter.numNew - numNew, numProcs);
+        EXPECT_LE(heapCounter.peakBytes, bytes);
+        EXPECT_EQ(numBlocks, heapCounter.numBlocks);
+        EXPECT_EQ(bytes, heapCounter.bytes);
+    }
+}
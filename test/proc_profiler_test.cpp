@@ -0,0 +1,146 @@
+/** Tests for the controller/proc_profiler.h */
+
+#include "proc_profiler.h"
+#include "proc_storage.h"
+#include "simple_byte_stream.h"
+#include "clock.h"
+#include "signals.h"
+#include "proc.h"
+#include <gtest/gtest.h>
+
+using namespace rcProc;
+using namespace rcSignals;
+
+/** Tests the histogram buckets
+ *
+ *  Tests
+ *
+ *  - StepTimes::bucketIndex()
+ *  - StepTimes::bucketLimit()
+ */
+TEST(ProcProfilerTest, Buckets) {
+
+    EXPECT_EQ(0u, StepTimes::bucketIndex(0u));
+    EXPECT_EQ(7u, StepTimes::bucketIndex(7u));
+    EXPECT_EQ(8u, StepTimes::bucketIndex(8u));
+    EXPECT_EQ(8u, StepTimes::bucketIndex(9u));
+    EXPECT_EQ(9u, StepTimes::bucketIndex(10u));
+    EXPECT_EQ(StepTimes::NUM_BUCKETS - 1u, StepTimes::bucketIndex(1000000u));
+
+    // every time is below the limit of it's bucket and at/above the previous one
+    for (uint32_t us = 1u; us < 100000u; us += 7u) {
+        const auto index = StepTimes::bucketIndex(us);
+        EXPECT_LT(us, StepTimes::bucketLimit(index));
+        EXPECT_GE(us, StepTimes::bucketLimit(index - 1u));
+    }
+}
+
+/** Tests the summary of the step times
+ *
+ *  Tests
+ *
+ *  - StepTimes::add()
+ *  - StepTimes::summary()
+ */
+TEST(ProcProfilerTest, Summary) {
+
+    StepTimes times;
+    EXPECT_EQ(0u, times.summary().count);
+
+    // -- incomplete window: 99 times 10us and one outlier
+    for (int i = 0; i < 99; i++) {
+        times.add(10u);
+    }
+    times.add(1000u);
+
+    auto summary = times.summary();
+    EXPECT_EQ(100u, summary.count);
+    EXPECT_EQ(10u, summary.minUs);
+    EXPECT_EQ(19u, summary.avgUs);
+    EXPECT_EQ(1000u, summary.maxUs);
+    EXPECT_EQ(StepTimes::bucketLimit(StepTimes::bucketIndex(10u)), summary.p99Us);
+
+    // -- complete the window. The summary stays until the next window is complete
+    for (uint32_t i = 100u; i < StepTimes::WINDOW_SIZE; i++) {
+        times.add(20u);
+    }
+    times.add(5u);
+
+    summary = times.summary();
+    EXPECT_EQ(StepTimes::WINDOW_SIZE, summary.count);
+    EXPECT_EQ(10u, summary.minUs);
+    EXPECT_EQ(1000u, summary.maxUs);
+    EXPECT_EQ(StepTimes::bucketLimit(StepTimes::bucketIndex(20u)), summary.p99Us);
+}
+
+static TimeUs fakeTime = 0;
+
+/** Advances 5us with every call. */
+static TimeUs fakeClock() {
+    fakeTime += 5;
+    return fakeTime;
+}
+
+/** Tests profiling in the ProcStorage
+ *
+ *  Tests
+ *
+ *  - ProcStorage::setProfiling()
+ *  - ProcStorage::getProfiler()
+ *  - operator<<(SimpleOutStream&, const ProcProfiler&)
+ */
+TEST(ProcProfilerTest, Storage) {
+
+    setClock(fakeClock);
+
+    ProcStorage storage;
+    storage.start();
+    EXPECT_FALSE(storage.isProfiling());
+    storage.setProfiling(true);
+
+    Signals signals;
+    StepInfo info = {
+        .deltaMs = 20U,
+        .signals = &signals,
+        .intervals = {
+            SamplesInterval{.first = nullptr, .last = nullptr},
+            SamplesInterval{.first = nullptr, .last = nullptr}}
+    };
+    for (int i = 0; i < 10; i++) {
+        signals.reset();
+        storage.step(info);
+    }
+    setClock(nullptr);
+
+    // -- every proc took exactly one clock tick
+    const auto& profiler = storage.getProfiler();
+    ASSERT_LT(2u, profiler.getNumProcs());
+    EXPECT_EQ(('D' << 8) | 'E', profiler.getProcType(1u));  // the InputDemo
+    for (size_t i = 0u; i < profiler.getNumProcs(); i++) {
+        auto summary = profiler.getProcSummary(i);
+        EXPECT_EQ(10u, summary.count);
+        EXPECT_EQ(5u, summary.minUs);
+        EXPECT_EQ(5u, summary.maxUs);
+    }
+
+    // -- per type the steps add up
+    uint32_t sum = 0u;
+    for (size_t i = 0u; i < profiler.getNumTypes(); i++) {
+        sum += profiler.getTypeSummary(i).count;
+    }
+    EXPECT_EQ(10u * profiler.getNumProcs(), sum);
+
+    // -- report
+    SimpleOutStream out;
+    out << profiler;
+    EXPECT_EQ(3u + 1u + profiler.getNumProcs() * 8u + 1u + profiler.getNumTypes() * 12u,
+        out.tellg());
+    EXPECT_EQ('R', out.buffer()[0]);
+    EXPECT_EQ('T', out.buffer()[1]);
+    free(out.buffer().data());
+
+    // -- switching off
+    storage.setProfiling(false);
+    EXPECT_EQ(0u, storage.getProfiler().getNumProcs());
+    storage.step(info);
+}
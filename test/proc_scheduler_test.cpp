@@ -0,0 +1,325 @@
+/** Tests for the parallel proc scheduler
+ *
+ *  @file
+ */
+
+#include "proc_scheduler.h"
+#include "proc_storage.h"
+#include "proc.h"
+#include "signals.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace rcSignals;
+using namespace rcProc;
+
+namespace {
+
+/** A proc with a configurable signal usage.
+ *
+ *  Sums up its input and writes the sum to the output. Audio
+ *  procs add the sum to the audio samples.
+ */
+class TestProc : public Proc {
+    private:
+        SignalType inType;
+        SignalType outType;
+        bool audio;
+        bool barrier;
+        int32_t sum;
+
+    public:
+        TestProc(SignalType inTypeVal, SignalType outTypeVal,
+                 bool audioVal = false, bool barrierVal = false) :
+            inType(inTypeVal),
+            outType(outTypeVal),
+            audio(audioVal),
+            barrier(barrierVal),
+            sum(0) {
+        }
+
+        virtual void step(const StepInfo& info) override {
+            sum = (sum + info.signals->get(inType, 1)) % 1000;
+            if (!audio) {
+                (*info.signals)[outType] = static_cast<RcSignal>(sum);
+                return;
+            }
+            for (const auto& interval : info.intervals) {
+                for (auto sample = interval.first; sample != interval.last; sample++) {
+                    sample->channel1 += sum;
+                    sample->channel2 -= sum;
+                }
+            }
+        }
+
+        virtual void getSignalUsage(SignalUsage& usage) const override {
+            usage.read(inType);
+            if (audio) {
+                usage.audio = true;
+            } else {
+                usage.write(outType);
+            }
+            usage.barrier = barrier;
+        }
+};
+
+void stepVirtual(Proc* proc, const StepInfo& info) {
+    proc->step(info);
+}
+
+/** Creates the procs used in the tests below. */
+std::vector<std::unique_ptr<Proc>> createProcs() {
+    std::vector<std::unique_ptr<Proc>> procs;
+    // 0-3: two independent chains
+    procs.emplace_back(new TestProc(SignalType::ST_THROTTLE, SignalType::ST_SPEED));
+    procs.emplace_back(new TestProc(SignalType::ST_YAW, SignalType::ST_LOWBEAM));
+    procs.emplace_back(new TestProc(SignalType::ST_SPEED, SignalType::ST_RPM));
+    procs.emplace_back(new TestProc(SignalType::ST_LOWBEAM, SignalType::ST_TAIL));
+    // 4: barrier
+    procs.emplace_back(new TestProc(SignalType::ST_RPM, SignalType::ST_THROTTLE, false, true));
+    // 5-6: audio
+    procs.emplace_back(new TestProc(SignalType::ST_RPM, SignalType::ST_NONE, true));
+    procs.emplace_back(new TestProc(SignalType::ST_YAW, SignalType::ST_NONE, true));
+    // 7-8: writing and reading ST_NONE
+    procs.emplace_back(new TestProc(SignalType::ST_THROTTLE, SignalType::ST_NONE));
+    procs.emplace_back(new TestProc(SignalType::ST_NONE, SignalType::ST_BRAKE));
+    return procs;
+}
+
+std::vector<ProcStep> createSteps(const std::vector<std::unique_ptr<Proc>>& procs) {
+    std::vector<ProcStep> steps;
+    for (const auto& proc : procs) {
+        steps.push_back(ProcStep{.fn = &stepVirtual, .proc = proc.get()});
+    }
+    return steps;
+}
+
+/** The result of one step. */
+struct StepResult {
+    Signals signals;
+    std::array<AudioSample, 64> audio;
+
+    bool operator==(const StepResult& other) const {
+        if (signals.signals != other.signals.signals) {
+            return false;
+        }
+        for (size_t i = 0u; i < audio.size(); i++) {
+            if (audio[i].channel1 != other.audio[i].channel1 ||
+                audio[i].channel2 != other.audio[i].channel2) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/** Creates the input for step i. */
+StepResult createInput(int i) {
+    StepResult result;
+    result.signals.reset();
+    result.signals[SignalType::ST_YAW] = static_cast<RcSignal>((i * 37) % 2000 - 1000);
+    for (auto& sample : result.audio) {
+        sample = AudioSample{static_cast<int16_t>(i), 0};
+    }
+    return result;
+}
+
+StepInfo createStepInfo(StepResult& result) {
+    return StepInfo{
+        .deltaMs = 20u,
+        .signals = &result.signals,
+        .intervals = {
+            SamplesInterval{.first = result.audio.data(), .last = result.audio.data() + 40},
+            SamplesInterval{.first = result.audio.data() + 40, .last = result.audio.data() + 64}}
+    };
+}
+
+/** Returns the indices of the procs in the lane. */
+std::vector<size_t> laneIndices(const std::vector<ProcScheduler::Item>& lane,
+        const std::vector<std::unique_ptr<Proc>>& procs) {
+    std::vector<size_t> result;
+    for (const auto& item : lane) {
+        for (size_t i = 0u; i < procs.size(); i++) {
+            if (procs[i].get() == item.step.proc) {
+                result.push_back(i);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+/** Tests the stages created from the signal usage.
+ *
+ *  Tests
+ *  - ProcScheduler::plan()
+ */
+TEST(ProcSchedulerTest, Plan) {
+    const auto procs = createProcs();
+    ProcScheduler scheduler;
+    scheduler.plan(createSteps(procs));
+
+    const auto& stages = scheduler.getStages();
+    ASSERT_EQ(3u, stages.size());
+
+    // the two chains in parallel
+    EXPECT_EQ((std::vector<size_t>{0u, 2u}), laneIndices(stages[0].lanes[0], procs));
+    EXPECT_EQ((std::vector<size_t>{1u, 3u}), laneIndices(stages[0].lanes[1], procs));
+    EXPECT_FALSE(stages[0].audio);
+
+    // the barrier alone
+    EXPECT_EQ((std::vector<size_t>{4u}), laneIndices(stages[1].lanes[0], procs));
+    EXPECT_TRUE(stages[1].lanes[1].empty());
+
+    // ST_NONE writer and reader stay together, the audio procs on the other lane
+    EXPECT_EQ((std::vector<size_t>{7u, 8u}), laneIndices(stages[2].lanes[0], procs));
+    EXPECT_TRUE(stages[2].lanes[0][0].resetNone);
+    EXPECT_TRUE(stages[2].lanes[0][1].resetNone);
+    EXPECT_EQ((std::vector<size_t>{5u, 6u}), laneIndices(stages[2].lanes[1], procs));
+    EXPECT_FALSE(stages[2].lanes[1][0].resetNone);
+    EXPECT_TRUE(stages[2].audio);
+}
+
+/** Tests that the parallel steps give the same results as the sequential ones.
+ *
+ *  Tests
+ *  - ProcScheduler::startWorker()
+ *  - ProcScheduler::step()
+ */
+TEST(ProcSchedulerTest, Deterministic) {
+    const auto referenceProcs = createProcs();
+    const auto sequentialProcs = createProcs();
+    const auto parallelProcs = createProcs();
+
+    ProcScheduler sequential;
+    sequential.plan(createSteps(sequentialProcs));
+
+    ProcScheduler parallel;
+    parallel.plan(createSteps(parallelProcs));
+    parallel.startWorker();
+    EXPECT_TRUE(parallel.hasWorker());
+
+    for (int i = 0; i < 2000; i++) {
+        auto reference = createInput(i);
+        const auto info = createStepInfo(reference);
+        for (const auto& proc : referenceProcs) {
+            reference.signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+            proc->step(info);
+        }
+
+        auto sequentialResult = createInput(i);
+        sequential.step(createStepInfo(sequentialResult));
+
+        auto parallelResult = createInput(i);
+        parallel.step(createStepInfo(parallelResult));
+
+        // ST_NONE is not defined after the step
+        reference.signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+        sequentialResult.signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+        parallelResult.signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+
+        ASSERT_TRUE(reference == sequentialResult) << "step " << i;
+        ASSERT_TRUE(reference == parallelResult) << "step " << i;
+    }
+
+    parallel.stopWorker();
+    EXPECT_FALSE(parallel.hasWorker());
+}
+
+/** Tests the parallel mode of the ProcStorage with the default configuration.
+ *
+ *  The audio procs mixing with floats (e.g. AudioSteam) round
+ *  differently when mixed into the scratch buffer, but two parallel
+ *  runs give exactly the same result.
+ *
+ *  Tests
+ *  - ProcStorage::setParallel()
+ */
+TEST(ProcSchedulerTest, Storage) {
+    ProcStorage reference;
+    std::array<ProcStorage, 2> parallel;
+    for (auto& storage : parallel) {
+        storage.setParallel(true);
+        EXPECT_TRUE(storage.isParallel());
+        EXPECT_TRUE(storage.getScheduler().hasWorker());
+        storage.start();
+    }
+    reference.start();
+
+    for (int i = 0; i < 500; i++) {
+        auto referenceResult = createInput(i);
+        reference.step(createStepInfo(referenceResult));
+        std::array<StepResult, 2> parallelResults;
+        for (size_t j = 0u; j < parallel.size(); j++) {
+            parallelResults[j] = createInput(i);
+            parallel[j].step(createStepInfo(parallelResults[j]));
+            parallelResults[j].signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+        }
+        referenceResult.signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+
+        ASSERT_TRUE(parallelResults[0] == parallelResults[1]) << "step " << i;
+        ASSERT_EQ(referenceResult.signals.signals, parallelResults[0].signals.signals) << "step " << i;
+        for (size_t k = 0u; k < referenceResult.audio.size(); k++) {
+            ASSERT_NEAR(referenceResult.audio[k].channel1, parallelResults[0].audio[k].channel1, 2) << "step " << i;
+            ASSERT_NEAR(referenceResult.audio[k].channel2, parallelResults[0].audio[k].channel2, 2) << "step " << i;
+        }
+    }
+    EXPECT_FALSE(parallel[0].getScheduler().getStages().empty());
+
+    parallel[0].setParallel(false);
+    EXPECT_FALSE(parallel[0].getScheduler().hasWorker());
+}
+
+/** Tests the parallel audio mode of the ProcStorage with the default configuration.
+ *
+ *  Tests
+ *  - ProcStorage::setParallelAudio()
+ *  - ProcStorage::stepAudio()
+ */
+TEST(ProcSchedulerTest, StorageAudio) {
+    ProcStorage reference;
+    std::array<ProcStorage, 2> parallel;
+    for (auto& storage : parallel) {
+        storage.setSeparateAudio(true);
+        storage.setParallelAudio(true);
+        EXPECT_TRUE(storage.isParallelAudio());
+        EXPECT_TRUE(storage.getAudioScheduler().hasWorker());
+        EXPECT_FALSE(storage.getScheduler().hasWorker());
+        storage.start();
+    }
+    reference.setSeparateAudio(true);
+    reference.start();
+
+    for (int i = 0; i < 500; i++) {
+        auto referenceResult = createInput(i);
+        reference.step(createStepInfo(referenceResult));
+        reference.stepAudio(createStepInfo(referenceResult));
+
+        std::array<StepResult, 2> parallelResults;
+        for (size_t j = 0u; j < parallel.size(); j++) {
+            parallelResults[j] = createInput(i);
+            parallel[j].step(createStepInfo(parallelResults[j]));
+            parallel[j].stepAudio(createStepInfo(parallelResults[j]));
+            parallelResults[j].signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+        }
+        referenceResult.signals[SignalType::ST_NONE] = RCSIGNAL_NEUTRAL;
+
+        ASSERT_TRUE(parallelResults[0] == parallelResults[1]) << "step " << i;
+        ASSERT_EQ(referenceResult.signals.signals, parallelResults[0].signals.signals) << "step " << i;
+        for (size_t k = 0u; k < referenceResult.audio.size(); k++) {
+            ASSERT_NEAR(referenceResult.audio[k].channel1, parallelResults[0].audio[k].channel1, 2) << "step " << i;
+            ASSERT_NEAR(referenceResult.audio[k].channel2, parallelResults[0].audio[k].channel2, 2) << "step " << i;
+        }
+    }
+
+    // all the audio procs are independent
+    const auto& stages = parallel[0].getAudioScheduler().getStages();
+    ASSERT_EQ(1u, stages.size());
+    EXPECT_FALSE(stages[0].lanes[1].empty());
+    EXPECT_TRUE(stages[0].audio);
+}
@@ -3,6 +3,8 @@
 #include "proc_storage.h"
 #include "simple_byte_stream.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
 
 using namespace rcProc;
 
@@ -61,3 +63,207 @@ TEST(StorageTest, serialize) {
     free(out.buffer().data());
 }
 
+/** Tests serializing with an exact sized buffer.
+ *
+ *  Tests
+ *  - ProcStorage::serialize() with a counting and a fixed stream
+ */
+TEST(StorageTest, serializeExact) {
+
+    ProcStorage storage;
+
+    SimpleOutStream out;
+    storage.serialize(out);
+
+    auto counter = SimpleOutStream::counting();
+    storage.serialize(counter);
+    EXPECT_EQ(out.tellg(), counter.tellg());
+
+    std::vector<uint8_t> buffer(counter.tellg());
+    SimpleOutStream fixed(buffer);
+    storage.serialize(fixed);
+    EXPECT_FALSE(fixed.fail());
+    EXPECT_EQ(counter.tellg(), fixed.tellg());
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), out.buffer().begin()));
+
+    // one byte less should fail
+    buffer.resize(buffer.size() - 1u);
+    SimpleOutStream tooSmall(buffer);
+    storage.serialize(tooSmall);
+    EXPECT_TRUE(tooSmall.fail());
+
+    free(out.buffer().data());
+}
+
+
+namespace {
+
+/** Returns the serialized configuration of the storage. */
+std::vector<uint8_t> serializeStorage(const ProcStorage& storage) {
+    auto counter = SimpleOutStream::counting();
+    storage.serialize(counter);
+    std::vector<uint8_t> buffer(counter.tellg());
+    SimpleOutStream out(buffer);
+    storage.serialize(out);
+    return buffer;
+}
+
+/** Splits the serialized configuration into the serialized procs. */
+std::vector<std::vector<uint8_t>> splitProcs(const std::vector<uint8_t>& config) {
+    std::vector<std::vector<uint8_t>> result;
+    size_t pos = 4u;  // header and count
+    for (uint8_t i = 0u; i < config[3]; i++) {
+        const size_t len = 3u + config[pos + 2u];  // id, length, payload
+        result.emplace_back(config.begin() + pos, config.begin() + pos + len);
+        pos += len;
+    }
+    return result;
+}
+
+/** Creates a patch with the proc. */
+std::vector<uint8_t> createPatch(ProcStorage::PatchOp op, uint8_t index,
+        const std::vector<uint8_t>& proc = {}) {
+    std::vector<uint8_t> result = {'R', 'P', 1u, static_cast<uint8_t>(op), index};
+    result.insert(result.end(), proc.begin(), proc.end());
+    return result;
+}
+
+/** Applies the patch to the storage. */
+bool applyPatch(ProcStorage& storage, const std::vector<uint8_t>& patch) {
+    EXPECT_TRUE(ProcStorage::isPatch(patch));
+    SimpleInStream in(patch);
+    return storage.patch(in);
+}
+
+/** Steps the storage and returns the resulting signals. */
+rcSignals::Signals stepStorage(ProcStorage& storage) {
+    rcSignals::Signals signals;
+    signals.reset();
+    rcProc::StepInfo info = {
+        .deltaMs = 20u,
+        .signals = &signals,
+        .intervals = {
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr},
+            rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+    };
+    storage.step(info);
+    return signals;
+}
+
+} // namespace
+
+/** Tests replacing, inserting and removing single procs.
+ *
+ *  Tests
+ *  - ProcStorage::isPatch()
+ *  - ProcStorage::patch()
+ */
+TEST(StorageTest, patch) {
+    using PatchOp = ProcStorage::PatchOp;
+
+    ProcStorage storage;
+    const auto config = serializeStorage(storage);
+    EXPECT_FALSE(ProcStorage::isPatch(config));
+    auto procs = splitProcs(config);
+    ASSERT_GT(procs.size(), 3u);
+
+    // -- replace
+    EXPECT_TRUE(applyPatch(storage, createPatch(PatchOp::REPLACE, 1u, procs[2])));
+    procs[1] = procs[2];
+    EXPECT_EQ(procs, splitProcs(serializeStorage(storage)));
+
+    // -- insert at the front and at the end
+    EXPECT_TRUE(applyPatch(storage, createPatch(PatchOp::INSERT, 0u, procs[3])));
+    procs.insert(procs.begin(), procs[3]);
+    EXPECT_TRUE(applyPatch(storage, createPatch(PatchOp::INSERT, procs.size(), procs[0])));
+    procs.push_back(procs[0]);
+    EXPECT_EQ(procs, splitProcs(serializeStorage(storage)));
+
+    // -- remove
+    EXPECT_TRUE(applyPatch(storage, createPatch(PatchOp::REMOVE, 2u)));
+    procs.erase(procs.begin() + 2);
+    EXPECT_EQ(procs, splitProcs(serializeStorage(storage)));
+
+    // -- invalid patches don't change anything
+    const auto before = serializeStorage(storage);
+    EXPECT_FALSE(applyPatch(storage, createPatch(PatchOp::REPLACE, procs.size(), procs[0])));
+    EXPECT_FALSE(applyPatch(storage, createPatch(PatchOp::INSERT, procs.size() + 1u, procs[0])));
+    EXPECT_FALSE(applyPatch(storage, createPatch(PatchOp::REMOVE, procs.size())));
+    EXPECT_FALSE(applyPatch(storage, createPatch(static_cast<PatchOp>('X'), 0u)));
+    auto truncated = createPatch(PatchOp::REPLACE, 0u, procs[1]);
+    truncated.pop_back();
+    EXPECT_FALSE(applyPatch(storage, truncated));
+
+    SimpleInStream full(config);
+    EXPECT_FALSE(storage.patch(full));  // not a patch
+    EXPECT_EQ(before, serializeStorage(storage));
+}
+
+/** Tests that the procs not affected by a patch keep their state. */
+TEST(StorageTest, patchKeepsState) {
+    ProcStorage patched;
+    ProcStorage reference;
+    patched.start();
+    reference.start();
+
+    for (int i = 0; i < 200; i++) {
+        stepStorage(patched);
+        stepStorage(reference);
+    }
+
+    // replace the first proc (the input group) with itself
+    const auto procs = splitProcs(serializeStorage(patched));
+    EXPECT_TRUE(applyPatch(patched,
+        createPatch(ProcStorage::PatchOp::REPLACE, 0u, procs[0])));
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(stepStorage(reference).signals, stepStorage(patched).signals);
+    }
+}
+
+/** Tests that the step pipelines give the same results as the virtual step calls.
+ *
+ *  Tests
+ *  - ProcStorage::setPipeline()
+ *  - ProcStorage::step()
+ *  - ProcStorage::stepAudio()
+ */
+TEST(StorageTest, pipeline) {
+    ProcStorage reference;
+    reference.setPipeline(false);
+    EXPECT_FALSE(reference.isPipeline());
+
+    // also with procs created by deserialize()
+    ProcStorage piped;
+    EXPECT_TRUE(piped.isPipeline());
+    const auto config = serializeStorage(reference);
+    SimpleInStream in(config);
+    ASSERT_TRUE(piped.deserialize(in));
+
+    reference.start();
+    piped.start();
+    for (int i = 0; i < 500; i++) {
+        EXPECT_EQ(stepStorage(reference).signals, stepStorage(piped).signals) << "step " << i;
+    }
+
+    // -- separate audio
+    reference.setSeparateAudio(true);
+    piped.setSeparateAudio(true);
+    for (int i = 0; i < 100; i++) {
+        auto signals = stepStorage(reference);
+        auto pipedSignals = stepStorage(piped);
+        EXPECT_EQ(signals.signals, pipedSignals.signals) << "step " << i;
+
+        rcProc::StepInfo info = {
+            .deltaMs = 20u,
+            .signals = &signals,
+            .intervals = {
+                rcProc::SamplesInterval{.first = nullptr, .last = nullptr},
+                rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+        };
+        reference.stepAudio(info);
+        info.signals = &pipedSignals;
+        piped.stepAudio(info);
+        EXPECT_EQ(signals.signals, pipedSignals.signals) << "step " << i;
+    }
+}
@@ -0,0 +1,66 @@
+/** Tests for the SampleIndex class */
+
+#include "sample_index.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+rcSamples::AudioId makeId(uint16_t i) {
+    return {static_cast<char>('a' + i % 26), static_cast<char>('a' + (i / 26) % 26), 'x'};
+}
+
+} // namespace
+
+/** Test:
+ *
+ *  - SampleIndex::add()
+ *  - SampleIndex::find()
+ *
+ *  with enough samples for collisions.
+ */
+TEST(SampleIndexTest, Find) {
+    const uint16_t num = 300u;
+    std::vector<uint8_t> data(num * 16u);
+
+    SampleIndex index;
+    EXPECT_EQ(SampleIndex::NOT_FOUND, index.find(makeId(0u)));
+    EXPECT_EQ(SampleIndex::NOT_FOUND, index.find(data.data()));
+
+    index.reset(num);
+    for (uint16_t i = 0u; i < num; i++) {
+        index.add(makeId(i), data.data() + i * 16u, i);
+    }
+    EXPECT_EQ(num, index.size());
+
+    for (uint16_t i = 0u; i < num; i++) {
+        EXPECT_EQ(i, index.find(makeId(i)));
+        EXPECT_EQ(i, index.find(data.data() + i * 16u));
+    }
+    EXPECT_EQ(SampleIndex::NOT_FOUND, index.find(rcSamples::AudioId{'n', 'o', 't'}));
+    EXPECT_EQ(SampleIndex::NOT_FOUND, index.find(data.data() + 1u));
+
+    // -- reset removes everything
+    index.reset(2u);
+    EXPECT_EQ(0u, index.size());
+    EXPECT_EQ(SampleIndex::NOT_FOUND, index.find(makeId(0u)));
+    EXPECT_EQ(SampleIndex::NOT_FOUND, index.find(data.data()));
+}
+
+/** The first sample with an ID wins, like with a linear search. */
+TEST(SampleIndexTest, Duplicates) {
+    const uint8_t data[3] = {1, 2, 3};
+
+    SampleIndex index;
+    index.reset(3u);
+    index.add({'a', 'b', 'c'}, data, 0u);
+    index.add({'a', 'b', 'c'}, data + 1, 1u);
+    index.add({'d', 'e', 'f'}, data, 2u);
+
+    EXPECT_EQ(0u, index.find(rcSamples::AudioId{'a', 'b', 'c'}));
+    EXPECT_EQ(2u, index.find(rcSamples::AudioId{'d', 'e', 'f'}));
+    EXPECT_EQ(0u, index.find(data));
+    EXPECT_EQ(1u, index.find(data + 1));
+}
@@ -0,0 +1,96 @@
+/** Tests for the SampleList class */
+
+#include "sample_list.h"
+#include "sample_index.h"
+#include "wav_sample.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+extern const uint8_t _binary_dummy_wav_start[];
+extern const uint8_t _binary_dummy_wav_end[];
+
+/** The SampleInfo generated by audio_tool.py gives the same
+ *  SampleData as parsing the WAV header.
+ */
+TEST(SampleListTest, StaticInfo) {
+    for (const auto& file : rcSamples::getStaticSamples()) {
+        EXPECT_NE(rcSamples::SampleInfo::UNKNOWN, file.info.format);
+
+        const auto precomputed = SampleList::resolve(file);
+        const auto parsed = getWavSampleData(file.content);
+        EXPECT_EQ(parsed.data(), precomputed.data());
+        EXPECT_EQ(parsed.size(), precomputed.size());
+        EXPECT_EQ(parsed.getBytes().size(), precomputed.getBytes().size());
+        EXPECT_EQ(parsed.getBlockSize(), precomputed.getBlockSize());
+    }
+}
+
+/** Test:
+ *
+ *  - SampleList::reset()
+ *  - SampleList::find()
+ *  - SampleList::getData()
+ *
+ *  Only the used samples are resolved.
+ */
+TEST(SampleListTest, Lazy) {
+    const std::span<const uint8_t> wav(_binary_dummy_wav_start,
+        _binary_dummy_wav_end - _binary_dummy_wav_start);
+    const uint8_t raw[4] = {1, 2, 3, 4};
+
+    const std::vector<rcSamples::SampleFile> files = {
+        // no info, the header is parsed
+        rcSamples::SampleFile{.id = {'w', 'a', 'v'}, .content = wav},
+        rcSamples::SampleFile{.id = {'r', 'a', 'w'}, .content = raw,
+            .info = {.format = rcSamples::SampleInfo::PCM, .blockSize = 0u,
+                .offset = 1u, .size = 2u, .numSamples = 2u}},
+        // info outside of the content is ignored
+        rcSamples::SampleFile{.id = {'b', 'a', 'd'}, .content = raw,
+            .info = {.format = rcSamples::SampleInfo::PCM, .blockSize = 0u,
+                .offset = 3u, .size = 2u, .numSamples = 2u}}
+    };
+
+    SampleList list;
+    list.reset(files);
+    EXPECT_EQ(3u, list.size());
+    EXPECT_EQ(0u, list.getNumResolved());
+
+    EXPECT_EQ(1u, list.find(rcSamples::AudioId{'r', 'a', 'w'}));
+    EXPECT_EQ(SampleIndex::NOT_FOUND, list.find(rcSamples::AudioId{'x', 'y', 'z'}));
+    EXPECT_EQ(0u, list.getNumResolved());
+
+    // -- precomputed
+    const auto& rawData = list.getData(1u);
+    EXPECT_EQ(raw + 1, rawData.data());
+    EXPECT_EQ(2u, rawData.size());
+    EXPECT_TRUE(list.isResolved(1u));
+    EXPECT_FALSE(list.isResolved(0u));
+    EXPECT_EQ(1u, list.getNumResolved());
+    EXPECT_EQ(1u, list.find(raw + 1));
+
+    // -- parsed
+    EXPECT_EQ(SampleIndex::NOT_FOUND, list.find(_binary_dummy_wav_start + 44));
+    const auto& wavData = list.getData(0u);
+    EXPECT_EQ(_binary_dummy_wav_start + 44, wavData.data());
+    EXPECT_EQ(0u, list.find(_binary_dummy_wav_start + 44));
+
+    // -- resolved only once
+    EXPECT_EQ(&wavData, &list.getData(0u));
+    EXPECT_EQ(2u, list.getNumResolved());
+
+    // -- broken info, the content is used as it is
+    const auto& badData = list.getData(2u);
+    EXPECT_EQ(raw, badData.data());
+    EXPECT_EQ(4u, badData.size());
+
+    list.reset(std::span<const rcSamples::SampleFile>(files).first(1u));
+    EXPECT_EQ(0u, list.getNumResolved());
+    EXPECT_EQ(SampleIndex::NOT_FOUND, list.find(raw + 1));
+
+    // -- data handed out before the reset
+    EXPECT_EQ(0u, list.findInContent(_binary_dummy_wav_start + 44));
+    EXPECT_TRUE(list.isResolved(0u));
+    EXPECT_EQ(SampleIndex::NOT_FOUND, list.findInContent(raw + 1));
+}
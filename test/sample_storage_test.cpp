@@ -2,11 +2,80 @@
 
 #include "sample_storage_singleton.h"
 #include "simple_byte_stream.h"
+#include "audio_adpcm.h"
+#include "crc16.h"
 #include <gtest/gtest.h>
 
 extern const uint8_t _binary_whistle_wav_start[];
 extern const uint8_t _binary_whistle_wav_end[];
 
+/** Appends a big endian value (the byte order of the commands). */
+static void appendUint16(std::vector<uint8_t>& buf, uint16_t value) {
+    buf.push_back(static_cast<uint8_t>(value >> 8));
+    buf.push_back(static_cast<uint8_t>(value));
+}
+
+/** Appends a big endian value (the byte order of the commands). */
+static void appendUint32(std::vector<uint8_t>& buf, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        buf.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+/** Appends a little endian value (the byte order of WAV files). */
+static void appendUint32le(std::vector<uint8_t>& buf, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        buf.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+/** Executes one sample storage command. */
+static void execute(const std::vector<uint8_t>& buf) {
+    SimpleInStream in(buf);
+    SampleStorageSingleton::getInstance().executeCommand(in);
+}
+
+/** Uploads a raw sample with size bytes of the value. */
+static void upload(const rcSamples::AudioId& id, uint8_t size, uint8_t value) {
+    execute({'R', 'A', 1, 0x01u, static_cast<uint8_t>(id[0]), static_cast<uint8_t>(id[1]),
+        static_cast<uint8_t>(id[2]), 0, 0, 0, size});
+    std::vector<uint8_t> addData = {'R', 'A', 1, 0x02u,
+        static_cast<uint8_t>(id[0]), static_cast<uint8_t>(id[1]), static_cast<uint8_t>(id[2]),
+        0, 0, 0, 0,  // offset
+        0, 0, 0, size};
+    addData.insert(addData.end(), size, value);
+    execute(addData);
+}
+
+/** The upload acknowledge, see SampleStorageSingleton::serializeAck(). */
+struct Ack {
+    rcSamples::AudioId id;
+    uint16_t seq;
+    uint8_t window;
+    uint16_t errors;
+    uint8_t active;
+};
+
+/** Reads the acknowledge serialized with a window of 16. */
+static Ack readAck() {
+    std::array<uint8_t, 20> buf;
+    SimpleOutStream out(buf);
+    SampleStorageSingleton::getInstance().serializeAck(out, 16u);
+    EXPECT_EQ(12u, out.tellg());
+
+    SimpleInStream in(std::span<const uint8_t>(buf.data(), out.tellg()));
+    EXPECT_EQ('R', in.read<uint8_t>());
+    EXPECT_EQ('K', in.read<uint8_t>());
+    EXPECT_EQ(1u, in.read<uint8_t>());
+    Ack ack;
+    ack.id = in.read<rcSamples::AudioId>();
+    ack.seq = in.read<uint16_t>();
+    ack.window = in.read<uint8_t>();
+    ack.errors = in.read<uint16_t>();
+    ack.active = in.read<uint8_t>();
+    return ack;
+}
+
 
 /** Test:
  *
@@ -78,7 +147,8 @@ TEST(SSTest, Command) {
     // -- add Data
     SimpleInStream in2(spAddData);
     ss.executeCommand(in2);
-    auto file2 = ss.getSampleFile(id); // does a flush for flash
+    ss.flush();  // the upload is not complete, done by the audio writer task when idle
+    auto file2 = ss.getSampleFile(id);
     EXPECT_EQ(1u, file2.content.begin()[1]);
     EXPECT_EQ(2u, file2.content.begin()[2]);
 
@@ -112,3 +182,395 @@ TEST(SSTest, SampleData) {
     EXPECT_EQ(rcSamples::AudioId({'T', 'S', 'W'}), id);
 }
 
+
+
+/** Test:
+ *
+ *  - SampleStorageSingleton::executeCommand()
+ *  - SampleStorageSingleton::serializeList()
+ *
+ *  for an uploaded 16 bit stereo 44.1 kHz WAV file.
+ */
+TEST(SSTest, ConvertUpload) {
+    auto& ss = SampleStorageSingleton::getInstance();
+    rcSamples::AudioId id({'w', 'a', 'v'});
+
+    // -- a WAV file with 2000 frames of a constant value
+    std::vector<uint8_t> wav = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0,
+        1, 0, 2, 0};  // PCM, stereo
+    appendUint32le(wav, 44100u);
+    appendUint32le(wav, 44100u * 4u);
+    wav.insert(wav.end(), {4, 0, 16, 0});  // block align, bits
+    wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+    appendUint32le(wav, 2000u * 4u);
+    for (uint32_t i = 0u; i < 2000u * 2u; i++) {
+        wav.insert(wav.end(), {0x00, 0x40});  // 0x4000
+    }
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+
+    std::vector<uint8_t> add = {'R', 'A', 1, 0x01u, 'w', 'a', 'v'};
+    appendUint32(add, wav.size());
+    execute(add);
+
+    const uint32_t chunkSize = 500u;
+    for (uint32_t offset = 0u; offset < wav.size(); offset += chunkSize) {
+        const uint32_t size = std::min(chunkSize, static_cast<uint32_t>(wav.size() - offset));
+        std::vector<uint8_t> addData = {'R', 'A', 1, 0x02u, 'w', 'a', 'v'};
+        appendUint32(addData, offset);
+        appendUint32(addData, size);
+        addData.insert(addData.end(), wav.begin() + offset, wav.begin() + offset + size);
+        execute(addData);
+    }
+
+    // -- the stored sample is converted
+    auto file = ss.getSampleFile(id);
+    EXPECT_EQ(id, file.id);
+    ASSERT_EQ(1000u, file.content.size());
+    EXPECT_EQ(rcSamples::SampleInfo::PCM, file.info.format);
+    EXPECT_EQ(1000u, file.info.numSamples);
+    for (size_t i = 20u; i < file.content.size() - 20u; i++) {
+        EXPECT_NEAR(128 + 0x40, file.content[i], 1) << "sample " << i;
+    }
+
+    // -- the list contains the uploaded file size
+    std::array<uint8_t, 100> listBuf;
+    SimpleOutStream out(listBuf);
+    ss.serializeList(out);
+    SimpleInStream in(std::span<const uint8_t>(listBuf.data(), out.tellg()));
+    in.read<uint8_t>();
+    in.read<uint8_t>();
+    in.read<uint8_t>();
+    in.read<uint16_t>();
+    in.read<uint16_t>();
+    ASSERT_EQ(1u, in.read<uint8_t>());
+    EXPECT_EQ(id, in.read<rcSamples::AudioId>());
+    EXPECT_EQ(wav.size(), in.read<uint32_t>());
+    EXPECT_FALSE(ss.getSampleData(id).isAdpcm());
+
+    // -- the same upload ADPCM encoded
+    execute({'R', 'A', 1, 0x00u});  // reset
+    ss.setAdpcm(true);
+    execute(add);
+    for (uint32_t offset = 0u; offset < wav.size(); offset += chunkSize) {
+        const uint32_t size = std::min(chunkSize, static_cast<uint32_t>(wav.size() - offset));
+        std::vector<uint8_t> addData = {'R', 'A', 1, 0x02u, 'w', 'a', 'v'};
+        appendUint32(addData, offset);
+        appendUint32(addData, size);
+        addData.insert(addData.end(), wav.begin() + offset, wav.begin() + offset + size);
+        execute(addData);
+    }
+    ss.setAdpcm(false);
+
+    EXPECT_EQ(rcAudio::adpcmBytes(1000u), ss.getSampleFile(id).content.size());
+    EXPECT_EQ(rcSamples::SampleInfo::ADPCM, ss.getSampleFile(id).info.format);
+    const auto& sample = ss.getSampleData(id);
+    EXPECT_TRUE(sample.isAdpcm());
+    ASSERT_EQ(1000u, sample.size());
+    rcAudio::SampleReader reader;
+    for (uint32_t i = 20u; i < sample.size() - 20u; i++) {
+        EXPECT_NEAR(128 + 0x40, reader.at(sample, i), 1) << "sample " << i;
+    }
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+}
+
+/** An upload with an unsupported WAV format (24 bit) whose header
+ *  is split over several chunks is stored as it is.
+ */
+TEST(SSTest, UnsupportedUpload) {
+    auto& ss = SampleStorageSingleton::getInstance();
+    rcSamples::AudioId id({'w', '2', '4'});
+
+    std::vector<uint8_t> wav = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0,
+        1, 0, 1, 0, 0x22, 0x56, 0, 0, 0x66, 0x02, 0x01, 0,  // PCM, mono, 22050 Hz
+        3, 0, 24, 0,  // block align, bits
+        'd', 'a', 't', 'a', 0x2c, 0x01, 0, 0};
+    for (uint32_t i = 0u; i < 300u; i++) {
+        wav.push_back(static_cast<uint8_t>(i));
+    }
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+
+    std::vector<uint8_t> add = {'R', 'A', 1, 0x01u, 'w', '2', '4'};
+    appendUint32(add, wav.size());
+    execute(add);
+
+    const uint32_t chunkSize = 16u;
+    for (uint32_t offset = 0u; offset < wav.size(); offset += chunkSize) {
+        const uint32_t size = std::min(chunkSize, static_cast<uint32_t>(wav.size() - offset));
+        std::vector<uint8_t> addData = {'R', 'A', 1, 0x02u, 'w', '2', '4'};
+        appendUint32(addData, offset);
+        appendUint32(addData, size);
+        addData.insert(addData.end(), wav.begin() + offset, wav.begin() + offset + size);
+        execute(addData);
+    }
+
+    const auto& file = ss.getSampleFile(id);
+    EXPECT_EQ(id, file.id);
+    ASSERT_EQ(wav.size(), file.content.size());
+    EXPECT_TRUE(std::equal(wav.begin(), wav.end(), file.content.begin()));
+    EXPECT_EQ(rcSamples::SampleInfo::UNKNOWN, file.info.format);
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+}
+
+/** An upload whose converted size doesn't fit (a low sample rate
+ *  is stored resampled) is removed and shown as stopped in the acknowledge.
+ */
+TEST(SSTest, ConvertedTooLarge) {
+    auto& ss = SampleStorageSingleton::getInstance();
+    rcSamples::AudioId id({'w', '0', '8'});
+
+    // 100000 samples with 8 kHz become 275625 samples with 22.05 kHz
+    std::vector<uint8_t> wav = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0,
+        1, 0, 1, 0, 0x40, 0x1f, 0, 0, 0x40, 0x1f, 0, 0,  // PCM, mono, 8000 Hz
+        1, 0, 8, 0,  // block align, bits
+        'd', 'a', 't', 'a', 0xa0, 0x86, 0x01, 0};
+    wav.resize(wav.size() + 100000u, 0x80u);
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+
+    std::vector<uint8_t> add = {'R', 'A', 1, 0x01u, 'w', '0', '8'};
+    appendUint32(add, wav.size());
+    execute(add);
+
+    const uint32_t chunkSize = 500u;
+    for (uint32_t offset = 0u; offset < 10u * chunkSize; offset += chunkSize) {
+        std::vector<uint8_t> addData = {'R', 'A', 1, 0x02u, 'w', '0', '8'};
+        appendUint32(addData, offset);
+        appendUint32(addData, chunkSize);
+        addData.insert(addData.end(), wav.begin() + offset, wav.begin() + offset + chunkSize);
+        execute(addData);
+    }
+
+    // -- the sample is gone, the following chunks went nowhere
+    EXPECT_NE(id, ss.getSampleFile(id).id);
+
+    std::array<uint8_t, 100> listBuf;
+    SimpleOutStream listOut(listBuf);
+    ss.serializeList(listOut);
+    SimpleInStream list(std::span<const uint8_t>(listBuf.data(), listOut.tellg()));
+    list.read<uint8_t>();
+    list.read<uint8_t>();
+    list.read<uint8_t>();
+    list.read<uint16_t>();
+    list.read<uint16_t>();
+    EXPECT_EQ(0u, list.read<uint8_t>());
+
+    // -- the acknowledge shows the stopped upload with an error
+    const auto ack = readAck();
+    EXPECT_EQ(id, ack.id);
+    EXPECT_EQ(1u, ack.errors);
+    EXPECT_EQ(0u, ack.active);
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+}
+
+/** Test the sequenced upload:
+ *
+ *  - SampleStorageSingleton::executeCommand() with CMD_ADD_DATA_SEQ
+ *  - SampleStorageSingleton::serializeAck()
+ */
+TEST(SSTest, SequencedUpload) {
+    auto& ss = SampleStorageSingleton::getInstance();
+    rcSamples::AudioId id({'s', 'e', 'q'});
+
+    std::vector<uint8_t> data(1000u);
+    for (size_t i = 0u; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 7u);
+    }
+
+    const uint32_t chunkSize = 100u;
+    const auto chunk = [&](uint16_t seq, bool corrupt = false) {
+        const uint32_t offset = seq * chunkSize;
+        std::span<const uint8_t> part(data.data() + offset, chunkSize);
+        std::vector<uint8_t> buf = {'R', 'A', 1, 0x03u, 's', 'e', 'q'};
+        appendUint16(buf, seq);
+        appendUint32(buf, offset);
+        appendUint32(buf, chunkSize);
+        appendUint16(buf, crc16le(UINT16_MAX, part));
+        buf.insert(buf.end(), part.begin(), part.end());
+        if (corrupt) {
+            buf.back() ^= 0x01u;
+        }
+        return buf;
+    };
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+    std::vector<uint8_t> add = {'R', 'A', 1, 0x01u, 's', 'e', 'q'};
+    appendUint32(add, data.size());
+    execute(add);
+
+    auto ack = readAck();
+    EXPECT_EQ(id, ack.id);
+    EXPECT_EQ(0u, ack.seq);
+    EXPECT_EQ(16u, ack.window);
+    EXPECT_EQ(0u, ack.errors);
+    EXPECT_EQ(1u, ack.active);
+
+    // -- in order
+    execute(chunk(0u));
+    execute(chunk(1u));
+    EXPECT_EQ(2u, readAck().seq);
+
+    // -- a corrupted chunk is rejected, the following ones are dropped
+    execute(chunk(2u, true));
+    execute(chunk(3u));
+    execute(chunk(4u));
+    ack = readAck();
+    EXPECT_EQ(2u, ack.seq);
+    EXPECT_EQ(1u, ack.errors);
+
+    // -- duplicates are dropped
+    execute(chunk(1u));
+    EXPECT_EQ(2u, readAck().seq);
+
+    // -- the expected seq with the wrong offset is rejected
+    std::vector<uint8_t> skipped = chunk(3u);
+    skipped[8] = 2u;  // seq
+    execute(skipped);
+    ack = readAck();
+    EXPECT_EQ(2u, ack.seq);
+    EXPECT_EQ(2u, ack.errors);
+
+    // -- go back and send the rest
+    for (uint16_t seq = 2u; seq < 10u; seq++) {
+        execute(chunk(seq));
+    }
+    ack = readAck();
+    EXPECT_EQ(10u, ack.seq);
+    EXPECT_EQ(2u, ack.errors);
+
+    // -- the stored sample is complete
+    auto file = ss.getSampleFile(id);
+    ASSERT_EQ(data.size(), file.content.size());
+    for (size_t i = 0u; i < data.size(); i++) {
+        EXPECT_EQ(data[i], file.content[i]) << "byte " << i;
+    }
+
+    // -- chunks for another sample are dropped
+    std::vector<uint8_t> other = chunk(0u);
+    other[6] = 'x';  // ID
+    other[8] = 10u;  // seq
+    execute(other);
+    EXPECT_EQ(10u, readAck().seq);
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+}
+
+/** Test replacing (CMD_ADD with an existing ID) and removing a single sample. */
+TEST(SSTest, ReplaceRemove) {
+    auto& ss = SampleStorageSingleton::getInstance();
+    const rcSamples::AudioId id1({'r', 'p', '1'});
+    const rcSamples::AudioId id2({'r', 'p', '2'});
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+    upload(id1, 10u, 1u);
+    upload(id2, 20u, 2u);
+
+    // -- replace
+    upload(id1, 30u, 3u);
+    auto file1 = ss.getSampleFile(id1);
+    ASSERT_EQ(id1, file1.id);
+    ASSERT_EQ(30u, file1.content.size());
+    EXPECT_EQ(3u, file1.content[29]);
+    auto file2 = ss.getSampleFile(id2);
+    ASSERT_EQ(20u, file2.content.size());
+    EXPECT_EQ(2u, file2.content[19]);
+
+    // -- remove
+    execute({'R', 'A', 1, 0x04u, 'r', 'p', '1'});
+    EXPECT_FALSE(id1 == ss.getSampleFile(id1).id);
+    EXPECT_EQ(id2, ss.getSampleFile(id2).id);
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+}
+
+/** SampleStorageSingleton::getAudioId() for the SampleData of a proc
+ *  after the dynamic samples changed.
+ */
+TEST(SSTest, AudioIdAfterRemove) {
+    auto& ss = SampleStorageSingleton::getInstance();
+    const rcSamples::AudioId id1({'x', 'y', 'z'});
+    const rcSamples::AudioId id2({'e', 'f', 'g'});
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+    upload(id1, 10u, 1u);
+    upload(id2, 20u, 2u);
+
+    // the proc keeps a copy of the SampleData
+    const rcAudio::SampleData data = ss.getSampleData(id2);
+    EXPECT_EQ(id2, ss.getAudioId(data));
+
+    execute({'R', 'A', 1, 0x04u, 'x', 'y', 'z'});  // remove
+    EXPECT_EQ(id2, ss.getAudioId(data));
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+}
+
+/** Test:
+ *
+ *  - SampleStorageSingleton::prepareCompact()
+ *  - SampleStorageSingleton::commitCompact()
+ *  - SampleStorageSingleton::getPendingMove()
+ *  - rcAudio::SampleData::relocate()
+ *
+ *  The SampleData of the procs can be pointed to the moved sample.
+ */
+TEST(SSTest, CompactMove) {
+    auto& ss = SampleStorageSingleton::getInstance();
+    const std::vector<rcSamples::AudioId> ids = {{'m', 'v', '1'}, {'m', 'v', '2'}, {'m', 'v', '3'}};
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+    while (ss.compact()) {
+        ss.moveDone();
+    }
+    EXPECT_FALSE(ss.isCompactPending());
+
+    // -- a gap in the middle
+    for (uint8_t i = 0u; i < ids.size(); i++) {
+        upload(ids[i], 100u, i + 1u);
+    }
+    execute({'R', 'A', 1, 0x04u, 'm', 'v', '2'});  // remove
+    EXPECT_TRUE(ss.isCompactPending());
+
+    // the procs keep copies of the SampleData
+    const rcAudio::SampleData data1 = ss.getSampleData(ids[0]);
+    const rcAudio::SampleData data3 = ss.getSampleData(ids[2]);
+    std::vector<rcAudio::SampleData> procData = {data1, data3};
+
+    // -- the copy is written, the readers still get the old samples
+    ASSERT_TRUE(ss.prepareCompact());
+    EXPECT_FALSE(ss.isMovePending());
+    EXPECT_EQ(data1.data(), ss.getSampleData(ids[0]).data());
+    EXPECT_EQ(data3.data(), ss.getSampleData(ids[2]).data());
+
+    // -- one sample is moved, no further move until the procs use it
+    ss.commitCompact();
+    EXPECT_TRUE(ss.isMovePending());
+    EXPECT_FALSE(ss.compact());
+
+    const auto& move = ss.getPendingMove();
+    uint32_t relocated = 0u;
+    for (auto& data : procData) {
+        if (data.relocate(move.from, move.to)) {
+            relocated++;
+        }
+    }
+    EXPECT_EQ(1u, relocated);
+    ss.moveDone();
+    EXPECT_FALSE(ss.isMovePending());
+
+    EXPECT_EQ(ids[0], ss.getAudioId(procData[0]));
+    EXPECT_EQ(ids[2], ss.getAudioId(procData[1]));
+    EXPECT_EQ(ss.getSampleData(ids[0]).data(), procData[0].data());
+    EXPECT_EQ(ss.getSampleData(ids[2]).data(), procData[1].data());
+    ASSERT_EQ(100u, procData[1].size());
+    EXPECT_EQ(3u, procData[1][99]);
+
+    execute({'R', 'A', 1, 0x00u});  // reset
+}
@@ -0,0 +1,185 @@
+/** Tests for the SharedBuffer used between the main task and bluetooth */
+
+#include "shared_buffer.h"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/** Fills the buffer with a pattern depending on the sequence number. */
+void fillBuffer(SharedBuffer* buffer, uint32_t seq) {
+    uint8_t* data = sharedBufferData(buffer);
+    std::memcpy(data, &seq, sizeof(seq));
+    for (size_t i = sizeof(seq); i < sharedBufferLen(buffer); i++) {
+        data[i] = static_cast<uint8_t>(seq + i);
+    }
+}
+
+/** Returns the sequence number or -1 if the pattern is broken. */
+int64_t checkBuffer(SharedBuffer* buffer) {
+    const uint8_t* data = sharedBufferData(buffer);
+    uint32_t seq;
+    std::memcpy(&seq, data, sizeof(seq));
+    for (size_t i = sizeof(seq); i < sharedBufferLen(buffer); i++) {
+        if (data[i] != static_cast<uint8_t>(seq + i)) {
+            return -1;
+        }
+    }
+    return seq;
+}
+
+} // namespace
+
+/** Tests the reference counting of a single buffer. */
+TEST(SharedBufferTest, RefCount) {
+    const size_t allocated = sharedBufferNumAllocated();
+
+    SharedBuffer* buffer = sharedBufferCreate(10u);
+    ASSERT_NE(nullptr, buffer);
+    EXPECT_EQ(allocated + 1u, sharedBufferNumAllocated());
+    EXPECT_EQ(1u, sharedBufferRefs(buffer));
+    EXPECT_EQ(10u, sharedBufferCapacity(buffer));
+    EXPECT_EQ(10u, sharedBufferLen(buffer));
+
+    sharedBufferSetLen(buffer, 4u);
+    EXPECT_EQ(4u, sharedBufferLen(buffer));
+    EXPECT_EQ(4u, sharedBufferSpan(buffer).size());
+    EXPECT_EQ(10u, sharedBufferCapacitySpan(buffer).size());
+    sharedBufferSetLen(buffer, 11u);
+    EXPECT_EQ(10u, sharedBufferLen(buffer));
+
+    sharedBufferRetain(buffer);
+    EXPECT_EQ(2u, sharedBufferRefs(buffer));
+    sharedBufferRelease(buffer);
+    EXPECT_EQ(allocated + 1u, sharedBufferNumAllocated());
+    sharedBufferRelease(buffer);
+    EXPECT_EQ(allocated, sharedBufferNumAllocated());
+
+    sharedBufferRelease(nullptr);  // ignored
+}
+
+/** Tests that the slot keeps acquired buffers alive. */
+TEST(SharedBufferTest, Slot) {
+    const size_t allocated = sharedBufferNumAllocated();
+
+    SharedBufferSlot* slot = sharedBufferSlotCreate();
+    EXPECT_TRUE(sharedBufferSlotIsEmpty(slot));
+    EXPECT_EQ(nullptr, sharedBufferSlotAcquire(slot));
+
+    SharedBuffer* first = sharedBufferCreate(8u);
+    fillBuffer(first, 1u);
+    sharedBufferSlotPublish(slot, first);
+    EXPECT_FALSE(sharedBufferSlotIsEmpty(slot));
+
+    SharedBuffer* acquired = sharedBufferSlotAcquire(slot);
+    EXPECT_EQ(first, acquired);
+    EXPECT_EQ(2u, sharedBufferRefs(acquired));
+
+    // the reader still holds the first buffer
+    SharedBuffer* second = sharedBufferCreate(8u);
+    fillBuffer(second, 2u);
+    sharedBufferSlotPublish(slot, second);
+    EXPECT_EQ(allocated + 2u, sharedBufferNumAllocated());
+    EXPECT_EQ(1u, sharedBufferRefs(acquired));
+    EXPECT_EQ(1, checkBuffer(acquired));
+
+    sharedBufferRelease(acquired);
+    EXPECT_EQ(allocated + 1u, sharedBufferNumAllocated());
+
+    sharedBufferSlotPublish(slot, nullptr);
+    EXPECT_TRUE(sharedBufferSlotIsEmpty(slot));
+    EXPECT_EQ(allocated, sharedBufferNumAllocated());
+    sharedBufferSlotDestroy(slot);
+}
+
+/** Tests that pool buffers are only reused once released by everybody. */
+TEST(SharedBufferTest, Pool) {
+    const size_t allocated = sharedBufferNumAllocated();
+    {
+        SharedBufferPool<2> pool(4u);
+        EXPECT_EQ(allocated + 2u, sharedBufferNumAllocated());
+
+        SharedBuffer* a = pool.get();
+        SharedBuffer* b = pool.get();
+        ASSERT_NE(nullptr, a);
+        ASSERT_NE(nullptr, b);
+        EXPECT_NE(a, b);
+        EXPECT_EQ(nullptr, pool.get());
+
+        sharedBufferSetLen(b, 2u);
+        sharedBufferRelease(b);
+        EXPECT_EQ(b, pool.get());
+        EXPECT_EQ(4u, sharedBufferLen(b));  // length is reset
+
+        sharedBufferRelease(a);
+        sharedBufferRelease(b);
+    }
+    EXPECT_EQ(allocated, sharedBufferNumAllocated());
+}
+
+/** Runs a publisher (main task) against several readers (GATT callbacks).
+ *
+ *  The readers check the content of the buffers while the publisher
+ *  replaces them. A buffer freed too early would show up as a broken
+ *  pattern, as a decreasing sequence number or in the ThreadSanitizer.
+ */
+TEST(SharedBufferTest, Threads) {
+    static constexpr uint32_t NUM_PUBLISH = 20000u;
+    static constexpr size_t NUM_READERS = 3u;
+
+    const size_t allocated = sharedBufferNumAllocated();
+    SharedBufferSlot* slot = sharedBufferSlotCreate();
+
+    std::vector<std::thread> readers;
+    std::vector<int> errors(NUM_READERS, 0);
+    std::vector<int> reads(NUM_READERS, 0);
+    for (size_t r = 0u; r < NUM_READERS; r++) {
+        readers.emplace_back([&, r]() {
+            int64_t lastSeq = 0;
+            while (lastSeq != NUM_PUBLISH) {
+                SharedBuffer* buffer = sharedBufferSlotAcquire(slot);
+                if (buffer == nullptr) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const int64_t seq = checkBuffer(buffer);
+                if (seq < lastSeq) {  // broken pattern or older buffer
+                    errors[r]++;
+                }
+                if (seq >= 0) {
+                    lastSeq = seq;
+                }
+                reads[r]++;
+                sharedBufferRelease(buffer);
+            }
+        });
+    }
+
+    // publish dynamically sized and pooled buffers alternately
+    SharedBufferPool<3> pool(64u);
+    for (uint32_t seq = 1u; seq <= NUM_PUBLISH; seq++) {
+        // the last one is always published
+        SharedBuffer* buffer = (seq % 2u || seq == NUM_PUBLISH) ?
+            sharedBufferCreate(16u + seq % 48u) : pool.get();
+        if (buffer == nullptr) {
+            continue;  // all pool buffers still in use
+        }
+        fillBuffer(buffer, seq);
+        sharedBufferSlotPublish(slot, buffer);
+    }
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (size_t r = 0u; r < NUM_READERS; r++) {
+        EXPECT_EQ(0, errors[r]) << "reader " << r;
+        EXPECT_LT(0, reads[r]) << "reader " << r;
+    }
+
+    sharedBufferSlotPublish(slot, nullptr);
+    EXPECT_EQ(allocated + 3u, sharedBufferNumAllocated());  // only the pool
+    sharedBufferSlotDestroy(slot);
+}
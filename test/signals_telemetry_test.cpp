@@ -0,0 +1,167 @@
+/** Tests for the delta encoded signals telemetry
+ *
+ *  @file
+ */
+
+#include "signals_telemetry.h"
+#include "proc_storage.h"
+#include "simple_byte_stream.h"
+#include "signals.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace rcSignals;
+
+namespace {
+
+typedef std::array<uint8_t, SignalsTelemetryEncoder::MAX_FRAME_SIZE> Frame;
+
+/** Records the signals of the default configuration for the given number of 20ms steps. */
+std::vector<Signals> recordTrace(size_t numSteps) {
+    ProcStorage storage;
+    storage.start();
+
+    std::vector<Signals> trace;
+    Signals signals;
+    for (size_t i = 0u; i < numSteps; i++) {
+        signals.reset();
+        rcProc::StepInfo info = {
+            .deltaMs = 20u,
+            .signals = &signals,
+            .intervals = {
+                rcProc::SamplesInterval{.first = nullptr, .last = nullptr},
+                rcProc::SamplesInterval{.first = nullptr, .last = nullptr}}
+        };
+        storage.step(info);
+        trace.push_back(signals);
+    }
+    storage.stop();
+    return trace;
+}
+
+/** Encodes one frame and returns the used part of the buffer. */
+std::span<const uint8_t> encode(SignalsTelemetryEncoder& encoder,
+        const Signals& signals, Frame& frame) {
+    SimpleOutStream out(frame);
+    encoder.encode(signals, out);
+    EXPECT_FALSE(out.fail());
+    return std::span<const uint8_t>(frame.data(), out.tellg());
+}
+
+/** Decodes one frame. */
+bool decode(SignalsTelemetryDecoder& decoder, std::span<const uint8_t> frame) {
+    SimpleInStream in(frame);
+    return decoder.decode(in);
+}
+
+} // namespace
+
+
+/** Round trips a trace recorded from the default configuration.
+ *
+ *  Tests
+ *  - SignalsTelemetryEncoder::encode()
+ *  - SignalsTelemetryDecoder::decode()
+ */
+TEST(SignalsTelemetryTest, RoundTripTrace) {
+    const auto trace = recordTrace(1000u);
+
+    SignalsTelemetryEncoder encoder;
+    SignalsTelemetryDecoder decoder;
+    Frame frame;
+    size_t encodedSize = 0u;
+    for (size_t i = 0u; i < trace.size(); i++) {
+        const auto data = encode(encoder, trace[i], frame);
+        encodedSize += data.size();
+
+        // a keyframe at the start and every KEYFRAME_INTERVAL frames
+        EXPECT_EQ((i % SignalsTelemetryEncoder::KEYFRAME_INTERVAL) ? 'D' : 'K', data[0]) << i;
+        EXPECT_EQ(static_cast<uint8_t>(i), data[1]);
+
+        ASSERT_TRUE(decode(decoder, data)) << "frame " << i;
+        EXPECT_TRUE(decoder.isSynced());
+        EXPECT_EQ(trace[i].signals, decoder.getSignals().signals) << "frame " << i;
+    }
+
+    // the full signals would be two bytes per signal
+    const size_t rawSize = trace.size() * sizeof(trace[0].signals);
+    EXPECT_LT(encodedSize * 4u, rawSize);
+}
+
+/** Tests the extreme values and differences. */
+TEST(SignalsTelemetryTest, RoundTripExtremes) {
+    SignalsTelemetryEncoder encoder;
+    SignalsTelemetryDecoder decoder;
+    Frame frame;
+
+    std::vector<Signals> trace(4u);
+    for (uint8_t i = 0u; i < Signals::NUM_SIGNALS; i++) {
+        trace[0].signals[i] = (i % 2u) ? INT16_MAX : INT16_MIN;
+        trace[1].signals[i] = (i % 2u) ? INT16_MIN : INT16_MAX;
+        trace[2].signals[i] = static_cast<RcSignal>(i * 1000 - 20000);
+        trace[3].signals[i] = RCSIGNAL_INVALID;
+    }
+
+    for (const auto& signals : trace) {
+        const auto data = encode(encoder, signals, frame);
+        EXPECT_LE(data.size(), SignalsTelemetryEncoder::MAX_FRAME_SIZE);
+        ASSERT_TRUE(decode(decoder, data));
+        EXPECT_EQ(signals.signals, decoder.getSignals().signals);
+    }
+
+    // no change: header and mask only
+    const auto data = encode(encoder, trace[3], frame);
+    EXPECT_EQ(3u + SignalsTelemetryEncoder::MASK_SIZE, data.size());
+    ASSERT_TRUE(decode(decoder, data));
+    EXPECT_EQ(trace[3].signals, decoder.getSignals().signals);
+}
+
+/** Tests resyncing after lost, repeated and broken frames. */
+TEST(SignalsTelemetryTest, Resync) {
+    const auto trace = recordTrace(100u);
+
+    SignalsTelemetryEncoder encoder;
+    SignalsTelemetryDecoder decoder;
+    Frame frame;
+
+    // -- delta frames before the first keyframe are ignored
+    encode(encoder, trace[0], frame);
+    auto data = encode(encoder, trace[1], frame);
+    EXPECT_FALSE(decode(decoder, data));
+    EXPECT_FALSE(decoder.isSynced());
+
+    encoder.requestKeyframe();
+    data = encode(encoder, trace[2], frame);
+    EXPECT_EQ('K', data[0]);
+    EXPECT_TRUE(decode(decoder, data));
+    EXPECT_EQ(trace[2].signals, decoder.getSignals().signals);
+
+    // -- a repeated frame is ignored but doesn't lose the sync
+    data = encode(encoder, trace[3], frame);
+    EXPECT_TRUE(decode(decoder, data));
+    EXPECT_FALSE(decode(decoder, data));
+    EXPECT_TRUE(decoder.isSynced());
+
+    // -- a truncated frame doesn't change the signals
+    data = encode(encoder, trace[50], frame);
+    EXPECT_FALSE(decode(decoder, data.first(data.size() - 1u)));
+    EXPECT_EQ(trace[3].signals, decoder.getSignals().signals);
+    EXPECT_FALSE(decoder.isSynced());
+
+    // -- after a lost frame we wait for the next keyframe
+    size_t i = 4u;
+    for (; i < trace.size(); i++) {
+        data = encode(encoder, trace[i], frame);
+        if (data[0] == 'K') {
+            break;
+        }
+        EXPECT_FALSE(decode(decoder, data));
+    }
+    ASSERT_LT(i, trace.size());
+    EXPECT_TRUE(decode(decoder, data));
+    EXPECT_EQ(trace[i].signals, decoder.getSignals().signals);
+    EXPECT_TRUE(decoder.isSynced());
+}
@@ -0,0 +1,212 @@
+/** Tests for the wav_converter.cpp */
+
+#include "wav_converter.h"
+#include "audio.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <vector>
+
+namespace {
+
+void writeUint16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(value & 0xFFu);
+    out.push_back(value >> 8);
+}
+
+void writeUint32(std::vector<uint8_t>& out, uint32_t value) {
+    writeUint16(out, value & 0xFFFFu);
+    writeUint16(out, value >> 16);
+}
+
+void writeTag(std::vector<uint8_t>& out, const char* tag) {
+    out.insert(out.end(), tag, tag + 4);
+}
+
+/** Creates a WAV file with a LIST chunk (odd size) before the data. */
+std::vector<uint8_t> createWav(uint16_t channels, uint16_t bits, uint32_t rate,
+        const std::vector<uint8_t>& data, uint16_t formatType = 1u) {
+
+    std::vector<uint8_t> wav;
+    writeTag(wav, "RIFF");
+    writeUint32(wav, 0u);  // not checked
+    writeTag(wav, "WAVE");
+
+    writeTag(wav, "fmt ");
+    writeUint32(wav, 16u);
+    writeUint16(wav, formatType);
+    writeUint16(wav, channels);
+    writeUint32(wav, rate);
+    writeUint32(wav, rate * channels * bits / 8u);
+    writeUint16(wav, channels * bits / 8u);
+    writeUint16(wav, bits);
+
+    writeTag(wav, "LIST");
+    writeUint32(wav, 3u);
+    wav.insert(wav.end(), {'a', 'b', 'c', 0u});  // with padding
+
+    writeTag(wav, "data");
+    writeUint32(wav, data.size());
+    wav.insert(wav.end(), data.begin(), data.end());
+    return wav;
+}
+
+/** Creates 16 bit stereo samples with a sine on both channels. */
+std::vector<uint8_t> createSine(uint32_t rate, float frequency, float amplitude, uint32_t frames) {
+    std::vector<uint8_t> data;
+    for (uint32_t i = 0u; i < frames; i++) {
+        const auto value = static_cast<int16_t>(std::lround(amplitude *
+            std::sin(2.0f * std::numbers::pi_v<float> * frequency * i / rate)));
+        writeUint16(data, static_cast<uint16_t>(value));
+        writeUint16(data, static_cast<uint16_t>(value));
+    }
+    return data;
+}
+
+/** Converts the whole file in chunks of the given size. */
+std::vector<uint8_t> convert(WavConverter& converter,
+        const std::vector<uint8_t>& wav, size_t chunkSize) {
+
+    std::vector<uint8_t> out;
+    converter.reset(wav.size());
+    std::span<const uint8_t> data(wav);
+    while (!data.empty()) {
+        const size_t size = std::min(chunkSize, data.size());
+        converter.write(data.subspan(0u, size), out);
+        data = data.subspan(size);
+    }
+    converter.finish(out);
+    return out;
+}
+
+} // namespace
+
+/** Files in the internal format are copied unchanged. */
+TEST(WavConverterTest, Native) {
+    std::vector<uint8_t> samples;
+    for (uint32_t i = 0u; i < 1000u; i++) {
+        samples.push_back(static_cast<uint8_t>(i * 13u));
+    }
+    const auto wav = createWav(1u, 8u, rcAudio::SAMPLE_RATE, samples);
+    EXPECT_TRUE(WavConverter::isWav(wav));
+
+    WavConverter converter;
+    for (const size_t chunkSize : {1u, 7u, 44u, 2000u}) {
+        const auto out = convert(converter, wav, chunkSize);
+        EXPECT_EQ(WavConverter::State::DONE, converter.getState());
+        EXPECT_EQ(samples.size(), converter.getConvertedSize());
+        EXPECT_EQ(samples, out) << "chunk size " << chunkSize;
+    }
+}
+
+/** A 16 bit stereo file with 44.1 kHz is down sampled. */
+TEST(WavConverterTest, Resample) {
+    const uint32_t frames = 4410u;
+    const auto wav = createWav(2u, 16u, 44100u, createSine(44100u, 1000.0f, 16000.0f, frames));
+
+    WavConverter converter;
+    const auto out = convert(converter, wav, 512u);
+    EXPECT_EQ(WavConverter::State::DONE, converter.getState());
+    EXPECT_EQ(2u, converter.getChannels());
+    EXPECT_EQ(16u, converter.getBitsPerSample());
+    EXPECT_EQ(44100u, converter.getSampleRate());
+    ASSERT_EQ(frames / 2u, converter.getConvertedSize());
+    ASSERT_EQ(frames / 2u, out.size());
+
+    // the result is the same sine (with some filter ripple and dither)
+    for (size_t i = 20u; i < out.size() - 20u; i++) {
+        const float expected = 128.0f + 16000.0f / 256.0f *
+            std::sin(2.0f * std::numbers::pi_v<float> * 1000.0f * i / rcAudio::SAMPLE_RATE);
+        EXPECT_NEAR(expected, out[i], 3.0f) << "sample " << i;
+    }
+
+    // the chunking doesn't change anything
+    EXPECT_EQ(out, convert(converter, wav, 1u));
+    EXPECT_EQ(out, convert(converter, wav, 3u));
+}
+
+/** Frequencies above the new nyquist frequency are filtered. */
+TEST(WavConverterTest, AntiAliasing) {
+    const auto wav = createWav(2u, 16u, 48000u, createSine(48000u, 18000.0f, 16000.0f, 4800u));
+
+    WavConverter converter;
+    const auto out = convert(converter, wav, 512u);
+    ASSERT_EQ(2205u, out.size());
+
+    // without the filter this would alias to a 4050 Hz sine with 62 LSB amplitude
+    for (size_t i = 20u; i < out.size() - 20u; i++) {
+        EXPECT_NEAR(128.0f, out[i], 3.0f) << "sample " << i;
+    }
+}
+
+/** An 8 kHz file is up sampled. */
+TEST(WavConverterTest, Upsample) {
+    std::vector<uint8_t> samples(800u, 200u);
+    const auto wav = createWav(1u, 8u, 8000u, samples);
+
+    WavConverter converter;
+    const auto out = convert(converter, wav, 100u);
+    EXPECT_EQ(WavConverter::State::DONE, converter.getState());
+    ASSERT_EQ(2205u, out.size());
+
+    // a constant signal stays constant (apart from the edges)
+    for (size_t i = 40u; i < out.size() - 40u; i++) {
+        EXPECT_NEAR(200.0f, out[i], 1.0f) << "sample " << i;
+    }
+}
+
+/** The output can be ADPCM encoded. */
+TEST(WavConverterTest, Adpcm) {
+    const uint32_t frames = 4410u;
+    const auto wav = createWav(2u, 16u, 44100u, createSine(44100u, 1000.0f, 16000.0f, frames));
+
+    WavConverter converter;
+    converter.setAdpcm(true);
+    const auto out = convert(converter, wav, 512u);
+    EXPECT_EQ(WavConverter::State::DONE, converter.getState());
+    ASSERT_EQ(frames / 2u, converter.getNumSamples());
+    ASSERT_EQ(rcAudio::adpcmBytes(frames / 2u), converter.getConvertedSize());
+    ASSERT_EQ(converter.getConvertedSize(), out.size());
+
+    const auto sample = rcAudio::SampleData::adpcm(out, rcAudio::ADPCM_BLOCK_SIZE, frames / 2u);
+    rcAudio::SampleReader reader;
+    for (uint32_t i = 20u; i < sample.size() - 20u; i++) {
+        const float expected = 128.0f + 16000.0f / 256.0f *
+            std::sin(2.0f * std::numbers::pi_v<float> * 1000.0f * i / rcAudio::SAMPLE_RATE);
+        EXPECT_NEAR(expected, reader.at(sample, i), 4.0f) << "sample " << i;
+    }
+
+    // native files are encoded, too
+    std::vector<uint8_t> samples(1000u, 200u);
+    const auto native = convert(converter, createWav(1u, 8u, rcAudio::SAMPLE_RATE, samples), 100u);
+    EXPECT_EQ(rcAudio::adpcmBytes(1000u), native.size());
+    converter.setAdpcm(false);
+}
+
+/** Unsupported files are reported as errors. */
+TEST(WavConverterTest, Unsupported) {
+    WavConverter converter;
+    std::vector<uint8_t> samples(300u, 0u);
+
+    // 24 bit
+    convert(converter, createWav(1u, 24u, 44100u, samples), 50u);
+    EXPECT_EQ(WavConverter::State::ERROR, converter.getState());
+
+    // float
+    convert(converter, createWav(1u, 16u, 44100u, samples, 3u), 50u);
+    EXPECT_EQ(WavConverter::State::ERROR, converter.getState());
+
+    // sample rate too high
+    convert(converter, createWav(1u, 16u, 96000u, samples), 50u);
+    EXPECT_EQ(WavConverter::State::ERROR, converter.getState());
+
+    // no WAV file at all
+    EXPECT_FALSE(WavConverter::isWav(samples));
+    convert(converter, samples, 50u);
+    EXPECT_EQ(WavConverter::State::ERROR, converter.getState());
+}
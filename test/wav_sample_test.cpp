@@ -1,8 +1,11 @@
 /** Tests for the wav_sample.cpp */
 
 #include "wav_sample.h"
+#include "audio_adpcm.h"
 #include <gtest/gtest.h>
 
+#include <vector>
+
 extern const uint8_t _binary_dummy_wav_start[];
 extern const uint8_t _binary_dummy_wav_end[];
 
@@ -39,3 +42,44 @@ TEST(WavSampleTest, WavSampleRaw) {
     EXPECT_EQ(6, wavSamples.size());
 }
 
+
+/** Unit test for WavSample
+ *
+ *  This test is using an IMA-ADPCM wav file with a fact chunk.
+ */
+TEST(WavSampleTest, WavSampleAdpcm) {
+
+    std::vector<uint8_t> wav = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 20, 0, 0, 0,
+        0x11, 0, 1, 0,  // IMA-ADPCM, mono
+        0x22, 0x56, 0, 0, 0, 0, 0, 0,  // sample rate, bytes per second
+        0, 1, 4, 0,  // block align, bits
+        2, 0, 0xF9, 1,  // extra size, samples per block
+        'f', 'a', 'c', 't', 4, 0, 0, 0,
+        0xE8, 3, 0, 0,  // 1000 samples
+        'd', 'a', 't', 'a', 0, 0, 0, 0};
+    const size_t dataStart = wav.size();
+
+    // 1000 samples need 2 full blocks and one with 4 + 1 bytes
+    const uint32_t dataSize = rcAudio::adpcmBytes(1000u);
+    wav[dataStart - 4] = dataSize & 0xFFu;
+    wav[dataStart - 3] = dataSize >> 8;
+    wav.resize(dataStart + dataSize, 0u);
+
+    auto sample = getWavSampleData(wav);
+    EXPECT_TRUE(sample.isAdpcm());
+    EXPECT_EQ(256u, sample.getBlockSize());
+    EXPECT_EQ(1000u, sample.size());
+    EXPECT_EQ(wav.data() + dataStart, sample.data());
+
+    // getWavSamples() doesn't know ADPCM and returns everything
+    EXPECT_EQ(wav.size(), getWavSamples(wav).size());
+
+    // PCM files are not affected
+    std::span<const uint8_t> sp(
+        _binary_dummy_wav_start,
+        _binary_dummy_wav_end - _binary_dummy_wav_start);
+    auto pcm = getWavSampleData(sp);
+    EXPECT_FALSE(pcm.isAdpcm());
+    EXPECT_EQ(2u, pcm.size());
+}
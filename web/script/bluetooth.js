@@ -15,6 +15,8 @@
 
 const uuidSignalsService = "31522e91-04d6-dfae-2042-3a40b42d393f";
 const uuidSignalsCharacteristic = "177d4281-2c71-50b2-264f-3fb3f9b556a8";
+const uuidAudioStatsCharacteristic = "1b7d4281-2c71-50b2-264f-3fb3f9b556a8";
+const uuidProfileCharacteristic = "1c7d4281-2c71-50b2-264f-3fb3f9b556a8";
 const uuidConfigService = "32522e91-04d6-dfae-2042-3a40b42d393f";
 const uuidConfigCharacteristic = "187d4281-2c71-50b2-264f-3fb3f9b556a8";
 const uuidAudioCharacteristic  = "197d4281-2c71-50b2-264f-3fb3f9b556a8";
@@ -28,6 +30,10 @@ let serviceSignals = null;
 let serviceConfig = null;
 /** The signals characteristics returned by getCharacteristics() */
 let characteristicSignals;
+/** The audio statistics characteristics returned by getCharacteristics() */
+let characteristicAudioStats;
+/** The profile characteristics returned by getCharacteristics() */
+let characteristicProfile;
 /** The config characteristics returned by getCharacteristics() */
 let characteristicConfig;
 /** The audio characteristics returned by getCharacteristics() */
@@ -131,6 +137,20 @@ async function connectToDevice(){
       startSignalsNotification(btSignalsUpdateCallback);
     }
 
+    // older firmware does not provide the audio statistics
+    try {
+      characteristicAudioStats = await serviceSignals.getCharacteristic(uuidAudioStatsCharacteristic);
+    } catch(error) {
+      console.log("No audio statistics characteristic: ", error);
+      characteristicAudioStats = null;
+    }
+    try {
+      characteristicProfile = await serviceSignals.getCharacteristic(uuidProfileCharacteristic);
+    } catch(error) {
+      console.log("No profile characteristic: ", error);
+      characteristicProfile = null;
+    }
+
     serviceConfig = await bleServer.getPrimaryService(uuidConfigService);
     console.log("Service discovered:", serviceConfig.uuid);
 
@@ -161,6 +181,8 @@ function onDisconnected(event){
   bleServer = null;
   serviceSignals = null;
   characteristicSignals = null;
+  characteristicAudioStats = null;
+  characteristicProfile = null;
   characteristicConfig = null;
   characteristicAudio = null;
   characteristicAudioList = null;
@@ -213,6 +235,41 @@ async function uploadSignals(dataView) {
   }
 }
 
+/** Reads the audio statistics of the last second.
+ *
+ *  Returns a DataView or null.
+ */
+async function downloadAudioStats() {
+  if (bleServer && bleServer.connected && characteristicAudioStats) {
+      let dataView = await characteristicAudioStats.readValue();
+      return dataView;
+  }
+  return null;
+}
+
+/** Reads the step times of the procs.
+ *
+ *  Returns a DataView or null.
+ */
+async function downloadProfile() {
+  if (bleServer && bleServer.connected && characteristicProfile) {
+      let dataView = await characteristicProfile.readValue();
+      return dataView;
+  }
+  return null;
+}
+
+/** Switches the profiling on the controller on or off. */
+async function uploadProfileState(on) {
+  if (bleServer && bleServer.connected && characteristicProfile) {
+    try {
+      await characteristicProfile.writeValue(new Uint8Array([on ? 1 : 0]).buffer);
+    } catch(error) {
+        console.error("Error writing profile characteristics")
+    }
+  }
+}
+
 async function downloadConfig() {
   if (bleServer && bleServer.connected && characteristicConfig) {
       let dataView = await characteristicConfig.readValue();
@@ -225,10 +282,12 @@ async function uploadConfig(dataView) {
   if (bleServer && bleServer.connected && characteristicConfig) {
     try {
       await characteristicConfig.writeValue(dataView.buffer);
+      return true;
     } catch(error) {
         console.error("Error writing config characteristics")
     }
   }
+  return false;
 }
 
 /** Sends a message to the audio characteristics.
@@ -254,6 +313,49 @@ async function uploadAudio(dataView) {
   throw new Error("Error uploading: bluetooth not connected.");
 }
 
+/** Sends a message to the audio characteristics without waiting for a response.
+ *
+ *  Used for the sequenced sample upload. Lost messages are detected
+ *  with the acknowledge, see downloadAudioAck().
+ */
+async function uploadAudioWithoutResponse(dataView) {
+  if (bleServer && bleServer.connected && characteristicAudio) {
+    if (characteristicAudio.writeValueWithoutResponse) {
+      await characteristicAudio.writeValueWithoutResponse(dataView.buffer);
+    } else {
+      await characteristicAudio.writeValue(dataView.buffer);
+    }
+    return;
+  }
+  throw new Error("Error uploading: bluetooth not connected.");
+}
+
+/** Checks if the controller supports the sequenced sample upload.
+ *
+ *  Older firmware has an audio characteristic that can only be written.
+ */
+function hasAudioAck() {
+  return Boolean(characteristicAudio &&
+      characteristicAudio.properties.read &&
+      characteristicAudio.properties.writeWithoutResponse);
+}
+
+/** Reads the acknowledge of the sequenced sample upload.
+ *
+ *  Returns a DataView or null.
+ */
+async function downloadAudioAck() {
+  if (bleServer && bleServer.connected && characteristicAudio) {
+    try {
+      let dataView = await characteristicAudio.readValue();
+      return dataView;
+    } catch(error) {
+      console.error("Error reading Audio characteristics: " + error)
+    }
+  }
+  return null;
+}
+
 async function downloadAudioList() {
   if (bleServer && bleServer.connected && characteristicAudioList) {
     let dataView = await characteristicAudioList.readValue();
@@ -317,7 +419,13 @@ export {
   uploadConfig,
 
   uploadAudio,
+  uploadAudioWithoutResponse,
+  hasAudioAck,
+  downloadAudioAck,
   downloadAudioList,
+  downloadAudioStats,
+  downloadProfile,
+  uploadProfileState,
 
   setStatusCallback,
 }
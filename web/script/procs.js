@@ -54,6 +54,13 @@ for (let i = 0; i < defSample.length; i++) {
   }
 }
 
+/** The procs as they are on the controller, each encoded as a string.
+ *
+ *  Used to upload only a single changed proc as a patch.
+ *  null if we don't know the configuration on the controller.
+ */
+let controllerProcs = null;
+
 /** A callback function for status update.
  *
  *  Will get as parameters a string with a status message
@@ -628,6 +635,69 @@ function encodeConfig(configStruct) {
   return new DataView(buffer.transfer(stream.tellg));
 }
 
+/** Returns each proc of the configuration encoded as a string.
+ *
+ *  Used to compare configurations.
+ */
+function encodeProcs(configStruct) {
+  let result = [];
+  for (let i = 0; i < configStruct.length; i++) {
+    const buffer = new ArrayBuffer(400);
+    let stream = new SimpleOutputStream(new DataView(buffer));
+    stream.writeProc(configStruct[i]);
+    result.push(new Uint8Array(buffer, 0, stream.tellg).join(","));
+  }
+  return result;
+}
+
+/** Returns the patch that changes the old procs into the new ones.
+ *
+ *  @param oldProcs The encoded procs from encodeProcs()
+ *  @param newProcs The encoded procs from encodeProcs()
+ *  @returns A dict with "op" and "index" or null if more than one
+ *    proc changed.
+ */
+function findPatch(oldProcs, newProcs) {
+  if (oldProcs == null) {
+    return null;
+  }
+
+  // skip the identical procs at the start and the end
+  const minLength = Math.min(oldProcs.length, newProcs.length);
+  let start = 0;
+  while (start < minLength && oldProcs[start] == newProcs[start]) {
+    start++;
+  }
+  let end = 0;
+  while (end < minLength - start &&
+      oldProcs[oldProcs.length - 1 - end] == newProcs[newProcs.length - 1 - end]) {
+    end++;
+  }
+
+  const numOld = oldProcs.length - start - end;
+  const numNew = newProcs.length - start - end;
+  if (numOld == 1 && numNew == 1) {
+    return {"op": "R", "index": start};
+  } else if (numOld == 0 && numNew == 1) {
+    return {"op": "I", "index": start};
+  } else if (numOld == 1 && numNew == 0) {
+    return {"op": "D", "index": start};
+  }
+  return null;
+}
+
+/** Returns the encoded patch ready to send.
+ *
+ *  @param patch The patch from findPatch()
+ *  @param configStruct The new list of proc configurations.
+ */
+function encodePatch(patch, configStruct) {
+  let buffer = new ArrayBuffer(400);
+  let stream = new SimpleOutputStream(new DataView(buffer));
+  stream.writePatch(patch["op"], patch["index"], configStruct[patch["index"]]);
+  return new DataView(buffer.transfer(stream.tellg));
+}
+
 /** Opens a file dialog box for saving the data.
  *
  *  This simulates a click on a temporary created <a> tag
@@ -678,6 +748,7 @@ async function downloadConfig() {
   if (dataView) {
     console.log("Received " + dataView.byteLength + " bytes.");
     updateConfigFromData(dataView);
+    controllerProcs = encodeProcs(getConfigFromTable());
 
     if (procStatusCallback) {
       procStatusCallback("Downloading done.", {"color": "green"});
@@ -707,10 +778,17 @@ async function uploadConfig() {
     // upload samples
     await uploadMissingSamples(configStruct);
 
-    // upload the rest of the config
-    let dataView = encodeConfig(configStruct);
+    // upload the rest of the config.
+    // If only one proc changed we just send this one,
+    // so that the other procs keep running undisturbed.
+    const newProcs = encodeProcs(configStruct);
+    const patch = findPatch(controllerProcs, newProcs);
+    let dataView = patch ?
+      encodePatch(patch, configStruct) :
+      encodeConfig(configStruct);
     console.log("Uploading " + dataView.byteLength + " bytes.");
-    await bluetooth.uploadConfig(dataView);
+    const uploaded = await bluetooth.uploadConfig(dataView);
+    controllerProcs = uploaded ? newProcs : null;  // unknown in case of an error
 
   } catch(error) {
     console.error("Error writing Audio characteristics: " + error)
@@ -736,6 +814,7 @@ async function resetConfig() {
 
   // upload an empty config (triggers a reset)
   let dataView = encodeConfig(configStruct);
+  controllerProcs = null;  // the controller creates a default configuration
   await bluetooth.uploadConfig(dataView);
 }
 
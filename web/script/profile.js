@@ -0,0 +1,114 @@
+/** Functions for the proc step time profiling.
+ *
+ *  The controller measures the time of every proc step
+ *  (see ProcProfiler). This file switches the profiling on
+ *  and shows the results in a table.
+ */
+
+import {defProcs} from './def_procs.js';
+import {SimpleInputStream} from './simple_stream.js';
+
+import * as bluetooth from "./bluetooth.js";
+
+/** The interval timer updating the profile table or null. */
+let profileTimer = null;
+
+/** Returns the proc name for the two character id. */
+function procName(typeId) {
+  const id = String.fromCharCode(typeId >> 8, typeId & 0xff);
+  for (const proc of defProcs) {
+    if (proc["id"] == id) {
+      return proc["name"];
+    }
+  }
+  return id;
+}
+
+/** Reads the step times summary from the stream. */
+function readTimes(stream) {
+  return {
+    "min": stream.readUint16(),
+    "avg": stream.readUint16(),
+    "max": stream.readUint16(),
+    "p99": stream.readUint16(),
+  };
+}
+
+/** Decodes the profile report.
+ *
+ *  See architecture.md for the format.
+ *
+ *  @returns an object with the times per proc index and per proc type
+ *    or null if the data is not a valid report.
+ */
+function decodeProfile(dataView) {
+  const stream = new SimpleInputStream(dataView);
+  if (stream.readUint8() != "R".charCodeAt(0) ||
+      stream.readUint8() != "T".charCodeAt(0) ||
+      stream.readUint8() != 1) {
+    return null;
+  }
+
+  let profile = {"procs": [], "types": []};
+  const numProcs = stream.readUint8();
+  for (let i = 0; i < numProcs; i++) {
+    profile["procs"].push(readTimes(stream));
+  }
+
+  const numTypes = stream.readUint8();
+  for (let i = 0; i < numTypes; i++) {
+    const type = stream.readUint16();
+    const count = stream.readUint16();
+    let times = readTimes(stream);
+    times["name"] = procName(type);
+    times["count"] = count;
+    profile["types"].push(times);
+  }
+  return profile;
+}
+
+/** Fills the table element with the step times per proc type. */
+function fillProfileTable(elTable, profile) {
+  elTable.replaceChildren();
+
+  const elHeader = elTable.insertRow();
+  for (const title of ["Proc", "Steps", "min us", "avg us", "max us", "p99 us"]) {
+    const elTh = document.createElement("th");
+    elTh.textContent = title;
+    elHeader.appendChild(elTh);
+  }
+
+  for (const times of profile["types"]) {
+    const elRow = elTable.insertRow();
+    for (const key of ["name", "count", "min", "avg", "max", "p99"]) {
+      elRow.insertCell().textContent = times[key];
+    }
+  }
+}
+
+/** Switches the profiling on or off.
+ *
+ *  While on, the table is updated every second.
+ *
+ *  @returns true if the profiling is on.
+ */
+async function toggleProfile(elTable) {
+  if (profileTimer) {
+    clearInterval(profileTimer);
+    profileTimer = null;
+    await bluetooth.uploadProfileState(false);
+    return false;
+  }
+
+  await bluetooth.uploadProfileState(true);
+  profileTimer = setInterval(async () => {
+    const dataView = await bluetooth.downloadProfile();
+    const profile = dataView ? decodeProfile(dataView) : null;
+    if (profile) {
+      fillProfileTable(elTable, profile);
+    }
+  }, 1000);
+  return true;
+}
+
+export {decodeProfile, toggleProfile};
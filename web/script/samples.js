@@ -32,6 +32,7 @@ let sampleStatusCallback = null;
 const AUDIO_CMD_RESET = 0;
 const AUDIO_CMD_ADD = 1;
 const AUDIO_CMD_ADD_DATA = 2;
+const AUDIO_CMD_ADD_DATA_SEQ = 3;
 
 /** This is the same crc implementation as used by esp32 from esp_rom_crc.c */
 const crc16_le_table = [
@@ -291,7 +292,7 @@ class AudioList {
     let neededSectors = 0;
     for (let i = 0; i < this.list.length; i++) {
       const length = this.list[i][1];
-      neededSectors += Math.ceil((length + 16 /* size of block header*/) / 4096.0);
+      neededSectors += Math.ceil((length + 24 /* size of block header*/) / 4096.0);
     }
     return neededSectors;
   }
@@ -426,6 +427,30 @@ async function resetSamples() {
 }
 
 
+/** Reads the acknowledge of the sequenced upload.
+ *
+ *  @returns an object with id, seq, window, errors and active or null.
+ */
+async function readUploadAck() {
+  const dataView = await bluetooth.downloadAudioAck();
+  if (!dataView || dataView.byteLength < 12) {
+    return null;
+  }
+  const stream = new SimpleInputStream(dataView);
+  const magic = String.fromCharCode(stream.readUint8(), stream.readUint8());
+  const version = stream.readUint8();
+  if (magic != 'RK' || version != 1) {
+    return null;
+  }
+  return {
+    "id": stream.readAudioId(),
+    "seq": stream.readUint16(),
+    "window": stream.readUint8(),
+    "errors": stream.readUint16(),
+    "active": stream.readUint8() > 0,
+  };
+}
+
 /** Uploads one sample via BT.
  *
  *  Note: we create the buffers overly large and then
@@ -439,7 +464,12 @@ async function uploadSample(id, audioArray) {
   const CHUNK_SIZE = 220; // the number of bytes transmitted in one go
   const INITIAL_BUFFER_SIZE = CHUNK_SIZE + 50;
 
+  // number of acknowledge reads without progress before resending
+  const MAX_STALLS = 5;
+  const MAX_RESENDS = 20;
+
   const uint8 = new Uint8Array(audioArray);
+  const numChunks = Math.ceil(uint8.length / CHUNK_SIZE);
 
   // send "new sample" command
   {
@@ -457,6 +487,99 @@ async function uploadSample(id, audioArray) {
     await bluetooth.uploadAudio(new DataView(buffer.transfer(stream.tellg)));
   }
 
+  const sendChunk = async (seq) => {
+    const offset = seq * CHUNK_SIZE;
+    const bytesToWrite = Math.min(uint8.length - offset, CHUNK_SIZE);
+    const chunk = uint8.subarray(offset, offset + bytesToWrite);
+
+    const buffer = new ArrayBuffer(INITIAL_BUFFER_SIZE);
+    const dataView = new DataView(buffer);
+    let stream = new SimpleOutputStream(dataView);
+
+    stream.writeUint8('RA'.charCodeAt(0));
+    stream.writeUint8('RA'.charCodeAt(1));
+    stream.writeUint8(1);  // binary format version
+    stream.writeUint8(AUDIO_CMD_ADD_DATA_SEQ);
+    stream.writeAudioId(id);
+    stream.writeUint16(seq & 0xffff);
+    stream.writeUint32(offset);
+    stream.writeUint32(bytesToWrite);
+    stream.writeUint16(esp_rom_crc16_le(65535, chunk));
+    for (let i = 0; i < bytesToWrite; i++) {
+      stream.writeUint8(chunk[i]);
+    }
+
+    await bluetooth.uploadAudioWithoutResponse(new DataView(buffer.transfer(stream.tellg)));
+  };
+
+  // send "add data" commands, a window of chunks without waiting
+  // for the controller. If a chunk got lost (or had a crc error),
+  // everything starting with the acknowledged chunk is sent again.
+  if (!bluetooth.hasAudioAck()) {
+    // an old controller without the sequenced upload
+    return uploadSampleUnsequenced(id, uint8);
+  }
+  // a lost acknowledge is handled like a stall below
+  const firstAck = await readUploadAck();
+  let window = firstAck ? Math.max(1, firstAck.window) : 1;
+  let errors = null;  // the crc errors reported for this upload
+  let acked = 0;  // chunks acknowledged by the controller
+  let sent = 0;   // chunks sent (acknowledged or in flight)
+  let stalls = 0;
+  let resends = 0;
+
+  while (acked < numChunks) {
+    while (sent < numChunks && sent - acked < window) {
+      await sendChunk(sent);
+      sent++;
+    }
+
+    const ack = await readUploadAck();
+    // the upload is not active any more after the last chunk
+    if (ack && ack.id == id &&
+        (ack.active || ((ack.seq - acked) & 0xffff) == numChunks - acked)) {
+      // the sequence number only has 16 bits
+      const progress = (ack.seq - acked) & 0xffff;
+      if (progress > 0 && progress <= sent - acked) {
+        acked += progress;
+        stalls = 0;
+      } else {
+        stalls++;
+      }
+      window = Math.max(1, ack.window);
+
+      if (errors !== null && ack.errors != errors) {
+        stalls = MAX_STALLS;
+      }
+      errors = ack.errors;
+    } else {
+      stalls++;
+    }
+
+    if (stalls >= MAX_STALLS) {
+      // sending again doesn't help if the controller stopped the upload,
+      // e.g. because the converted sample does not fit
+      if (ack && ack.id == id && !ack.active) {
+        throw new Error("Error uploading: the controller rejected the sample.");
+      }
+      resends++;
+      if (resends > MAX_RESENDS) {
+        throw new Error("Error uploading: too many lost chunks.");
+      }
+      sent = acked;
+      stalls = 0;
+    }
+
+    if (sampleStatusCallback) {
+      sampleStatusCallback(null, {"progress": (100.0 * acked / numChunks)});
+    }
+  }
+}
+
+/** Uploads the sample data one chunk after another, each write waiting for the response. */
+async function uploadSampleUnsequenced(id, uint8) {
+  const CHUNK_SIZE = 220; // the number of bytes transmitted in one go
+  const INITIAL_BUFFER_SIZE = CHUNK_SIZE + 50;
 
   // send "add data" command
   for (let offset = 0; offset < uint8.length; offset += CHUNK_SIZE) {
@@ -4,7 +4,7 @@
  */
 
 import {defSignals} from "./def_signals.js";
-import {SimpleInputStream} from "./simple_stream.js";
+import {SignalsDecoder} from "./simple_stream.js";
 import * as bluetooth from "./bluetooth.js";
 
 // add a number to all signals and count them.
@@ -308,13 +308,19 @@ function fillTable() {
   }
 }
 
+/** Decodes the signals telemetry frames. */
+const signalsDecoder = new SignalsDecoder();
+
 /** Updates the UI (the signals table) with the values
  *  from the data view.
  *
- *  @param dataView a DataView object containing the received data.
+ *  @param dataView a DataView object containing the received telemetry frame.
  */
 function updateSignals(dataView) {
-    const signals = new SimpleInputStream(dataView).readSignals(NUM_SIGNALS);
+    if (!signalsDecoder.decode(dataView)) {
+      return;  // waiting for the next keyframe
+    }
+    const signals = signalsDecoder.signals;
     for (let i = 1; i < defSignals.length; i++ ) {
         const signal = defSignals[i];
         if (!("name" in signal) ||
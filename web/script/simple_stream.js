@@ -43,6 +43,7 @@ class SimpleInputStream {
 
   indexRead = 0;  ///< cursor for reading. Index in bytes.
   dataview = null;  ///< A DataView instance as a source.
+  failed = false;  ///< set when reading a byte beyond the end.
 
   /** Construct a new stream from a dataview. */
   constructor(dataview) {
@@ -76,6 +77,7 @@ class SimpleInputStream {
   *  @returns the read byte or 0U in case there is no other byte to read.  */
   readUint8() {
     if (this.eof) {
+      this.failed = true;
       return 0;
     } else {
       return this.dataview.getUint8(this.indexRead++);
@@ -169,6 +171,21 @@ class SimpleInputStream {
     return signals;
   }
 
+  /** Reads a zigzag encoded varint (7 bits per byte, LSB first).
+  *
+  *  @returns the signed value. */
+  readZigzag() {
+    let zigzag = 0;
+    for (let shift = 0; shift < 32; shift += 7) {
+      const byte = this.readUint8();
+      zigzag += (byte & 0x7f) * (2 ** shift);
+      if ((byte & 0x80) == 0) {
+        break;
+      }
+    }
+    return (zigzag % 2) ? -(zigzag + 1) / 2 : zigzag / 2;
+  }
+
   /** Reads an audio ID (three bytes) and returns it as a string. */
   readAudioId() {
     return String.fromCharCode(
@@ -337,6 +354,70 @@ class SimpleInputStream {
 
 } // end SimpleInputStream
 
+/** Decodes the signals telemetry frames (see signals_telemetry.h).
+ *
+ *  A keyframe ('K') contains all signals, a delta frame ('D') only
+ *  the differences of the changed signals.
+ */
+class SignalsDecoder {
+
+  signals = [];  ///< the last decoded signals
+  seq = 0;  ///< sequence number of the last decoded frame
+  synced = false;  ///< true if we can apply delta frames
+
+  /** Reads one frame and updates the signals.
+  *
+  *  @param dataView A DataView with the frame.
+  *  @returns true if the signals were updated. */
+  decode(dataView) {
+    const stream = new SimpleInputStream(dataView);
+    const type = String.fromCharCode(stream.readUint8());
+    const seq = stream.readUint8();
+    const count = stream.readUint8();
+
+    let result = this.signals.slice();
+    if (type == "K") {
+      for (let i = 0; i < count; i++) {
+        result[i] = stream.readZigzag();
+      }
+
+    } else if (type == "D") {
+      if (this.synced && seq == this.seq) {
+        return false;  // the same frame again
+      }
+      if (!this.synced || seq != ((this.seq + 1) & 0xff)) {
+        this.synced = false;  // wait for the next keyframe
+        return false;
+      }
+
+      let mask = [];
+      for (let i = 0; i < (count + 7) >> 3; i++) {
+        mask[i] = stream.readUint8();
+      }
+      for (let i = 0; i < count; i++) {
+        if (mask[i >> 3] & (1 << (i & 7))) {
+          // wrap around like the int16 on the controller
+          result[i] = ((result[i] + stream.readZigzag() + 32768) & 0xffff) - 32768;
+        }
+      }
+
+    } else {
+      return false;
+    }
+
+    if (stream.failed) {
+      this.synced = false;
+      return false;
+    }
+
+    this.signals = result;
+    this.seq = seq;
+    this.synced = true;
+    return true;
+  }
+
+} // end SignalsDecoder
+
 class SimpleOutputStream {
 
   indexWrite = 0;  ///< cursor for writeing. Index in bytes.
@@ -661,7 +742,25 @@ class SimpleOutputStream {
     }
   }
 
+  /** Writes a patch of a single proc.
+  *
+  *  @param op The patch operation. "R" (replace), "I" (insert) or "D" (remove).
+  *  @param index The index of the proc in the configuration.
+  *  @param value The new proc struct. Not used for remove.
+  */
+  writePatch(op, index, value) {
+    this.writeUint8('RP'.charCodeAt(0));
+    this.writeUint8('RP'.charCodeAt(1));
+    this.writeUint8(1);  // binary format version
+
+    this.writeUint8(op.charCodeAt(0));
+    this.writeUint8(index);
+    if (op != "D") {
+      this.writeProc(value);
+    }
+  }
+
 } // end SimpleOutputStream
 
-export {SimpleInputStream, SimpleOutputStream};
+export {SimpleInputStream, SimpleOutputStream, SignalsDecoder};
 